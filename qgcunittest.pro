@@ -200,6 +200,7 @@ FORMS += src/ui/MainWindow.ui \
     src/ui/QGCMAVLinkLogPlayer.ui \
     src/ui/QGCWaypointListMulti.ui \
     src/ui/QGCUDPLinkConfiguration.ui \
+    src/ui/QGCSharedMemoryLinkConfiguration.ui \
     src/ui/QGCSettingsWidget.ui \
     src/ui/UASControlParameters.ui \
     src/ui/map/QGCMapTool.ui \
@@ -241,6 +242,8 @@ INCLUDEPATH += src \
     src/ui/designer
 HEADERS += src/MG.h \
     src/QGCCore.h \
+    src/QGCSwarmBenchmark.h \
+    src/QGCReplayBenchmark.h \
     src/uas/UASInterface.h \
     src/uas/UAS.h \
     src/uas/UASManager.h \
@@ -250,7 +253,18 @@ HEADERS += src/MG.h \
     src/comm/SerialLink.h \
     src/comm/ProtocolInterface.h \
     src/comm/MAVLinkProtocol.h \
+    src/comm/MAVLinkFrameScanner.h \
+    src/comm/QGCSpscQueue.h \
+    src/comm/MAVLinkParserWorker.h \
+    src/comm/MAVLinkMessagePool.h \
+    src/comm/MAVLinkMessageDispatcher.h \
+    src/comm/MAVLinkLogWriter.h \
+    src/comm/MAVLinkStatistics.h \
+    src/comm/MAVLinkSendScheduler.h \
+    src/comm/QGCByteRingBuffer.h \
     src/comm/QGCFlightGearLink.h \
+    src/comm/QGCXPlaneLink.h \
+    src/comm/QGCHilLink.h \
     src/ui/CommConfigurationWindow.h \
     src/ui/SerialConfigurationWindow.h \
     src/ui/MainWindow.h \
@@ -267,6 +281,20 @@ HEADERS += src/MG.h \
     src/ui/CameraView.h \
     src/comm/MAVLinkSimulationLink.h \
     src/comm/UDPLink.h \
+    src/comm/UDPEndpointTable.h \
+    src/comm/SharedMemoryLink.h \
+    src/comm/qgc_shm_ring.h \
+    src/comm/LinkStatistics.h \
+    src/comm/SerialPortDiscovery.h \
+    src/comm/QGCHilLatency.h \
+    src/comm/QGCHilUdpWorker.h \
+    src/comm/QGCXPlaneLoopback.h \
+    src/comm/QGCFlightGearNet.h \
+    src/comm/MAVLinkLogIndex.h \
+    src/comm/MAVLinkLogReader.h \
+    src/comm/MAVLinkLogReplay.h \
+    src/comm/MAVLinkLogPacer.h \
+    src/comm/MAVLinkLogBlockFile.h \
     src/ui/ParameterInterface.h \
     src/ui/WaypointList.h \
     src/Waypoint.h \   
@@ -323,6 +351,7 @@ HEADERS += src/MG.h \
     src/uas/QGCMAVLinkUASFactory.h \
     src/ui/QGCWaypointListMulti.h \
     src/ui/QGCUDPLinkConfiguration.h \
+    src/ui/QGCSharedMemoryLinkConfiguration.h \
     src/ui/QGCSettingsWidget.h \
     src/ui/uas/UASControlParameters.h \
     src/uas/QGCUASParamManager.h \
@@ -367,6 +396,7 @@ HEADERS += src/MG.h \
     src/ui/mission/QGCMissionNavTakeoff.h \
     $$TESTDIR/AutoTest.h \
     $$TESTDIR/UASUnitTest.h \
+    $$TESTDIR/CommBenchmarkTest.h \
 
 # Google Earth is only supported on Mac OS and Windows with Visual Studio Compiler
 macx|macx-g++|macx-g++42|win32-msvc2008|win32-msvc2010::HEADERS += src/ui/map3D/QGCGoogleEarthView.h
@@ -414,13 +444,23 @@ contains(DEPENDENCIES_PRESENT, libfreenect) {
 }
 
 SOURCES += src/QGCCore.cc \
+    src/QGCSwarmBenchmark.cc \
+    src/QGCReplayBenchmark.cc \
     src/uas/UASManager.cc \
     src/uas/UAS.cc \
     src/comm/LinkManager.cc \
     src/comm/LinkInterface.cpp \
     src/comm/SerialLink.cc \
     src/comm/MAVLinkProtocol.cc \
+    src/comm/MAVLinkFrameScanner.cc \
+    src/comm/MAVLinkParserWorker.cc \
+    src/comm/MAVLinkMessagePool.cc \
+    src/comm/MAVLinkMessageDispatcher.cc \
+    src/comm/MAVLinkLogWriter.cc \
+    src/comm/MAVLinkStatistics.cc \
+    src/comm/MAVLinkSendScheduler.cc \
     src/comm/QGCFlightGearLink.cc \
+    src/comm/QGCXPlaneLink.cc \
     src/ui/CommConfigurationWindow.cc \
     src/ui/SerialConfigurationWindow.cc \
     src/ui/MainWindow.cc \
@@ -436,6 +476,19 @@ SOURCES += src/QGCCore.cc \
     src/ui/CameraView.cc \
     src/comm/MAVLinkSimulationLink.cc \
     src/comm/UDPLink.cc \
+    src/comm/UDPEndpointTable.cc \
+    src/comm/SharedMemoryLink.cc \
+    src/comm/LinkStatistics.cc \
+    src/comm/SerialPortDiscovery.cc \
+    src/comm/QGCHilLatency.cc \
+    src/comm/QGCHilUdpWorker.cc \
+    src/comm/QGCXPlaneLoopback.cc \
+    src/comm/QGCFlightGearNet.cc \
+    src/comm/MAVLinkLogIndex.cc \
+    src/comm/MAVLinkLogReader.cc \
+    src/comm/MAVLinkLogReplay.cc \
+    src/comm/MAVLinkLogPacer.cc \
+    src/comm/MAVLinkLogBlockFile.cc \
     src/ui/ParameterInterface.cc \
     src/ui/WaypointList.cc \
     src/Waypoint.cc \
@@ -490,6 +543,7 @@ SOURCES += src/QGCCore.cc \
     src/uas/QGCMAVLinkUASFactory.cc \
     src/ui/QGCWaypointListMulti.cc \
     src/ui/QGCUDPLinkConfiguration.cc \
+    src/ui/QGCSharedMemoryLinkConfiguration.cc \
     src/ui/QGCSettingsWidget.cc \
     src/ui/uas/UASControlParameters.cpp \
     src/uas/QGCUASParamManager.cc \
@@ -520,7 +574,8 @@ SOURCES += src/QGCCore.cc \
     src/ui/QGCPluginHost.cc \
     src/ui/firmwareupdate/QGCPX4FirmwareUpdate.cc \
     $$TESTDIR/testSuite.cc \
-    $$TESTDIR/UASUnitTest.cc
+    $$TESTDIR/UASUnitTest.cc \
+    $$TESTDIR/CommBenchmarkTest.cc
 
 # Enable Google Earth only on Mac OS and Windows with Visual Studio compiler
 macx|macx-g++|macx-g++42|win32-msvc2008|win32-msvc2010::SOURCES += src/ui/map3D/QGCGoogleEarthView.cc
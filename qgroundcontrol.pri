@@ -191,7 +191,8 @@ linux-g++|linux-g++-64{
 		-lflite \
 		-lSDL \
 		-lSDLmain \
-		-lasound
+		-lasound \
+		-lrt
 
 	exists(/usr/include/osg) | exists(/usr/local/include/osg) {
 		message("Building support for OpenSceneGraph")
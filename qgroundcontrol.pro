@@ -198,6 +198,7 @@ FORMS += src/ui/MainWindow.ui \
     src/ui/QGCMAVLinkLogPlayer.ui \
     src/ui/QGCWaypointListMulti.ui \
     src/ui/QGCUDPLinkConfiguration.ui \
+    src/ui/QGCSharedMemoryLinkConfiguration.ui \
     src/ui/QGCSettingsWidget.ui \
     src/ui/UASControlParameters.ui \
     src/ui/map/QGCMapTool.ui \
@@ -246,6 +247,8 @@ INCLUDEPATH += src \
     src/ui/designer
 HEADERS += src/MG.h \
     src/QGCCore.h \
+    src/QGCSwarmBenchmark.h \
+    src/QGCReplayBenchmark.h \
     src/uas/UASInterface.h \
     src/uas/UAS.h \
     src/uas/UASManager.h \
@@ -274,6 +277,20 @@ HEADERS += src/MG.h \
     src/ui/CameraView.h \
     src/comm/MAVLinkSimulationLink.h \
     src/comm/UDPLink.h \
+    src/comm/UDPEndpointTable.h \
+    src/comm/SharedMemoryLink.h \
+    src/comm/qgc_shm_ring.h \
+    src/comm/LinkStatistics.h \
+    src/comm/SerialPortDiscovery.h \
+    src/comm/QGCHilLatency.h \
+    src/comm/QGCHilUdpWorker.h \
+    src/comm/QGCXPlaneLoopback.h \
+    src/comm/QGCFlightGearNet.h \
+    src/comm/MAVLinkLogIndex.h \
+    src/comm/MAVLinkLogReader.h \
+    src/comm/MAVLinkLogReplay.h \
+    src/comm/MAVLinkLogPacer.h \
+    src/comm/MAVLinkLogBlockFile.h \
     src/ui/ParameterInterface.h \
     src/ui/WaypointList.h \
     src/Waypoint.h \   
@@ -329,6 +346,7 @@ HEADERS += src/MG.h \
     src/uas/QGCMAVLinkUASFactory.h \
     src/ui/QGCWaypointListMulti.h \
     src/ui/QGCUDPLinkConfiguration.h \
+    src/ui/QGCSharedMemoryLinkConfiguration.h \
     src/ui/QGCSettingsWidget.h \
     src/ui/uas/UASControlParameters.h \
     src/uas/QGCUASParamManager.h \
@@ -369,7 +387,16 @@ HEADERS += src/MG.h \
     src/ui/QGCHilConfiguration.h \
     src/ui/QGCHilFlightGearConfiguration.h \
     src/ui/QGCHilJSBSimConfiguration.h \
-    src/ui/QGCHilXPlaneConfiguration.h
+    src/ui/QGCHilXPlaneConfiguration.h \
+    src/comm/MAVLinkFrameScanner.h \
+    src/comm/QGCSpscQueue.h \
+    src/comm/MAVLinkParserWorker.h \
+    src/comm/MAVLinkMessagePool.h \
+    src/comm/MAVLinkMessageDispatcher.h \
+    src/comm/MAVLinkLogWriter.h \
+    src/comm/MAVLinkStatistics.h \
+    src/comm/MAVLinkSendScheduler.h \
+    src/comm/QGCByteRingBuffer.h
 
 # Google Earth is only supported on Mac OS and Windows with Visual Studio Compiler
 macx|macx-g++|macx-g++42|win32-msvc2008|win32-msvc2010::HEADERS += src/ui/map3D/QGCGoogleEarthView.h
@@ -416,6 +443,8 @@ contains(DEPENDENCIES_PRESENT, libfreenect) {
 }
 SOURCES += src/main.cc \
     src/QGCCore.cc \
+    src/QGCSwarmBenchmark.cc \
+    src/QGCReplayBenchmark.cc \
     src/uas/UASManager.cc \
     src/uas/UAS.cc \
     src/comm/LinkManager.cc \
@@ -440,6 +469,19 @@ SOURCES += src/main.cc \
     src/ui/CameraView.cc \
     src/comm/MAVLinkSimulationLink.cc \
     src/comm/UDPLink.cc \
+    src/comm/UDPEndpointTable.cc \
+    src/comm/SharedMemoryLink.cc \
+    src/comm/LinkStatistics.cc \
+    src/comm/SerialPortDiscovery.cc \
+    src/comm/QGCHilLatency.cc \
+    src/comm/QGCHilUdpWorker.cc \
+    src/comm/QGCXPlaneLoopback.cc \
+    src/comm/QGCFlightGearNet.cc \
+    src/comm/MAVLinkLogIndex.cc \
+    src/comm/MAVLinkLogReader.cc \
+    src/comm/MAVLinkLogReplay.cc \
+    src/comm/MAVLinkLogPacer.cc \
+    src/comm/MAVLinkLogBlockFile.cc \
     src/ui/ParameterInterface.cc \
     src/ui/WaypointList.cc \
     src/Waypoint.cc \
@@ -494,6 +536,7 @@ SOURCES += src/main.cc \
     src/uas/QGCMAVLinkUASFactory.cc \
     src/ui/QGCWaypointListMulti.cc \
     src/ui/QGCUDPLinkConfiguration.cc \
+    src/ui/QGCSharedMemoryLinkConfiguration.cc \
     src/ui/QGCSettingsWidget.cc \
     src/ui/uas/UASControlParameters.cpp \
     src/uas/QGCUASParamManager.cc \
@@ -530,7 +573,14 @@ SOURCES += src/main.cc \
     src/ui/QGCHilConfiguration.cc \
     src/ui/QGCHilFlightGearConfiguration.cc \
     src/ui/QGCHilJSBSimConfiguration.cc \
-    src/ui/QGCHilXPlaneConfiguration.cc
+    src/ui/QGCHilXPlaneConfiguration.cc \
+    src/comm/MAVLinkFrameScanner.cc \
+    src/comm/MAVLinkParserWorker.cc \
+    src/comm/MAVLinkMessagePool.cc \
+    src/comm/MAVLinkMessageDispatcher.cc \
+    src/comm/MAVLinkLogWriter.cc \
+    src/comm/MAVLinkStatistics.cc \
+    src/comm/MAVLinkSendScheduler.cc
 
 # Enable Google Earth only on Mac OS and Windows with Visual Studio compiler
 macx|macx-g++|macx-g++42|win32-msvc2008|win32-msvc2010::SOURCES += src/ui/map3D/QGCGoogleEarthView.cc
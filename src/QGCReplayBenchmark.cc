@@ -0,0 +1,205 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class QGCReplayBenchmark
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <QCoreApplication>
+
+#include "QGCReplayBenchmark.h"
+#include "MAVLinkLogReplay.h"
+#include "MAVLinkSimulationLink.h"
+#include "MAVLinkProtocol.h"
+#include "MAVLinkDecoder.h"
+#include "LinechartWidget.h"
+#include "UASManager.h"
+#include "UASInterface.h"
+
+QGCReplayBenchmark::QGCReplayBenchmark(QObject* parent) : QObject(parent),
+    protocol(new MAVLinkProtocol()),
+    link(new MAVLinkSimulationLink("")),
+    decoder(NULL),
+    chart(NULL),
+    replay(NULL),
+    decoderEnabled(true),
+    chartEnabled(false),
+    reportedProgress(0),
+    systems(0),
+    out(stdout)
+{
+    // Only measure the receive path, the replay hands the frames to the protocol
+    protocol->enableLogging(false);
+    protocol->enableMultiplexing(false);
+    protocol->enableHeartbeats(false);
+    replay = new MAVLinkLogReplay(protocol, this);
+
+    connect(replay, SIGNAL(progressChanged(int)), this, SLOT(reportProgress(int)));
+    connect(replay, SIGNAL(finished()), this, SLOT(finish()));
+    connect(UASManager::instance(), SIGNAL(UASCreated(UASInterface*)), this, SLOT(addUAS(UASInterface*)));
+}
+
+QGCReplayBenchmark::~QGCReplayBenchmark()
+{
+    replay->stop();
+    delete chart;
+    delete decoder;
+    // The vehicles use the protocol
+    delete UASManager::instance();
+    delete protocol;
+    delete link;
+}
+
+bool QGCReplayBenchmark::isRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--replay-benchmark") == 0) return true;
+    }
+    return false;
+}
+
+bool QGCReplayBenchmark::needsDisplay(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--charts") == 0) return true;
+    }
+    return false;
+}
+
+void QGCReplayBenchmark::printUsage()
+{
+    fprintf(stderr,
+            "Usage: qgroundcontrol --replay-benchmark --log=FILE [options]\n"
+            "  --log=FILE       MAVLink log to replay (*.mavlink, *.mavlinkz)\n"
+            "  --no-decoder     do not decode the message fields\n"
+            "  --charts         plot the decoded fields in a linechart, needs a display\n");
+}
+
+bool QGCReplayBenchmark::parseArguments(const QStringList& arguments)
+{
+    for (int i = 1; i < arguments.size(); i++)
+    {
+        const QString& argument = arguments.at(i);
+        const QString option = argument.section('=', 0, 0);
+        const QString value = argument.section('=', 1);
+        bool ok = true;
+
+        if (option == "--replay-benchmark")
+        {
+            continue;
+        }
+        else if (option == "--log")
+        {
+            logFileName = value;
+            ok = !value.isEmpty();
+        }
+        else if (option == "--no-decoder")
+        {
+            decoderEnabled = false;
+        }
+        else if (option == "--charts")
+        {
+            chartEnabled = true;
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            fprintf(stderr, "Invalid option: %s\n", argument.toLocal8Bit().constData());
+            printUsage();
+            return false;
+        }
+    }
+
+    if (logFileName.isEmpty() || (chartEnabled && !decoderEnabled))
+    {
+        fprintf(stderr, logFileName.isEmpty() ? "No log file given\n" : "The linechart needs the decoder\n");
+        printUsage();
+        return false;
+    }
+    return true;
+}
+
+void QGCReplayBenchmark::start()
+{
+    if (decoderEnabled)
+    {
+        decoder = new MAVLinkDecoder(protocol);
+    }
+    if (chartEnabled)
+    {
+        // The chart only plots while it is visible
+        chart = new LinechartWidget(0);
+        chart->show();
+        replay->beginValueSlots(decoder);
+        connect(decoder, SIGNAL(valueChanged(int,QString,QString,quint8,quint64)), chart, SLOT(appendData(int,QString,QString,quint8,quint64)));
+        connect(decoder, SIGNAL(valueChanged(int,QString,QString,qint8,quint64)), chart, SLOT(appendData(int,QString,QString,qint8,quint64)));
+        connect(decoder, SIGNAL(valueChanged(int,QString,QString,quint16,quint64)), chart, SLOT(appendData(int,QString,QString,quint16,quint64)));
+        connect(decoder, SIGNAL(valueChanged(int,QString,QString,qint16,quint64)), chart, SLOT(appendData(int,QString,QString,qint16,quint64)));
+        connect(decoder, SIGNAL(valueChanged(int,QString,QString,quint32,quint64)), chart, SLOT(appendData(int,QString,QString,quint32,quint64)));
+        connect(decoder, SIGNAL(valueChanged(int,QString,QString,qint32,quint64)), chart, SLOT(appendData(int,QString,QString,qint32,quint64)));
+        connect(decoder, SIGNAL(valueChanged(int,QString,QString,quint64,quint64)), chart, SLOT(appendData(int,QString,QString,quint64,quint64)));
+        connect(decoder, SIGNAL(valueChanged(int,QString,QString,qint64,quint64)), chart, SLOT(appendData(int,QString,QString,qint64,quint64)));
+        connect(decoder, SIGNAL(valueChanged(int,QString,QString,double,quint64)), chart, SLOT(appendData(int,QString,QString,double,quint64)));
+        replay->endValueSlots(decoder, tr("linechart"));
+    }
+
+    out << "Replay benchmark: " << logFileName << (decoderEnabled ? ", decoder" : "")
+        << (chartEnabled ? ", linechart" : "") << endl;
+
+    if (!replay->start(logFileName, link))
+    {
+        fprintf(stderr, "Can't read %s\n", logFileName.toLocal8Bit().constData());
+        QCoreApplication::exit(1);
+    }
+}
+
+void QGCReplayBenchmark::finish()
+{
+    out << replay->getReport();
+    out << "systems: " << systems << endl;
+    QCoreApplication::quit();
+}
+
+void QGCReplayBenchmark::addUAS(UASInterface* uas)
+{
+    Q_UNUSED(uas);
+    systems++;
+}
+
+void QGCReplayBenchmark::reportProgress(int percent)
+{
+    if (percent >= reportedProgress + 10)
+    {
+        reportedProgress = percent - percent % 10;
+        out << reportedProgress << " %, " << replay->getFrames() << " frames" << endl;
+    }
+}
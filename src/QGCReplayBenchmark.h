@@ -0,0 +1,97 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class QGCReplayBenchmark
+ */
+
+#ifndef QGCREPLAYBENCHMARK_H
+#define QGCREPLAYBENCHMARK_H
+
+#include <QObject>
+#include <QStringList>
+#include <QTextStream>
+
+class UASInterface;
+class MAVLinkProtocol;
+class MAVLinkSimulationLink;
+class MAVLinkDecoder;
+class MAVLinkLogReplay;
+class LinechartWidget;
+
+/**
+ * @brief Headless unpaced replay of a MAVLink log
+ *
+ * Pushes a complete log through MAVLinkProtocol, the UAS objects, the
+ * MAVLink decoder and optionally a linechart as fast as the CPU allows
+ * and prints the frame rate and the time spent in every stage, see
+ * MAVLinkLogReplay.
+ *
+ * Started with --replay-benchmark, see printUsage() for the options.
+ */
+class QGCReplayBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    QGCReplayBenchmark(QObject* parent = 0);
+    ~QGCReplayBenchmark();
+
+    /** @brief Check if the command line requests the benchmark, the application does not exist yet */
+    static bool isRequested(int argc, char* argv[]);
+    /** @brief Check if the command line requests the linecharts, which need a display */
+    static bool needsDisplay(int argc, char* argv[]);
+    /** @brief Print the command line options */
+    static void printUsage();
+    /**
+     * @brief Configure the benchmark from the command line
+     * @return false if an option is invalid
+     */
+    bool parseArguments(const QStringList& arguments);
+
+public slots:
+    /** @brief Build the pipeline and start the replay */
+    void start();
+    /** @brief Print the report and quit the application */
+    void finish();
+
+protected slots:
+    void addUAS(UASInterface* uas);
+    /** @brief Print the progress in steps of 10% */
+    void reportProgress(int percent);
+
+protected:
+    MAVLinkProtocol* protocol;
+    MAVLinkSimulationLink* link;
+    MAVLinkDecoder* decoder;
+    LinechartWidget* chart;
+    MAVLinkLogReplay* replay;
+    QString logFileName;
+    bool decoderEnabled;
+    bool chartEnabled;
+    int reportedProgress;
+    int systems;
+    QTextStream out;
+};
+
+#endif // QGCREPLAYBENCHMARK_H
@@ -0,0 +1,277 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class QGCSwarmBenchmark
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <QCoreApplication>
+
+#include "QGCSwarmBenchmark.h"
+#include "MAVLinkSwarmSimulationLink.h"
+#include "MAVLinkProtocol.h"
+#include "LinkManager.h"
+#include "UASManager.h"
+#include "UASInterface.h"
+
+/** Dispatched messages reported to the swarm link at once in fast mode */
+static const int acknowledgeBatch = 64;
+
+QGCSwarmBenchmark::Totals::Totals() :
+    time(0),
+    generated(0),
+    generatedBytes(0),
+    dropped(0),
+    parsed(0),
+    crcErrors(0),
+    dispatched(0),
+    uasUpdates(0)
+{
+}
+
+QGCSwarmBenchmark::QGCSwarmBenchmark(QObject* parent) : QObject(parent),
+    protocol(new MAVLinkProtocol()),
+    link(new MAVLinkSwarmSimulationLink()),
+    duration(10),
+    out(stdout),
+    dispatched(0),
+    unacknowledged(0),
+    uasUpdates(0),
+    systems(0)
+{
+    // Only measure the receive path
+    protocol->enableLogging(false);
+    protocol->enableMultiplexing(false);
+    protocol->enableHeartbeats(false);
+    LinkManager::instance()->addProtocol(link, protocol);
+
+    connect(protocol, SIGNAL(messageHandleReceived(LinkInterface*,MAVLinkMessageHandle)), this, SLOT(countMessage(LinkInterface*,MAVLinkMessageHandle)));
+    connect(UASManager::instance(), SIGNAL(UASCreated(UASInterface*)), this, SLOT(addUAS(UASInterface*)));
+    connect(&reportTimer, SIGNAL(timeout()), this, SLOT(report()));
+}
+
+QGCSwarmBenchmark::~QGCSwarmBenchmark()
+{
+    link->disconnect();
+    // The vehicles use the protocol, the parser threads the link. The
+    // manager itself is a singleton owned by the application.
+    foreach (UASInterface* uas, UASManager::instance()->getUASList())
+    {
+        UASManager::instance()->removeUAS(uas);
+        delete uas;
+    }
+    delete protocol;
+    delete link;
+}
+
+bool QGCSwarmBenchmark::isRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--swarm-benchmark") == 0) return true;
+    }
+    return false;
+}
+
+void QGCSwarmBenchmark::printUsage()
+{
+    fprintf(stderr,
+            "Usage: qgroundcontrol --swarm-benchmark [options]\n"
+            "  --vehicles=N     number of simulated vehicles, 1 to %d (default 10)\n"
+            "  --duration=S     measurement time in seconds (default 10)\n"
+            "  --mix=ID:HZ,...  message ids and rates per vehicle, include 0 (heartbeat)\n"
+            "                   to create the vehicles (default 0:1,1:2,24:5,30:50,33:10,74:4)\n"
+            "  --seed=N         seed of the loss and jitter model (default 1)\n"
+            "  --loss=P         percentage of dropped messages (default 0)\n"
+            "  --jitter=MS      largest delay of a message in milliseconds (default 0)\n"
+            "  --fast           run as fast as the pipeline keeps up instead of in real time\n",
+            SWARM_MAX_VEHICLES);
+}
+
+bool QGCSwarmBenchmark::parseArguments(const QStringList& arguments)
+{
+    for (int i = 1; i < arguments.size(); i++)
+    {
+        const QString& argument = arguments.at(i);
+        const QString option = argument.section('=', 0, 0);
+        const QString value = argument.section('=', 1);
+        bool ok = true;
+
+        if (option == "--swarm-benchmark")
+        {
+            continue;
+        }
+        else if (option == "--fast")
+        {
+            link->setFastMode(true);
+        }
+        else if (option == "--vehicles")
+        {
+            int vehicles = value.toInt(&ok);
+            ok = ok && vehicles > 0 && vehicles <= SWARM_MAX_VEHICLES;
+            link->setVehicleCount(vehicles);
+        }
+        else if (option == "--duration")
+        {
+            duration = value.toInt(&ok);
+            ok = ok && duration > 0;
+        }
+        else if (option == "--mix")
+        {
+            QList<SwarmMessage> mix;
+            ok = MAVLinkSwarmSimulationLink::parseMessageMix(value, &mix);
+            if (ok) link->setMessageMix(mix);
+        }
+        else if (option == "--seed")
+        {
+            link->setSeed(value.toUInt(&ok));
+        }
+        else if (option == "--loss")
+        {
+            double loss = value.toDouble(&ok);
+            ok = ok && loss >= 0.0 && loss <= 100.0;
+            link->setLossRate(loss / 100.0);
+        }
+        else if (option == "--jitter")
+        {
+            double jitter = value.toDouble(&ok);
+            ok = ok && jitter >= 0.0;
+            link->setJitter(int(jitter * 1000.0));
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            fprintf(stderr, "Invalid option: %s\n", argument.toLocal8Bit().constData());
+            printUsage();
+            return false;
+        }
+    }
+    return true;
+}
+
+void QGCSwarmBenchmark::start()
+{
+    out << "Swarm benchmark: " << link->getVehicleCount() << " vehicles, " << duration << " s, "
+        << (link->isFastMode() ? "fast" : "real time") << ", seed " << link->getSeed()
+        << ", loss " << link->getLossRate() * 100.0 << " %, jitter " << link->getJitter() / 1000.0 << " ms" << endl;
+
+    clock.start();
+    last = Totals();
+    link->connect();
+    reportTimer.start(1000);
+    QTimer::singleShot(duration * 1000, this, SLOT(finish()));
+}
+
+void QGCSwarmBenchmark::finish()
+{
+    reportTimer.stop();
+    link->disconnect();
+    Totals total = takeTotals();
+    printRates("total", Totals(), total);
+    out << "systems: " << systems;
+    if (link->isFastMode()) out << ", consumer stalls: " << link->getStalls();
+    out << endl;
+    MAVLinkMessagePool* pool = MAVLinkMessagePool::instance();
+    out << "message pool: " << pool->getAllocations() << " allocations, "
+        << pool->getReusedBlocks() << " reused, " << pool->getHeapAllocations() << " from the heap, "
+        << pool->getHeapReleases() << " returned to the heap" << endl;
+    QCoreApplication::quit();
+}
+
+void QGCSwarmBenchmark::countMessage(LinkInterface* source, MAVLinkMessageHandle message)
+{
+    Q_UNUSED(message);
+    if (source != link) return;
+    dispatched++;
+    // Let the swarm run ahead in fast mode
+    if (++unacknowledged == acknowledgeBatch)
+    {
+        link->acknowledge(acknowledgeBatch);
+        unacknowledged = 0;
+    }
+}
+
+void QGCSwarmBenchmark::addUAS(UASInterface* uas)
+{
+    systems++;
+    connect(uas, SIGNAL(heartbeat(UASInterface*)), this, SLOT(countUASUpdate()));
+    connect(uas, SIGNAL(attitudeChanged(UASInterface*,int,double,double,double,quint64)), this, SLOT(countUASUpdate()));
+    connect(uas, SIGNAL(globalPositionChanged(UASInterface*,double,double,double,quint64)), this, SLOT(countUASUpdate()));
+}
+
+void QGCSwarmBenchmark::countUASUpdate()
+{
+    uasUpdates++;
+}
+
+void QGCSwarmBenchmark::report()
+{
+    Totals now = takeTotals();
+    printRates(QString("%1 s").arg(now.time / 1e9, 5, 'f', 1), last, now);
+    last = now;
+}
+
+QGCSwarmBenchmark::Totals QGCSwarmBenchmark::takeTotals()
+{
+    Totals totals;
+    totals.time = clock.nsecsElapsed();
+    totals.generated = link->getGeneratedMessages();
+    totals.generatedBytes = link->getEmittedBytes();
+    totals.dropped = link->getDroppedMessages();
+    totals.dispatched = dispatched;
+    totals.uasUpdates = uasUpdates;
+
+    // The parser thread only counts, the snapshot sums up
+    MAVLinkStatistics* statistics = protocol->getStatistics();
+    statistics->updateSnapshot();
+    foreach (const MAVLinkLinkSample& sample, statistics->getSnapshot().links)
+    {
+        if (sample.linkId != link->getId()) continue;
+        totals.crcErrors = sample.crcErrors;
+        foreach (const MAVLinkComponentSample& component, sample.components)
+        {
+            totals.parsed += component.messages;
+        }
+    }
+    return totals;
+}
+
+void QGCSwarmBenchmark::printRates(const QString& label, const Totals& from, const Totals& to)
+{
+    const double seconds = qMax(to.time - from.time, qint64(1)) / 1e9;
+    out << qSetFieldWidth(8) << label << qSetFieldWidth(0)
+        << " | generated " << int((to.generated - from.generated) / seconds) << " msg/s "
+        << int((to.generatedBytes - from.generatedBytes) / seconds / 1024.0) << " KiB/s"
+        << " (lost " << (to.dropped - from.dropped) << ")"
+        << " | parsed " << int((to.parsed - from.parsed) / seconds) << " msg/s"
+        << " (crc errors " << (to.crcErrors - from.crcErrors) << ")"
+        << " | dispatched " << int((to.dispatched - from.dispatched) / seconds) << " msg/s"
+        << " | uas " << int((to.uasUpdates - from.uasUpdates) / seconds) << " updates/s" << endl;
+}
@@ -0,0 +1,122 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class QGCSwarmBenchmark
+ */
+
+#ifndef QGCSWARMBENCHMARK_H
+#define QGCSWARMBENCHMARK_H
+
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include "MAVLinkMessagePool.h"
+
+class LinkInterface;
+class UASInterface;
+class MAVLinkProtocol;
+class MAVLinkSwarmSimulationLink;
+
+/**
+ * @brief Headless throughput benchmark of the receive pipeline
+ *
+ * Feeds a MAVLinkSwarmSimulationLink through MAVLinkProtocol into the UAS
+ * objects without creating any widget and prints the throughput of every
+ * stage once per second:
+ *
+ * - generated: frames emitted by the swarm link
+ * - parsed: frames decoded by the parser thread of the link
+ * - dispatched: messages handled by the protocol
+ * - uas: heartbeat, attitude and position updates emitted by the UAS objects
+ *
+ * Started with --swarm-benchmark, see printUsage() for the options.
+ */
+class QGCSwarmBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    QGCSwarmBenchmark(QObject* parent = 0);
+    ~QGCSwarmBenchmark();
+
+    /** @brief Check if the command line requests the benchmark, the application does not exist yet */
+    static bool isRequested(int argc, char* argv[]);
+    /** @brief Print the command line options */
+    static void printUsage();
+    /**
+     * @brief Configure the benchmark from the command line
+     * @return false if an option is invalid
+     */
+    bool parseArguments(const QStringList& arguments);
+
+public slots:
+    /** @brief Connect the swarm and start the measurement */
+    void start();
+    /** @brief Print the summary and quit the application */
+    void finish();
+
+protected slots:
+    void countMessage(LinkInterface* source, MAVLinkMessageHandle message);
+    void addUAS(UASInterface* uas);
+    void countUASUpdate();
+    /** @brief Print the throughput since the last report */
+    void report();
+
+protected:
+    /** @brief Counters of all stages at one point in time */
+    struct Totals
+    {
+        Totals();
+        qint64 time;        ///< Nanoseconds since start()
+        quint64 generated;
+        quint64 generatedBytes;
+        quint64 dropped;
+        quint64 parsed;
+        quint64 crcErrors;
+        quint64 dispatched;
+        quint64 uasUpdates;
+    };
+
+    /** @brief Read the counters of all stages */
+    Totals takeTotals();
+    /** @brief Print the rates between two points in time */
+    void printRates(const QString& label, const Totals& from, const Totals& to);
+
+    MAVLinkProtocol* protocol;
+    MAVLinkSwarmSimulationLink* link;
+    int duration;           ///< Measurement time in seconds
+    QTimer reportTimer;
+    QElapsedTimer clock;
+    QTextStream out;
+    Totals last;
+    quint64 dispatched;
+    quint64 unacknowledged; ///< Dispatched messages not yet reported to the link
+    quint64 uasUpdates;
+    int systems;
+};
+
+#endif // QGCSWARMBENCHMARK_H
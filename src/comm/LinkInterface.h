@@ -34,6 +34,8 @@ along with PIXHAWK. If not, see <http://www.gnu.org/licenses/>.
 
 #include <QThread>
 
+#include "LinkStatistics.h"
+
 /**
 * The link interface defines the interface for all links used to communicate
 * with the groundstation application.
@@ -109,7 +111,7 @@ public:
      * @Brief Get the long term (complete) mean of the data rate
      *
      * The mean of the total data rate. It is calculated as
-     * all transferred bits / total link uptime.
+     * all transferred bits / time since the statistics were reset.
      *
      * @return The mean data rate of the interface in bit per second, 0 if unknown
      * @see getNominalDataRate() For the nominal data rate of the interface
@@ -117,12 +119,14 @@ public:
      * @see getCurrentDataRate() For the data rate of the last transferred chunk
      * @see getMaxDataRate() For the maximum data rate
      **/
-    virtual qint64 getTotalUpstream() = 0;
+    virtual qint64 getTotalUpstream() {
+        return qint64(linkStatistics.getAverageRate().sentBytes * 8);
+    }
 
     /**
      * @Brief Get the current data rate
      *
-     * The datarate of the last 100 ms
+     * The datarate of the last completed one second sample
      *
      * @return The mean data rate of the interface in bit per second, 0 if unknown
      * @see getNominalDataRate() For the nominal data rate of the interface
@@ -130,12 +134,14 @@ public:
      * @see getShortTermDataRate() For a the mean data rate of the last seconds
      * @see getMaxDataRate() For the maximum data rate
      **/
-    virtual qint64 getCurrentUpstream() = 0;
+    virtual qint64 getCurrentUpstream() {
+        return qint64(linkStatistics.getRate().sentBytes * 8);
+    }
 
     /**
      * @Brief Get the maximum data rate
      *
-     * The maximum peak data rate.
+     * The maximum peak data rate of a one second sample in the history.
      *
      * @return The mean data rate of the interface in bit per second, 0 if unknown
      * @see getNominalDataRate() For the nominal data rate of the interface
@@ -143,14 +149,33 @@ public:
      * @see getShortTermDataRate() For a the mean data rate of the last seconds
      * @see getCurrentDataRate() For the data rate of the last transferred chunk
      **/
-    virtual qint64 getMaxUpstream() = 0;
+    virtual qint64 getMaxUpstream() {
+        return qint64(linkStatistics.getMaxRate().sentBytes * 8);
+    }
+
+    /** @brief Get the mean receive data rate in bit per second, see getTotalUpstream() */
+    virtual qint64 getTotalDownstream() {
+        return qint64(linkStatistics.getAverageRate().receivedBytes * 8);
+    }
+
+    /** @brief Get the receive data rate of the last second in bit per second */
+    virtual qint64 getCurrentDownstream() {
+        return qint64(linkStatistics.getRate().receivedBytes * 8);
+    }
+
+    /** @brief Get the maximum receive data rate in bit per second */
+    virtual qint64 getMaxDownstream() {
+        return qint64(linkStatistics.getMaxRate().receivedBytes * 8);
+    }
 
     /**
      * @Brief Get the total number of bits sent
      *
      * @return The number of sent bits
      **/
-    virtual qint64 getBitsSent() = 0;
+    virtual qint64 getBitsSent() {
+        return qint64(linkStatistics.getSentBytes() * 8);
+    }
 
     /**
      * @Brief Get the total number of bits received
@@ -158,7 +183,19 @@ public:
      * @return The number of received bits
      * @bug Decide if the bits should be counted fromt the instantiation of the interface or if the counter should reset on disconnect.
      **/
-    virtual qint64 getBitsReceived() = 0;
+    virtual qint64 getBitsReceived() {
+        return qint64(linkStatistics.getReceivedBytes() * 8);
+    }
+
+    /**
+     * @brief Get the traffic counters and the per-second history of this link
+     *
+     * The links count their traffic in it, the statistics are sampled in
+     * the thread which created the link.
+     **/
+    LinkStatistics* getLinkStatistics() {
+        return &linkStatistics;
+    }
 
     /**
      * @brief Connect this interface logically
@@ -181,6 +218,20 @@ public:
      **/
     virtual qint64 bytesAvailable() = 0;
 
+    /**
+     * @brief Get the number of bytes forwarded to this link from other links
+     *
+     * @return The number of bytes written by packet multiplexing
+     **/
+    quint64 getForwardedBytes() const {
+        return linkStatistics.getForwardedBytes();
+    }
+
+    /** @brief Count bytes forwarded to this link, lock-free, any thread */
+    void addForwardedBytes(int bytes) {
+        linkStatistics.countForwarded(bytes);
+    }
+
 public slots:
 
     /**
@@ -236,6 +287,8 @@ signals:
 	void deleteLink(LinkInterface* const link);
 
 protected:
+    LinkStatistics linkStatistics; ///< Traffic of this link, counted lock-free
+
     static int getNextLinkId() {
         static int nextId = 1;
         return nextId++;
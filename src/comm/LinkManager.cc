@@ -54,7 +54,8 @@ LinkManager* LinkManager::instance()
  *
  * This class implements the singleton design pattern and has therefore only a private constructor.
  **/
-LinkManager::LinkManager()
+LinkManager::LinkManager() :
+    protocolLinksGeneration(0)
 {
     links = QList<LinkInterface*>();
     protocolLinks = QMap<ProtocolInterface*, LinkInterface*>();
@@ -93,9 +94,10 @@ void LinkManager::addProtocol(LinkInterface* link, ProtocolInterface* protocol)
     if ((linkList.length() > 0 && !linkList.contains(link)) || linkList.length() == 0)
     {
         // Protocol is new, add
-        connect(link, SIGNAL(bytesReceived(LinkInterface*, QByteArray)), protocol, SLOT(receiveBytes(LinkInterface*, QByteArray)));
+        protocol->addLink(link);
         // Store the connection information in the protocol links map
         protocolLinks.insertMulti(protocol, link);
+        protocolLinksGeneration++;
     }
     //qDebug() << __FILE__ << __LINE__ << "ADDED LINK TO PROTOCOL" << link->getName() << protocol->getName() << "NEW SIZE OF LINK LIST:" << protocolLinks.size();
 }
@@ -147,7 +149,9 @@ bool LinkManager::disconnectLink(LinkInterface* link)
 
 void LinkManager::removeLink(QObject* link)
 {
-    LinkInterface* linkInterface = dynamic_cast<LinkInterface*>(link);
+    // Called from the destructor of QObject, the dynamic type is already
+    // lost. Only links are connected to this slot and only the pointer is used.
+    LinkInterface* linkInterface = static_cast<LinkInterface*>(link);
     if (linkInterface)
     {
         removeLink(linkInterface);
@@ -171,6 +175,7 @@ bool LinkManager::removeLink(LinkInterface* link)
         {
             protocolLinks.remove(proto, link);
         }
+        protocolLinksGeneration++;
         return true;
     }
     return false;
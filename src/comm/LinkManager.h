@@ -55,6 +55,15 @@ public:
     void run();
 
     QList<LinkInterface*> getLinksForProtocol(ProtocolInterface* protocol);
+    /**
+     * @brief Get the generation of the link / protocol assignment
+     *
+     * The generation changes whenever a link is added to or removed from a
+     * protocol, so a copy of getLinksForProtocol() can be cached until then.
+     */
+    int getProtocolLinksGeneration() const {
+        return protocolLinksGeneration;
+    }
 
     /** @brief Get the link for this id */
     LinkInterface* getLinkForId(int id);
@@ -85,6 +94,7 @@ protected:
     LinkManager();
     QList<LinkInterface*> links;
     QMultiMap<ProtocolInterface*,LinkInterface*> protocolLinks;
+    int protocolLinksGeneration;    ///< Incremented on every change of protocolLinks
 
 private:
     static LinkManager* _instance;
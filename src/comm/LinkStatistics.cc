@@ -0,0 +1,204 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class LinkStatistics
+ */
+
+#include "LinkStatistics.h"
+#include "QGC.h"
+
+LinkStatistics::LinkStatistics(QObject* parent) : QObject(parent),
+    receivedBytes(0),
+    sentBytes(0),
+    receivedPackets(0),
+    sentPackets(0),
+    forwardedBytes(0),
+    next(0),
+    lastSample(0),
+    timer(this)
+{
+    clock.start();
+    connect(&timer, SIGNAL(timeout()), this, SLOT(sample()));
+    timer.start(1000);
+}
+
+/**
+ * Only the pending counters are touched without the mutex, they are
+ * swapped to zero here, so no count gets lost or counted twice.
+ */
+void LinkStatistics::sample()
+{
+    QMutexLocker locker(&mutex);
+    LinkTrafficSample current;
+    // The pending counters are read as unsigned, they only wrap after 4 GB per second
+    current.receivedBytes = quint32(receivedBytesPending.fetchAndStoreRelaxed(0));
+    current.sentBytes = quint32(sentBytesPending.fetchAndStoreRelaxed(0));
+    current.receivedPackets = quint32(receivedPacketsPending.fetchAndStoreRelaxed(0));
+    current.sentPackets = quint32(sentPacketsPending.fetchAndStoreRelaxed(0));
+    forwardedBytes += quint32(forwardedBytesPending.fetchAndStoreRelaxed(0));
+
+    const qint64 now = clock.elapsed();
+    current.time = QGC::groundTimeMilliseconds();
+    current.interval = quint32(qMax(now - lastSample, qint64(1)));
+    lastSample = now;
+
+    receivedBytes += current.receivedBytes;
+    sentBytes += current.sentBytes;
+    receivedPackets += current.receivedPackets;
+    sentPackets += current.sentPackets;
+
+    if (history.size() < LINK_STATISTICS_HISTORY)
+    {
+        history.append(current);
+    }
+    else
+    {
+        history[next] = current;
+    }
+    next = (next + 1) % LINK_STATISTICS_HISTORY;
+    locker.unlock();
+
+    emit sampled();
+}
+
+void LinkStatistics::reset()
+{
+    QMutexLocker locker(&mutex);
+    receivedBytesPending.fetchAndStoreRelaxed(0);
+    sentBytesPending.fetchAndStoreRelaxed(0);
+    receivedPacketsPending.fetchAndStoreRelaxed(0);
+    sentPacketsPending.fetchAndStoreRelaxed(0);
+    forwardedBytesPending.fetchAndStoreRelaxed(0);
+    receivedBytes = 0;
+    sentBytes = 0;
+    receivedPackets = 0;
+    sentPackets = 0;
+    forwardedBytes = 0;
+    history.clear();
+    next = 0;
+    clock.restart();
+    lastSample = 0;
+}
+
+quint64 LinkStatistics::getReceivedBytes() const
+{
+    QMutexLocker locker(&mutex);
+    return receivedBytes + quint32(int(receivedBytesPending));
+}
+
+quint64 LinkStatistics::getSentBytes() const
+{
+    QMutexLocker locker(&mutex);
+    return sentBytes + quint32(int(sentBytesPending));
+}
+
+quint64 LinkStatistics::getReceivedPackets() const
+{
+    QMutexLocker locker(&mutex);
+    return receivedPackets + quint32(int(receivedPacketsPending));
+}
+
+quint64 LinkStatistics::getSentPackets() const
+{
+    QMutexLocker locker(&mutex);
+    return sentPackets + quint32(int(sentPacketsPending));
+}
+
+quint64 LinkStatistics::getForwardedBytes() const
+{
+    QMutexLocker locker(&mutex);
+    return forwardedBytes + quint32(int(forwardedBytesPending));
+}
+
+QVector<LinkTrafficSample> LinkStatistics::getHistory(int seconds) const
+{
+    QMutexLocker locker(&mutex);
+    const int count = qBound(0, seconds, history.size());
+    QVector<LinkTrafficSample> samples;
+    samples.reserve(count);
+    // The newest sample is right before next
+    const int first = next - count + ((next - count < 0) ? history.size() : 0);
+    for (int i = 0; i < count; i++)
+    {
+        samples.append(history.at((first + i) % history.size()));
+    }
+    return samples;
+}
+
+int LinkStatistics::getHistorySize() const
+{
+    QMutexLocker locker(&mutex);
+    return history.size();
+}
+
+LinkTrafficRate LinkStatistics::getRate(int seconds) const
+{
+    LinkTrafficRate rate;
+    quint64 interval = 0;
+    foreach (const LinkTrafficSample& entry, getHistory(seconds))
+    {
+        interval += entry.interval;
+        rate.receivedBytes += entry.receivedBytes;
+        rate.sentBytes += entry.sentBytes;
+        rate.receivedPackets += entry.receivedPackets;
+        rate.sentPackets += entry.sentPackets;
+    }
+    if (interval == 0) return LinkTrafficRate();
+    const double scale = 1000.0 / interval;
+    rate.receivedBytes *= scale;
+    rate.sentBytes *= scale;
+    rate.receivedPackets *= scale;
+    rate.sentPackets *= scale;
+    return rate;
+}
+
+LinkTrafficRate LinkStatistics::getMaxRate() const
+{
+    QMutexLocker locker(&mutex);
+    LinkTrafficRate rate;
+    foreach (const LinkTrafficSample& entry, history)
+    {
+        const double scale = 1000.0 / entry.interval;
+        rate.receivedBytes = qMax(rate.receivedBytes, entry.receivedBytes * scale);
+        rate.sentBytes = qMax(rate.sentBytes, entry.sentBytes * scale);
+        rate.receivedPackets = qMax(rate.receivedPackets, entry.receivedPackets * scale);
+        rate.sentPackets = qMax(rate.sentPackets, entry.sentPackets * scale);
+    }
+    return rate;
+}
+
+LinkTrafficRate LinkStatistics::getAverageRate() const
+{
+    QMutexLocker locker(&mutex);
+    LinkTrafficRate rate;
+    const qint64 elapsed = clock.elapsed();
+    if (elapsed <= 0) return rate;
+    const double scale = 1000.0 / elapsed;
+    rate.receivedBytes = (receivedBytes + quint32(int(receivedBytesPending))) * scale;
+    rate.sentBytes = (sentBytes + quint32(int(sentBytesPending))) * scale;
+    rate.receivedPackets = (receivedPackets + quint32(int(receivedPacketsPending))) * scale;
+    rate.sentPackets = (sentPackets + quint32(int(sentPacketsPending))) * scale;
+    return rate;
+}
@@ -0,0 +1,141 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class LinkStatistics
+ */
+
+#ifndef LINKSTATISTICS_H
+#define LINKSTATISTICS_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QTimer>
+#include <QVector>
+#include <QElapsedTimer>
+
+/** Number of one second samples a link keeps, one hour */
+#define LINK_STATISTICS_HISTORY 3600
+
+/** @brief Traffic of a link during one sample interval */
+struct LinkTrafficSample
+{
+    LinkTrafficSample() : time(0), interval(0), receivedBytes(0), sentBytes(0), receivedPackets(0), sentPackets(0) {}
+    quint64 time;           ///< Ground time at the end of the interval in milliseconds
+    quint32 interval;       ///< Length of the interval in milliseconds
+    quint32 receivedBytes;
+    quint32 sentBytes;
+    quint32 receivedPackets; ///< Reads, datagrams or blocks handed to the protocols
+    quint32 sentPackets;    ///< Writes or datagrams sent
+};
+
+/** @brief Traffic of a link per second */
+struct LinkTrafficRate
+{
+    LinkTrafficRate() : receivedBytes(0), sentBytes(0), receivedPackets(0), sentPackets(0) {}
+    double receivedBytes;
+    double sentBytes;
+    double receivedPackets;
+    double sentPackets;
+};
+
+/**
+ * @brief Traffic counters and per-second history of one link
+ *
+ * The read and write paths of the link only add to atomic counters, which
+ * takes no lock. Once per second the counters are moved into the totals
+ * and into a ring of the samples of the last LINK_STATISTICS_HISTORY
+ * seconds. The sample timer runs in the thread the object was created in,
+ * the queries can be called from any thread.
+ */
+class LinkStatistics : public QObject
+{
+    Q_OBJECT
+public:
+    LinkStatistics(QObject* parent = 0);
+
+    /** @brief Count received bytes, lock-free, any thread */
+    void countReceived(int bytes, int packets = 1) {
+        receivedBytesPending.fetchAndAddRelaxed(bytes);
+        receivedPacketsPending.fetchAndAddRelaxed(packets);
+    }
+    /** @brief Count sent bytes, lock-free, any thread */
+    void countSent(int bytes, int packets = 1) {
+        sentBytesPending.fetchAndAddRelaxed(bytes);
+        sentPacketsPending.fetchAndAddRelaxed(packets);
+    }
+    /** @brief Count bytes forwarded to the link from other links, lock-free, any thread */
+    void countForwarded(int bytes) {
+        forwardedBytesPending.fetchAndAddRelaxed(bytes);
+    }
+
+    quint64 getReceivedBytes() const;
+    quint64 getSentBytes() const;
+    quint64 getReceivedPackets() const;
+    quint64 getSentPackets() const;
+    quint64 getForwardedBytes() const;
+
+    /** @brief Get up to the last seconds samples, oldest first */
+    QVector<LinkTrafficSample> getHistory(int seconds = LINK_STATISTICS_HISTORY) const;
+    /** @brief Get the number of samples in the history */
+    int getHistorySize() const;
+    /** @brief Mean traffic per second over the last samples */
+    LinkTrafficRate getRate(int seconds = 1) const;
+    /** @brief Highest traffic per second of any sample in the history, per field */
+    LinkTrafficRate getMaxRate() const;
+    /** @brief Mean traffic per second since the statistics were reset */
+    LinkTrafficRate getAverageRate() const;
+
+public slots:
+    /** @brief Close the current sample interval, done every second by the timer */
+    void sample();
+    /** @brief Clear the counters and the history */
+    void reset();
+
+signals:
+    /** @brief A new sample was added to the history */
+    void sampled();
+
+protected:
+    QAtomicInt receivedBytesPending; ///< Counted since the last sample
+    QAtomicInt sentBytesPending;
+    QAtomicInt receivedPacketsPending;
+    QAtomicInt sentPacketsPending;
+    QAtomicInt forwardedBytesPending;
+
+    mutable QMutex mutex;   ///< Protects everything below, never taken by the counting
+    quint64 receivedBytes;
+    quint64 sentBytes;
+    quint64 receivedPackets;
+    quint64 sentPackets;
+    quint64 forwardedBytes;
+    QVector<LinkTrafficSample> history; ///< Ring of the last samples
+    int next;               ///< Position of the next sample in history
+    QElapsedTimer clock;    ///< Started at the last reset
+    qint64 lastSample;      ///< Time of the last sample on clock in milliseconds
+    QTimer timer;
+};
+
+#endif // LINKSTATISTICS_H
@@ -0,0 +1,260 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class MAVLinkFrameScanner
+ */
+
+#include <string.h>
+#include <algorithm>
+
+#include "MAVLinkFrameScanner.h"
+
+#if MAVLINK_CRC_EXTRA
+static const quint8 messageCrcs[256] = MAVLINK_MESSAGE_CRCS;
+#endif
+#if MAVLINK_CHECK_MESSAGE_LENGTH
+static const quint8 messageLengths[256] = MAVLINK_MESSAGE_LENGTHS;
+#endif
+
+/** Start sign of the deprecated MAVLink 0.9 protocol */
+static const quint8 mavlink09Stx = 0x55;
+
+/**
+ * @brief Lookup table for the X.25 checksum used by MAVLink
+ *
+ * crc_accumulate() is linear in the xor of the data byte and the low CRC
+ * byte, the table holds its result for all 256 values starting from zero.
+ */
+class MAVLinkCrcTable
+{
+public:
+    MAVLinkCrcTable()
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            quint16 crc = 0;
+            crc_accumulate(i, &crc);
+            table[i] = crc;
+        }
+    }
+
+    quint16 calculate(const quint8* data, int length, quint16 crc) const
+    {
+        const quint8* end = data + length;
+        while (data != end)
+        {
+            crc = (crc >> 8) ^ table[(crc ^ *data++) & 0xFF];
+        }
+        return crc;
+    }
+
+private:
+    quint16 table[256];
+};
+
+static const MAVLinkCrcTable crcTable;
+
+MAVLinkFrameScanner::MAVLinkFrameScanner() :
+    input(NULL),
+    inputLen(0),
+    inputPos(0)
+{
+    reset();
+}
+
+void MAVLinkFrameScanner::reset()
+{
+    input = NULL;
+    inputLen = 0;
+    inputPos = 0;
+    partialLen = 0;
+    receivedFrames = 0;
+    parseErrors = 0;
+    skippedBytes = 0;
+    v09Markers = 0;
+}
+
+void MAVLinkFrameScanner::setInput(const char* data, int length)
+{
+    input = reinterpret_cast<const quint8*>(data);
+    inputLen = (data) ? length : 0;
+    inputPos = 0;
+}
+
+void MAVLinkFrameScanner::skip(int bytes)
+{
+    inputPos = qMin(inputPos + qMax(bytes, 0), inputLen);
+}
+
+bool MAVLinkFrameScanner::isValidFrame(const char* data, int length) const
+{
+    const quint8* frame = reinterpret_cast<const quint8*>(data);
+    if (length < 2 || frame[0] != MAVLINK_STX || length < frameLength(frame[1])) return false;
+    quint16 checksum;
+    return checkFrame(frame, &checksum);
+}
+
+/**
+ * The frame has to be complete, i.e. frameLength(frame[1]) bytes
+ * have to be readable starting at frame.
+ */
+bool MAVLinkFrameScanner::checkFrame(const quint8* frame, quint16* checksum) const
+{
+    const quint8 len = frame[1];
+#if (MAVLINK_MAX_PAYLOAD_LEN < 255)
+    if (len > MAVLINK_MAX_PAYLOAD_LEN) return false;
+#endif
+#if MAVLINK_CHECK_MESSAGE_LENGTH
+    if (len != messageLengths[frame[5]]) return false;
+#endif
+    // Checksum covers length, sequence, system, component, message id and payload
+    quint16 crc = crcTable.calculate(frame + 1, MAVLINK_CORE_HEADER_LEN + len, X25_INIT_CRC);
+#if MAVLINK_CRC_EXTRA
+    crc = crcTable.calculate(&messageCrcs[frame[5]], 1, crc);
+#endif
+    *checksum = crc;
+    return (frame[MAVLINK_NUM_HEADER_BYTES + len] == (crc & 0xFF) &&
+            frame[MAVLINK_NUM_HEADER_BYTES + len + 1] == (crc >> 8));
+}
+
+void MAVLinkFrameScanner::decodeFrame(const quint8* frame, quint16 checksum, mavlink_message_t* message)
+{
+    // The header fields and the payload (followed by the two CRC bytes) are
+    // laid out in the message struct exactly as on the wire, starting at the
+    // magic field. This is the inverse of mavlink_msg_to_send_buffer().
+    memcpy(&message->magic, frame, frameLength(frame[1]));
+    message->checksum = checksum;
+    receivedFrames++;
+}
+
+void MAVLinkFrameScanner::countSkipped(const quint8* begin, const quint8* end)
+{
+    if (end <= begin) return;
+    skippedBytes += (end - begin);
+    v09Markers += std::count(begin, end, mavlink09Stx);
+}
+
+bool MAVLinkFrameScanner::completePartial(mavlink_message_t* message)
+{
+    while (partialLen > 0)
+    {
+        // Resynchronize on the next start sign in the buffered bytes
+        if (partial[0] != MAVLINK_STX)
+        {
+            const quint8* next = static_cast<const quint8*>(memchr(partial, MAVLINK_STX, partialLen));
+            if (!next)
+            {
+                countSkipped(partial, partial + partialLen);
+                partialLen = 0;
+                break;
+            }
+            countSkipped(partial, next);
+            consumePartial(next - partial);
+        }
+
+        // The length byte is needed to know how long the frame is
+        int needed = (partialLen < 2) ? 2 : frameLength(partial[1]);
+        if (partialLen < needed)
+        {
+            int copy = qMin(needed - partialLen, inputLen - inputPos);
+            memcpy(partial + partialLen, input + inputPos, copy);
+            partialLen += copy;
+            inputPos += copy;
+            // Block exhausted, wait for more data
+            if (partialLen < needed) return false;
+            // Got the length byte, now complete the frame
+            if (needed == 2) continue;
+        }
+
+        quint16 checksum;
+        if (checkFrame(partial, &checksum))
+        {
+            decodeFrame(partial, checksum, message);
+            // After a resynchronization the buffer can hold more than this frame
+            consumePartial(needed);
+            return true;
+        }
+
+        // Invalid frame, drop the start sign and search for the next one
+        parseErrors++;
+        countSkipped(partial, partial + 1);
+        consumePartial(1);
+    }
+    return false;
+}
+
+void MAVLinkFrameScanner::consumePartial(int bytes)
+{
+    partialLen -= bytes;
+    if (partialLen > 0) memmove(partial, partial + bytes, partialLen);
+}
+
+bool MAVLinkFrameScanner::nextMessage(mavlink_message_t* message)
+{
+    // First finish a frame which started in the previous block
+    if (partialLen > 0)
+    {
+        if (completePartial(message)) return true;
+        if (partialLen > 0) return false;
+    }
+
+    while (inputPos < inputLen)
+    {
+        const quint8* begin = input + inputPos;
+        const quint8* stx = static_cast<const quint8*>(memchr(begin, MAVLINK_STX, inputLen - inputPos));
+        if (!stx)
+        {
+            countSkipped(begin, input + inputLen);
+            inputPos = inputLen;
+            return false;
+        }
+        countSkipped(begin, stx);
+        inputPos = stx - input;
+
+        const int available = inputLen - inputPos;
+        if (available < 2 || available < frameLength(stx[1]))
+        {
+            // Incomplete frame, keep it until the next block arrives
+            memcpy(partial, stx, available);
+            partialLen = available;
+            inputPos = inputLen;
+            return false;
+        }
+
+        quint16 checksum;
+        if (checkFrame(stx, &checksum))
+        {
+            decodeFrame(stx, checksum, message);
+            inputPos += frameLength(stx[1]);
+            return true;
+        }
+
+        // Not a valid frame, resynchronize on the next start sign
+        parseErrors++;
+        countSkipped(stx, stx + 1);
+        inputPos++;
+    }
+    return false;
+}
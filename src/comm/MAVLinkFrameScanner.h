@@ -0,0 +1,146 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class MAVLinkFrameScanner
+ */
+
+#ifndef MAVLINKFRAMESCANNER_H
+#define MAVLINKFRAMESCANNER_H
+
+#include <QtGlobal>
+#include "QGCMAVLink.h"
+
+/**
+ * @brief Block-oriented MAVLink frame parser
+ *
+ * Instead of feeding every byte through the mavlink_parse_char() state
+ * machine, the scanner searches the received block for the start sign,
+ * checks the length and the CRC of the complete frame in one go and
+ * copies the frame into the message struct. Only an incomplete frame at
+ * the end of a block is kept until the next block of the same link arrives.
+ *
+ * One scanner instance has to be used per link, it replaces the per-channel
+ * parse state of mavlink_parse_char().
+ *
+ * Typical use:
+ * @code
+ * scanner.setInput(data.constData(), data.size());
+ * while (scanner.nextMessage(&message))
+ * {
+ *     // handle message
+ * }
+ * @endcode
+ */
+class MAVLinkFrameScanner
+{
+public:
+    MAVLinkFrameScanner();
+
+    /** @brief Drop any partial frame and reset all counters */
+    void reset();
+
+    /**
+     * @brief Set the block to scan
+     *
+     * The data is not copied, it has to stay valid until nextMessage()
+     * returned false. Bytes of an incomplete frame from the previous block
+     * are completed with the new data first.
+     */
+    void setInput(const char* data, int length);
+
+    /**
+     * @brief Get the next valid frame out of the current block
+     *
+     * @param message the decoded message, only valid if true is returned
+     * @return true if a message was decoded, false if the block is exhausted
+     */
+    bool nextMessage(mavlink_message_t* message);
+
+    /** @brief Skip bytes of the current block, e.g. out-of-band payload following a frame */
+    void skip(int bytes);
+
+    /**
+     * @brief Check if a complete, valid frame starts at data
+     *
+     * Does not touch the scan state, can be used to validate frames found
+     * by other means, e.g. the records of a log file.
+     * @param length number of readable bytes starting at data
+     */
+    bool isValidFrame(const char* data, int length) const;
+
+    /** @brief Position of the next unscanned byte in the current block */
+    int position() const {
+        return inputPos;
+    }
+    /** @brief Number of bytes kept from an incomplete frame */
+    int pendingBytes() const {
+        return partialLen;
+    }
+    /** @brief Number of successfully decoded frames */
+    quint64 getReceivedFrames() const {
+        return receivedFrames;
+    }
+    /** @brief Number of frames dropped due to CRC or length errors */
+    quint64 getParseErrors() const {
+        return parseErrors;
+    }
+    /** @brief Number of bytes which could not be attributed to a valid frame */
+    quint64 getSkippedBytes() const {
+        return skippedBytes;
+    }
+    /** @brief Number of MAVLink 0.9 start signs seen outside of valid frames */
+    quint64 getVersion09Markers() const {
+        return v09Markers;
+    }
+
+    /** @brief Total length of a frame with the given payload length */
+    static int frameLength(quint8 payloadLength) {
+        return payloadLength + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+    }
+
+protected:
+    /** @brief Check length and CRC of the complete frame starting at the start sign */
+    bool checkFrame(const quint8* frame, quint16* checksum) const;
+    /** @brief Copy a checked frame into the message struct */
+    void decodeFrame(const quint8* frame, quint16 checksum, mavlink_message_t* message);
+    /** @brief Count bytes which were skipped while looking for the start sign */
+    void countSkipped(const quint8* begin, const quint8* end);
+    /** @brief Try to complete the buffered partial frame */
+    bool completePartial(mavlink_message_t* message);
+    /** @brief Remove bytes from the front of the buffered partial frame */
+    void consumePartial(int bytes);
+
+    const quint8* input;     ///< Current block
+    int inputLen;            ///< Length of the current block
+    int inputPos;            ///< Read position in the current block
+    quint8 partial[MAVLINK_MAX_PACKET_LEN]; ///< Incomplete frame from the last block
+    int partialLen;          ///< Number of valid bytes in partial
+    quint64 receivedFrames;
+    quint64 parseErrors;
+    quint64 skippedBytes;
+    quint64 v09Markers;
+};
+
+#endif // MAVLINKFRAMESCANNER_H
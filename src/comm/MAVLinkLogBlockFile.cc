@@ -0,0 +1,544 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class MAVLinkLogBlockFile
+ */
+
+#include <string.h>
+#include <algorithm>
+
+#include <QObject>
+#include <QFileInfo>
+
+#include "MAVLinkLogBlockFile.h"
+#include "MAVLinkLogReader.h"
+
+/** @brief Header of the file */
+struct MAVLinkLogBlockFileHeader
+{
+    char magic[8];
+    quint32 byteOrder;      ///< blockByteOrder as written by the host
+    quint32 version;
+};
+
+/** @brief Header of a block, followed by the compressed records */
+struct MAVLinkLogBlockHeader
+{
+    quint32 marker;
+    quint32 compressedSize;
+    quint32 rawSize;
+    quint32 records;
+    quint64 firstTime;
+    quint64 lastTime;
+};
+
+/** @brief Footer entry of a block */
+struct MAVLinkLogBlockIndexEntry
+{
+    qint64 offset;
+    quint32 rawSize;
+    quint32 records;
+    quint64 firstTime;
+    quint64 lastTime;
+};
+
+/** @brief End of the file, locates the footer */
+struct MAVLinkLogBlockTrailer
+{
+    qint64 indexOffset;
+    qint64 blockCount;
+    char magic[8];
+};
+
+static const char fileMagic[8] = { 'Q', 'G', 'C', 'L', 'B', 'L', 'K', '1' };
+static const char trailerMagic[8] = { 'Q', 'G', 'C', 'L', 'B', 'I', 'D', 'X' };
+static const quint32 blockByteOrder = 0x01020304;
+static const quint32 blockFileVersion = 1;
+static const quint32 blockMarker = 0x4b4c4251;   // "QBLK" on little endian hosts
+/** Compressed blocks are not much larger than their records, this bounds corrupted sizes */
+static const quint32 blockSizeLimit = 64 * 1024 * 1024;
+
+const int MAVLinkLogBlockFile::blockSize;
+const int MAVLinkLogBlockFile::compressionLevel;
+
+static bool blockTimeLess(const MAVLinkLogBlock& block, quint64 time)
+{
+    return block.lastTime < time;
+}
+
+static bool blockRawOffsetLess(qint64 offset, const MAVLinkLogBlock& block)
+{
+    return offset < block.rawOffset;
+}
+
+MAVLinkLogBlockFile::MAVLinkLogBlockFile() :
+    recovered(false),
+    writing(false)
+{
+}
+
+MAVLinkLogBlockFile::~MAVLinkLogBlockFile()
+{
+    close();
+}
+
+bool MAVLinkLogBlockFile::isBlockLog(const QString& fileName)
+{
+    QFile file(fileName);
+    MAVLinkLogBlockFileHeader header;
+    return file.open(QIODevice::ReadOnly) &&
+            file.read(reinterpret_cast<char*>(&header), sizeof(header)) == sizeof(header) &&
+            memcmp(header.magic, fileMagic, sizeof(fileMagic)) == 0;
+}
+
+bool MAVLinkLogBlockFile::isBlockLogName(const QString& fileName)
+{
+    return fileName.endsWith(".mavlinkz");
+}
+
+bool MAVLinkLogBlockFile::open(const QString& fileName)
+{
+    close();
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    MAVLinkLogBlockFileHeader header;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header) ||
+            memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0 ||
+            header.byteOrder != blockByteOrder || header.version != blockFileVersion)
+    {
+        file.close();
+        return false;
+    }
+
+    if (!readIndex())
+    {
+        blocks.clear();
+        scanBlocks();
+        recovered = true;
+    }
+    return true;
+}
+
+void MAVLinkLogBlockFile::close()
+{
+    if (writing)
+    {
+        finish();
+    }
+    if (file.isOpen())
+    {
+        file.close();
+    }
+    blocks.clear();
+    recovered = false;
+}
+
+qint64 MAVLinkLogBlockFile::rawSize() const
+{
+    return blocks.isEmpty() ? 0 : blocks.last().rawOffset + blocks.last().rawSize;
+}
+
+int MAVLinkLogBlockFile::findTime(quint64 time) const
+{
+    return std::lower_bound(blocks.begin(), blocks.end(), time, blockTimeLess) - blocks.begin();
+}
+
+int MAVLinkLogBlockFile::findRawOffset(qint64 offset) const
+{
+    // The last block starting at or before the offset
+    const int index = int(std::upper_bound(blocks.begin(), blocks.end(), offset, blockRawOffsetLess) - blocks.begin()) - 1;
+    if (index < 0 || offset >= blocks.at(index).rawOffset + blocks.at(index).rawSize)
+    {
+        return blocks.size();
+    }
+    return index;
+}
+
+void MAVLinkLogBlockFile::addBlock(MAVLinkLogBlock block)
+{
+    block.rawOffset = rawSize();
+    blocks.append(block);
+}
+
+bool MAVLinkLogBlockFile::readIndex()
+{
+    const qint64 size = file.size();
+    if (size < qint64(sizeof(MAVLinkLogBlockFileHeader) + sizeof(MAVLinkLogBlockTrailer)))
+    {
+        return false;
+    }
+
+    MAVLinkLogBlockTrailer trailer;
+    const qint64 indexEnd = size - sizeof(trailer);
+    if (!file.seek(indexEnd) ||
+            file.read(reinterpret_cast<char*>(&trailer), sizeof(trailer)) != sizeof(trailer) ||
+            memcmp(trailer.magic, trailerMagic, sizeof(trailerMagic)) != 0 ||
+            trailer.indexOffset < qint64(sizeof(MAVLinkLogBlockFileHeader)) ||
+            trailer.blockCount < 0 ||
+            trailer.blockCount > (indexEnd - trailer.indexOffset) / qint64(sizeof(MAVLinkLogBlockIndexEntry)) ||
+            trailer.indexOffset + trailer.blockCount * qint64(sizeof(MAVLinkLogBlockIndexEntry)) != indexEnd)
+    {
+        return false;
+    }
+
+    QByteArray data;
+    if (!file.seek(trailer.indexOffset) ||
+            (data = file.read(indexEnd - trailer.indexOffset)).size() != indexEnd - trailer.indexOffset)
+    {
+        return false;
+    }
+    blocks.reserve(trailer.blockCount);
+    for (qint64 i = 0; i < trailer.blockCount; i++)
+    {
+        MAVLinkLogBlockIndexEntry entry;
+        memcpy(&entry, data.constData() + i * sizeof(entry), sizeof(entry));
+        if (entry.offset < qint64(sizeof(MAVLinkLogBlockFileHeader)) || entry.offset >= trailer.indexOffset)
+        {
+            return false;
+        }
+        MAVLinkLogBlock block;
+        block.offset = entry.offset;
+        block.rawSize = entry.rawSize;
+        block.records = entry.records;
+        block.firstTime = entry.firstTime;
+        block.lastTime = entry.lastTime;
+        addBlock(block);
+    }
+    return true;
+}
+
+qint64 MAVLinkLogBlockFile::scanBlocks()
+{
+    const qint64 size = file.size();
+    qint64 offset = sizeof(MAVLinkLogBlockFileHeader);
+    MAVLinkLogBlockHeader header;
+    while (file.seek(offset) &&
+           file.read(reinterpret_cast<char*>(&header), sizeof(header)) == sizeof(header) &&
+           header.marker == blockMarker &&
+           header.compressedSize <= blockSizeLimit &&
+           offset + qint64(sizeof(header)) + header.compressedSize <= size)
+    {
+        MAVLinkLogBlock block;
+        block.offset = offset;
+        block.rawSize = header.rawSize;
+        block.records = header.records;
+        block.firstTime = header.firstTime;
+        block.lastTime = header.lastTime;
+        addBlock(block);
+        offset += sizeof(header) + header.compressedSize;
+    }
+    return offset;
+}
+
+bool MAVLinkLogBlockFile::readBlock(int index, QByteArray* records)
+{
+    if (index < 0 || index >= blocks.size())
+    {
+        return false;
+    }
+    const MAVLinkLogBlock& block = blocks.at(index);
+    MAVLinkLogBlockHeader header;
+    if (!file.seek(block.offset) ||
+            file.read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header) ||
+            header.marker != blockMarker || header.rawSize != block.rawSize ||
+            header.compressedSize > blockSizeLimit)
+    {
+        return false;
+    }
+    QByteArray compressed = file.read(header.compressedSize);
+    if (compressed.size() != int(header.compressedSize))
+    {
+        return false;
+    }
+    *records = qUncompress(compressed);
+    return records->size() == int(block.rawSize);
+}
+
+bool MAVLinkLogBlockFile::create(const QString& fileName)
+{
+    close();
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadWrite))
+    {
+        return false;
+    }
+
+    MAVLinkLogBlockFileHeader header;
+    if (file.size() == 0)
+    {
+        memcpy(header.magic, fileMagic, sizeof(fileMagic));
+        header.byteOrder = blockByteOrder;
+        header.version = blockFileVersion;
+        if (file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header))
+        {
+            file.close();
+            return false;
+        }
+    }
+    else
+    {
+        // Never overwrite anything but a block log of this host
+        if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header) ||
+                memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0 ||
+                header.byteOrder != blockByteOrder || header.version != blockFileVersion)
+        {
+            file.close();
+            return false;
+        }
+        // Continue behind the last block, the footer is written again by finish()
+        qint64 end;
+        if (readIndex())
+        {
+            end = blocks.isEmpty() ? qint64(sizeof(header)) : blocks.last().offset;
+            if (!blocks.isEmpty())
+            {
+                MAVLinkLogBlockHeader last;
+                if (!file.seek(end) || file.read(reinterpret_cast<char*>(&last), sizeof(last)) != sizeof(last))
+                {
+                    file.close();
+                    blocks.clear();
+                    return false;
+                }
+                end += sizeof(last) + last.compressedSize;
+            }
+        }
+        else
+        {
+            blocks.clear();
+            end = scanBlocks();
+        }
+        if (!file.resize(end) || !file.seek(end))
+        {
+            file.close();
+            blocks.clear();
+            return false;
+        }
+    }
+    writing = true;
+    return true;
+}
+
+bool MAVLinkLogBlockFile::appendBlock(const QByteArray& records, int count, quint64 firstTime, quint64 lastTime)
+{
+    if (!writing || records.isEmpty())
+    {
+        return false;
+    }
+    const QByteArray compressed = qCompress(records, compressionLevel);
+
+    MAVLinkLogBlockHeader header;
+    header.marker = blockMarker;
+    header.compressedSize = compressed.size();
+    header.rawSize = records.size();
+    header.records = count;
+    header.firstTime = firstTime;
+    header.lastTime = lastTime;
+
+    const qint64 offset = file.pos();
+    if (file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header) ||
+            file.write(compressed) != compressed.size() || !file.flush())
+    {
+        // Drop a partial block, the next one is written in its place
+        file.resize(offset);
+        file.seek(offset);
+        return false;
+    }
+
+    MAVLinkLogBlock block;
+    block.offset = offset;
+    block.rawSize = header.rawSize;
+    block.records = header.records;
+    block.firstTime = firstTime;
+    block.lastTime = lastTime;
+    addBlock(block);
+    return true;
+}
+
+bool MAVLinkLogBlockFile::finish()
+{
+    if (!writing)
+    {
+        return false;
+    }
+    writing = false;
+
+    QByteArray index;
+    index.reserve(blocks.size() * sizeof(MAVLinkLogBlockIndexEntry) + sizeof(MAVLinkLogBlockTrailer));
+    foreach (const MAVLinkLogBlock& block, blocks)
+    {
+        MAVLinkLogBlockIndexEntry entry;
+        entry.offset = block.offset;
+        entry.rawSize = block.rawSize;
+        entry.records = block.records;
+        entry.firstTime = block.firstTime;
+        entry.lastTime = block.lastTime;
+        index.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    }
+    MAVLinkLogBlockTrailer trailer;
+    trailer.indexOffset = file.pos();
+    trailer.blockCount = blocks.size();
+    memcpy(trailer.magic, trailerMagic, sizeof(trailerMagic));
+    index.append(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+
+    // Without the footer the log stays readable by walking the blocks
+    const bool result = file.write(index) == index.size() && file.flush();
+    file.close();
+    blocks.clear();
+    return result;
+}
+
+/**
+ * The destination is written to a temporary file next to it and only
+ * replaced once the conversion succeeded, a failed conversion leaves an
+ * existing destination untouched.
+ */
+bool MAVLinkLogBlockFile::convert(const QString& from, const QString& to, QString* error)
+{
+    QString message;
+    const QFileInfo source(from);
+    const QFileInfo target(to);
+    const QString temporary = to + ".part";
+    if (!source.isFile() || !source.isReadable())
+    {
+        message = QObject::tr("Can't read the log %1").arg(from);
+    }
+    else if (source.absoluteFilePath() == target.absoluteFilePath() ||
+             (target.exists() && source.canonicalFilePath() == target.canonicalFilePath()))
+    {
+        message = QObject::tr("Can't convert %1 into itself").arg(from);
+    }
+    else if (isBlockLog(from))
+    {
+        MAVLinkLogBlockFile input;
+        QFile output(temporary);
+        if (!input.open(from))
+        {
+            message = QObject::tr("Can't read the block log %1").arg(from);
+        }
+        else if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            message = QObject::tr("Can't write %1").arg(to);
+        }
+        else
+        {
+            QByteArray records;
+            for (int i = 0; i < input.count() && message.isEmpty(); i++)
+            {
+                if (!input.readBlock(i, &records))
+                {
+                    message = QObject::tr("Block %1 of %2 is corrupted").arg(i).arg(from);
+                }
+                else if (output.write(records) != records.size())
+                {
+                    message = QObject::tr("Writing %1 failed").arg(to);
+                }
+            }
+            if (!output.flush() && message.isEmpty())
+            {
+                message = QObject::tr("Writing %1 failed").arg(to);
+            }
+            output.close();
+        }
+    }
+    else
+    {
+        MAVLinkLogReader input;
+        MAVLinkLogBlockFile output;
+        // A stale temporary file of an aborted conversion is not a valid block log
+        QFile::remove(temporary);
+        if (!input.open(from))
+        {
+            message = QObject::tr("Can't read the log %1").arg(from);
+        }
+        else if (!output.create(temporary))
+        {
+            message = QObject::tr("Can't write %1").arg(to);
+        }
+        else
+        {
+            // Invalid data between the records is dropped
+            input.setValidateFrames(true);
+            MAVLinkLogFrame frame;
+            QByteArray records;
+            records.reserve(blockSize + MAVLinkLogReader::timeLen + MAVLINK_MAX_PACKET_LEN);
+            int count = 0;
+            int total = 0;
+            quint64 firstTime = 0;
+            quint64 lastTime = 0;
+            bool more = true;
+            while (more && message.isEmpty())
+            {
+                more = input.next(&frame);
+                if (more)
+                {
+                    if (count == 0) firstTime = frame.time;
+                    lastTime = frame.time;
+                    records.append(reinterpret_cast<const char*>(&frame.time), MAVLinkLogReader::timeLen);
+                    records.append(frame.data, frame.length);
+                    count++;
+                    total++;
+                }
+                if ((records.size() >= blockSize || !more) && count > 0)
+                {
+                    if (!output.appendBlock(records, count, firstTime, lastTime))
+                    {
+                        message = QObject::tr("Writing %1 failed").arg(to);
+                    }
+                    records.resize(0);
+                    count = 0;
+                }
+            }
+            if (!output.finish() && message.isEmpty())
+            {
+                message = QObject::tr("Writing %1 failed").arg(to);
+            }
+            // Not a single valid record, e.g. a binary dataflash log
+            if (total == 0 && message.isEmpty())
+            {
+                message = QObject::tr("%1 is not a MAVLink log").arg(from);
+            }
+        }
+    }
+
+    if (message.isEmpty())
+    {
+        QFile::remove(to);
+        if (!QFile::rename(temporary, to))
+        {
+            message = QObject::tr("Can't replace %1").arg(to);
+        }
+    }
+    if (!message.isEmpty())
+    {
+        QFile::remove(temporary);
+    }
+
+    if (error) *error = message;
+    return message.isEmpty();
+}
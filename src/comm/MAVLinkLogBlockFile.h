@@ -0,0 +1,175 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class MAVLinkLogBlockFile
+ */
+
+#ifndef MAVLINKLOGBLOCKFILE_H
+#define MAVLINKLOGBLOCKFILE_H
+
+#include <QFile>
+#include <QVector>
+#include <QString>
+#include <QByteArray>
+
+/** @brief Position and time range of one compressed block of a block log */
+struct MAVLinkLogBlock
+{
+    qint64 offset;      ///< File offset of the block header
+    qint64 rawOffset;   ///< Offset of the first record in the uncompressed log
+    quint32 rawSize;    ///< Bytes of the uncompressed records
+    quint32 records;
+    quint64 firstTime;  ///< Timestamp of the first record in microseconds
+    quint64 lastTime;   ///< Timestamp of the last record in microseconds
+};
+
+/**
+ * @brief Compressed MAVLink log made of independently readable blocks
+ *
+ * A block log holds the records of a raw MAVLink log (see MAVLinkLogWriter)
+ * in blocks of about blockSize uncompressed bytes. Every block is compressed
+ * on its own and never splits a record, so any block can be read without
+ * the ones before it. The file consists of
+ *
+ * - a header with magic and byte order
+ * - the blocks, each a header with sizes, record count and time range
+ *   followed by the compressed records
+ * - a footer with the position and time range of every block, followed by
+ *   a trailer locating the footer
+ *
+ * Seeking to a time therefore reads the footer and decompresses a single
+ * block. A log without footer, e.g. after a crash or while it is still
+ * written, is indexed by walking the block headers instead.
+ *
+ * Offsets into the records are those of the uncompressed log, as if the
+ * blocks were concatenated. MAVLinkLogReader reads block logs through
+ * these offsets, the rest of the replay does not know about the blocks.
+ *
+ * The integers are stored in host byte order like the records themselves,
+ * logs are rejected on a host with a different byte order.
+ */
+class MAVLinkLogBlockFile
+{
+public:
+    MAVLinkLogBlockFile();
+    ~MAVLinkLogBlockFile();
+
+    /** @brief Open a block log for reading and load its block index */
+    bool open(const QString& fileName);
+    /** @brief Close the file, a file opened with create() is finished first */
+    void close();
+    bool isOpen() const {
+        return file.isOpen();
+    }
+    QString getFileName() const {
+        return file.fileName();
+    }
+    /** @brief The footer was missing, the blocks were found by walking the file */
+    bool isRecovered() const {
+        return recovered;
+    }
+
+    /** @brief Number of blocks */
+    int count() const {
+        return blocks.size();
+    }
+    const MAVLinkLogBlock& block(int index) const {
+        return blocks.at(index);
+    }
+    /** @brief Size of the uncompressed records of all blocks */
+    qint64 rawSize() const;
+    /** @brief Timestamp of the first record, 0 if the log is empty */
+    quint64 startTime() const {
+        return blocks.isEmpty() ? 0 : blocks.first().firstTime;
+    }
+    /** @brief Timestamp of the last record, 0 if the log is empty */
+    quint64 endTime() const {
+        return blocks.isEmpty() ? 0 : blocks.last().lastTime;
+    }
+    /** @brief First block ending at or after a time, count() if none */
+    int findTime(quint64 time) const;
+    /** @brief Block containing an offset of the uncompressed log, count() if none */
+    int findRawOffset(qint64 offset) const;
+    /** @brief Decompress the records of one block */
+    bool readBlock(int index, QByteArray* records);
+
+    /**
+     * @brief Open a block log for writing
+     *
+     * An existing block log is continued, its footer is removed until
+     * finish() writes the new one. Other existing files are not touched.
+     */
+    bool create(const QString& fileName);
+    /**
+     * @brief Compress and write complete records as one block
+     *
+     * @param records records as written to a raw log
+     * @param count number of records
+     * @param firstTime timestamp of the first record
+     * @param lastTime timestamp of the last record
+     */
+    bool appendBlock(const QByteArray& records, int count, quint64 firstTime, quint64 lastTime);
+    /** @brief Write the footer and close the file */
+    bool finish();
+    /** @brief File handle of the open file, e.g. to sync it */
+    int handle() const {
+        return file.handle();
+    }
+
+    /** @brief Check the header of a file */
+    static bool isBlockLog(const QString& fileName);
+    /** @brief Block logs are written to files with this suffix, see MAVLinkLogWriter */
+    static bool isBlockLogName(const QString& fileName);
+    /**
+     * @brief Convert a raw log into a block log or a block log into a raw log
+     *
+     * The direction is chosen by the header of the source. Invalid records
+     * of a raw log are skipped, a raw log without a single valid record is
+     * rejected. An existing destination is only replaced on success.
+     * @param error set to the reason if the conversion fails
+     */
+    static bool convert(const QString& from, const QString& to, QString* error = NULL);
+
+    static const int blockSize = 256 * 1024;    ///< Uncompressed bytes per block
+    static const int compressionLevel = 1;      ///< zlib level, favours speed
+
+protected:
+    /** @brief Read the footer */
+    bool readIndex();
+    /**
+     * @brief Index the blocks by walking their headers
+     * @return file offset behind the last complete block
+     */
+    qint64 scanBlocks();
+    /** @brief Add a block to the index, computing its uncompressed offset */
+    void addBlock(MAVLinkLogBlock block);
+
+    QFile file;
+    QVector<MAVLinkLogBlock> blocks;
+    bool recovered;
+    bool writing;
+};
+
+#endif // MAVLINKLOGBLOCKFILE_H
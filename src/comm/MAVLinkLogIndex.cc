@@ -0,0 +1,232 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class MAVLinkLogIndex
+ */
+
+#include <string.h>
+#include <limits.h>
+#include <algorithm>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+
+#include "MAVLinkLogIndex.h"
+#include "MAVLinkLogReader.h"
+
+/** @brief Header of the sidecar file, followed by the entries in host byte order */
+struct MAVLinkLogIndexHeader
+{
+    char magic[8];
+    quint32 byteOrder;      ///< indexByteOrder as written by the host
+    quint32 entrySize;
+    qint64 logSize;
+    qint64 logModified;
+    qint64 entryCount;
+};
+
+static const char indexMagic[8] = { 'Q', 'G', 'C', 'L', 'I', 'D', 'X', '1' };
+static const quint32 indexByteOrder = 0x01020304;
+
+static bool entryTimeLess(const MAVLinkLogIndexEntry& entry, quint64 time)
+{
+    return entry.time < time;
+}
+
+static bool entryOffsetLess(const MAVLinkLogIndexEntry& entry, qint64 offset)
+{
+    return entry.offset < offset;
+}
+
+MAVLinkLogIndex::MAVLinkLogIndex(QObject* parent) :
+    QThread(parent),
+    logSize(0),
+    logModified(0),
+    resyncs(0),
+    ready(false),
+    loadedFromFile(false),
+    cancelRequested(false)
+{
+}
+
+MAVLinkLogIndex::~MAVLinkLogIndex()
+{
+    cancel();
+}
+
+QString MAVLinkLogIndex::indexFileName(const QString& logFileName)
+{
+    return logFileName + ".idx";
+}
+
+void MAVLinkLogIndex::build(const QString& fileName)
+{
+    cancel();
+    logFileName = fileName;
+    entries.clear();
+    resyncs = 0;
+    loadedFromFile = false;
+    cancelRequested = false;
+    start(QThread::LowPriority);
+}
+
+void MAVLinkLogIndex::cancel()
+{
+    ready = false;
+    if (isRunning())
+    {
+        cancelRequested = true;
+        wait();
+    }
+}
+
+int MAVLinkLogIndex::findTime(quint64 time) const
+{
+    return std::lower_bound(entries.begin(), entries.end(), time, entryTimeLess) - entries.begin();
+}
+
+int MAVLinkLogIndex::findOffset(qint64 offset) const
+{
+    return std::lower_bound(entries.begin(), entries.end(), offset, entryOffsetLess) - entries.begin();
+}
+
+void MAVLinkLogIndex::run()
+{
+    QFileInfo info(logFileName);
+    logSize = info.size();
+    logModified = info.lastModified().toMSecsSinceEpoch();
+
+    if (load())
+    {
+        loadedFromFile = true;
+        ready = true;
+        return;
+    }
+    if (scan())
+    {
+        // Indexing works without the sidecar, e.g. in a read-only directory
+        save();
+        ready = true;
+    }
+}
+
+bool MAVLinkLogIndex::scan()
+{
+    MAVLinkLogReader reader;
+    if (!reader.open(logFileName))
+    {
+        return false;
+    }
+    // The index has to point to valid frames only
+    reader.setValidateFrames(true);
+
+    MAVLinkLogFrame frame;
+    MAVLinkLogIndexEntry entry;
+    int percent = -1;
+    while (reader.next(&frame))
+    {
+        entry.offset = frame.offset;
+        entry.time = frame.time;
+        entries.append(entry);
+
+        if ((entries.size() & (progressInterval - 1)) == 0)
+        {
+            if (cancelRequested)
+            {
+                return false;
+            }
+            if (percent != int(frame.offset * 100 / reader.size()))
+            {
+                percent = int(frame.offset * 100 / reader.size());
+                emit progressChanged(percent);
+            }
+        }
+    }
+    resyncs = reader.getResyncs();
+    emit progressChanged(100);
+    return true;
+}
+
+bool MAVLinkLogIndex::load()
+{
+    QFile file(indexFileName(logFileName));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    MAVLinkLogIndexHeader header;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header) ||
+            memcmp(header.magic, indexMagic, sizeof(indexMagic)) != 0 ||
+            header.byteOrder != indexByteOrder ||
+            header.entrySize != sizeof(MAVLinkLogIndexEntry) ||
+            header.logSize != logSize ||
+            header.logModified != logModified ||
+            header.entryCount < 0 ||
+            header.entryCount > INT_MAX / qint64(sizeof(MAVLinkLogIndexEntry)) ||
+            file.size() != qint64(sizeof(header)) + header.entryCount * qint64(sizeof(MAVLinkLogIndexEntry)))
+    {
+        return false;
+    }
+
+    entries.resize(header.entryCount);
+    const qint64 bytes = header.entryCount * sizeof(MAVLinkLogIndexEntry);
+    if (file.read(reinterpret_cast<char*>(entries.data()), bytes) != bytes)
+    {
+        entries.clear();
+        return false;
+    }
+    return true;
+}
+
+bool MAVLinkLogIndex::save()
+{
+    QFile file(indexFileName(logFileName));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+
+    MAVLinkLogIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, indexMagic, sizeof(indexMagic));
+    header.byteOrder = indexByteOrder;
+    header.entrySize = sizeof(MAVLinkLogIndexEntry);
+    header.logSize = logSize;
+    header.logModified = logModified;
+    header.entryCount = entries.size();
+
+    const qint64 bytes = entries.size() * qint64(sizeof(MAVLinkLogIndexEntry));
+    if (file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header) ||
+            file.write(reinterpret_cast<const char*>(entries.constData()), bytes) != bytes)
+    {
+        // A partial sidecar fails the size check on load, remove it anyway
+        file.close();
+        file.remove();
+        return false;
+    }
+    return true;
+}
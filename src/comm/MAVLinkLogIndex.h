@@ -0,0 +1,146 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class MAVLinkLogIndex
+ */
+
+#ifndef MAVLINKLOGINDEX_H
+#define MAVLINKLOGINDEX_H
+
+#include <QThread>
+#include <QVector>
+#include <QString>
+
+/** @brief Position and timestamp of one record of a MAVLink log */
+struct MAVLinkLogIndexEntry
+{
+    qint64 offset;  ///< File offset of the record, i.e. of its timestamp
+    quint64 time;   ///< Timestamp of the record in microseconds
+};
+
+/**
+ * @brief Frame index of a MAVLink log file
+ *
+ * A MAVLink log consists of records of an 8 byte timestamp followed by the
+ * frame at its encoded length, see MAVLinkLogWriter. The records therefore
+ * can't be located by arithmetic. The index holds the offset and the
+ * timestamp of every record, which turns seeking to a packet index into a
+ * lookup and seeking to a time into a binary search.
+ *
+ * build() creates the index in a background thread, reading the log with
+ * MAVLinkLogReader. The result is stored
+ * in a sidecar file next to the log (see indexFileName()) and reused as
+ * long as size and modification time of the log did not change. Records
+ * with an invalid frame are skipped, the scan resynchronizes on the next
+ * valid frame.
+ *
+ * The accessors may only be used once isReady() returned true.
+ */
+class MAVLinkLogIndex : public QThread
+{
+    Q_OBJECT
+
+public:
+    MAVLinkLogIndex(QObject* parent = 0);
+    ~MAVLinkLogIndex();
+
+    /** @brief Start indexing a log file, a running build is cancelled */
+    void build(const QString& logFileName);
+    /** @brief Stop a running build, the index stays unusable */
+    void cancel();
+
+    /** @brief The index of the log is complete */
+    bool isReady() const {
+        return ready && isFinished();
+    }
+    /** @brief The index was read from the sidecar file instead of scanning the log */
+    bool isLoadedFromFile() const {
+        return loadedFromFile;
+    }
+    QString getLogFileName() const {
+        return logFileName;
+    }
+
+    /** @brief Number of records */
+    int count() const {
+        return entries.size();
+    }
+    qint64 offset(int record) const {
+        return entries.at(record).offset;
+    }
+    quint64 time(int record) const {
+        return entries.at(record).time;
+    }
+    /** @brief Timestamp of the first record, 0 if the log is empty */
+    quint64 startTime() const {
+        return entries.isEmpty() ? 0 : entries.first().time;
+    }
+    /** @brief Timestamp of the last record, 0 if the log is empty */
+    quint64 endTime() const {
+        return entries.isEmpty() ? 0 : entries.last().time;
+    }
+    /**
+     * @brief Find the first record at or after a time
+     *
+     * The timestamps are expected to be ascending, as written by the logger.
+     * @return record index, count() if all records are older
+     */
+    int findTime(quint64 time) const;
+    /** @brief Find the first record starting at or after a file offset, count() if none */
+    int findOffset(qint64 offset) const;
+    /** @brief Number of times the scan had to skip an invalid record */
+    int getResyncs() const {
+        return resyncs;
+    }
+
+    /** @brief Name of the sidecar file of a log file */
+    static QString indexFileName(const QString& logFileName);
+
+signals:
+    /** @brief Progress of the log scan in percent */
+    void progressChanged(int percent);
+
+protected:
+    void run();
+    /** @brief Scan all records of the log file */
+    bool scan();
+    /** @brief Read the sidecar file if it matches the log */
+    bool load();
+    /** @brief Write the sidecar file */
+    bool save();
+
+    static const int progressInterval = 4096;   ///< Records between progress reports, a power of two
+
+    QString logFileName;
+    qint64 logSize;
+    qint64 logModified;         ///< Modification time of the log in ms since epoch
+    QVector<MAVLinkLogIndexEntry> entries;
+    int resyncs;
+    volatile bool ready;
+    volatile bool loadedFromFile;
+    volatile bool cancelRequested;
+};
+
+#endif // MAVLINKLOGINDEX_H
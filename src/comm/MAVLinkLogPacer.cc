@@ -0,0 +1,291 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class MAVLinkLogPacer
+ */
+
+#include "MAVLinkLogPacer.h"
+
+MAVLinkLogPacer::MAVLinkLogPacer(QObject* parent) :
+    QThread(parent),
+    link(NULL),
+    stopRequested(false),
+    paused(false),
+    anchored(false),
+    seekOffset(-1),
+    speed(1.0),
+    anchorTime(0),
+    anchorClock(0),
+    maxDrift(50000000),
+    pendingBatches(0),
+    generation(0),
+    driftCorrections(0),
+    offset(0),
+    frames(0),
+    batches(0),
+    driftSum(0),
+    maxDriftSeen(0),
+    lastProgress(0)
+{
+    qRegisterMetaType<MAVLinkLogBatch>("MAVLinkLogBatch");
+    connect(this, SIGNAL(batchReady(MAVLinkLogBatch)), this, SLOT(deliverBatch(MAVLinkLogBatch)), Qt::QueuedConnection);
+    clock.start();
+}
+
+MAVLinkLogPacer::~MAVLinkLogPacer()
+{
+    stop();
+}
+
+bool MAVLinkLogPacer::start(const QString& fileName, LinkInterface* link, qint64 offset)
+{
+    stop();
+    if (!reader.open(fileName) || !reader.seek(offset))
+    {
+        reader.close();
+        return false;
+    }
+    this->link = link;
+    this->offset = offset;
+    stopRequested = false;
+    paused = false;
+    anchored = false;
+    seekOffset = -1;
+    driftCorrections = 0;
+    frames = 0;
+    batches = 0;
+    driftSum = 0;
+    maxDriftSeen = 0;
+    lastProgress = 0;
+    QThread::start(QThread::HighestPriority);
+    return true;
+}
+
+void MAVLinkLogPacer::stop()
+{
+    if (isRunning())
+    {
+        mutex.lock();
+        stopRequested = true;
+        condition.wakeAll();
+        mutex.unlock();
+        wait();
+    }
+    // Drop the batches still queued to deliverBatch()
+    generation.ref();
+    reader.close();
+}
+
+void MAVLinkLogPacer::pause()
+{
+    QMutexLocker locker(&mutex);
+    paused = true;
+    condition.wakeAll();
+}
+
+void MAVLinkLogPacer::resume()
+{
+    QMutexLocker locker(&mutex);
+    paused = false;
+    anchored = false;
+    condition.wakeAll();
+}
+
+void MAVLinkLogPacer::seek(qint64 offset)
+{
+    QMutexLocker locker(&mutex);
+    seekOffset = offset;
+    generation.ref();
+    this->offset = offset;
+    condition.wakeAll();
+}
+
+/**
+ * The anchor is moved to the log time replayed right now, so the frames
+ * already waited for are not released early or late.
+ */
+void MAVLinkLogPacer::setSpeed(double speed)
+{
+    if (speed <= 0.0) return;
+    QMutexLocker locker(&mutex);
+    if (anchored)
+    {
+        const qint64 now = clock.nsecsElapsed();
+        anchorTime += qint64((now - anchorClock) / 1000.0 * this->speed);
+        anchorClock = now;
+    }
+    this->speed = speed;
+    condition.wakeAll();
+}
+
+void MAVLinkLogPacer::setMaxDrift(int milliseconds)
+{
+    QMutexLocker locker(&mutex);
+    maxDrift = milliseconds * qint64(1000000);
+}
+
+qint64 MAVLinkLogPacer::getMeanDrift() const
+{
+    return (batches > 0) ? driftSum / qint64(batches) : 0;
+}
+
+qint64 MAVLinkLogPacer::dueTime(quint64 time) const
+{
+    return anchorClock + qint64((qint64(time) - qint64(anchorTime)) * 1000.0 / speed);
+}
+
+void MAVLinkLogPacer::run()
+{
+    MAVLinkLogFrame frame;
+    bool pending = false;   // frame holds the next frame to release
+    bool ended = false;     // the end of the log was released
+    QMutexLocker locker(&mutex);
+    while (!stopRequested)
+    {
+        if (seekOffset >= 0)
+        {
+            if (reader.seek(seekOffset))
+            {
+                pending = false;
+                ended = false;
+            }
+            seekOffset = -1;
+            anchored = false;
+        }
+        if (paused || ended)
+        {
+            condition.wait(&mutex);
+            continue;
+        }
+        if (!pending && !reader.next(&frame))
+        {
+            // Nothing left after a seek to the end
+            MAVLinkLogBatch batch;
+            batch.frames = 0;
+            batch.due = clock.nsecsElapsed();
+            batch.time = 0;
+            batch.nextOffset = reader.position();
+            batch.generation = generation;
+            batch.last = true;
+            ended = true;
+            pendingBatches.ref();
+            emit batchReady(batch);
+            continue;
+        }
+        pending = true;
+
+        if (!anchored)
+        {
+            anchorTime = frame.time;
+            anchorClock = clock.nsecsElapsed();
+            anchored = true;
+        }
+        qint64 due = dueTime(frame.time);
+        qint64 now = clock.nsecsElapsed();
+
+        // Sleep until shortly before the frame is due, a change of the
+        // replay state wakes the thread up
+        const qint64 sleep = (due - now - spinTime) / 1000000;
+        if (sleep > 0)
+        {
+            condition.wait(&mutex, sleep);
+            continue;
+        }
+        if (int(pendingBatches) >= maxPendingBatches)
+        {
+            // The pipeline is behind, the waiting shows up as drift
+            condition.wait(&mutex, 1);
+            continue;
+        }
+        if (now < due)
+        {
+            locker.unlock();
+            while (now < due)
+            {
+                yieldCurrentThread();
+                now = clock.nsecsElapsed();
+            }
+            locker.relock();
+            // The replay state might have changed in the meantime
+            continue;
+        }
+
+        if (now - due > maxDrift)
+        {
+            // Continue in real time instead of rushing through the backlog
+            anchorTime = frame.time;
+            anchorClock = now;
+            due = now;
+            driftCorrections.ref();
+        }
+
+        // Release every frame due by now in one batch
+        MAVLinkLogBatch batch;
+        batch.frames = 0;
+        batch.due = due;
+        batch.generation = generation;
+        do
+        {
+            batch.bytes.append(frame.data, frame.length);
+            batch.time = frame.time;
+            batch.frames++;
+            pending = reader.next(&frame);
+        }
+        while (pending && batch.bytes.size() < maxBatchSize && dueTime(frame.time) <= now);
+        batch.nextOffset = pending ? frame.offset : reader.position();
+        batch.last = !pending;
+        ended = !pending;
+        pendingBatches.ref();
+        emit batchReady(batch);
+    }
+}
+
+void MAVLinkLogPacer::deliverBatch(const MAVLinkLogBatch& batch)
+{
+    pendingBatches.deref();
+    if (batch.generation != int(generation)) return;
+
+    offset = batch.nextOffset;
+    if (batch.frames > 0)
+    {
+        const qint64 drift = clock.nsecsElapsed() - batch.due;
+        driftSum += drift;
+        maxDriftSeen = qMax(maxDriftSeen, drift);
+        batches++;
+        frames += batch.frames;
+        emit bytesReady(link, batch.bytes);
+
+        const qint64 now = clock.elapsed();
+        if (now - lastProgress >= progressInterval || batch.last)
+        {
+            lastProgress = now;
+            emit timeChanged(batch.time);
+        }
+    }
+    if (batch.last)
+    {
+        emit endReached();
+    }
+}
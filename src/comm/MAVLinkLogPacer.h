@@ -0,0 +1,186 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class MAVLinkLogPacer
+ */
+
+#ifndef MAVLINKLOGPACER_H
+#define MAVLINKLOGPACER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QMetaType>
+
+#include "MAVLinkLogReader.h"
+
+class LinkInterface;
+
+/** @brief Frames of a MAVLink log released together by MAVLinkLogPacer */
+struct MAVLinkLogBatch
+{
+    QByteArray bytes;       ///< The frames without their timestamps
+    int frames;
+    qint64 due;             ///< Release time of the first frame on the clock of the pacer, in ns
+    quint64 time;           ///< Log time of the last frame in microseconds
+    qint64 nextOffset;      ///< Offset of the record following the batch
+    int generation;         ///< Batches of an older generation are dropped
+    bool last;              ///< The batch ends the log
+};
+
+Q_DECLARE_METATYPE(MAVLinkLogBatch)
+
+/**
+ * @brief Real-time replay of a MAVLink log at an adjustable speed
+ *
+ * A high priority thread reads the log with MAVLinkLogReader and releases
+ * the frames when they are due according to their timestamps and the
+ * speed. The due times are computed from an anchor, i.e. a log time and the
+ * point on the monotonic clock it was replayed at, so timing errors never
+ * add up. The thread sleeps until shortly before a frame is due and then
+ * yields until the exact time. All frames due by then are handed over as
+ * one batch, dense bursts therefore cost one event instead of one per frame.
+ *
+ * The batches are queued to the thread owning the pacer, which emits them
+ * with bytesReady(). At most maxPendingBatches may wait there, a pipeline
+ * that can't keep up stops the pacer. If a batch is released more than
+ * maxDrift late, e.g. after a stall, the anchor is moved to the current time
+ * instead of rushing through the backlog. The lateness of the delivered
+ * batches is reported as drift.
+ *
+ * pause(), seek() and setSpeed() apply to the running replay.
+ */
+class MAVLinkLogPacer : public QThread
+{
+    Q_OBJECT
+
+public:
+    MAVLinkLogPacer(QObject* parent = 0);
+    ~MAVLinkLogPacer();
+
+    /**
+     * @brief Start the replay
+     *
+     * @param fileName MAVLink log
+     * @param link the frames are emitted as received on this link
+     * @param offset record offset to start at, e.g. from MAVLinkLogIndex
+     * @return false if the log can't be read
+     */
+    bool start(const QString& fileName, LinkInterface* link, qint64 offset = 0);
+    /** @brief Stop the replay, undelivered batches are dropped */
+    void stop();
+    /** @brief Stop releasing frames, the position is kept */
+    void pause();
+    /** @brief Continue a paused replay, the next frame is due immediately */
+    void resume();
+    /** @brief Continue at a record offset, undelivered batches are dropped */
+    void seek(qint64 offset);
+    /** @brief Set the replay speed, 1.0 is real time */
+    void setSpeed(double speed);
+    /** @brief Move the anchor if a batch is released more than maxDrift ms late */
+    void setMaxDrift(int milliseconds);
+
+    bool isPaused() const {
+        return paused;
+    }
+    double getSpeed() const {
+        return speed;
+    }
+    /** @brief Offset of the next record to deliver */
+    qint64 getOffset() const {
+        return offset;
+    }
+    /** @brief Number of delivered frames */
+    quint64 getFrames() const {
+        return frames;
+    }
+    /** @brief Number of delivered batches */
+    quint64 getBatches() const {
+        return batches;
+    }
+    /** @brief Mean lateness of the delivered batches in nanoseconds */
+    qint64 getMeanDrift() const;
+    /** @brief Maximum lateness of the delivered batches in nanoseconds */
+    qint64 getMaxDrift() const {
+        return maxDriftSeen;
+    }
+    /** @brief Number of times the anchor had to be moved, see setMaxDrift() */
+    int getDriftCorrections() const {
+        return int(driftCorrections);
+    }
+
+signals:
+    /** @brief A batch of frames is due */
+    void bytesReady(LinkInterface* link, const QByteArray& bytes);
+    /** @brief Log time of the last delivered frame in microseconds, at most every progressInterval ms */
+    void timeChanged(quint64 time);
+    /** @brief The last frame of the log was delivered */
+    void endReached();
+    /** @brief Internal: hands a batch from the pacer thread to deliverBatch() */
+    void batchReady(const MAVLinkLogBatch& batch);
+
+protected slots:
+    /** @brief Emit a batch in the thread owning the pacer */
+    void deliverBatch(const MAVLinkLogBatch& batch);
+
+protected:
+    void run();
+    /** @brief Release time of a log time on the clock, call with the mutex locked */
+    qint64 dueTime(quint64 time) const;
+
+    static const int maxPendingBatches = 16;
+    static const int maxBatchSize = 65536;      ///< Bytes, a longer burst is split up
+    static const qint64 spinTime = 1000000;     ///< Nanoseconds before the due time the thread stops sleeping
+    static const int progressInterval = 50;     ///< Milliseconds between two timeChanged() signals
+
+    MAVLinkLogReader reader;
+    LinkInterface* link;
+    QElapsedTimer clock;        ///< Monotonic clock of all due times
+    QMutex mutex;               ///< Protects the replay state below
+    QWaitCondition condition;   ///< Wakes the thread on a change of the replay state
+    bool stopRequested;
+    bool paused;
+    bool anchored;
+    qint64 seekOffset;          ///< Record to continue at, -1 if none
+    double speed;
+    quint64 anchorTime;         ///< Log time replayed at anchorClock
+    qint64 anchorClock;
+    qint64 maxDrift;            ///< Nanoseconds
+    QAtomicInt pendingBatches;  ///< Batches released but not yet delivered
+    QAtomicInt generation;      ///< Increased by stop() and seek()
+    QAtomicInt driftCorrections;
+    // Accessed by the thread owning the pacer only
+    qint64 offset;
+    quint64 frames;
+    quint64 batches;
+    qint64 driftSum;
+    qint64 maxDriftSeen;
+    qint64 lastProgress;
+};
+
+#endif // MAVLINKLOGPACER_H
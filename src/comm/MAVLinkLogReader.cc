@@ -0,0 +1,251 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class MAVLinkLogReader
+ */
+
+#include <string.h>
+
+#include "MAVLinkLogReader.h"
+
+const int MAVLinkLogReader::timeLen;
+const qint64 MAVLinkLogReader::mapWindowSize;
+
+/** Largest record: timestamp and frame with the maximum payload */
+static const int recordMax = sizeof(quint64) + MAVLINK_MAX_PACKET_LEN;
+/** Smallest record: timestamp and frame without payload */
+static const int recordMin = sizeof(quint64) + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+
+MAVLinkLogReader::MAVLinkLogReader() :
+    fileSize(0),
+    map(NULL),
+    mapStart(0),
+    mapLength(0),
+    pos(0),
+    validateFrames(false),
+    resyncs(0)
+{
+}
+
+MAVLinkLogReader::~MAVLinkLogReader()
+{
+    close();
+}
+
+bool MAVLinkLogReader::open(const QString& fileName)
+{
+    close();
+    if (MAVLinkLogBlockFile::isBlockLog(fileName))
+    {
+        if (!blocks.open(fileName))
+        {
+            return false;
+        }
+        fileSize = blocks.rawSize();
+        if (fileSize > 0 && !mapRange(0, recordMin))
+        {
+            blocks.close();
+            fileSize = 0;
+            return false;
+        }
+        return true;
+    }
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    fileSize = file.size();
+
+    // Map everything at once, fall back to a window if the address space is too small
+    if (fileSize > 0 && !mapRange(0, fileSize) && !mapRange(0, qMin(fileSize, mapWindowSize)))
+    {
+        file.close();
+        fileSize = 0;
+        return false;
+    }
+    return true;
+}
+
+void MAVLinkLogReader::close()
+{
+    unmap();
+    blocks.close();
+    if (file.isOpen())
+    {
+        file.close();
+    }
+    fileSize = 0;
+    pos = 0;
+    resyncs = 0;
+}
+
+void MAVLinkLogReader::unmap()
+{
+    if (map && !blocks.isOpen())
+    {
+        file.unmap(map);
+    }
+    map = NULL;
+    blockData.clear();
+    mapStart = 0;
+    mapLength = 0;
+}
+
+bool MAVLinkLogReader::mapRange(qint64 offset, qint64 length)
+{
+    if (blocks.isOpen())
+    {
+        // Records never cross blocks, the block containing the offset holds the range
+        if (map && offset >= mapStart && offset < mapStart + mapLength)
+        {
+            return true;
+        }
+        unmap();
+        const int index = blocks.findRawOffset(offset);
+        if (index >= blocks.count() || !blocks.readBlock(index, &blockData))
+        {
+            blockData.clear();
+            return false;
+        }
+        map = reinterpret_cast<uchar*>(blockData.data());
+        mapStart = blocks.block(index).rawOffset;
+        mapLength = blockData.size();
+        return true;
+    }
+
+    if (map && offset >= mapStart && offset + length <= mapStart + mapLength)
+    {
+        return true;
+    }
+    unmap();
+    // Windows start at the requested range, the window size is at least the range
+    mapLength = qMin(qMax(length, mapWindowSize), fileSize - offset);
+    map = file.map(offset, mapLength);
+    if (!map)
+    {
+        mapLength = 0;
+        return false;
+    }
+    mapStart = offset;
+    return true;
+}
+
+bool MAVLinkLogReader::seek(qint64 offset)
+{
+    if (!isOpen() || offset < 0 || offset > fileSize)
+    {
+        return false;
+    }
+    pos = offset;
+    return true;
+}
+
+bool MAVLinkLogReader::seekTime(quint64 time)
+{
+    if (!blocks.isOpen())
+    {
+        return false;
+    }
+    const int index = blocks.findTime(time);
+    if (index >= blocks.count())
+    {
+        pos = fileSize;
+        return true;
+    }
+    pos = blocks.block(index).rawOffset;
+
+    // The block ends at or after the time, only it is decompressed
+    MAVLinkLogFrame frame;
+    while (next(&frame))
+    {
+        if (frame.time >= time)
+        {
+            pos = frame.offset;
+            break;
+        }
+    }
+    return true;
+}
+
+bool MAVLinkLogReader::atEnd() const
+{
+    return pos + recordMin > fileSize;
+}
+
+bool MAVLinkLogReader::recordFollows(qint64 offset) const
+{
+    // A block ends with a complete record
+    if (offset == fileSize || (blocks.isOpen() && offset == mapStart + mapLength))
+    {
+        return true;
+    }
+    const qint64 stx = offset + timeLen;
+    return stx >= mapStart && stx < mapStart + mapLength && map[stx - mapStart] == MAVLINK_STX;
+}
+
+bool MAVLinkLogReader::next(MAVLinkLogFrame* frame)
+{
+    bool resyncing = false;
+    while (pos + recordMin <= fileSize)
+    {
+        if (!mapRange(pos, qMin<qint64>(recordMax, fileSize - pos)))
+        {
+            return false;
+        }
+        const char* record = reinterpret_cast<const char*>(map) + (pos - mapStart);
+        const int available = int(qMin<qint64>(recordMax, mapStart + mapLength - pos));
+        const char* stx = record + timeLen;
+        const int length = MAVLinkFrameScanner::frameLength(stx[1]);
+
+        // A start sign followed by the next record at the right distance is
+        // trusted, else and after invalid data the CRC has to match
+        bool valid = ((quint8)stx[0] == MAVLINK_STX && timeLen + length <= available);
+        if (valid && (validateFrames || resyncing || !recordFollows(pos + timeLen + length)))
+        {
+            valid = scanner.isValidFrame(stx, available - timeLen);
+        }
+        if (valid)
+        {
+            frame->offset = pos;
+            memcpy(&frame->time, record, timeLen);
+            frame->data = stx;
+            frame->length = length;
+            pos += timeLen + length;
+            return true;
+        }
+
+        if (!resyncing)
+        {
+            resyncs++;
+            resyncing = true;
+        }
+        // Try the next start sign, the record starts with the timestamp in front of it
+        const void* next = memchr(stx + 1, MAVLINK_STX, available - timeLen - 1);
+        pos += (next ? static_cast<const char*>(next) : record + available) - stx;
+    }
+    return false;
+}
@@ -0,0 +1,164 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class MAVLinkLogReader
+ */
+
+#ifndef MAVLINKLOGREADER_H
+#define MAVLINKLOGREADER_H
+
+#include <QFile>
+#include <QByteArray>
+
+#include "MAVLinkFrameScanner.h"
+#include "MAVLinkLogBlockFile.h"
+
+/** @brief One record of a MAVLink log, the frame is a view into the mapped file */
+struct MAVLinkLogFrame
+{
+    qint64 offset;      ///< File offset of the record, i.e. of its timestamp
+    quint64 time;       ///< Timestamp in microseconds
+    const char* data;   ///< Complete frame starting at the start sign
+    int length;         ///< Length of the frame
+
+    /** @brief The frame as byte array without copying, only valid as long as the view */
+    QByteArray bytes() const {
+        return QByteArray::fromRawData(data, length);
+    }
+};
+
+/**
+ * @brief Zero-copy reader of MAVLink log files
+ *
+ * Reads the records written by MAVLinkLogWriter, an 8 byte timestamp
+ * followed by the frame at its encoded length, from a memory mapping of
+ * the file. next() returns the frames as views into the mapping, nothing
+ * is copied until the frame is decoded.
+ *
+ * The whole file is mapped if the address space allows it, else the
+ * reader maps a window of mapWindowSize bytes at a time. A view stays
+ * valid until close() if the whole file is mapped (see isMappedCompletely()),
+ * else only until the next call of next() or seek(). Views handed on as
+ * bytes() therefore must be consumed synchronously.
+ *
+ * Block logs (see MAVLinkLogBlockFile) are read one decompressed block at
+ * a time instead of a mapping window, offsets and size are those of the
+ * uncompressed records. Seeking only decompresses the block it lands in.
+ *
+ * By default a record is accepted without checking the CRC, which is left
+ * to the consumer, if it starts with a start sign and the next record
+ * starts right behind it. Records not starting with a frame are skipped,
+ * the reader resynchronizes on the next frame with a valid CRC.
+ */
+class MAVLinkLogReader
+{
+public:
+    MAVLinkLogReader();
+    ~MAVLinkLogReader();
+
+    /** @brief Open and map a log file, positioned at the first record */
+    bool open(const QString& fileName);
+    void close();
+    bool isOpen() const {
+        return file.isOpen() || blocks.isOpen();
+    }
+    QString getFileName() const {
+        return blocks.isOpen() ? blocks.getFileName() : file.fileName();
+    }
+    /** @brief The log is a compressed block log */
+    bool isBlockLog() const {
+        return blocks.isOpen();
+    }
+    /** @brief Blocks of a block log, e.g. for their time range */
+    const MAVLinkLogBlockFile& getBlockFile() const {
+        return blocks;
+    }
+    /** @brief Size of the log in bytes, uncompressed for block logs */
+    qint64 size() const {
+        return fileSize;
+    }
+    /** @brief The whole file is mapped, views stay valid until close() */
+    bool isMappedCompletely() const {
+        return map && mapStart == 0 && mapLength == fileSize;
+    }
+
+    /** @brief File offset of the next record */
+    qint64 position() const {
+        return pos;
+    }
+    /** @brief Continue at a record offset, e.g. from MAVLinkLogIndex */
+    bool seek(qint64 offset);
+    /**
+     * @brief Continue at the first record at or after a time
+     *
+     * Only possible in block logs, which find the block by their footer.
+     * The position is at the end if all records are older.
+     */
+    bool seekTime(quint64 time);
+    /** @brief No complete record is left */
+    bool atEnd() const;
+
+    /**
+     * @brief Get the next record
+     *
+     * @param frame the record, only valid if true is returned
+     * @return false at the end of the file or if it could not be mapped
+     */
+    bool next(MAVLinkLogFrame* frame);
+
+    /** @brief Check the CRC of every frame, not only while resynchronizing */
+    void setValidateFrames(bool validate) {
+        validateFrames = validate;
+    }
+    /** @brief Number of times the reader had to skip invalid data */
+    int getResyncs() const {
+        return resyncs;
+    }
+
+    static const int timeLen = sizeof(quint64);
+    /** @brief Bytes mapped at a time if the whole file can't be mapped */
+    static const qint64 mapWindowSize = 64 * 1024 * 1024;
+
+protected:
+    /** @brief Make sure the range is mapped, moving the window or decompressing the block if necessary */
+    bool mapRange(qint64 offset, qint64 length);
+    void unmap();
+    /** @brief A record starts at the offset or the file ends there */
+    bool recordFollows(qint64 offset) const;
+
+    QFile file;
+    qint64 fileSize;
+    uchar* map;
+    qint64 mapStart;        ///< File offset of the mapping
+    qint64 mapLength;
+    qint64 pos;             ///< File offset of the next record
+    bool validateFrames;
+    int resyncs;
+    MAVLinkFrameScanner scanner;    ///< Validates frames
+    MAVLinkLogBlockFile blocks;     ///< Open instead of file for block logs
+    QByteArray blockData;           ///< Decompressed block, the mapping of block logs
+};
+
+#endif // MAVLINKLOGREADER_H
@@ -0,0 +1,269 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class MAVLinkLogReplay
+ */
+
+#include <QTimer>
+#include <QStringList>
+
+#include "MAVLinkLogReplay.h"
+#include "MAVLinkProtocol.h"
+#include "MAVLinkMessageDispatcher.h"
+
+/** All overloads of valueChanged() of the value sources */
+static const char* const valueSignals[] =
+{
+    SIGNAL(valueChanged(int,QString,QString,quint8,quint64)),
+    SIGNAL(valueChanged(int,QString,QString,qint8,quint64)),
+    SIGNAL(valueChanged(int,QString,QString,quint16,quint64)),
+    SIGNAL(valueChanged(int,QString,QString,qint16,quint64)),
+    SIGNAL(valueChanged(int,QString,QString,quint32,quint64)),
+    SIGNAL(valueChanged(int,QString,QString,qint32,quint64)),
+    SIGNAL(valueChanged(int,QString,QString,quint64,quint64)),
+    SIGNAL(valueChanged(int,QString,QString,qint64,quint64)),
+    SIGNAL(valueChanged(int,QString,QString,double,quint64))
+};
+static const int valueSignalCount = sizeof(valueSignals) / sizeof(valueSignals[0]);
+
+MAVLinkLogReplay::MAVLinkLogReplay(MAVLinkProtocol* protocol, QObject* parent) : QObject(parent),
+    protocol(protocol),
+    link(NULL),
+    running(false),
+    frames(0),
+    bytes(0),
+    startedAt(0),
+    elapsed(0),
+    readTime(0),
+    pipelineTime(0),
+    valueStart(0)
+{
+    clock.start();
+}
+
+void MAVLinkLogReplay::beginValueSlots(QObject* source)
+{
+    // Slots are called in the order they were connected
+    for (int i = 0; i < valueSignalCount; i++)
+    {
+        connect(source, valueSignals[i], this, SLOT(valueSlotsStarted()));
+    }
+}
+
+void MAVLinkLogReplay::endValueSlots(QObject* source, const QString& name)
+{
+    for (int i = 0; i < valueSignalCount; i++)
+    {
+        connect(source, valueSignals[i], this, SLOT(valueSlotsFinished()));
+    }
+    valueSources.insert(source, name);
+    // A subscriber emits the values while handling a message
+    MAVLinkMessageSubscriber* subscriber = dynamic_cast<MAVLinkMessageSubscriber*>(source);
+    valueParents.insert(name, subscriber ? subscriber->getSubscriberName() : QString());
+}
+
+void MAVLinkLogReplay::valueSlotsStarted()
+{
+    if (running) valueStart = clock.nsecsElapsed();
+}
+
+void MAVLinkLogReplay::valueSlotsFinished()
+{
+    if (!running || valueStart == 0) return;
+    valueTimes[valueSources.value(sender())] += clock.nsecsElapsed() - valueStart;
+    valueStart = 0;
+}
+
+bool MAVLinkLogReplay::start(const QString& fileName, LinkInterface* link, qint64 offset)
+{
+    stop();
+    if (!reader.open(fileName) || !reader.seek(offset))
+    {
+        reader.close();
+        return false;
+    }
+    this->link = link;
+    frames = 0;
+    bytes = 0;
+    elapsed = 0;
+    readTime = 0;
+    pipelineTime = 0;
+    valueStart = 0;
+    valueTimes.clear();
+    subscriberTimes.clear();
+    subscribersAtStart = takeSubscriberTimes();
+    running = true;
+    startedAt = clock.nsecsElapsed();
+    QTimer::singleShot(0, this, SLOT(replaySlice()));
+    return true;
+}
+
+void MAVLinkLogReplay::stop()
+{
+    if (running)
+    {
+        finish();
+    }
+}
+
+void MAVLinkLogReplay::finish()
+{
+    running = false;
+    elapsed = clock.nsecsElapsed() - startedAt;
+    subscriberTimes = takeSubscriberTimes();
+    reader.close();
+    emit finished();
+}
+
+void MAVLinkLogReplay::replaySlice()
+{
+    if (!running) return;
+
+    MAVLinkLogFrame frame;
+    qint64 now = clock.nsecsElapsed();
+    const qint64 sliceEnd = now + sliceTime * qint64(1000000);
+    do
+    {
+        const qint64 readStart = now;
+        if (!reader.next(&frame))
+        {
+            finish();
+            return;
+        }
+        const qint64 received = clock.nsecsElapsed();
+        // The frame is a view into the mapped log, receiveBytes() parses it right away
+        protocol->receiveBytes(link, frame.bytes());
+        now = clock.nsecsElapsed();
+
+        readTime += received - readStart;
+        pipelineTime += now - received;
+        frames++;
+        bytes += frame.length;
+    }
+    while (now < sliceEnd && running);
+
+    if (running)
+    {
+        emit progressChanged(int(reader.position() * 100 / qMax(reader.size(), qint64(1))));
+        QTimer::singleShot(0, this, SLOT(replaySlice()));
+    }
+}
+
+QHash<QString, qint64> MAVLinkLogReplay::takeSubscriberTimes() const
+{
+    QHash<QString, qint64> times;
+    foreach (const MAVLinkSubscriberStatistics& subscriber, protocol->getDispatcher()->getStatistics())
+    {
+        times[subscriber.name] += subscriber.handlerTime;
+    }
+    return times;
+}
+
+double MAVLinkLogReplay::getFrameRate() const
+{
+    return (elapsed > 0) ? frames / (elapsed / 1e9) : 0.0;
+}
+
+QList<MAVLinkLogReplay::Stage> MAVLinkLogReplay::getStages() const
+{
+    // Time of every subscriber during the replay
+    QHash<QString, qint64> subscribers;
+    qint64 subscriberTotal = 0;
+    QHashIterator<QString, qint64> i(subscriberTimes);
+    while (i.hasNext())
+    {
+        i.next();
+        const qint64 time = i.value() - subscribersAtStart.value(i.key());
+        if (time <= 0) continue;
+        subscribers.insert(i.key(), time);
+        subscriberTotal += time;
+    }
+    qint64 protocolTime = pipelineTime - subscriberTotal;
+
+    // The measured slots run inside the stage emitting the values
+    QHashIterator<QString, qint64> v(valueTimes);
+    while (v.hasNext())
+    {
+        v.next();
+        const QString parent = valueParents.value(v.key());
+        if (subscribers.contains(parent))
+        {
+            subscribers[parent] -= v.value();
+        }
+        else
+        {
+            protocolTime -= v.value();
+        }
+    }
+
+    QList<Stage> stages;
+    Stage stage;
+    stage.name = tr("read");
+    stage.time = readTime;
+    stages.append(stage);
+    stage.name = tr("protocol");
+    stage.time = protocolTime;
+    stages.append(stage);
+    QStringList names = subscribers.keys();
+    names.sort();
+    foreach (const QString& name, names)
+    {
+        stage.name = name;
+        stage.time = subscribers.value(name);
+        stages.append(stage);
+    }
+    names = valueTimes.keys();
+    names.sort();
+    foreach (const QString& name, names)
+    {
+        stage.name = name;
+        stage.time = valueTimes.value(name);
+        stages.append(stage);
+    }
+    stage.name = tr("other");
+    stage.time = elapsed - readTime - pipelineTime;
+    stages.append(stage);
+    return stages;
+}
+
+QString MAVLinkLogReplay::getReport() const
+{
+    const double seconds = elapsed / 1e9;
+    QString report = tr("Replayed %1 frames (%2 MB) in %3 s: %4 frames/s, %5 MB/s\n")
+            .arg(frames)
+            .arg(bytes / 1e6, 0, 'f', 2)
+            .arg(seconds, 0, 'f', 3)
+            .arg(getFrameRate(), 0, 'f', 0)
+            .arg((seconds > 0.0) ? bytes / 1e6 / seconds : 0.0, 0, 'f', 2);
+    foreach (const Stage& stage, getStages())
+    {
+        report += tr("  %1 %2 s %3 % %4 us/frame\n")
+                .arg(stage.name, -20)
+                .arg(stage.time / 1e9, 8, 'f', 3)
+                .arg((elapsed > 0) ? 100.0 * stage.time / elapsed : 0.0, 5, 'f', 1)
+                .arg((frames > 0) ? stage.time / 1e3 / frames : 0.0, 7, 'f', 2);
+    }
+    return report;
+}
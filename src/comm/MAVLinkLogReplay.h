@@ -0,0 +1,155 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class MAVLinkLogReplay
+ */
+
+#ifndef MAVLINKLOGREPLAY_H
+#define MAVLINKLOGREPLAY_H
+
+#include <QObject>
+#include <QHash>
+#include <QElapsedTimer>
+
+#include "MAVLinkLogReader.h"
+
+class LinkInterface;
+class MAVLinkProtocol;
+
+/**
+ * @brief Unpaced replay of a MAVLink log through the receive pipeline
+ *
+ * Hands the frames of a log to MAVLinkProtocol::receiveBytes() as fast as
+ * the pipeline processes them, ignoring the timestamps. The replay runs in
+ * slices of sliceTime ms in the thread of the protocol, between the slices
+ * the event loop keeps the user interface alive.
+ *
+ * The time is split up into stages:
+ *
+ * - read: getting the frames out of the mapped log
+ * - protocol: parsing and handling in MAVLinkProtocol, without the subscribers
+ * - one stage per subscriber of the message dispatcher (vehicles, decoder),
+ *   including the slots they call directly
+ * - one stage per source measured with beginValueSlots(), taken out of the
+ *   subscriber emitting the values
+ * - other: everything else, i.e. the event loop between the slices
+ */
+class MAVLinkLogReplay : public QObject
+{
+    Q_OBJECT
+
+public:
+    MAVLinkLogReplay(MAVLinkProtocol* protocol, QObject* parent = 0);
+
+    /** @brief Time spent in one stage */
+    struct Stage
+    {
+        QString name;
+        qint64 time;        ///< Nanoseconds
+    };
+
+    /**
+     * @brief Start measuring the slots connected to the valueChanged() signals of source
+     *
+     * Only the slots connected between this call and endValueSlots() are
+     * measured, e.g. the linecharts fed by the MAVLink decoder.
+     */
+    void beginValueSlots(QObject* source);
+    /** @brief Stop connecting slots to measure, see beginValueSlots() */
+    void endValueSlots(QObject* source, const QString& name);
+
+    bool isRunning() const {
+        return running;
+    }
+    /** @brief Number of replayed frames */
+    quint64 getFrames() const {
+        return frames;
+    }
+    quint64 getBytes() const {
+        return bytes;
+    }
+    /** @brief Wall clock time of the replay in nanoseconds */
+    qint64 getElapsed() const {
+        return elapsed;
+    }
+    /** @brief Replayed frames per second */
+    double getFrameRate() const;
+    /** @brief Time per stage of the last replay, in pipeline order */
+    QList<Stage> getStages() const;
+    /** @brief Multi-line summary of the last replay */
+    QString getReport() const;
+
+public slots:
+    /**
+     * @brief Start the replay
+     *
+     * @param fileName MAVLink log
+     * @param link the frames are received on this link
+     * @param offset record offset to start at, e.g. from MAVLinkLogIndex
+     * @return false if the log can't be read
+     */
+    bool start(const QString& fileName, LinkInterface* link, qint64 offset = 0);
+    /** @brief Stop the replay, finished() is emitted */
+    void stop();
+
+signals:
+    /** @brief Progress of the replay in percent, emitted after every slice */
+    void progressChanged(int percent);
+    /** @brief The replay reached the end of the log or was stopped */
+    void finished();
+
+protected slots:
+    /** @brief Replay frames for one slice */
+    void replaySlice();
+    void valueSlotsStarted();
+    void valueSlotsFinished();
+
+protected:
+    /** @brief Handler time of the dispatcher subscribers by name */
+    QHash<QString, qint64> takeSubscriberTimes() const;
+    void finish();
+
+    static const int sliceTime = 20;    ///< Milliseconds between two event loop runs
+
+    MAVLinkProtocol* protocol;
+    LinkInterface* link;
+    MAVLinkLogReader reader;
+    QElapsedTimer clock;
+    bool running;
+    quint64 frames;
+    quint64 bytes;
+    qint64 startedAt;           ///< Start of the replay on clock
+    qint64 elapsed;
+    qint64 readTime;
+    qint64 pipelineTime;        ///< Time in receiveBytes() including all subscribers
+    QHash<QString, qint64> subscribersAtStart;
+    QHash<QString, qint64> subscriberTimes;
+    QHash<QObject*, QString> valueSources;  ///< Stage names of the measured sources
+    QHash<QString, QString> valueParents;   ///< Stage the time of a measured source is taken from
+    QHash<QString, qint64> valueTimes;
+    qint64 valueStart;          ///< Start of the current valueChanged() emission, 0 if none
+};
+
+#endif // MAVLINKLOGREPLAY_H
@@ -0,0 +1,252 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class MAVLinkLogWriter
+ */
+
+#include <string.h>
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <QDateTime>
+
+#include "MAVLinkLogWriter.h"
+
+MAVLinkLogWriter::MAVLinkLogWriter(QObject* parent) :
+    QThread(parent),
+    queue(queueSize),
+    wakeRequested(0),
+    queuedBytes(0),
+    stopRequested(false),
+    syncPolicy(SYNC_INTERVAL),
+    syncInterval(1000),
+    flushInterval(200),
+    batchSize(64 * 1024),
+    writtenPackets(0),
+    droppedPackets(0),
+    lostPackets(0),
+    writeErrors(0),
+    failing(false),
+    lastSync(0),
+    compressed(false),
+    blockRecords(0),
+    blockFirstTime(0),
+    blockLastTime(0),
+    blockStarted(0)
+{
+}
+
+MAVLinkLogWriter::~MAVLinkLogWriter()
+{
+    stopLogging();
+}
+
+bool MAVLinkLogWriter::startLogging(const QString& fileName)
+{
+    stopLogging();
+    compressed = MAVLinkLogBlockFile::isBlockLogName(fileName);
+    if (compressed)
+    {
+        if (!blockFile.create(fileName))
+        {
+            return false;
+        }
+        block.reserve(MAVLinkLogBlockFile::blockSize + sizeof(MAVLinkLogRecord));
+        blockRecords = 0;
+    }
+    else
+    {
+        file.setFileName(fileName);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+        {
+            return false;
+        }
+    }
+    stopRequested = false;
+    failing = false;
+    lastSync = QDateTime::currentMSecsSinceEpoch();
+    batch.reserve(batchSize + sizeof(MAVLinkLogRecord));
+    start(QThread::LowPriority);
+    return true;
+}
+
+void MAVLinkLogWriter::stopLogging()
+{
+    if (isRunning())
+    {
+        stopRequested = true;
+        wakeCondition.wakeOne();
+        wait();
+    }
+    if (file.isOpen())
+    {
+        file.close();
+    }
+    if (blockFile.isOpen() && !blockFile.finish())
+    {
+        writeErrors.fetchAndAddOrdered(1);
+        emit writeFailed(blockFile.getFileName());
+    }
+}
+
+bool MAVLinkLogWriter::append(quint64 time, const mavlink_message_t& message)
+{
+    MAVLinkLogRecord record;
+    memcpy(record.data, &time, sizeof(quint64));
+    record.length = sizeof(quint64) + mavlink_msg_to_send_buffer(reinterpret_cast<uint8_t*>(record.data + sizeof(quint64)), &message);
+
+    if (!queue.push(record))
+    {
+        droppedPackets.fetchAndAddOrdered(1);
+        return false;
+    }
+
+    // Wake the thread once a batch is complete, else it
+    // writes the packets after the flush interval
+    if (queuedBytes.fetchAndAddOrdered(record.length) + record.length >= batchSize &&
+            wakeRequested.testAndSetOrdered(0, 1))
+    {
+        wakeCondition.wakeOne();
+    }
+    return true;
+}
+
+void MAVLinkLogWriter::run()
+{
+    while (!stopRequested)
+    {
+        wakeMutex.lock();
+        if (int(queuedBytes) < batchSize && !stopRequested)
+        {
+            wakeCondition.wait(&wakeMutex, flushInterval);
+        }
+        wakeMutex.unlock();
+        wakeRequested.fetchAndStoreOrdered(0);
+
+        writeQueued();
+    }
+
+    // Write everything which was queued before stopping
+    writeQueued();
+    if (blockRecords > 0) writeBlock();
+    if (syncPolicy != SYNC_NEVER) sync();
+}
+
+void MAVLinkLogWriter::writeQueued()
+{
+    MAVLinkLogRecord record;
+    int packets = 0;
+    while (queue.pop(&record))
+    {
+        queuedBytes.fetchAndAddOrdered(-record.length);
+        if (compressed)
+        {
+            quint64 time;
+            memcpy(&time, record.data, sizeof(time));
+            if (blockRecords == 0)
+            {
+                blockFirstTime = time;
+                blockStarted = QDateTime::currentMSecsSinceEpoch();
+            }
+            blockLastTime = time;
+            block.append(record.data, record.length);
+            blockRecords++;
+            if (block.size() >= MAVLinkLogBlockFile::blockSize)
+            {
+                writeBlock();
+            }
+            continue;
+        }
+        batch.append(record.data, record.length);
+        packets++;
+        if (batch.size() >= batchSize)
+        {
+            writeBatch(packets);
+            packets = 0;
+        }
+    }
+    if (packets > 0)
+    {
+        writeBatch(packets);
+    }
+    // Limit the packets lost with a partial block on a crash
+    if (blockRecords > 0 && QDateTime::currentMSecsSinceEpoch() - blockStarted >= blockInterval)
+    {
+        writeBlock();
+    }
+}
+
+void MAVLinkLogWriter::writeBatch(int packets)
+{
+    countWrite(file.write(batch) == batch.size() && file.flush(), packets);
+    // Keeps the reserved capacity
+    batch.resize(0);
+}
+
+void MAVLinkLogWriter::writeBlock()
+{
+    countWrite(blockFile.appendBlock(block, blockRecords, blockFirstTime, blockLastTime), blockRecords);
+    block.resize(0);
+    blockRecords = 0;
+}
+
+void MAVLinkLogWriter::countWrite(bool written, int packets)
+{
+    if (written)
+    {
+        writtenPackets.fetchAndAddOrdered(packets);
+        failing = false;
+
+        qint64 now = QDateTime::currentMSecsSinceEpoch();
+        if (syncPolicy == SYNC_BATCH || (syncPolicy == SYNC_INTERVAL && now - lastSync >= syncInterval))
+        {
+            sync();
+            lastSync = now;
+        }
+    }
+    else
+    {
+        lostPackets.fetchAndAddOrdered(packets);
+        writeErrors.fetchAndAddOrdered(1);
+        if (!failing)
+        {
+            failing = true;
+            emit writeFailed(getFileName());
+        }
+    }
+}
+
+void MAVLinkLogWriter::sync()
+{
+    const int handle = compressed ? blockFile.handle() : file.handle();
+#ifdef Q_OS_WIN
+    _commit(handle);
+#else
+    fsync(handle);
+#endif
+}
@@ -0,0 +1,187 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class MAVLinkLogWriter
+ */
+
+#ifndef MAVLINKLOGWRITER_H
+#define MAVLINKLOGWRITER_H
+
+#include <QThread>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QByteArray>
+
+#include "QGCMAVLink.h"
+#include "QGCSpscQueue.h"
+#include "MAVLinkLogBlockFile.h"
+
+/** @brief One log record: timestamp and complete frame */
+struct MAVLinkLogRecord
+{
+    int length;     ///< Number of valid bytes in data
+    char data[sizeof(quint64) + MAVLINK_MAX_PACKET_LEN];
+};
+
+/**
+ * @brief Writes the MAVLink packet log in a background thread
+ *
+ * Every packet is stored as an 8 byte timestamp in microseconds since
+ * epoch (host byte order), followed by the complete MAVLink frame, as read
+ * by QGCMAVLinkLogPlayer.
+ *
+ * append() only copies the packet into a lock-free queue and never blocks.
+ * If the queue is full, the packet is dropped and counted. The thread
+ * collects the queued packets and writes them in batches, as soon as
+ * enough packets are waiting or at the latest after the flush interval.
+ * A failed write does not stop logging, the packets of the batch are
+ * counted as lost and the next batch is tried again.
+ *
+ * Files named like a block log (see MAVLinkLogBlockFile::isBlockLogName())
+ * are written compressed instead. The thread collects the records into
+ * blocks of MAVLinkLogBlockFile::blockSize bytes and compresses them, a
+ * block is written once it is full or blockInterval ms old. stopLogging()
+ * writes the block index.
+ */
+class MAVLinkLogWriter : public QThread
+{
+    Q_OBJECT
+
+public:
+    /** @brief When the written data is forced to the disk */
+    enum SyncPolicy
+    {
+        SYNC_NEVER = 0,     ///< Leave it to the operating system
+        SYNC_INTERVAL = 1,  ///< At most once per sync interval
+        SYNC_BATCH = 2      ///< After every written batch
+    };
+
+    MAVLinkLogWriter(QObject* parent = 0);
+    ~MAVLinkLogWriter();
+
+    /** @brief Open the file for appending and start the writer thread */
+    bool startLogging(const QString& fileName);
+    /** @brief Write all queued packets, close the file and stop the thread */
+    void stopLogging();
+    bool isLogging() const {
+        return isRunning();
+    }
+    QString getFileName() const {
+        return compressed ? blockFile.getFileName() : file.fileName();
+    }
+    /** @brief The log is written as compressed block log */
+    bool isCompressed() const {
+        return compressed;
+    }
+
+    /** @brief Queue a packet for writing. Only call from one thread. */
+    bool append(quint64 time, const mavlink_message_t& message);
+
+    void setSyncPolicy(SyncPolicy policy) {
+        syncPolicy = policy;
+    }
+    SyncPolicy getSyncPolicy() const {
+        return syncPolicy;
+    }
+    /** @brief Set the minimum time between two syncs for SYNC_INTERVAL */
+    void setSyncInterval(int ms) {
+        syncInterval = ms;
+    }
+    /** @brief Set the maximum time a packet waits in the queue */
+    void setFlushInterval(int ms) {
+        flushInterval = ms;
+    }
+    /** @brief Set the number of queued bytes which triggers a write */
+    void setBatchSize(int bytes) {
+        batchSize = bytes;
+    }
+
+    /** @brief Number of packets written to the file */
+    int getWrittenPackets() const {
+        return int(writtenPackets);
+    }
+    /** @brief Number of packets dropped because the queue was full */
+    int getDroppedPackets() const {
+        return int(droppedPackets);
+    }
+    /** @brief Number of packets lost in failed writes */
+    int getLostPackets() const {
+        return int(lostPackets);
+    }
+    /** @brief Number of failed writes */
+    int getWriteErrors() const {
+        return int(writeErrors);
+    }
+
+signals:
+    /** @brief Writing to the file failed, emitted once until a write succeeds again */
+    void writeFailed(const QString& fileName);
+
+protected:
+    void run();
+    /** @brief Write all queued packets */
+    void writeQueued();
+    /** @brief Write the collected batch to the file */
+    void writeBatch(int packets);
+    /** @brief Compress and write the collected block */
+    void writeBlock();
+    /** @brief Count the packets of a write and sync according to the policy */
+    void countWrite(bool written, int packets);
+    /** @brief Force the written data to the disk */
+    void sync();
+
+    static const int queueSize = 4096;      ///< Maximum number of queued packets
+    static const int blockInterval = 10000; ///< Maximum age of a block in ms before it is written
+
+    QFile file;
+    QGCSpscQueue<MAVLinkLogRecord> queue;
+    QByteArray batch;               ///< Collected packets of the current batch
+    QMutex wakeMutex;
+    QWaitCondition wakeCondition;   ///< Wakes the thread if a batch is complete
+    QAtomicInt wakeRequested;
+    QAtomicInt queuedBytes;         ///< Bytes waiting in the queue
+    volatile bool stopRequested;
+    SyncPolicy syncPolicy;
+    int syncInterval;
+    int flushInterval;
+    int batchSize;
+    QAtomicInt writtenPackets;
+    QAtomicInt droppedPackets;
+    QAtomicInt lostPackets;
+    QAtomicInt writeErrors;
+    bool failing;                   ///< The last write failed
+    qint64 lastSync;                ///< Time of the last sync in ms
+    bool compressed;                ///< Writing a block log
+    MAVLinkLogBlockFile blockFile;
+    QByteArray block;               ///< Collected records of the current block
+    int blockRecords;
+    quint64 blockFirstTime;
+    quint64 blockLastTime;
+    qint64 blockStarted;            ///< Time the first record of the block was collected in ms
+};
+
+#endif // MAVLINKLOGWRITER_H
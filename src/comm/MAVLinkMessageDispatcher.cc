@@ -0,0 +1,183 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class MAVLinkMessageDispatcher
+ */
+
+#include "MAVLinkMessageDispatcher.h"
+
+MAVLinkMessageSubscriber::~MAVLinkMessageSubscriber()
+{
+    // Work on a copy, unsubscribe() modifies the list
+    QList<MAVLinkMessageDispatcher*> subscribed = dispatchers;
+    foreach (MAVLinkMessageDispatcher* dispatcher, subscribed)
+    {
+        dispatcher->unsubscribe(this);
+    }
+}
+
+MAVLinkMessageDispatcher::MAVLinkMessageDispatcher() :
+    dispatchDepth(0)
+{
+    clock.start();
+}
+
+MAVLinkMessageDispatcher::~MAVLinkMessageDispatcher()
+{
+    foreach (MAVLinkMessageSubscriber* subscriber, statistics.keys())
+    {
+        subscriber->dispatchers.removeAll(this);
+    }
+    qDeleteAll(statistics);
+    qDeleteAll(retired);
+}
+
+MAVLinkMessageDispatcher::Statistics* MAVLinkMessageDispatcher::getStatisticsEntry(MAVLinkMessageSubscriber* subscriber)
+{
+    Statistics* entry = statistics.value(subscriber, NULL);
+    if (!entry)
+    {
+        entry = new Statistics;
+        entry->data.name = subscriber->getSubscriberName();
+        entry->data.deliveries = 0;
+        entry->data.handlerTime = 0;
+        entry->active = true;
+        statistics.insert(subscriber, entry);
+        subscriber->dispatchers.append(this);
+    }
+    return entry;
+}
+
+void MAVLinkMessageDispatcher::addSubscription(int msgid, const Subscription& subscription)
+{
+    QVector<Subscription>& entries = table[msgid];
+    for (int i = 0; i < entries.size(); i++)
+    {
+        const Subscription& existing = entries.at(i);
+        if (existing.subscriber == subscription.subscriber &&
+                existing.sysid == subscription.sysid &&
+                existing.compid == subscription.compid)
+        {
+            return;
+        }
+    }
+    entries.append(subscription);
+}
+
+void MAVLinkMessageDispatcher::subscribe(MAVLinkMessageSubscriber* subscriber, int msgid, int sysid, int compid)
+{
+    if (!subscriber || msgid < 0 || msgid > 255) return;
+    Subscription subscription;
+    subscription.subscriber = subscriber;
+    subscription.statistics = getStatisticsEntry(subscriber);
+    subscription.sysid = sysid;
+    subscription.compid = compid;
+    addSubscription(msgid, subscription);
+}
+
+void MAVLinkMessageDispatcher::subscribeAll(MAVLinkMessageSubscriber* subscriber, int sysid, int compid)
+{
+    for (int msgid = 0; msgid < 256; msgid++)
+    {
+        subscribe(subscriber, msgid, sysid, compid);
+    }
+}
+
+void MAVLinkMessageDispatcher::unsubscribe(MAVLinkMessageSubscriber* subscriber)
+{
+    Statistics* entry = statistics.take(subscriber);
+    if (!entry) return;
+
+    for (int msgid = 0; msgid < 256; msgid++)
+    {
+        QVector<Subscription>& entries = table[msgid];
+        for (int i = entries.size() - 1; i >= 0; i--)
+        {
+            if (entries.at(i).subscriber == subscriber) entries.remove(i);
+        }
+    }
+    subscriber->dispatchers.removeAll(this);
+
+    if (dispatchDepth > 0)
+    {
+        // A running dispatch may still hold the subscription
+        entry->active = false;
+        retired.append(entry);
+    }
+    else
+    {
+        delete entry;
+    }
+}
+
+void MAVLinkMessageDispatcher::dispatch(LinkInterface* link, const mavlink_message_t& message)
+{
+    // The copy is shared with the table and only detaches if the
+    // subscriptions change during the dispatch
+    const QVector<Subscription> entries = table[message.msgid];
+    const int count = entries.size();
+    if (count == 0) return;
+
+    dispatchDepth++;
+    for (int i = 0; i < count; i++)
+    {
+        const Subscription& subscription = entries.at(i);
+        if (subscription.sysid != 0 && subscription.sysid != message.sysid) continue;
+        if (subscription.compid != 0 && subscription.compid != message.compid) continue;
+        Statistics* entry = subscription.statistics;
+        if (!entry->active) continue;
+
+        const qint64 start = clock.nsecsElapsed();
+        subscription.subscriber->receiveMessage(link, message);
+        entry->data.handlerTime += clock.nsecsElapsed() - start;
+        entry->data.deliveries++;
+    }
+    dispatchDepth--;
+
+    if (dispatchDepth == 0 && !retired.isEmpty())
+    {
+        qDeleteAll(retired);
+        retired.clear();
+    }
+}
+
+QList<MAVLinkSubscriberStatistics> MAVLinkMessageDispatcher::getStatistics() const
+{
+    QList<MAVLinkSubscriberStatistics> result;
+    foreach (Statistics* entry, statistics)
+    {
+        result.append(entry->data);
+    }
+    return result;
+}
+
+void MAVLinkMessageDispatcher::resetStatistics()
+{
+    foreach (Statistics* entry, statistics)
+    {
+        entry->data.deliveries = 0;
+        entry->data.handlerTime = 0;
+    }
+}
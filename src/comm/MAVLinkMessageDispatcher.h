@@ -0,0 +1,135 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class MAVLinkMessageDispatcher
+ */
+
+#ifndef MAVLINKMESSAGEDISPATCHER_H
+#define MAVLINKMESSAGEDISPATCHER_H
+
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QString>
+#include <QElapsedTimer>
+
+#include "QGCMAVLink.h"
+
+class LinkInterface;
+class MAVLinkMessageDispatcher;
+
+/**
+ * @brief Interface of components which receive messages from a MAVLinkMessageDispatcher
+ *
+ * A subscriber is removed from all dispatchers when it is destroyed.
+ */
+class MAVLinkMessageSubscriber
+{
+public:
+    virtual ~MAVLinkMessageSubscriber();
+
+    /** @brief Handle one message the subscriber registered for */
+    virtual void receiveMessage(LinkInterface* link, const mavlink_message_t& message) = 0;
+    /** @brief Name shown in the dispatch statistics */
+    virtual QString getSubscriberName() = 0;
+
+private:
+    friend class MAVLinkMessageDispatcher;
+    QList<MAVLinkMessageDispatcher*> dispatchers;
+};
+
+/** @brief Delivery statistics of one subscriber */
+struct MAVLinkSubscriberStatistics
+{
+    QString name;
+    quint64 deliveries;     ///< Number of delivered messages
+    quint64 handlerTime;    ///< Time spent in the subscriber, in nanoseconds
+};
+
+/**
+ * @brief Delivers messages only to the components which subscribed to their message id
+ *
+ * The subscriptions are kept in a flat table indexed by the message id.
+ * Each subscription can additionally be limited to one system and / or
+ * component id, 0 accepts all ids. Messages are delivered by a direct call
+ * in the thread calling dispatch(), so all subscribers have to live in
+ * this thread.
+ *
+ * Subscribers may subscribe and unsubscribe, also themselves, while a
+ * message is dispatched.
+ */
+class MAVLinkMessageDispatcher
+{
+public:
+    MAVLinkMessageDispatcher();
+    ~MAVLinkMessageDispatcher();
+
+    /** @brief Receive messages with the given id */
+    void subscribe(MAVLinkMessageSubscriber* subscriber, int msgid, int sysid = 0, int compid = 0);
+    /** @brief Receive all messages, optionally limited to one system / component */
+    void subscribeAll(MAVLinkMessageSubscriber* subscriber, int sysid = 0, int compid = 0);
+    /** @brief Remove all subscriptions of the subscriber */
+    void unsubscribe(MAVLinkMessageSubscriber* subscriber);
+
+    /** @brief Deliver the message to all matching subscribers */
+    void dispatch(LinkInterface* link, const mavlink_message_t& message);
+
+    /** @brief Number of subscriptions for a message id */
+    int getSubscriptionCount(int msgid) const {
+        return table[msgid & 0xFF].size();
+    }
+    /** @brief Delivery counts and handler time of all subscribers */
+    QList<MAVLinkSubscriberStatistics> getStatistics() const;
+    /** @brief Reset the delivery counts and handler times */
+    void resetStatistics();
+
+protected:
+    struct Statistics
+    {
+        MAVLinkSubscriberStatistics data;
+        bool active;        ///< Cleared if unsubscribed during a dispatch
+    };
+
+    struct Subscription
+    {
+        MAVLinkMessageSubscriber* subscriber;
+        Statistics* statistics;
+        quint8 sysid;
+        quint8 compid;
+    };
+
+    /** @brief Add one subscription, duplicates are ignored */
+    void addSubscription(int msgid, const Subscription& subscription);
+    /** @brief Get the statistics entry of a subscriber, created on first use */
+    Statistics* getStatisticsEntry(MAVLinkMessageSubscriber* subscriber);
+
+    QVector<Subscription> table[256];   ///< Subscriptions indexed by message id
+    QHash<MAVLinkMessageSubscriber*, Statistics*> statistics;
+    QList<Statistics*> retired;         ///< Statistics of subscribers removed during a dispatch
+    int dispatchDepth;                  ///< Nesting level of dispatch() calls
+    QElapsedTimer clock;
+};
+
+#endif // MAVLINKMESSAGEDISPATCHER_H
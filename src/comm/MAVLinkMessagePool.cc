@@ -0,0 +1,153 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class MAVLinkMessagePool and MAVLinkMessageHandle
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "MAVLinkMessagePool.h"
+
+MAVLinkMessageHandle& MAVLinkMessageHandle::operator=(const MAVLinkMessageHandle& other)
+{
+    if (other.block != block)
+    {
+        if (other.block) other.block->ref.ref();
+        release();
+        block = other.block;
+    }
+    return *this;
+}
+
+void MAVLinkMessageHandle::release()
+{
+    if (block && !block->ref.deref())
+    {
+        MAVLinkMessagePool::instance()->recycle(block);
+    }
+    block = NULL;
+}
+
+MAVLinkMessagePool* MAVLinkMessagePool::instance()
+{
+    static MAVLinkMessagePool pool;
+    return &pool;
+}
+
+MAVLinkMessagePool::MAVLinkMessagePool() :
+    allocations(0),
+    heapAllocations(0),
+    reusedBlocks(0),
+    heapReleases(0),
+    liveMessages(0)
+{
+    // Handles are passed through queued connections
+    qRegisterMetaType<MAVLinkMessageHandle>("MAVLinkMessageHandle");
+    freeBlocks.reserve(maxFreeBlocks);
+}
+
+MAVLinkMessagePool::~MAVLinkMessagePool()
+{
+    qDeleteAll(freeBlocks);
+}
+
+MAVLinkMessageHandle MAVLinkMessagePool::allocate(const mavlink_message_t& message)
+{
+    MAVLinkMessageBlock* block = NULL;
+    mutex.lock();
+    allocations++;
+    liveMessages++;
+    if (!freeBlocks.isEmpty())
+    {
+        block = freeBlocks.last();
+        freeBlocks.remove(freeBlocks.size() - 1);
+        reusedBlocks++;
+    }
+    else
+    {
+        heapAllocations++;
+    }
+    mutex.unlock();
+
+    if (!block) block = new MAVLinkMessageBlock;
+    block->ref = 1;
+    // Only copy the header, the used part of the payload and the CRC bytes
+    memcpy(&block->message, &message, offsetof(mavlink_message_t, payload64) + message.len + MAVLINK_NUM_CHECKSUM_BYTES);
+    return MAVLinkMessageHandle(block);
+}
+
+void MAVLinkMessagePool::recycle(MAVLinkMessageBlock* block)
+{
+    mutex.lock();
+    liveMessages--;
+    if (freeBlocks.size() < maxFreeBlocks)
+    {
+        freeBlocks.append(block);
+        block = NULL;
+    }
+    else
+    {
+        heapReleases++;
+    }
+    mutex.unlock();
+    delete block;
+}
+
+quint64 MAVLinkMessagePool::getAllocations()
+{
+    QMutexLocker locker(&mutex);
+    return allocations;
+}
+
+quint64 MAVLinkMessagePool::getHeapAllocations()
+{
+    QMutexLocker locker(&mutex);
+    return heapAllocations;
+}
+
+quint64 MAVLinkMessagePool::getReusedBlocks()
+{
+    QMutexLocker locker(&mutex);
+    return reusedBlocks;
+}
+
+quint64 MAVLinkMessagePool::getHeapReleases()
+{
+    QMutexLocker locker(&mutex);
+    return heapReleases;
+}
+
+int MAVLinkMessagePool::getLiveMessages()
+{
+    QMutexLocker locker(&mutex);
+    return liveMessages;
+}
+
+int MAVLinkMessagePool::getFreeBlocks()
+{
+    QMutexLocker locker(&mutex);
+    return freeBlocks.size();
+}
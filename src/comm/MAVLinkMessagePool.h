@@ -0,0 +1,138 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class MAVLinkMessagePool and MAVLinkMessageHandle
+ */
+
+#ifndef MAVLINKMESSAGEPOOL_H
+#define MAVLINKMESSAGEPOOL_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QVector>
+#include <QMetaType>
+
+#include "QGCMAVLink.h"
+
+/** @brief Pooled storage of one message and its reference count */
+struct MAVLinkMessageBlock
+{
+    QAtomicInt ref;
+    mavlink_message_t message;
+};
+
+/**
+ * @brief Immutable, reference-counted handle to a pooled MAVLink message
+ *
+ * Copying a handle only increments the reference count, so a message can
+ * be handed to any number of receivers, also through queued connections,
+ * without copying the message itself. The message is returned to the pool
+ * when the last handle is destroyed.
+ */
+class MAVLinkMessageHandle
+{
+public:
+    MAVLinkMessageHandle() : block(NULL) {}
+    MAVLinkMessageHandle(const MAVLinkMessageHandle& other) : block(other.block) {
+        if (block) block->ref.ref();
+    }
+    ~MAVLinkMessageHandle() {
+        release();
+    }
+    MAVLinkMessageHandle& operator=(const MAVLinkMessageHandle& other);
+
+    bool isNull() const {
+        return block == NULL;
+    }
+    const mavlink_message_t* data() const {
+        return &block->message;
+    }
+    const mavlink_message_t& operator*() const {
+        return block->message;
+    }
+    const mavlink_message_t* operator->() const {
+        return &block->message;
+    }
+
+private:
+    friend class MAVLinkMessagePool;
+    explicit MAVLinkMessageHandle(MAVLinkMessageBlock* block) : block(block) {}
+    void release();
+
+    MAVLinkMessageBlock* block;
+};
+
+Q_DECLARE_METATYPE(MAVLinkMessageHandle)
+
+/**
+ * @brief Allocator for MAVLink message handles
+ *
+ * Released messages are kept in a free list and reused, only if the free
+ * list is empty a new block is allocated on the heap. Handles can be
+ * created and released from any thread.
+ */
+class MAVLinkMessagePool
+{
+public:
+    static MAVLinkMessagePool* instance();
+
+    /** @brief Copy the message into a pooled block */
+    MAVLinkMessageHandle allocate(const mavlink_message_t& message);
+
+    /** @brief Number of handles allocated since start */
+    quint64 getAllocations();
+    /** @brief Number of allocations which needed a new block from the heap */
+    quint64 getHeapAllocations();
+    /** @brief Number of allocations served by a block from the free list */
+    quint64 getReusedBlocks();
+    /** @brief Number of released blocks returned to the heap, the free list was full */
+    quint64 getHeapReleases();
+    /** @brief Number of messages currently referenced by a handle */
+    int getLiveMessages();
+    /** @brief Number of free blocks ready for reuse */
+    int getFreeBlocks();
+
+protected:
+    MAVLinkMessagePool();
+    ~MAVLinkMessagePool();
+
+    /** @brief Return a block whose last handle was destroyed */
+    void recycle(MAVLinkMessageBlock* block);
+
+    /** Free blocks kept at most, the rest is returned to the heap */
+    static const int maxFreeBlocks = 4096;
+
+    QMutex mutex;
+    QVector<MAVLinkMessageBlock*> freeBlocks;
+    quint64 allocations;
+    quint64 heapAllocations;
+    quint64 reusedBlocks;
+    quint64 heapReleases;
+    int liveMessages;
+
+    friend class MAVLinkMessageHandle;
+};
+
+#endif // MAVLINKMESSAGEPOOL_H
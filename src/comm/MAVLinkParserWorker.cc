@@ -0,0 +1,78 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class MAVLinkParserWorker
+ */
+
+#include <QMetaType>
+
+#include "MAVLinkParserWorker.h"
+
+MAVLinkParserWorker::MAVLinkParserWorker(LinkInterface* link, int queueSize) :
+    QObject(),
+    link(link),
+    queue(queueSize),
+    statistics(NULL),
+    notified(0),
+    dropped(0),
+    warned(false)
+{
+    // The bytes of the link arrive through a queued connection
+    qRegisterMetaType<LinkInterface*>("LinkInterface*");
+}
+
+void MAVLinkParserWorker::receiveBytes(LinkInterface* link, QByteArray b)
+{
+    Q_UNUSED(link);
+    mavlink_message_t message;
+    bool queued = false;
+
+    scanner.setInput(b.constData(), b.size());
+    while (scanner.nextMessage(&message))
+    {
+        if (statistics) statistics->countMessage(message);
+        if (queue.push(message))
+        {
+            queued = true;
+        }
+        else
+        {
+            dropped.fetchAndAddOrdered(1);
+        }
+    }
+
+    if (statistics) statistics->setParseErrors(scanner.getParseErrors());
+
+    if (queued && notified.testAndSetOrdered(0, 1))
+    {
+        emit messagesReady();
+    }
+
+    if (!warned && scanner.getReceivedFrames() == 0 && scanner.getVersion09Markers() > 100)
+    {
+        warned = true;
+        emit version09Detected(this->link);
+    }
+}
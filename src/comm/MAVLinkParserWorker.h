@@ -0,0 +1,105 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class MAVLinkParserWorker
+ */
+
+#ifndef MAVLINKPARSERWORKER_H
+#define MAVLINKPARSERWORKER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QAtomicInt>
+
+#include "LinkInterface.h"
+#include "QGCMAVLink.h"
+#include "QGCSpscQueue.h"
+#include "MAVLinkFrameScanner.h"
+#include "MAVLinkStatistics.h"
+
+/**
+ * @brief Parses the bytes of one link in a separate thread
+ *
+ * The worker is moved to its own thread and receives the bytes of its link
+ * through a queued connection. Decoded messages are handed to the dispatch
+ * stage through a bounded single-producer/single-consumer queue. If the
+ * queue is full, messages are dropped and counted instead of blocking the
+ * parser and backing up the link.
+ *
+ * messagesReady() is only emitted if the dispatcher has not been notified
+ * yet, the dispatcher calls acknowledge() before draining the queue.
+ */
+class MAVLinkParserWorker : public QObject
+{
+    Q_OBJECT
+public:
+    MAVLinkParserWorker(LinkInterface* link, int queueSize = 1024);
+
+    /** @brief The link parsed by this worker, only used as identifier */
+    LinkInterface* getLink() const {
+        return link;
+    }
+    /** @brief Take the next decoded message. Dispatch thread only. */
+    bool takeMessage(mavlink_message_t* message) {
+        return queue.pop(message);
+    }
+    /** @brief Re-arm the messagesReady() notification. Dispatch thread only. */
+    void acknowledge() {
+        notified.fetchAndStoreOrdered(0);
+    }
+    /** @brief Number of messages waiting for dispatch */
+    int pendingMessages() const {
+        return queue.count();
+    }
+    /** @brief Count all decoded messages in the statistics. Call before the thread is started. */
+    void setStatistics(MAVLinkLinkStatistics* statistics) {
+        this->statistics = statistics;
+    }
+    /** @brief Number of messages dropped because the queue was full */
+    int getDroppedMessages() const {
+        return int(dropped);
+    }
+
+public slots:
+    /** @brief Parse a block of received bytes */
+    void receiveBytes(LinkInterface* link, QByteArray b);
+
+signals:
+    /** @brief New messages are available in the queue */
+    void messagesReady();
+    /** @brief The link seems to talk MAVLink 0.9 or uses a wrong baud rate */
+    void version09Detected(LinkInterface* link);
+
+protected:
+    LinkInterface* link;
+    MAVLinkFrameScanner scanner;
+    QGCSpscQueue<mavlink_message_t> queue;
+    MAVLinkLinkStatistics* statistics; ///< Receive statistics of the link, may be NULL
+    QAtomicInt notified;    ///< Set while a messagesReady() notification is pending
+    QAtomicInt dropped;
+    bool warned;            ///< version09Detected() was emitted
+};
+
+#endif // MAVLINKPARSERWORKER_H
@@ -18,6 +18,8 @@
 #include <QDesktopServices>
 
 #include "MAVLinkProtocol.h"
+#include "MAVLinkFrameScanner.h"
+#include "MAVLinkParserWorker.h"
 #include "UASInterface.h"
 #include "UASManager.h"
 #include "UASInterface.h"
@@ -47,7 +49,7 @@ MAVLinkProtocol::MAVLinkProtocol() :
     m_multiplexingEnabled(false),
     m_authEnabled(false),
     m_loggingEnabled(false),
-    m_logfile(NULL),
+    m_logWriter(new MAVLinkLogWriter(this)),
     m_enable_version_check(true),
     m_paramRetransmissionTimeout(350),
     m_paramRewriteTimeout(500),
@@ -55,13 +57,18 @@ MAVLinkProtocol::MAVLinkProtocol() :
     m_actionGuardEnabled(false),
     m_actionRetransmissionTimeout(100),
     versionMismatchIgnore(false),
-    systemId(QGC::defaultSystemId)
+    systemId(QGC::defaultSystemId),
+    decodedFirstPacket(false),
+    warnedUser(false),
+    nextParser(0),
+    forwardLinksGeneration(-1)
 {
     m_authKey = "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx";
     loadSettings();
     //start(QThread::LowPriority);
     // Start heartbeat timer, emitting a heartbeat at the configured rate
     connect(heartbeatTimer, SIGNAL(timeout()), this, SLOT(sendHeartbeat()));
+    connect(m_logWriter, SIGNAL(writeFailed(QString)), this, SLOT(logWriteFailed(QString)));
     heartbeatTimer->start(1000/heartbeatRate);
     totalReceiveCounter = 0;
     totalLossCounter = 0;
@@ -89,13 +96,18 @@ void MAVLinkProtocol::loadSettings()
     enableMultiplexing(settings.value("MULTIPLEXING_ENABLED", m_multiplexingEnabled).toBool());
 
     // Only set logfile if there is a name present in settings
-    if (settings.contains("LOGFILE_NAME") && m_logfile == NULL)
+    if (settings.contains("LOGFILE_NAME") && m_logfileName.isEmpty())
     {
-        m_logfile = new QFile(settings.value("LOGFILE_NAME").toString());
+        m_logfileName = settings.value("LOGFILE_NAME").toString();
     }
-    else if (m_logfile == NULL)
+    else if (m_logfileName.isEmpty())
     {
-        m_logfile = new QFile(QDesktopServices::storageLocation(QDesktopServices::HomeLocation) + "/qgroundcontrol_packetlog.mavlink");
+        m_logfileName = QDesktopServices::storageLocation(QDesktopServices::HomeLocation) + "/qgroundcontrol_packetlog.mavlink";
+    }
+    int policy = settings.value("LOGGING_SYNC_POLICY", m_logWriter->getSyncPolicy()).toInt();
+    if (policy >= MAVLinkLogWriter::SYNC_NEVER && policy <= MAVLinkLogWriter::SYNC_BATCH)
+    {
+        m_logWriter->setSyncPolicy(static_cast<MAVLinkLogWriter::SyncPolicy>(policy));
     }
     // Enable logging
     enableLogging(settings.value("LOGGING_ENABLED", m_loggingEnabled).toBool());
@@ -133,11 +145,12 @@ void MAVLinkProtocol::storeSettings()
     settings.setValue("GCS_SYSTEM_ID", systemId);
     settings.setValue("GCS_AUTH_KEY", m_authKey);
     settings.setValue("GCS_AUTH_ENABLED", m_authEnabled);
-    if (m_logfile)
+    if (!m_logfileName.isEmpty())
     {
         // Logfile exists, store the name
-        settings.setValue("LOGFILE_NAME", m_logfile->fileName());
+        settings.setValue("LOGFILE_NAME", m_logfileName);
     }
+    settings.setValue("LOGGING_SYNC_POLICY", m_logWriter->getSyncPolicy());
     // Parameter interface settings
     settings.setValue("PARAMETER_RETRANSMISSION_TIMEOUT", m_paramRetransmissionTimeout);
     settings.setValue("PARAMETER_REWRITE_TIMEOUT", m_paramRewriteTimeout);
@@ -150,23 +163,24 @@ void MAVLinkProtocol::storeSettings()
 MAVLinkProtocol::~MAVLinkProtocol()
 {
     storeSettings();
-    if (m_logfile)
+    m_logWriter->stopLogging();
+    foreach (const LinkParseState& state, scanners)
     {
-        if (m_logfile->isOpen())
-        {
-            m_logfile->flush();
-            m_logfile->close();
-        }
-        delete m_logfile;
-        m_logfile = NULL;
+        delete state.scanner;
+    }
+    scanners.clear();
+    foreach (MAVLinkParserWorker* worker, parsers)
+    {
+        stopParser(worker);
     }
+    parsers.clear();
 }
 
 QString MAVLinkProtocol::getLogfileName()
 {
-    if (m_logfile)
+    if (!m_logfileName.isEmpty())
     {
-        return m_logfile->fileName();
+        return m_logfileName;
     }
     else
     {
@@ -174,11 +188,138 @@ QString MAVLinkProtocol::getLogfileName()
     }
 }
 
+/**
+ * @param link The link to get the frame scanner for
+ * @return The scanner holding the parse state of this link and the
+ *         statistics of the link, both created on first use
+ */
+MAVLinkProtocol::LinkParseState MAVLinkProtocol::getScanner(LinkInterface* link)
+{
+    LinkParseState state = scanners.value(link);
+    if (!state.scanner)
+    {
+        state.scanner = new MAVLinkFrameScanner();
+        state.statistics = statistics.addLink(link);
+        scanners.insert(link, state);
+        connect(link, SIGNAL(deleteLink(LinkInterface* const)), this, SLOT(removeLinkState(LinkInterface* const)));
+    }
+    return state;
+}
+
+/**
+ * Drops the parse state of a link. The link is already being destroyed,
+ * the pointer is only used as key.
+ */
+void MAVLinkProtocol::removeLinkState(LinkInterface* const link)
+{
+    delete scanners.take(link).scanner;
+    for (int i = 0; i < parsers.size(); i++)
+    {
+        if (parsers.at(i)->getLink() == link)
+        {
+            stopParser(parsers.takeAt(i));
+            break;
+        }
+    }
+    // No parser is counting anymore
+    statistics.removeLink(link);
+}
+
+/**
+ * Every link gets its own parser thread, the decoded messages are handed
+ * back to this object through a lock-free queue and dispatched in
+ * dispatchMessages(). Builds with protobuf support parse in receiveBytes(),
+ * as extended messages carry payload outside of the MAVLink frame.
+ * @param link The link to receive from
+ */
+void MAVLinkProtocol::addLink(LinkInterface* link)
+{
+#if defined(QGC_PROTOBUF_ENABLED)
+    ProtocolInterface::addLink(link);
+#else
+    foreach (MAVLinkParserWorker* worker, parsers)
+    {
+        if (worker->getLink() == link) return;
+    }
+
+    QThread* thread = new QThread();
+    MAVLinkParserWorker* worker = new MAVLinkParserWorker(link, MAVLINK_PARSER_QUEUE_SIZE);
+    worker->setStatistics(statistics.addLink(link));
+    worker->moveToThread(thread);
+    connect(link, SIGNAL(bytesReceived(LinkInterface*, QByteArray)), worker, SLOT(receiveBytes(LinkInterface*, QByteArray)), Qt::QueuedConnection);
+    connect(worker, SIGNAL(messagesReady()), this, SLOT(dispatchMessages()), Qt::QueuedConnection);
+    connect(worker, SIGNAL(version09Detected(LinkInterface*)), this, SLOT(warnVersion09(LinkInterface*)), Qt::QueuedConnection);
+    connect(link, SIGNAL(deleteLink(LinkInterface* const)), this, SLOT(removeLinkState(LinkInterface* const)));
+    parsers.append(worker);
+    thread->start();
+#endif
+}
+
+void MAVLinkProtocol::stopParser(MAVLinkParserWorker* worker)
+{
+    QThread* thread = worker->thread();
+    thread->quit();
+    thread->wait();
+    delete worker;
+    delete thread;
+}
+
+/**
+ * Takes the decoded messages of all parser threads in rounds of at most
+ * MAVLINK_DISPATCH_BATCH messages per link, so a busy link can not starve
+ * the others. After MAVLINK_DISPATCH_LIMIT messages the event loop gets
+ * control back and the dispatch is continued with a queued call.
+ */
+void MAVLinkProtocol::dispatchMessages()
+{
+    const int count = parsers.size();
+    if (count == 0) return;
+
+    foreach (MAVLinkParserWorker* worker, parsers)
+    {
+        worker->acknowledge();
+    }
+
+    mavlink_message_t message;
+    int dispatched = 0;
+    bool pending = true;
+    while (pending && dispatched < MAVLINK_DISPATCH_LIMIT)
+    {
+        pending = false;
+        // Start with a different link in every round
+        nextParser = (nextParser + 1) % count;
+        for (int i = 0; i < count; i++)
+        {
+            // A link can be removed while a message is handled
+            if (parsers.size() != count)
+            {
+                QMetaObject::invokeMethod(this, "dispatchMessages", Qt::QueuedConnection);
+                return;
+            }
+            MAVLinkParserWorker* worker = parsers.at((nextParser + i) % count);
+            int batch = 0;
+            while (batch < MAVLINK_DISPATCH_BATCH && worker->takeMessage(&message))
+            {
+                handleMessage(worker->getLink(), message);
+                batch++;
+            }
+            dispatched += batch;
+            if (batch == MAVLINK_DISPATCH_BATCH) pending = true;
+        }
+    }
+
+    if (pending)
+    {
+        QMetaObject::invokeMethod(this, "dispatchMessages", Qt::QueuedConnection);
+    }
+}
+
 /**
  * The bytes are copied by calling the LinkInterface::readBytes() method.
  * This method parses all incoming bytes and constructs a MAVLink packet.
- * It can handle multiple links in parallel, as each link has it's own buffer/
- * parsing state machine.
+ * It can handle multiple links in parallel, as each link has it's own
+ * frame scanner, which keeps incomplete frames until the next bytes arrive.
+ * The scanner works on the whole block instead of single bytes.
  * @param link The interface to read from
  * @see LinkInterface
  **/
@@ -186,252 +327,298 @@ void MAVLinkProtocol::receiveBytes(LinkInterface* link, QByteArray b)
 {
 //    receiveMutex.lock();
     mavlink_message_t message;
-    mavlink_status_t status;
 
-    static int mavlink09Count = 0;
-    static bool decodedFirstPacket = false;
-    static bool warnedUser = false;
+    const LinkParseState state = getScanner(link);
+    MAVLinkFrameScanner* scanner = state.scanner;
+    MAVLinkLinkStatistics* linkStatistics = state.statistics;
+    scanner->setInput(b.constData(), b.size());
 
-    for (int position = 0; position < b.size(); position++) {
-        unsigned int decodeState = mavlink_parse_char(link->getId(), (uint8_t)(b[position]), &message, &status);
+    while (scanner->nextMessage(&message))
+    {
+        linkStatistics->countMessage(message);
+#if defined(QGC_PROTOBUF_ENABLED)
 
-        if ((uint8_t)b[position] == 0x55) mavlink09Count++;
-        if ((mavlink09Count > 100) && !decodedFirstPacket && !warnedUser)
+        if (message.msgid == MAVLINK_MSG_ID_EXTENDED_MESSAGE)
         {
-            warnedUser = true;
-            // Obviously the user tries to use a 0.9 autopilot
-            // with QGroundControl built for version 1.0
-            emit protocolStatusMessage("MAVLink Version or Baud Rate Mismatch", "Your MAVLink device seems to use the deprecated version 0.9, while QGroundControl only supports version 1.0+. Please upgrade the MAVLink version of your autopilot. If your autopilot is using version 1.0, check if the baud rates of QGroundControl and your autopilot are the same.");
-        }
+            mavlink_extended_message_t extended_message;
 
-        if (decodeState == 1)
-        {
-            decodedFirstPacket = true;
-#if defined(QGC_PROTOBUF_ENABLED)
+            extended_message.base_msg = message;
+
+            // read extended header
+            uint8_t* payload = reinterpret_cast<uint8_t*>(message.payload64);
+
+            memcpy(&extended_message.extended_payload_len, payload + 3, 4);
 
-            if (message.msgid == MAVLINK_MSG_ID_EXTENDED_MESSAGE)
+            // Check if message is valid
+            if
+             (b.size() != MAVLINK_NUM_NON_PAYLOAD_BYTES+MAVLINK_EXTENDED_HEADER_LEN+ extended_message.extended_payload_len)
             {
-                mavlink_extended_message_t extended_message;
+                //invalid message
+                qDebug() << "GOT INVALID EXTENDED MESSAGE, ABORTING";
+                return;
+            }
+
+            const uint8_t* extended_payload = reinterpret_cast<const uint8_t*>(b.constData()) + MAVLINK_NUM_NON_PAYLOAD_BYTES + MAVLINK_EXTENDED_HEADER_LEN;
 
-                extended_message.base_msg = message;
+            // copy extended payload data
+            memcpy(extended_message.extended_payload, extended_payload, extended_message.extended_payload_len);
 
-                // read extended header
-                uint8_t* payload = reinterpret_cast<uint8_t*>(message.payload64);
+#if defined(QGC_USE_PIXHAWK_MESSAGES)
 
-                memcpy(&extended_message.extended_payload_len, payload + 3, 4);
+            if (protobufManager.cacheFragment(extended_message))
+            {
+                std::tr1::shared_ptr<google::protobuf::Message> protobuf_msg;
 
-                // Check if message is valid
-                if
-                 (b.size() != MAVLINK_NUM_NON_PAYLOAD_BYTES+MAVLINK_EXTENDED_HEADER_LEN+ extended_message.extended_payload_len)
+                if (protobufManager.getMessage(protobuf_msg))
                 {
-                    //invalid message
-                    qDebug() << "GOT INVALID EXTENDED MESSAGE, ABORTING";
-                    return;
-                }
+                    const google::protobuf::Descriptor* descriptor = protobuf_msg->GetDescriptor();
+                    if (!descriptor)
+                    {
+                        continue;
+                    }
 
-                const uint8_t* extended_payload = reinterpret_cast<const uint8_t*>(b.constData()) + MAVLINK_NUM_NON_PAYLOAD_BYTES + MAVLINK_EXTENDED_HEADER_LEN;
+                    const google::protobuf::FieldDescriptor* headerField = descriptor->FindFieldByName("header");
+                    if (!headerField)
+                    {
+                        continue;
+                    }
 
-                // copy extended payload data
-                memcpy(extended_message.extended_payload, extended_payload, extended_message.extended_payload_len);
+                    const google::protobuf::Descriptor* headerDescriptor = headerField->message_type();
+                    if (!headerDescriptor)
+                    {
+                        continue;
+                    }
 
-#if defined(QGC_USE_PIXHAWK_MESSAGES)
+                    const google::protobuf::FieldDescriptor* sourceSysIdField = headerDescriptor->FindFieldByName("source_sysid");
+                    if (!sourceSysIdField)
+                    {
+                        continue;
+                    }
 
-                if (protobufManager.cacheFragment(extended_message))
-                {
-                    std::tr1::shared_ptr<google::protobuf::Message> protobuf_msg;
+                    const google::protobuf::Reflection* reflection = protobuf_msg->GetReflection();
+                    const google::protobuf::Message& headerMsg = reflection->GetMessage(*protobuf_msg, headerField);
+                    const google::protobuf::Reflection* headerReflection = headerMsg.GetReflection();
 
-                    if (protobufManager.getMessage(protobuf_msg))
+                    int source_sysid = headerReflection->GetInt32(headerMsg, sourceSysIdField);
+
+                    UASInterface* uas = UASManager::instance()->getUASForId(source_sysid);
+
+                    if (uas != NULL)
                     {
-                        const google::protobuf::Descriptor* descriptor = protobuf_msg->GetDescriptor();
-                        if (!descriptor)
-                        {
-                            continue;
-                        }
-
-                        const google::protobuf::FieldDescriptor* headerField = descriptor->FindFieldByName("header");
-                        if (!headerField)
-                        {
-                            continue;
-                        }
-
-                        const google::protobuf::Descriptor* headerDescriptor = headerField->message_type();
-                        if (!headerDescriptor)
-                        {
-                            continue;
-                        }
-
-                        const google::protobuf::FieldDescriptor* sourceSysIdField = headerDescriptor->FindFieldByName("source_sysid");
-                        if (!sourceSysIdField)
-                        {
-                            continue;
-                        }
-
-                        const google::protobuf::Reflection* reflection = protobuf_msg->GetReflection();
-                        const google::protobuf::Message& headerMsg = reflection->GetMessage(*protobuf_msg, headerField);
-                        const google::protobuf::Reflection* headerReflection = headerMsg.GetReflection();
-
-                        int source_sysid = headerReflection->GetInt32(headerMsg, sourceSysIdField);
-
-                        UASInterface* uas = UASManager::instance()->getUASForId(source_sysid);
-
-                        if (uas != NULL)
-                        {
-                            emit extendedMessageReceived(link, protobuf_msg);
-                        }
+                        emit extendedMessageReceived(link, protobuf_msg);
                     }
                 }
+            }
 #endif
 
-                position += extended_message.extended_payload_len;
+            scanner->skip(extended_message.extended_payload_len);
 
-                continue;
-            }
+            continue;
+        }
 #endif
 
-            // Log data
-            if (m_loggingEnabled && m_logfile)
-            {
-                uint8_t buf[MAVLINK_MAX_PACKET_LEN+sizeof(quint64)];
-                quint64 time = QGC::groundTimeUsecs();
-                memcpy(buf, (void*)&time, sizeof(quint64));
-                // Write message to buffer
-                int len = mavlink_msg_to_send_buffer(buf+sizeof(quint64), &message);
-                QByteArray b((const char*)buf, len);
-                if(m_logfile->write(b) != len)
-                {
-                    emit protocolStatusMessage(tr("MAVLink Logging failed"), tr("Could not write to file %1, disabling logging.").arg(m_logfile->fileName()));
-                    // Stop logging
-                    enableLogging(false);
-                }
-            }
+        handleMessage(link, message);
+    }
+    linkStatistics->setParseErrors(scanner->getParseErrors());
+
+    if (scanner->getVersion09Markers() > 100)
+    {
+        warnVersion09(link);
+    }
+}
+
+/**
+ * The message is forwarded exactly as it was received. The header, the
+ * payload and the checksum are stored in the message struct in wire order,
+ * starting at the magic byte, so no re-encoding is necessary.
+ * @param link The link the message was received on, it is not forwarded to it
+ * @param message The received message
+ */
+void MAVLinkProtocol::forwardMessage(LinkInterface* link, const mavlink_message_t& message)
+{
+    // Only copy the link list if the links of this protocol changed
+    LinkManager* manager = LinkManager::instance();
+    if (forwardLinksGeneration != manager->getProtocolLinksGeneration())
+    {
+        forwardLinks = manager->getLinksForProtocol(this);
+        forwardLinksGeneration = manager->getProtocolLinksGeneration();
+    }
 
-            // ORDER MATTERS HERE!
-            // If the matching UAS object does not yet exist, it has to be created
-            // before emitting the packetReceived signal
+    const char* frame = reinterpret_cast<const char*>(&message.magic);
+    const int length = message.len + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+    const int count = forwardLinks.size();
+    for (int i = 0; i < count; i++)
+    {
+        LinkInterface* currLink = forwardLinks.at(i);
+        if (currLink != link && currLink->isConnected())
+        {
+            scheduler.sendFrame(currLink, frame, length);
+            currLink->addForwardedBytes(length);
+        }
+    }
+}
 
-            UASInterface* uas = UASManager::instance()->getUASForId(message.sysid);
+/**
+ * Warns the user once, as long as no valid MAVLink 1.0 packet was decoded.
+ */
+void MAVLinkProtocol::warnVersion09(LinkInterface* link)
+{
+    Q_UNUSED(link);
+    if (!decodedFirstPacket && !warnedUser)
+    {
+        warnedUser = true;
+        // Obviously the user tries to use a 0.9 autopilot
+        // with QGroundControl built for version 1.0
+        emit protocolStatusMessage("MAVLink Version or Baud Rate Mismatch", "Your MAVLink device seems to use the deprecated version 0.9, while QGroundControl only supports version 1.0+. Please upgrade the MAVLink version of your autopilot. If your autopilot is using version 1.0, check if the baud rates of QGroundControl and your autopilot are the same.");
+    }
+}
 
-            // Check and (if necessary) create UAS object
-            if (uas == NULL && message.msgid == MAVLINK_MSG_ID_HEARTBEAT)
-            {
-                // ORDER MATTERS HERE!
-                // The UAS object has first to be created and connected,
-                // only then the rest of the application can be made aware
-                // of its existence, as it only then can send and receive
-                // it's first messages.
-
-                // Check if the UAS has the same id like this system
-                if (message.sysid == getSystemId())
-                {
-                    emit protocolStatusMessage(tr("SYSTEM ID CONFLICT!"), tr("Warning: A second system is using the same system id (%1)").arg(getSystemId()));
-                }
+/**
+ * Logs the message, creates the UAS object on the first heartbeat of a
+ * system, updates the loss statistics, delivers the message to the
+ * subscribers of its message id and emits messageHandleReceived().
+ * @param link The link the message was received on
+ * @param message The decoded message
+ */
+void MAVLinkProtocol::handleMessage(LinkInterface* link, const mavlink_message_t& message)
+{
+    decodedFirstPacket = true;
 
-                // Create a new UAS based on the heartbeat received
-                // Todo dynamically load plugin at run-time for MAV
-                // WIKISEARCH:AUTOPILOT_TYPE_INSTANTIATION
+    // Log data, the writer thread writes it to the disk
+    if (m_loggingEnabled)
+    {
+        m_logWriter->append(QGC::groundTimeUsecs(), message);
+    }
 
-                // First create new UAS object
-                // Decode heartbeat message
-                mavlink_heartbeat_t heartbeat;
-                // Reset version field to 0
-                heartbeat.mavlink_version = 0;
-                mavlink_msg_heartbeat_decode(&message, &heartbeat);
+    // ORDER MATTERS HERE!
+    // If the matching UAS object does not yet exist, it has to be created
+    // before emitting the packetReceived signal
 
-                // Check if the UAS has a different protocol version
-                if (m_enable_version_check && (heartbeat.mavlink_version != MAVLINK_VERSION))
-                {
-                    // Bring up dialog to inform user
-                    if (!versionMismatchIgnore)
-                    {
-                        emit protocolStatusMessage(tr("The MAVLink protocol version on the MAV and QGroundControl mismatch!"),
-                                                   tr("It is unsafe to use different MAVLink versions. QGroundControl therefore refuses to connect to system %1, which sends MAVLink version %2 (QGroundControl uses version %3).").arg(message.sysid).arg(heartbeat.mavlink_version).arg(MAVLINK_VERSION));
-                        versionMismatchIgnore = true;
-                    }
+    UASInterface* uas = UASManager::instance()->getUASForId(message.sysid);
 
-                    // Ignore this message and continue gracefully
-                    continue;
-                }
+    // Check and (if necessary) create UAS object
+    if (uas == NULL && message.msgid == MAVLINK_MSG_ID_HEARTBEAT)
+    {
+        // ORDER MATTERS HERE!
+        // The UAS object has first to be created and connected,
+        // only then the rest of the application can be made aware
+        // of its existence, as it only then can send and receive
+        // it's first messages.
+
+        // Check if the UAS has the same id like this system
+        if (message.sysid == getSystemId())
+        {
+            emit protocolStatusMessage(tr("SYSTEM ID CONFLICT!"), tr("Warning: A second system is using the same system id (%1)").arg(getSystemId()));
+        }
 
-                // Create a new UAS object
-                uas = QGCMAVLinkUASFactory::createUAS(this, link, message.sysid, &heartbeat);
-            }
+        // Create a new UAS based on the heartbeat received
+        // Todo dynamically load plugin at run-time for MAV
+        // WIKISEARCH:AUTOPILOT_TYPE_INSTANTIATION
 
-            // Only count message if UAS exists for this message
-            if (uas != NULL)
+        // First create new UAS object
+        // Decode heartbeat message
+        mavlink_heartbeat_t heartbeat;
+        // Reset version field to 0
+        heartbeat.mavlink_version = 0;
+        mavlink_msg_heartbeat_decode(&message, &heartbeat);
+
+        // Check if the UAS has a different protocol version
+        if (m_enable_version_check && (heartbeat.mavlink_version != MAVLINK_VERSION))
+        {
+            // Bring up dialog to inform user
+            if (!versionMismatchIgnore)
             {
+                emit protocolStatusMessage(tr("The MAVLink protocol version on the MAV and QGroundControl mismatch!"),
+                                           tr("It is unsafe to use different MAVLink versions. QGroundControl therefore refuses to connect to system %1, which sends MAVLink version %2 (QGroundControl uses version %3).").arg(message.sysid).arg(heartbeat.mavlink_version).arg(MAVLINK_VERSION));
+                versionMismatchIgnore = true;
+            }
 
-                // Increase receive counter
-                totalReceiveCounter++;
-                currReceiveCounter++;
+            // Ignore this message and continue gracefully
+            return;
+        }
 
-                // Update last message sequence ID
-                uint8_t expectedIndex;
-                if (lastIndex[message.sysid][message.compid] == -1)
-                {
-                    lastIndex[message.sysid][message.compid] = message.seq;
-                    expectedIndex = message.seq;
-                }
-                else
-                {
-                    // NOTE: Using uint8_t here auto-wraps the number around to 0.
-                    expectedIndex = lastIndex[message.sysid][message.compid] + 1;
-                }
+        // Create a new UAS object
+        uas = QGCMAVLinkUASFactory::createUAS(this, link, message.sysid, &heartbeat);
+    }
 
-                // Make some noise if a message was skipped
-                //qDebug() << "SYSID" << message.sysid << "COMPID" << message.compid << "MSGID" << message.msgid << "EXPECTED INDEX:" << expectedIndex << "SEQ" << message.seq;
-                if (message.seq != expectedIndex)
-                {
-                    // Determine how many messages were skipped accounting for 0-wraparound
-                    int16_t lostMessages = message.seq - expectedIndex; 
-                    if (lostMessages < 0)
-                    {
-                        // Usually, this happens in the case of an out-of order packet
-                        lostMessages = 0;
-                    }
-                    else
-                    {
-                        // Console generates excessive load at high loss rates, needs better GUI visualization
-                        //qDebug() << QString("Lost %1 messages for comp %4: expected sequence ID %2 but received %3.").arg(lostMessages).arg(expectedIndex).arg(message.seq).arg(message.compid);
-                    }
-                    totalLossCounter += lostMessages;
-                    currLossCounter += lostMessages;
-                }
+    // Only count message if UAS exists for this message
+    if (uas != NULL)
+    {
 
-                // Update the last sequence ID
-                lastIndex[message.sysid][message.compid] = message.seq;
+        // Increase receive counter
+        totalReceiveCounter++;
+        currReceiveCounter++;
 
-                // Update on every 32th packet
-                if (totalReceiveCounter % 32 == 0)
-                {
-                    // Calculate new loss ratio
-                    // Receive loss
-                    float receiveLoss = (double)currLossCounter/(double)(currReceiveCounter+currLossCounter);
-                    receiveLoss *= 100.0f;
-                    currLossCounter = 0;
-                    currReceiveCounter = 0;
-                    emit receiveLossChanged(message.sysid, receiveLoss);
-                }
+        // Update last message sequence ID
+        uint8_t expectedIndex;
+        if (lastIndex[message.sysid][message.compid] == -1)
+        {
+            lastIndex[message.sysid][message.compid] = message.seq;
+            expectedIndex = message.seq;
+        }
+        else
+        {
+            // NOTE: Using uint8_t here auto-wraps the number around to 0.
+            expectedIndex = lastIndex[message.sysid][message.compid] + 1;
+        }
 
-                // The packet is emitted as a whole, as it is only 255 - 261 bytes short
-                // kind of inefficient, but no issue for a groundstation pc.
-                // It buys as reentrancy for the whole code over all threads
-                emit messageReceived(link, message);
+        // Make some noise if a message was skipped
+        //qDebug() << "SYSID" << message.sysid << "COMPID" << message.compid << "MSGID" << message.msgid << "EXPECTED INDEX:" << expectedIndex << "SEQ" << message.seq;
+        if (message.seq != expectedIndex)
+        {
+            // Determine how many messages were skipped accounting for 0-wraparound
+            int16_t lostMessages = message.seq - expectedIndex; 
+            if (lostMessages < 0)
+            {
+                // Usually, this happens in the case of an out-of order packet
+                lostMessages = 0;
+            }
+            else
+            {
+                // Console generates excessive load at high loss rates, needs better GUI visualization
+                //qDebug() << QString("Lost %1 messages for comp %4: expected sequence ID %2 but received %3.").arg(lostMessages).arg(expectedIndex).arg(message.seq).arg(message.compid);
+            }
+            totalLossCounter += lostMessages;
+            currLossCounter += lostMessages;
+        }
 
-                // Multiplex message if enabled
-                if (m_multiplexingEnabled)
-                {
-                    // Get all links connected to this unit
-                    QList<LinkInterface*> links = LinkManager::instance()->getLinksForProtocol(this);
+        // Update the last sequence ID
+        lastIndex[message.sysid][message.compid] = message.seq;
 
-                    // Emit message on all links that are currently connected
-                    foreach (LinkInterface* currLink, links)
-                    {
-                        // Only forward this message to the other links,
-                        // not the link the message was received on
-                        if (currLink != link) sendMessage(currLink, message, message.sysid, message.compid);
-                    }
-                }
-            }
+        // Update on every 32th packet
+        if (totalReceiveCounter % 32 == 0)
+        {
+            // Calculate new loss ratio
+            // Receive loss
+            float receiveLoss = (double)currLossCounter/(double)(currReceiveCounter+currLossCounter);
+            receiveLoss *= 100.0f;
+            currLossCounter = 0;
+            currReceiveCounter = 0;
+            emit receiveLossChanged(message.sysid, receiveLoss);
+        }
+
+        // Deliver to the components which subscribed to this message id
+        dispatcher.dispatch(link, message);
+
+        // The packet is copied once into a pooled block, the receivers
+        // only share a reference to it. Nothing is allocated if nobody
+        // is connected.
+        if (receivers(SIGNAL(messageHandleReceived(LinkInterface*,MAVLinkMessageHandle))) > 0)
+        {
+            emit messageHandleReceived(link, MAVLinkMessagePool::instance()->allocate(message));
+        }
+
+        // The by-value signal copies the packet for every receiver,
+        // skip it if nobody is connected
+        if (receivers(SIGNAL(messageReceived(LinkInterface*,mavlink_message_t))) > 0)
+        {
+            emit messageReceived(link, message);
+        }
+
+        // Multiplex message if enabled
+        if (m_multiplexingEnabled)
+        {
+            forwardMessage(link, message);
         }
     }
 }
@@ -484,19 +671,7 @@ void MAVLinkProtocol::sendMessage(mavlink_message_t message)
  */
 void MAVLinkProtocol::sendMessage(LinkInterface* link, mavlink_message_t message)
 {
-    // Create buffer
-    static uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
-    // Rewriting header to ensure correct link ID is set
-    static uint8_t messageKeys[256] = MAVLINK_MESSAGE_CRCS;
-    if (link->getId() != 0) mavlink_finalize_message_chan(&message, this->getSystemId(), this->getComponentId(), link->getId(), message.len, messageKeys[message.msgid]);
-    // Write message into buffer, prepending start sign
-    int len = mavlink_msg_to_send_buffer(buffer, &message);
-    // If link is connected
-    if (link->isConnected())
-    {
-        // Send the portion of the buffer now occupied by the message
-        link->writeBytes((const char*)buffer, len);
-    }
+    sendMessage(link, message, getSystemId(), getComponentId());
 }
 
 /**
@@ -507,19 +682,8 @@ void MAVLinkProtocol::sendMessage(LinkInterface* link, mavlink_message_t message
  */
 void MAVLinkProtocol::sendMessage(LinkInterface* link, mavlink_message_t message, quint8 systemid, quint8 componentid)
 {
-    // Create buffer
-    static uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
-    // Rewriting header to ensure correct link ID is set
-    static uint8_t messageKeys[256] = MAVLINK_MESSAGE_CRCS;
-    if (link->getId() != 0) mavlink_finalize_message_chan(&message, systemid, componentid, link->getId(), message.len, messageKeys[message.msgid]);
-    // Write message into buffer, prepending start sign
-    int len = mavlink_msg_to_send_buffer(buffer, &message);
-    // If link is connected
-    if (link->isConnected())
-    {
-        // Send the portion of the buffer now occupied by the message
-        link->writeBytes((const char*)buffer, len);
-    }
+    // The scheduler encodes the message and writes it by priority and link budget
+    scheduler.sendMessage(link, message, systemid, componentid);
 }
 
 /**
@@ -619,53 +783,38 @@ void MAVLinkProtocol::enableLogging(bool enabled)
 
     if (enabled)
     {
-        if (m_logfile && m_logfile->isOpen())
-        {
-            m_logfile->flush();
-            m_logfile->close();
-        }
-
-        if (m_logfile)
+        if (!m_logfileName.isEmpty())
         {
-            if (!m_logfile->open(QIODevice::WriteOnly | QIODevice::Append))
+            if (!m_logWriter->startLogging(m_logfileName))
             {
-                emit protocolStatusMessage(tr("Opening MAVLink logfile for writing failed"), tr("MAVLink cannot log to the file %1, please choose a different file. Stopping logging.").arg(m_logfile->fileName()));
-                m_loggingEnabled = false;
+                emit protocolStatusMessage(tr("Opening MAVLink logfile for writing failed"), tr("MAVLink cannot log to the file %1, please choose a different file. Stopping logging.").arg(m_logfileName));
+                enabled = false;
             }
         }
         else
         {
             emit protocolStatusMessage(tr("Opening MAVLink logfile for writing failed"), tr("MAVLink cannot start logging, no logfile selected."));
+            enabled = false;
         }
     }
-    else if (!enabled)
+    else
     {
-        if (m_logfile)
-        {
-            if (m_logfile->isOpen())
-            {
-                m_logfile->flush();
-                m_logfile->close();
-            }
-        }
+        m_logWriter->stopLogging();
     }
     m_loggingEnabled = enabled;
     if (changed) emit loggingChanged(enabled);
 }
 
+void MAVLinkProtocol::logWriteFailed(const QString& fileName)
+{
+    emit protocolStatusMessage(tr("MAVLink Logging failed"), tr("Could not write to file %1, packets are lost until writing succeeds again.").arg(fileName));
+}
+
 void MAVLinkProtocol::setLogfileName(const QString& filename)
 {
-    if (!m_logfile)
-    {
-        m_logfile = new QFile(filename);
-    }
-    else
-    {
-        m_logfile->flush();
-        m_logfile->close();
-    }
-    m_logfile->setFileName(filename);
-    enableLogging(m_loggingEnabled);
+    m_logfileName = filename;
+    // Restart logging with the new file
+    if (m_loggingEnabled) enableLogging(true);
 }
 
 void MAVLinkProtocol::enableVersionCheck(bool enabled)
@@ -36,11 +36,17 @@ This file is part of the QGROUNDCONTROL project
 #include <QTimer>
 #include <QFile>
 #include <QMap>
+#include <QHash>
 #include <QByteArray>
 #include "ProtocolInterface.h"
 #include "LinkInterface.h"
 #include "QGCMAVLink.h"
 #include "QGC.h"
+#include "MAVLinkMessagePool.h"
+#include "MAVLinkMessageDispatcher.h"
+#include "MAVLinkLogWriter.h"
+#include "MAVLinkStatistics.h"
+#include "MAVLinkSendScheduler.h"
 
 #if defined(QGC_PROTOBUF_ENABLED)
 #include <tr1/memory>
@@ -50,6 +56,15 @@ This file is part of the QGROUNDCONTROL project
 #endif
 #endif
 
+class MAVLinkFrameScanner;
+class MAVLinkParserWorker;
+
+/** Maximum number of decoded messages waiting for dispatch per link */
+#define MAVLINK_PARSER_QUEUE_SIZE 1024
+/** Messages taken from one link before the next link is served */
+#define MAVLINK_DISPATCH_BATCH 16
+/** Messages dispatched before the event loop is serviced again */
+#define MAVLINK_DISPATCH_LIMIT 1024
 
 /**
  * @brief MAVLink micro air vehicle protocol reference implementation.
@@ -68,6 +83,8 @@ public:
 
     /** @brief Get the human-friendly name of this protocol */
     QString getName();
+    /** @brief Start a parser thread for the link */
+    void addLink(LinkInterface* link);
     /** @brief Get the system id of this application */
     int getSystemId();
     /** @brief Get the component id of this application */
@@ -104,6 +121,10 @@ public:
     }
     /** @brief Get the name of the packet log file */
     QString getLogfileName();
+    /** @brief Get the packet log writer, e.g. for its statistics */
+    MAVLinkLogWriter* getLogWriter() {
+        return m_logWriter;
+    }
     /** @brief Get state of parameter retransmission */
     bool paramGuardEnabled() {
         return m_paramGuardEnabled;
@@ -124,6 +145,18 @@ public:
     int getActionRetransmissionTimeout() {
         return m_actionRetransmissionTimeout;
     }
+    /** @brief Get the dispatcher delivering messages by message id */
+    MAVLinkMessageDispatcher* getDispatcher() {
+        return &dispatcher;
+    }
+    /** @brief Get the scheduler ordering and pacing all outgoing messages */
+    MAVLinkSendScheduler* getSendScheduler() {
+        return &scheduler;
+    }
+    /** @brief Get the receive statistics of all links */
+    MAVLinkStatistics* getStatistics() {
+        return &statistics;
+    }
 
 public slots:
     /** @brief Receive bytes from a communication interface */
@@ -185,6 +218,16 @@ public slots:
     /** @brief Store protocol settings */
     void storeSettings();
 
+protected slots:
+    /** @brief Drop the parse state of a link that is being deleted */
+    void removeLinkState(LinkInterface* const link);
+    /** @brief Handle the messages decoded by the parser threads */
+    void dispatchMessages();
+    /** @brief Warn the user about a MAVLink 0.9 device or a wrong baud rate */
+    void warnVersion09(LinkInterface* link);
+    /** @brief Inform the user about a failed write to the logfile */
+    void logWriteFailed(const QString& fileName);
+
 protected:
     QTimer* heartbeatTimer;    ///< Timer to emit heartbeats
     int heartbeatRate;         ///< Heartbeat rate, controls the timer interval
@@ -193,7 +236,8 @@ protected:
     bool m_authEnabled;        ///< Enable authentication token broadcast
     QString m_authKey;         ///< Authentication key
     bool m_loggingEnabled;     ///< Enable/disable packet logging
-    QFile* m_logfile;           ///< Logfile
+    QString m_logfileName;     ///< Logfile
+    MAVLinkLogWriter* m_logWriter; ///< Writes the logfile in a background thread
     bool m_enable_version_check; ///< Enable checking of version match of MAV and QGC
     int m_paramRetransmissionTimeout; ///< Timeout for parameter retransmission
     int m_paramRewriteTimeout;    ///< Timeout for sending re-write request
@@ -208,6 +252,34 @@ protected:
     int currLossCounter;
     bool versionMismatchIgnore;
     int systemId;
+    bool decodedFirstPacket;   ///< At least one valid MAVLink 1.0 packet was decoded
+    bool warnedUser;           ///< User was warned about a MAVLink 0.9 / baud rate mismatch
+    /** @brief Parse state of a link parsed in receiveBytes() */
+    struct LinkParseState
+    {
+        LinkParseState() : scanner(NULL), statistics(NULL) {}
+        MAVLinkFrameScanner* scanner;
+        MAVLinkLinkStatistics* statistics; ///< Cached, the lookup locks the statistics
+    };
+    QHash<LinkInterface*, LinkParseState> scanners; ///< Per-link frame parse state
+
+    QList<MAVLinkParserWorker*> parsers; ///< Parser threads, in dispatch order
+    MAVLinkMessageDispatcher dispatcher; ///< Subscriptions by message id
+    MAVLinkStatistics statistics; ///< Receive statistics by link, system, component and message id
+    MAVLinkSendScheduler scheduler; ///< Priority queues and rate limits of the outgoing messages
+    int nextParser;            ///< First parser served in the next dispatch round
+
+    /** @brief Get the frame scanner and the statistics of a link */
+    LinkParseState getScanner(LinkInterface* link);
+    QList<LinkInterface*> forwardLinks; ///< Cached links of this protocol, used for multiplexing
+    int forwardLinksGeneration; ///< Link generation of LinkManager forwardLinks was copied at
+
+    /** @brief Handle one decoded message */
+    void handleMessage(LinkInterface* link, const mavlink_message_t& message);
+    /** @brief Forward the unchanged frame of a message to all other links */
+    void forwardMessage(LinkInterface* link, const mavlink_message_t& message);
+    /** @brief Stop the thread of a parser and delete it */
+    void stopParser(MAVLinkParserWorker* worker);
 #if defined(QGC_PROTOBUF_ENABLED) && defined(QGC_USE_PIXHAWK_MESSAGES)
     mavlink::ProtobufManager protobufManager;
 #endif
@@ -215,6 +287,8 @@ protected:
 signals:
     /** @brief Message received and directly copied via signal */
     void messageReceived(LinkInterface* link, mavlink_message_t message);
+    /** @brief Message received, shared with all receivers through a pooled handle */
+    void messageHandleReceived(LinkInterface* link, MAVLinkMessageHandle message);
 #if defined(QGC_PROTOBUF_ENABLED)
     /** @brief Message received via signal */
     void extendedMessageReceived(LinkInterface *link, std::tr1::shared_ptr<google::protobuf::Message> message);
@@ -0,0 +1,432 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class MAVLinkSendScheduler
+ */
+
+#include <string.h>
+#include <math.h>
+#include <QMutexLocker>
+#include <QMetaObject>
+
+#include "MAVLinkSendScheduler.h"
+#include "LinkInterface.h"
+
+/**
+ * @brief Offsets of the target fields in the payload of each message
+ *
+ * Built once from the field descriptions of the message definitions.
+ * MANUAL_CONTROL names its target system "target".
+ */
+class MAVLinkSendTargetTable
+{
+public:
+    MAVLinkSendTargetTable()
+    {
+        static const mavlink_message_info_t info[256] = MAVLINK_MESSAGE_INFO;
+        for (int msgid = 0; msgid < 256; msgid++)
+        {
+            system[msgid] = -1;
+            component[msgid] = -1;
+            for (unsigned int f = 0; f < info[msgid].num_fields; f++)
+            {
+                const mavlink_field_info_t& field = info[msgid].fields[f];
+                if (!field.name || field.type != MAVLINK_TYPE_UINT8_T || field.array_length != 0) continue;
+                if (strcmp(field.name, "target_system") == 0 || strcmp(field.name, "target") == 0)
+                {
+                    system[msgid] = field.wire_offset;
+                }
+                else if (strcmp(field.name, "target_component") == 0)
+                {
+                    component[msgid] = field.wire_offset;
+                }
+            }
+        }
+    }
+
+    int system[256];
+    int component[256];
+};
+
+static const MAVLinkSendTargetTable targetTable;
+
+MAVLinkSendScheduler::LinkQueue::LinkQueue(LinkInterface* link) :
+    link(link),
+    mutex(QMutex::Recursive),
+    configuredRate(0),
+    rate(-1),
+    tokens(MAVLINK_MAX_PACKET_LEN),
+    lastRefill(0)
+{
+    memset(statistics, 0, sizeof(statistics));
+}
+
+MAVLinkSendScheduler::LinkQueue::~LinkQueue()
+{
+    for (int i = 0; i < PRIORITY_COUNT; i++)
+    {
+        qDeleteAll(frames[i]);
+    }
+}
+
+MAVLinkSendScheduler::MAVLinkSendScheduler(QObject* parent) :
+    QObject(parent),
+    timer(this),
+    flushScheduled(0)
+{
+    clock.start();
+    timer.setSingleShot(true);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+MAVLinkSendScheduler::~MAVLinkSendScheduler()
+{
+    timer.stop();
+    qDeleteAll(queues);
+    queues.clear();
+}
+
+MAVLinkSendScheduler::Priority MAVLinkSendScheduler::getPriority(quint8 msgid)
+{
+    switch (msgid)
+    {
+    case MAVLINK_MSG_ID_MANUAL_CONTROL:
+    case MAVLINK_MSG_ID_MANUAL_SETPOINT:
+    case MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE:
+    case MAVLINK_MSG_ID_SET_ROLL_PITCH_YAW_THRUST:
+    case MAVLINK_MSG_ID_SET_ROLL_PITCH_YAW_SPEED_THRUST:
+    case MAVLINK_MSG_ID_SET_QUAD_MOTORS_SETPOINT:
+    case MAVLINK_MSG_ID_SET_QUAD_SWARM_ROLL_PITCH_YAW_THRUST:
+    case MAVLINK_MSG_ID_SET_QUAD_SWARM_LED_ROLL_PITCH_YAW_THRUST:
+    case MAVLINK_MSG_ID_SETPOINT_6DOF:
+    case MAVLINK_MSG_ID_SETPOINT_8DOF:
+    case MAVLINK_MSG_ID_HIL_STATE:
+    case MAVLINK_MSG_ID_HIL_CONTROLS:
+    case MAVLINK_MSG_ID_HIL_RC_INPUTS_RAW:
+        return PRIORITY_CONTROL;
+    case MAVLINK_MSG_ID_HEARTBEAT:
+    case MAVLINK_MSG_ID_COMMAND_LONG:
+    case MAVLINK_MSG_ID_COMMAND_ACK:
+    case MAVLINK_MSG_ID_SET_MODE:
+    case MAVLINK_MSG_ID_MISSION_SET_CURRENT:
+    case MAVLINK_MSG_ID_SET_LOCAL_POSITION_SETPOINT:
+    case MAVLINK_MSG_ID_SET_GLOBAL_POSITION_SETPOINT_INT:
+    case MAVLINK_MSG_ID_AUTH_KEY:
+        return PRIORITY_COMMAND;
+    case MAVLINK_MSG_ID_PARAM_REQUEST_READ:
+    case MAVLINK_MSG_ID_PARAM_REQUEST_LIST:
+    case MAVLINK_MSG_ID_PARAM_VALUE:
+    case MAVLINK_MSG_ID_PARAM_SET:
+    case MAVLINK_MSG_ID_MISSION_ITEM:
+    case MAVLINK_MSG_ID_MISSION_REQUEST:
+    case MAVLINK_MSG_ID_MISSION_REQUEST_LIST:
+    case MAVLINK_MSG_ID_MISSION_COUNT:
+    case MAVLINK_MSG_ID_MISSION_CLEAR_ALL:
+    case MAVLINK_MSG_ID_MISSION_ACK:
+        return PRIORITY_BULK;
+    default:
+        return PRIORITY_NORMAL;
+    }
+}
+
+/**
+ * Continuous control streams and heartbeats only carry the latest state,
+ * a waiting older frame is worthless once a new one is sent.
+ */
+bool MAVLinkSendScheduler::isCoalesced(quint8 msgid)
+{
+    return (getPriority(msgid) == PRIORITY_CONTROL || msgid == MAVLINK_MSG_ID_HEARTBEAT);
+}
+
+int MAVLinkSendScheduler::getCoalescingKey(const quint8* frame, int length)
+{
+    const quint8 msgid = frame[5];
+    if (!isCoalesced(msgid)) return -1;
+    if (msgid == MAVLINK_MSG_ID_HEARTBEAT)
+    {
+        // The sender is the only thing telling heartbeats apart
+        return msgid | (frame[3] << 8) | (frame[4] << 16);
+    }
+
+    // The sender of control messages is always this station, the target tells them apart
+    const quint8* payload = frame + MAVLINK_NUM_HEADER_BYTES;
+    const int payloadLength = length - MAVLINK_NUM_NON_PAYLOAD_BYTES;
+    const int system = targetTable.system[msgid];
+    const int component = targetTable.component[msgid];
+    if (system < 0 || system >= payloadLength) return -1;
+    const quint8 targetComponent = (component >= 0 && component < payloadLength) ? payload[component] : 0;
+    return msgid | (payload[system] << 8) | (targetComponent << 16);
+}
+
+/**
+ * The message is encoded for the channel of the link immediately, so the
+ * sequence numbers are assigned in call order.
+ * @param link the link to send the message over
+ * @param message message to send
+ * @param systemid id of the system the message is originating from
+ * @param componentid id of the component the message is originating from
+ */
+void MAVLinkSendScheduler::sendMessage(LinkInterface* link, mavlink_message_t message, quint8 systemid, quint8 componentid)
+{
+    static const uint8_t messageKeys[256] = MAVLINK_MESSAGE_CRCS;
+
+    Frame* frame = new Frame();
+    encodeMutex.lock();
+    // Rewriting header to ensure correct link ID is set
+    if (link->getId() != 0) mavlink_finalize_message_chan(&message, systemid, componentid, link->getId(), message.len, messageKeys[message.msgid]);
+    encodeMutex.unlock();
+    frame->length = mavlink_msg_to_send_buffer(frame->data, &message);
+    frame->key = getCoalescingKey(frame->data, frame->length);
+
+    if (!link->isConnected())
+    {
+        delete frame;
+        return;
+    }
+    enqueue(getQueue(link), frame, getPriority(message.msgid));
+}
+
+/**
+ * @param link the link to send the frame over
+ * @param frame the complete frame, starting with the start sign
+ * @param length the length of the frame
+ */
+void MAVLinkSendScheduler::sendFrame(LinkInterface* link, const char* frame, int length)
+{
+    if (length < MAVLINK_NUM_NON_PAYLOAD_BYTES || length > MAVLINK_MAX_PACKET_LEN || !link->isConnected()) return;
+
+    const quint8* bytes = reinterpret_cast<const quint8*>(frame);
+    const quint8 msgid = bytes[5];
+    Frame* copy = new Frame();
+    memcpy(copy->data, bytes, length);
+    copy->length = length;
+    copy->key = getCoalescingKey(copy->data, length);
+    enqueue(getQueue(link), copy, getPriority(msgid));
+}
+
+MAVLinkSendScheduler::LinkQueue* MAVLinkSendScheduler::getQueue(LinkInterface* link)
+{
+    QMutexLocker locker(&mutex);
+    LinkQueue* queue = queues.value(link, NULL);
+    if (!queue)
+    {
+        queue = new LinkQueue(link);
+        queue->lastRefill = now();
+        queues.insert(link, queue);
+        connect(link, SIGNAL(deleteLink(LinkInterface* const)), this, SLOT(removeLink(LinkInterface* const)));
+    }
+    return queue;
+}
+
+void MAVLinkSendScheduler::enqueue(LinkQueue* queue, Frame* frame, Priority priority)
+{
+    QMutexLocker locker(&queue->mutex);
+
+    frame->enqueued = now();
+    QList<Frame*>& frames = queue->frames[priority];
+    MAVLinkSendStatistics& statistics = queue->statistics[priority];
+
+    bool queued = false;
+    if (frame->key >= 0)
+    {
+        // Take the place of the waiting frame, the latency counts for the new data
+        for (int i = 0; i < frames.size(); i++)
+        {
+            if (frames.at(i)->key == frame->key)
+            {
+                delete frames.at(i);
+                frames[i] = frame;
+                statistics.coalesced++;
+                queued = true;
+                break;
+            }
+        }
+    }
+    if (!queued)
+    {
+        if (frames.size() < MAVLINK_SEND_QUEUE_SIZE)
+        {
+            frames.append(frame);
+            statistics.maxQueued = qMax(statistics.maxQueued, frames.size());
+        }
+        else
+        {
+            statistics.dropped++;
+            delete frame;
+        }
+    }
+
+    const int wait = drain(queue);
+    locker.unlock();
+
+    // The timer can only be started in the thread of the scheduler
+    if (wait >= 0 && flushScheduled.testAndSetOrdered(0, 1))
+    {
+        QMetaObject::invokeMethod(this, "scheduleFlush", Qt::QueuedConnection, Q_ARG(int, wait));
+    }
+}
+
+/**
+ * Serial data rates are given in baud, with start and stop bit every
+ * byte takes ten bits on the line.
+ */
+void MAVLinkSendScheduler::updateRate(LinkQueue* queue)
+{
+    qint64 bytesPerSecond = queue->configuredRate;
+    if (bytesPerSecond == 0)
+    {
+        const qint64 bitsPerSecond = queue->link->getNominalDataRate();
+        bytesPerSecond = (bitsPerSecond > 0) ? bitsPerSecond / 10 : -1;
+    }
+    queue->rate = (bytesPerSecond > 0) ? bytesPerSecond / 1e6 : -1;
+}
+
+/**
+ * Frames are sent strictly by priority class. If the first frame of a
+ * class does not fit into the budget, no lower class frame is sent.
+ */
+int MAVLinkSendScheduler::drain(LinkQueue* queue)
+{
+    updateRate(queue);
+    const qint64 time = now();
+    if (queue->rate > 0)
+    {
+        const double burst = qMax(queue->rate * MAVLINK_SEND_BURST_MS * 1000, double(MAVLINK_MAX_PACKET_LEN));
+        queue->tokens = qMin(queue->tokens + (time - queue->lastRefill) * queue->rate, burst);
+    }
+    queue->lastRefill = time;
+
+    for (int priority = 0; priority < PRIORITY_COUNT; priority++)
+    {
+        QList<Frame*>& frames = queue->frames[priority];
+        MAVLinkSendStatistics& statistics = queue->statistics[priority];
+        while (!frames.isEmpty())
+        {
+            Frame* frame = frames.first();
+            if (queue->rate > 0 && queue->tokens < frame->length)
+            {
+                return qMax(1, int(ceil((frame->length - queue->tokens) / queue->rate / 1000)));
+            }
+            // Remove the frame before writing, the link may send a reply from writeBytes()
+            frames.removeFirst();
+            if (queue->rate > 0) queue->tokens -= frame->length;
+
+            if (queue->link->isConnected())
+            {
+                queue->link->writeBytes(reinterpret_cast<const char*>(frame->data), frame->length);
+                const quint64 latency = time - frame->enqueued;
+                statistics.sent++;
+                statistics.latencySum += latency;
+                statistics.maxLatency = qMax(statistics.maxLatency, latency);
+            }
+            else
+            {
+                statistics.dropped++;
+            }
+            delete frame;
+        }
+    }
+    return -1;
+}
+
+void MAVLinkSendScheduler::scheduleFlush(int ms)
+{
+    flushScheduled.fetchAndStoreOrdered(0);
+    if (!timer.isActive()) timer.start(ms);
+}
+
+/**
+ * The queue list is copied, as a link may send a message from writeBytes().
+ * Links are deleted in the thread of the scheduler, so the queues stay valid.
+ */
+void MAVLinkSendScheduler::flush()
+{
+    mutex.lock();
+    const QList<LinkQueue*> links = queues.values();
+    mutex.unlock();
+
+    int wait = -1;
+    foreach (LinkQueue* queue, links)
+    {
+        QMutexLocker queueLocker(&queue->mutex);
+        const int linkWait = drain(queue);
+        if (linkWait >= 0) wait = (wait < 0) ? linkWait : qMin(wait, linkWait);
+    }
+    if (wait >= 0) timer.start(wait);
+}
+
+/**
+ * The link is already being destroyed, the pointer is only used as key.
+ */
+void MAVLinkSendScheduler::removeLink(LinkInterface* const link)
+{
+    QMutexLocker locker(&mutex);
+    delete queues.take(link);
+}
+
+void MAVLinkSendScheduler::setRateLimit(LinkInterface* link, qint64 bytesPerSecond)
+{
+    LinkQueue* queue = getQueue(link);
+    QMutexLocker locker(&queue->mutex);
+    queue->configuredRate = bytesPerSecond;
+    updateRate(queue);
+    locker.unlock();
+    // Waiting frames may be sent earlier with the new budget
+    QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);
+}
+
+qint64 MAVLinkSendScheduler::getRateLimit(LinkInterface* link)
+{
+    LinkQueue* queue = getQueue(link);
+    QMutexLocker locker(&queue->mutex);
+    updateRate(queue);
+    return (queue->rate > 0) ? qint64(queue->rate * 1e6 + 0.5) : -1;
+}
+
+int MAVLinkSendScheduler::getQueuedFrames(LinkInterface* link)
+{
+    LinkQueue* queue = getQueue(link);
+    QMutexLocker locker(&queue->mutex);
+    int frames = 0;
+    for (int priority = 0; priority < PRIORITY_COUNT; priority++)
+    {
+        frames += queue->frames[priority].size();
+    }
+    return frames;
+}
+
+QList<MAVLinkSendStatistics> MAVLinkSendScheduler::getStatistics(LinkInterface* link)
+{
+    LinkQueue* queue = getQueue(link);
+    QMutexLocker locker(&queue->mutex);
+    QList<MAVLinkSendStatistics> statistics;
+    for (int priority = 0; priority < PRIORITY_COUNT; priority++)
+    {
+        MAVLinkSendStatistics entry = queue->statistics[priority];
+        entry.queued = queue->frames[priority].size();
+        statistics.append(entry);
+    }
+    return statistics;
+}
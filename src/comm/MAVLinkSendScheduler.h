@@ -0,0 +1,183 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class MAVLinkSendScheduler
+ */
+
+#ifndef MAVLINKSENDSCHEDULER_H
+#define MAVLINKSENDSCHEDULER_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QMutex>
+#include <QTimer>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+
+#include "QGCMAVLink.h"
+
+class LinkInterface;
+
+/** Maximum number of frames waiting per link and priority class */
+#define MAVLINK_SEND_QUEUE_SIZE 256
+/** Bytes a link may send in one burst, in milliseconds of its data rate */
+#define MAVLINK_SEND_BURST_MS 50
+
+/** @brief Send statistics of one priority class of a link */
+struct MAVLinkSendStatistics
+{
+    int queued;             ///< Frames currently waiting
+    int maxQueued;          ///< Highest number of waiting frames
+    quint64 sent;           ///< Frames written to the link
+    quint64 coalesced;      ///< Waiting frames replaced by a newer frame of the same kind
+    quint64 dropped;        ///< Frames dropped because the queue was full
+    quint64 latencySum;     ///< Sum of the queueing latencies of all sent frames, in microseconds
+    quint64 maxLatency;     ///< Longest queueing latency, in microseconds
+};
+
+/**
+ * @brief Orders and paces the outgoing frames of all links
+ *
+ * Every outgoing message is put into one of four priority classes by its
+ * message id. Manual control and setpoints are sent first, then commands
+ * and heartbeats, then all other messages and at last bulk transfers
+ * like parameters and mission items.
+ *
+ * Each link has a token bucket filled with its nominal data rate, so a
+ * parameter burst can not fill the buffers of a slow radio and delay the
+ * control messages queued after it. Frames which do not fit into the
+ * budget wait and are sent from a timer in the thread of the scheduler.
+ *
+ * Frames of messages which are superseded by their successor, e.g.
+ * setpoints and manual control, replace a waiting frame of the same
+ * message id and target instead of being queued behind it. Heartbeats
+ * carry no target and replace the waiting heartbeat of the same sender.
+ *
+ * All methods are thread-safe.
+ */
+class MAVLinkSendScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority
+    {
+        PRIORITY_CONTROL = 0,   ///< Manual control and setpoints, coalesced
+        PRIORITY_COMMAND,       ///< Commands, mode changes and heartbeats
+        PRIORITY_NORMAL,        ///< Everything else, including forwarded frames
+        PRIORITY_BULK,          ///< Parameter and mission transfers
+        PRIORITY_COUNT
+    };
+
+    MAVLinkSendScheduler(QObject* parent = 0);
+    ~MAVLinkSendScheduler();
+
+    /** @brief Finalize the message with the given sender ids and queue it for the link */
+    void sendMessage(LinkInterface* link, mavlink_message_t message, quint8 systemid, quint8 componentid);
+    /** @brief Queue a complete frame, e.g. a forwarded one, without changing it */
+    void sendFrame(LinkInterface* link, const char* frame, int length);
+
+    /** @brief Priority class of a message id */
+    static Priority getPriority(quint8 msgid);
+    /** @brief A newer message with this id replaces a waiting one */
+    static bool isCoalesced(quint8 msgid);
+    /**
+     * @brief Key of a frame for coalescing
+     *
+     * Control messages are keyed by their target system and component,
+     * heartbeats by their sender. Control messages without a target field
+     * can not be told apart and are never coalesced.
+     * @param frame the complete frame, starting with the start sign
+     * @return the key, -1 if the frame is not coalesced
+     */
+    static int getCoalescingKey(const quint8* frame, int length);
+
+    /**
+     * @brief Set the send budget of a link
+     * @param bytesPerSecond the budget, 0 derives it from the nominal data rate, -1 disables the limit
+     */
+    void setRateLimit(LinkInterface* link, qint64 bytesPerSecond);
+    /** @brief Get the send budget of a link in bytes per second, -1 if unlimited */
+    qint64 getRateLimit(LinkInterface* link);
+    /** @brief Number of frames waiting for the link in all classes */
+    int getQueuedFrames(LinkInterface* link);
+    /** @brief Send statistics of the link, one entry per priority class */
+    QList<MAVLinkSendStatistics> getStatistics(LinkInterface* link);
+
+public slots:
+    /** @brief Send the waiting frames of all links as far as their budgets allow */
+    void flush();
+    /** @brief Drop the queues of a link that is being deleted */
+    void removeLink(LinkInterface* const link);
+
+protected slots:
+    /** @brief Start the flush timer, called in the thread of the scheduler */
+    void scheduleFlush(int ms);
+
+protected:
+    struct Frame
+    {
+        quint8 data[MAVLINK_MAX_PACKET_LEN];
+        int length;
+        int key;                ///< Message id and target for coalescing, -1 if not coalesced
+        qint64 enqueued;        ///< Time the frame was queued, in microseconds
+    };
+
+    struct LinkQueue
+    {
+        LinkQueue(LinkInterface* link);
+        ~LinkQueue();
+        LinkInterface* link;
+        QMutex mutex;           ///< Protects all members, held while writing to the link, recursive
+        QList<Frame*> frames[PRIORITY_COUNT];
+        MAVLinkSendStatistics statistics[PRIORITY_COUNT];
+        qint64 configuredRate;  ///< Rate set by setRateLimit()
+        double rate;            ///< Bytes per microsecond, negative if unlimited
+        double tokens;          ///< Bytes the link may send now
+        qint64 lastRefill;      ///< Time tokens was updated, in microseconds
+    };
+
+    /** @brief Get the queues of a link, created on first use */
+    LinkQueue* getQueue(LinkInterface* link);
+    /** @brief Queue a frame and send as much as the budget allows */
+    void enqueue(LinkQueue* queue, Frame* frame, Priority priority);
+    /** @brief Send waiting frames, queue->mutex is locked. Returns the milliseconds until the next frame fits, -1 if empty */
+    int drain(LinkQueue* queue);
+    /** @brief Update the rate of the token bucket from the link */
+    void updateRate(LinkQueue* queue);
+    /** @brief Get the current time in microseconds */
+    qint64 now() const {
+        return clock.nsecsElapsed() / 1000;
+    }
+
+    QMutex mutex;               ///< Protects queues
+    QHash<LinkInterface*, LinkQueue*> queues;
+    QTimer timer;
+    QAtomicInt flushScheduled;  ///< A scheduleFlush() call is pending
+    QElapsedTimer clock;
+    QMutex encodeMutex;         ///< mavlink_finalize_message_chan() updates the static channel state
+};
+
+#endif // MAVLINKSENDSCHEDULER_H
@@ -57,6 +57,11 @@ This file is part of the QGROUNDCONTROL project
  **/
 MAVLinkSimulationLink::MAVLinkSimulationLink(QString readFile, QString writeFile, int rate, QObject* parent) : LinkInterface(parent),
     readyBytes(0),
+    readyBuffer(SIMULATION_BUFFER_SIZE),
+    loopInterval(SIMULATION_LOOP_INTERVAL),
+    targetDataRate(0),
+    loadRate(0),
+    loadBytes(0),
     timeOffset(0)
 {
     this->rate = rate;
@@ -133,26 +138,67 @@ void MAVLinkSimulationLink::run()
     system.custom_mode = MAV_MODE_FLAG_MANUAL_INPUT_ENABLED | MAV_MODE_FLAG_SAFETY_ARMED;
     system.system_status = MAV_STATE_UNINIT;
 
+    quint64 last = 0;
     forever
     {
-        static quint64 last = 0;
-
-        if (QGC::groundTimeMilliseconds() - last >= rate)
+        if (_isConnected)
         {
-            if (_isConnected)
+            if (QGC::groundTimeMilliseconds() - last >= rate)
             {
                 mainloop();
-                readBytes();
-            }
-            else
-            {
-                // Sleep for substantially longer
-                // if not connected
-                QGC::SLEEP::msleep(500);
+                last = QGC::groundTimeMilliseconds();
             }
-            last = QGC::groundTimeMilliseconds();
+            generateLoad();
+            readBytes();
+            QGC::SLEEP::msleep(int(loopInterval));
+        }
+        else
+        {
+            // Sleep for substantially longer
+            // if not connected
+            QGC::SLEEP::msleep(500);
+        }
+    }
+}
+
+bool MAVLinkSimulationLink::enqueueBytes(const char* data, int length)
+{
+    QMutexLocker locker(&readyBufferMutex);
+    // Never enqueue parts of a packet
+    if (readyBuffer.freeSpace() < length) return false;
+    readyBuffer.write(data, length);
+    return true;
+}
+
+/**
+ * The bytes due are derived from the time since the target data rate was
+ * set, so the rate does not depend on the loop cadence and does not drift.
+ */
+void MAVLinkSimulationLink::generateLoad()
+{
+    const int target = targetDataRate;
+    if (target != loadRate)
+    {
+        loadRate = target;
+        loadBytes = 0;
+        loadTimer.start();
+    }
+    if (loadRate <= 0) return;
+
+    const quint64 due = quint64(double(loadRate) * loadTimer.nsecsElapsed() / 1e9);
+    mavlink_message_t msg;
+    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+    while (loadBytes < due)
+    {
+        mavlink_msg_attitude_pack(systemId, componentId, &msg, loadTimer.elapsed(), roll, pitch, yaw, 0, 0, 0);
+        const int length = mavlink_msg_to_send_buffer(buf, &msg);
+        if (!enqueueBytes(reinterpret_cast<const char*>(buf), length))
+        {
+            // The buffer is full, do not build up a backlog
+            loadBytes = due;
+            break;
         }
-        QGC::SLEEP::msleep(3);
+        loadBytes += length;
     }
 }
 
@@ -163,12 +209,7 @@ void MAVLinkSimulationLink::sendMAVLinkMessage(const mavlink_message_t* msg)
     unsigned int bufferlength = mavlink_msg_to_send_buffer(buf, msg);
 
     // Pack to link buffer
-    readyBufferMutex.lock();
-    for (unsigned int i = 0; i < bufferlength; i++)
-    {
-        readyBuffer.enqueue(*(buf + i));
-    }
-    readyBufferMutex.unlock();
+    enqueueBytes(reinterpret_cast<const char*>(buf), bufferlength);
 }
 
 void MAVLinkSimulationLink::enqueue(uint8_t* stream, uint8_t* index, mavlink_message_t* msg)
@@ -647,11 +688,7 @@ void MAVLinkSimulationLink::mainloop()
         rate50hzCounter = 1;
     }*/
 
-    readyBufferMutex.lock();
-    for (unsigned int i = 0; i < streampointer; i++) {
-        readyBuffer.enqueue(*(stream + i));
-    }
-    readyBufferMutex.unlock();
+    enqueueBytes(reinterpret_cast<const char*>(stream), streampointer);
 
     // Increment counters after full main loop
     rate1hzCounter++;
@@ -662,14 +699,13 @@ void MAVLinkSimulationLink::mainloop()
 
 qint64 MAVLinkSimulationLink::bytesAvailable()
 {
-    readyBufferMutex.lock();
-    qint64 size = readyBuffer.size();
-    readyBufferMutex.unlock();
-    return size;
+    return readyBuffer.count();
 }
 
 void MAVLinkSimulationLink::writeBytes(const char* data, qint64 size)
 {
+    linkStatistics.countSent(size);
+
     // Parse bytes
     mavlink_message_t msg;
     mavlink_status_t comm;
@@ -861,12 +897,7 @@ void MAVLinkSimulationLink::writeBytes(const char* data, qint64 size)
     }
     fprintf(stderr,"\n");
 
-    readyBufferMutex.lock();
-    for (int i = 0; i < streampointer; i++)
-    {
-        readyBuffer.enqueue(*(stream + i));
-    }
-    readyBufferMutex.unlock();
+    enqueueBytes(reinterpret_cast<const char*>(stream), streampointer);
 
     // Update comm status
     status.errors_comm = comm.packet_rx_drop_count;
@@ -874,22 +905,21 @@ void MAVLinkSimulationLink::writeBytes(const char* data, qint64 size)
 }
 
 
+/**
+ * Emits everything in the send buffer as one block. Only the link thread
+ * reads the buffer, so no lock is needed.
+ */
 void MAVLinkSimulationLink::readBytes()
 {
-    // Lock concurrent resource readyBuffer
-    readyBufferMutex.lock();
-    const qint64 maxLength = 2048;
-    char data[maxLength];
-    qint64 len = qMin((qint64)readyBuffer.size(), maxLength);
-
-    for (unsigned int i = 0; i < len; i++) {
-        *(data + i) = readyBuffer.takeFirst();
-    }
-
-    QByteArray b(data, len);
-    emit bytesReceived(this, b);
+    const int available = readyBuffer.count();
+    if (available == 0) return;
 
-    readyBufferMutex.unlock();
+    // Sized to the data, the protocols may queue the block for a while
+    QByteArray chunk;
+    chunk.resize(available);
+    readyBuffer.read(chunk.data(), available);
+    linkStatistics.countReceived(available);
+    emit bytesReceived(this, chunk);
 
 //    if (len > 0)
 //    {
@@ -999,67 +1029,50 @@ int MAVLinkSimulationLink::getId()
     return id;
 }
 
-QString MAVLinkSimulationLink::getName()
+int MAVLinkSimulationLink::getLoopInterval()
 {
-    return name;
-}
-
-qint64 MAVLinkSimulationLink::getNominalDataRate()
-{
-    /* 100 Mbit is reasonable fast and sufficient for all embedded applications */
-    return 100000000;
+    return loopInterval;
 }
 
-qint64 MAVLinkSimulationLink::getTotalUpstream()
+void MAVLinkSimulationLink::setLoopInterval(int milliseconds)
 {
-    return 0;
-    //TODO Add functionality here
-    // @todo Add functionality here
+    loopInterval.fetchAndStoreRelaxed(qMax(milliseconds, 0));
 }
 
-qint64 MAVLinkSimulationLink::getShortTermUpstream()
+int MAVLinkSimulationLink::getTargetDataRate()
 {
-    return 0;
+    return targetDataRate;
 }
 
-qint64 MAVLinkSimulationLink::getCurrentUpstream()
+void MAVLinkSimulationLink::setTargetDataRate(int bytesPerSecond)
 {
-    return 0;
+    targetDataRate.fetchAndStoreRelaxed(qMax(bytesPerSecond, 0));
 }
 
-qint64 MAVLinkSimulationLink::getMaxUpstream()
+quint64 MAVLinkSimulationLink::getEmittedBytes()
 {
-    return 0;
+    return linkStatistics.getReceivedBytes();
 }
 
-qint64 MAVLinkSimulationLink::getBitsSent()
+QString MAVLinkSimulationLink::getName()
 {
-    return 0;
+    return name;
 }
 
-qint64 MAVLinkSimulationLink::getBitsReceived()
+qint64 MAVLinkSimulationLink::getNominalDataRate()
 {
-    return 0;
+    /* 100 Mbit is reasonable fast and sufficient for all embedded applications */
+    return 100000000;
 }
 
-qint64 MAVLinkSimulationLink::getTotalDownstream()
+qint64 MAVLinkSimulationLink::getShortTermUpstream()
 {
-    return 0;
+    return qint64(linkStatistics.getRate(10).sentBytes * 8);
 }
 
 qint64 MAVLinkSimulationLink::getShortTermDownstream()
 {
-    return 0;
-}
-
-qint64 MAVLinkSimulationLink::getCurrentDownstream()
-{
-    return 0;
-}
-
-qint64 MAVLinkSimulationLink::getMaxDownstream()
-{
-    return 0;
+    return qint64(linkStatistics.getRate(10).receivedBytes * 8);
 }
 
 bool MAVLinkSimulationLink::isFullDuplex()
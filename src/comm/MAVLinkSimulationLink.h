@@ -35,14 +35,17 @@ This file is part of the QGROUNDCONTROL project
 #include <QFile>
 #include <QTimer>
 #include <QTextStream>
-#include <QQueue>
 #include <QMutex>
+#include <QAtomicInt>
+#include <QElapsedTimer>
 #include <QMap>
 #include <qmath.h>
 #include <inttypes.h>
 #include "QGCMAVLink.h"
 
 #include "LinkInterface.h"
+#include "QGCByteRingBuffer.h"
+#include "configuration.h"
 
 class MAVLinkSimulationLink : public LinkInterface
 {
@@ -60,16 +63,8 @@ public:
 
     /* Extensive statistics for scientific purposes */
     qint64 getNominalDataRate();
-    qint64 getTotalUpstream();
     qint64 getShortTermUpstream();
-    qint64 getCurrentUpstream();
-    qint64 getMaxUpstream();
-    qint64 getTotalDownstream();
     qint64 getShortTermDownstream();
-    qint64 getCurrentDownstream();
-    qint64 getMaxDownstream();
-    qint64 getBitsSent();
-    qint64 getBitsReceived();
 
     QString getName();
     int getId();
@@ -83,6 +78,13 @@ public:
     int getLinkQuality();
     bool isFullDuplex();
 
+    /** @brief Sleep between two iterations of the link loop in milliseconds */
+    int getLoopInterval();
+    /** @brief Target data rate of the generated load in bytes per second, 0 if off */
+    int getTargetDataRate();
+    /** @brief Number of bytes emitted to the protocols */
+    quint64 getEmittedBytes();
+
 public slots:
     void writeBytes(const char* data, qint64 size);
     void readBytes();
@@ -91,6 +93,15 @@ public slots:
     bool connectLink(bool connect);
     void connectLink();
     void sendMAVLinkMessage(const mavlink_message_t* msg);
+    /** @brief Set the sleep between two iterations of the link loop, i.e. the emit cadence */
+    void setLoopInterval(int milliseconds);
+    /**
+     * @brief Fill up the simulated traffic to a data rate
+     *
+     * Additional attitude messages are generated until the link emits
+     * bytesPerSecond, 0 only emits the simulated traffic.
+     */
+    void setTargetDataRate(int bytesPerSecond);
 
 
 protected:
@@ -123,7 +134,12 @@ protected:
     uint8_t stream[streamlength];
 
     int readyBytes;
-    QQueue<uint8_t> readyBuffer;
+    QGCByteRingBuffer readyBuffer; ///< Written under readyBufferMutex, read by the link thread only
+    QAtomicInt loopInterval;
+    QAtomicInt targetDataRate;
+    int loadRate;                  ///< Target data rate the load generation started with
+    quint64 loadBytes;             ///< Generated load bytes since loadTimer started
+    QElapsedTimer loadTimer;
 
     int id;
     QString name;
@@ -133,6 +149,10 @@ protected:
     QMap<QString, float> onboardParams;
 
     void enqueue(uint8_t* stream, uint8_t* index, mavlink_message_t* msg);
+    /** @brief Append bytes to the send buffer, drops all of them if they do not fit */
+    bool enqueueBytes(const char* data, int length);
+    /** @brief Generate load messages up to the target data rate */
+    void generateLoad();
 
     static const uint8_t systemId = 220;
     static const uint8_t componentId = 200;
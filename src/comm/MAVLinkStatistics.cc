@@ -0,0 +1,420 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class MAVLinkStatistics
+ */
+
+#include <string.h>
+#include <QFile>
+#include <QTextStream>
+#include <QMutexLocker>
+
+#include "MAVLinkStatistics.h"
+#include "LinkInterface.h"
+#include "QGC.h"
+
+MAVLinkLinkStatistics::MessageRecord::MessageRecord() :
+    lastArrival(-1),
+    lastInterval(-1),
+    smoothedJitter(0),
+    snapMessages(0),
+    snapBytes(0),
+    totalMessages(0),
+    totalBytes(0)
+{
+}
+
+MAVLinkLinkStatistics::ComponentRecord::ComponentRecord(quint8 sysid, quint8 compid) :
+    sysid(sysid),
+    compid(compid),
+    lastSeq(-1),
+    snapReceived(0),
+    snapLost(0),
+    totalReceived(0),
+    totalLost(0)
+{
+    memset(messages, 0, sizeof(messages));
+}
+
+MAVLinkLinkStatistics::ComponentRecord::~ComponentRecord()
+{
+    for (int i = 0; i < 256; i++)
+    {
+        delete messages[i];
+    }
+}
+
+MAVLinkLinkStatistics::MAVLinkLinkStatistics(int linkId, const QString& linkName) :
+    linkId(linkId),
+    linkName(linkName),
+    snapCrcErrors(0),
+    totalCrcErrors(0),
+    lastComponent(NULL)
+{
+    clock.start();
+}
+
+MAVLinkLinkStatistics::~MAVLinkLinkStatistics()
+{
+    qDeleteAll(published);
+}
+
+/**
+ * Bin 0 holds a jitter of zero, bin n holds [2^(n-1), 2^n) microseconds.
+ * The last bin also takes all larger values.
+ */
+int MAVLinkLinkStatistics::jitterBin(qint64 jitter)
+{
+    int bin = 0;
+    while (jitter > 0 && bin < MAVLINK_STATISTICS_JITTER_BINS - 1)
+    {
+        jitter >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+/**
+ * Sequence numbers are counted per component over all message ids, as
+ * the sender increments them for every message. The jitter is the
+ * difference of two consecutive inter-arrival times of a message id.
+ */
+void MAVLinkLinkStatistics::countMessage(const mavlink_message_t& message)
+{
+    const qint64 now = clock.nsecsElapsed() / 1000;
+
+    ComponentRecord* component = lastComponent;
+    if (!component || component->sysid != message.sysid || component->compid != message.compid)
+    {
+        component = components.value((message.sysid << 8) | message.compid, NULL);
+        if (!component) component = addComponent(message.sysid, message.compid);
+        lastComponent = component;
+    }
+
+    if (component->lastSeq >= 0)
+    {
+        // Messages missing between the last and this sequence number, wrapping at 255
+        const int gap = (message.seq - component->lastSeq - 1) & 0xFF;
+        if (gap > 0) component->lost.fetchAndAddRelaxed(gap);
+    }
+    component->lastSeq = message.seq;
+    component->received.fetchAndAddRelaxed(1);
+
+    MessageRecord* record = component->messages[message.msgid];
+    if (!record) record = addMessage(component, message.msgid);
+    record->messages.fetchAndAddRelaxed(1);
+    record->bytes.fetchAndAddRelaxed(message.len + MAVLINK_NUM_NON_PAYLOAD_BYTES);
+
+    if (record->lastArrival >= 0)
+    {
+        const qint64 interval = now - record->lastArrival;
+        if (record->lastInterval >= 0)
+        {
+            const qint64 deviation = qAbs(interval - record->lastInterval);
+            record->histogram[jitterBin(deviation)].fetchAndAddRelaxed(1);
+            // Smoothed as the interarrival jitter of RFC 3550
+            record->smoothedJitter += (deviation - record->smoothedJitter) / 16.0;
+            record->jitter.fetchAndStoreRelaxed(int(record->smoothedJitter));
+        }
+        record->lastInterval = interval;
+    }
+    record->lastArrival = now;
+}
+
+MAVLinkLinkStatistics::ComponentRecord* MAVLinkLinkStatistics::addComponent(quint8 sysid, quint8 compid)
+{
+    ComponentRecord* component = new ComponentRecord(sysid, compid);
+    components.insert((sysid << 8) | compid, component);
+    QMutexLocker locker(&mutex);
+    published.append(component);
+    return component;
+}
+
+MAVLinkLinkStatistics::MessageRecord* MAVLinkLinkStatistics::addMessage(ComponentRecord* component, quint8 msgid)
+{
+    MessageRecord* record = new MessageRecord();
+    QMutexLocker locker(&mutex);
+    component->messages[msgid] = record;
+    return record;
+}
+
+MAVLinkStatistics::MAVLinkStatistics(QObject* parent) :
+    QObject(parent),
+    timer(this),
+    lastUpdate(0)
+{
+    clock.start();
+    connect(&timer, SIGNAL(timeout()), this, SLOT(updateSnapshot()));
+    timer.start(MAVLINK_STATISTICS_INTERVAL);
+}
+
+MAVLinkStatistics::~MAVLinkStatistics()
+{
+    timer.stop();
+    qDeleteAll(links);
+    links.clear();
+}
+
+/**
+ * Has to be called before the thread parsing the link starts to count.
+ * @param link The link, only used as key, its id and name are copied
+ * @return The counters to update for all messages of the link
+ */
+MAVLinkLinkStatistics* MAVLinkStatistics::addLink(LinkInterface* link)
+{
+    QMutexLocker locker(&mutex);
+    MAVLinkLinkStatistics* statistics = links.value(link, NULL);
+    if (!statistics)
+    {
+        statistics = new MAVLinkLinkStatistics(link->getId(), link->getName());
+        links.insert(link, statistics);
+    }
+    return statistics;
+}
+
+void MAVLinkStatistics::removeLink(LinkInterface* link)
+{
+    QMutexLocker locker(&mutex);
+    delete links.take(link);
+}
+
+MAVLinkStatisticsSnapshot MAVLinkStatistics::getSnapshot() const
+{
+    QMutexLocker locker(&mutex);
+    return snapshot;
+}
+
+/**
+ * Totals are kept in 64 bit by adding the difference of the wrapping
+ * 32 bit counters since the last snapshot. The rates are calculated
+ * over the time since the last snapshot.
+ */
+void MAVLinkStatistics::updateSnapshot()
+{
+    QMutexLocker locker(&mutex);
+
+    const qint64 now = clock.nsecsElapsed();
+    const double seconds = qMax(now - lastUpdate, qint64(1)) / 1e9;
+    lastUpdate = now;
+
+    MAVLinkStatisticsSnapshot current;
+    current.time = QGC::groundTimeUsecs();
+
+    foreach (MAVLinkLinkStatistics* link, links)
+    {
+        QMutexLocker linkLocker(&link->mutex);
+
+        MAVLinkLinkSample linkSample;
+        linkSample.linkId = link->linkId;
+        linkSample.linkName = link->linkName;
+        const quint32 crcErrors = quint32(int(link->crcErrors));
+        link->totalCrcErrors += quint32(crcErrors - link->snapCrcErrors);
+        link->snapCrcErrors = crcErrors;
+        linkSample.crcErrors = link->totalCrcErrors;
+        linkSample.messageRate = 0;
+        linkSample.byteRate = 0;
+
+        foreach (MAVLinkLinkStatistics::ComponentRecord* component, link->published)
+        {
+            MAVLinkComponentSample componentSample;
+            componentSample.sysid = component->sysid;
+            componentSample.compid = component->compid;
+
+            const quint32 received = quint32(int(component->received));
+            const quint32 lost = quint32(int(component->lost));
+            const quint32 newReceived = received - component->snapReceived;
+            const quint32 newLost = lost - component->snapLost;
+            component->totalReceived += newReceived;
+            component->totalLost += newLost;
+            component->snapReceived = received;
+            component->snapLost = lost;
+
+            componentSample.messages = component->totalReceived;
+            componentSample.lost = component->totalLost;
+            componentSample.messageRate = newReceived / seconds;
+            componentSample.byteRate = 0;
+            componentSample.loss = (newReceived + newLost > 0) ? (100.0f * newLost) / (newReceived + newLost) : 0.0f;
+
+            for (int msgid = 0; msgid < 256; msgid++)
+            {
+                MAVLinkLinkStatistics::MessageRecord* record = component->messages[msgid];
+                if (!record) continue;
+
+                const quint32 messages = quint32(int(record->messages));
+                const quint32 bytes = quint32(int(record->bytes));
+                const quint32 newMessages = messages - record->snapMessages;
+                const quint32 newBytes = bytes - record->snapBytes;
+                record->totalMessages += newMessages;
+                record->totalBytes += newBytes;
+                record->snapMessages = messages;
+                record->snapBytes = bytes;
+
+                MAVLinkMessageSample messageSample;
+                messageSample.msgid = msgid;
+                messageSample.messages = record->totalMessages;
+                messageSample.bytes = record->totalBytes;
+                messageSample.messageRate = newMessages / seconds;
+                messageSample.byteRate = newBytes / seconds;
+                messageSample.jitter = int(record->jitter);
+                messageSample.jitterHistogram.resize(MAVLINK_STATISTICS_JITTER_BINS);
+                for (int bin = 0; bin < MAVLINK_STATISTICS_JITTER_BINS; bin++)
+                {
+                    messageSample.jitterHistogram[bin] = quint32(int(record->histogram[bin]));
+                }
+                componentSample.byteRate += messageSample.byteRate;
+                componentSample.messageTypes.append(messageSample);
+            }
+
+            linkSample.messageRate += componentSample.messageRate;
+            linkSample.byteRate += componentSample.byteRate;
+            linkSample.components.append(componentSample);
+        }
+        current.links.append(linkSample);
+    }
+
+    snapshot = current;
+    locker.unlock();
+
+    emit snapshotUpdated();
+}
+
+/**
+ * The component and link columns are repeated in every row of their
+ * message ids, so the file can be loaded into a spreadsheet as is.
+ */
+QString MAVLinkStatistics::toCsv(const MAVLinkStatisticsSnapshot& snapshot)
+{
+    QString csv;
+    QTextStream out(&csv);
+    out << "time,link_id,link_name,crc_errors,sysid,compid,lost,loss_percent,msgid,messages,bytes,message_rate,byte_rate,jitter_us";
+    for (int bin = 0; bin < MAVLINK_STATISTICS_JITTER_BINS; bin++)
+    {
+        out << ",jitter_bin_" << bin;
+    }
+    out << "\n";
+
+    foreach (const MAVLinkLinkSample& link, snapshot.links)
+    {
+        QString name = link.linkName;
+        name.replace("\"", "\"\"");
+        foreach (const MAVLinkComponentSample& component, link.components)
+        {
+            foreach (const MAVLinkMessageSample& message, component.messageTypes)
+            {
+                out << snapshot.time << "," << link.linkId << ",\"" << name << "\"," << link.crcErrors << ","
+                    << int(component.sysid) << "," << int(component.compid) << "," << component.lost << "," << component.loss << ","
+                    << int(message.msgid) << "," << message.messages << "," << message.bytes << ","
+                    << message.messageRate << "," << message.byteRate << "," << message.jitter;
+                foreach (quint32 count, message.jitterHistogram)
+                {
+                    out << "," << count;
+                }
+                out << "\n";
+            }
+        }
+    }
+    out.flush();
+    return csv;
+}
+
+/** @brief Quote a string for JSON */
+static QString jsonString(const QString& string)
+{
+    QString quoted("\"");
+    for (int i = 0; i < string.size(); i++)
+    {
+        const QChar c = string.at(i);
+        if (c == '"' || c == '\\')
+        {
+            quoted += '\\';
+            quoted += c;
+        }
+        else if (c.unicode() < 0x20)
+        {
+            quoted += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+        }
+        else
+        {
+            quoted += c;
+        }
+    }
+    quoted += '"';
+    return quoted;
+}
+
+QString MAVLinkStatistics::toJson(const MAVLinkStatisticsSnapshot& snapshot)
+{
+    QString json;
+    QTextStream out(&json);
+    out << "{\"time\":" << snapshot.time << ",\"links\":[";
+    for (int l = 0; l < snapshot.links.size(); l++)
+    {
+        const MAVLinkLinkSample& link = snapshot.links.at(l);
+        if (l > 0) out << ",";
+        out << "{\"id\":" << link.linkId << ",\"name\":" << jsonString(link.linkName)
+            << ",\"crc_errors\":" << link.crcErrors << ",\"message_rate\":" << link.messageRate
+            << ",\"byte_rate\":" << link.byteRate << ",\"components\":[";
+        for (int c = 0; c < link.components.size(); c++)
+        {
+            const MAVLinkComponentSample& component = link.components.at(c);
+            if (c > 0) out << ",";
+            out << "{\"sysid\":" << int(component.sysid) << ",\"compid\":" << int(component.compid)
+                << ",\"messages\":" << component.messages << ",\"lost\":" << component.lost
+                << ",\"loss_percent\":" << component.loss << ",\"message_rate\":" << component.messageRate
+                << ",\"byte_rate\":" << component.byteRate << ",\"messages_by_id\":[";
+            for (int m = 0; m < component.messageTypes.size(); m++)
+            {
+                const MAVLinkMessageSample& message = component.messageTypes.at(m);
+                if (m > 0) out << ",";
+                out << "{\"msgid\":" << int(message.msgid) << ",\"messages\":" << message.messages
+                    << ",\"bytes\":" << message.bytes << ",\"message_rate\":" << message.messageRate
+                    << ",\"byte_rate\":" << message.byteRate << ",\"jitter_us\":" << message.jitter
+                    << ",\"jitter_histogram\":[";
+                for (int bin = 0; bin < message.jitterHistogram.size(); bin++)
+                {
+                    if (bin > 0) out << ",";
+                    out << message.jitterHistogram.at(bin);
+                }
+                out << "]}";
+            }
+            out << "]}";
+        }
+        out << "]}";
+    }
+    out << "]}\n";
+    out.flush();
+    return json;
+}
+
+bool MAVLinkStatistics::exportSnapshot(const QString& fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) return false;
+
+    const MAVLinkStatisticsSnapshot current = getSnapshot();
+    const QString data = fileName.endsWith(".json", Qt::CaseInsensitive) ? toJson(current) : toCsv(current);
+    const QByteArray bytes = data.toUtf8();
+    return (file.write(bytes) == bytes.size());
+}
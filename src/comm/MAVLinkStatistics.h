@@ -0,0 +1,232 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class MAVLinkStatistics
+ */
+
+#ifndef MAVLINKSTATISTICS_H
+#define MAVLINKSTATISTICS_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QTimer>
+#include <QString>
+#include <QElapsedTimer>
+
+#include "QGCMAVLink.h"
+
+class LinkInterface;
+
+/** Number of log2 bins of the inter-arrival jitter histogram */
+#define MAVLINK_STATISTICS_JITTER_BINS 24
+/** Default interval between two statistics snapshots in milliseconds */
+#define MAVLINK_STATISTICS_INTERVAL 1000
+
+/** @brief Statistics of one message id sent by one component */
+struct MAVLinkMessageSample
+{
+    quint8 msgid;
+    quint64 messages;       ///< Received messages since the link was added
+    quint64 bytes;          ///< Received bytes, including the frame overhead
+    float messageRate;      ///< Messages per second since the last snapshot
+    float byteRate;         ///< Bytes per second since the last snapshot
+    int jitter;             ///< Smoothed inter-arrival jitter in microseconds
+    QVector<quint32> jitterHistogram; ///< Bin n > 0 counts jitters of [2^(n-1), 2^n) microseconds
+};
+
+/** @brief Statistics of one system / component on one link */
+struct MAVLinkComponentSample
+{
+    quint8 sysid;
+    quint8 compid;
+    quint64 messages;       ///< Received messages since the link was added
+    quint64 lost;           ///< Messages missing in the sequence numbers
+    float messageRate;      ///< Messages per second since the last snapshot
+    float byteRate;         ///< Bytes per second since the last snapshot
+    float loss;             ///< Messages lost since the last snapshot, in percent
+    QList<MAVLinkMessageSample> messageTypes;
+};
+
+/** @brief Statistics of one link */
+struct MAVLinkLinkSample
+{
+    int linkId;
+    QString linkName;
+    quint64 crcErrors;      ///< Frames dropped due to CRC or length errors
+    float messageRate;      ///< Messages per second since the last snapshot
+    float byteRate;         ///< Bytes per second since the last snapshot
+    QList<MAVLinkComponentSample> components;
+};
+
+/** @brief Statistics of all links at one point in time */
+struct MAVLinkStatisticsSnapshot
+{
+    MAVLinkStatisticsSnapshot() : time(0) {}
+    quint64 time;           ///< Ground time of the snapshot in microseconds
+    QList<MAVLinkLinkSample> links;
+};
+
+/**
+ * @brief Receive counters of one link
+ *
+ * The counters are updated by the thread parsing the link, only this
+ * thread may call countMessage() and setParseErrors(). On the hot path
+ * only atomic counters are incremented. Records for new components and
+ * message ids are allocated on their first message and published to the
+ * snapshot under a mutex.
+ */
+class MAVLinkLinkStatistics
+{
+public:
+    MAVLinkLinkStatistics(int linkId, const QString& linkName);
+    ~MAVLinkLinkStatistics();
+
+    /** @brief Count one received message. Parser thread only. */
+    void countMessage(const mavlink_message_t& message);
+    /** @brief Set the total number of frames with CRC or length errors. Parser thread only. */
+    void setParseErrors(quint64 errors) {
+        crcErrors.fetchAndStoreRelaxed(int(errors));
+    }
+
+    /** @brief Histogram bin of an inter-arrival jitter in microseconds */
+    static int jitterBin(qint64 jitter);
+
+protected:
+    friend class MAVLinkStatistics;
+
+    struct MessageRecord
+    {
+        MessageRecord();
+        QAtomicInt messages;
+        QAtomicInt bytes;
+        QAtomicInt jitter;
+        QAtomicInt histogram[MAVLINK_STATISTICS_JITTER_BINS];
+        // Parser thread only
+        qint64 lastArrival;     ///< Arrival of the last message in microseconds, -1 if none
+        qint64 lastInterval;    ///< Last inter-arrival time in microseconds, -1 if none
+        double smoothedJitter;
+        // Snapshot only
+        quint32 snapMessages;
+        quint32 snapBytes;
+        quint64 totalMessages;
+        quint64 totalBytes;
+    };
+
+    struct ComponentRecord
+    {
+        ComponentRecord(quint8 sysid, quint8 compid);
+        ~ComponentRecord();
+        quint8 sysid;
+        quint8 compid;
+        QAtomicInt received;
+        QAtomicInt lost;
+        MessageRecord* messages[256]; ///< Written under the mutex of the link
+        // Parser thread only
+        int lastSeq;            ///< Sequence number of the last message, -1 if none
+        // Snapshot only
+        quint32 snapReceived;
+        quint32 snapLost;
+        quint64 totalReceived;
+        quint64 totalLost;
+    };
+
+    /** @brief Create and publish the record of a new component */
+    ComponentRecord* addComponent(quint8 sysid, quint8 compid);
+    /** @brief Create and publish the record of a new message id */
+    MessageRecord* addMessage(ComponentRecord* component, quint8 msgid);
+
+    int linkId;
+    QString linkName;
+    QAtomicInt crcErrors;
+    quint32 snapCrcErrors;
+    quint64 totalCrcErrors;
+
+    QMutex mutex;                   ///< Protects published and the message tables
+    QList<ComponentRecord*> published;
+    QHash<int, ComponentRecord*> components; ///< Parser thread only
+    ComponentRecord* lastComponent; ///< Parser thread only, component of the last message
+    QElapsedTimer clock;            ///< Parser thread only
+};
+
+/**
+ * @brief Receive statistics keyed by link, system, component and message id
+ *
+ * Tracks message and byte rates, inter-arrival jitter, sequence gaps and
+ * CRC errors. A snapshot of all counters is taken periodically in the
+ * thread of this object, snapshotUpdated() is emitted afterwards. The
+ * latest snapshot can be read from any thread and exported as CSV or JSON.
+ */
+class MAVLinkStatistics : public QObject
+{
+    Q_OBJECT
+public:
+    MAVLinkStatistics(QObject* parent = 0);
+    ~MAVLinkStatistics();
+
+    /** @brief Get the counters of a link, created on first use */
+    MAVLinkLinkStatistics* addLink(LinkInterface* link);
+    /** @brief Drop the counters of a link, no thread may update them anymore */
+    void removeLink(LinkInterface* link);
+
+    /** @brief Get the latest snapshot */
+    MAVLinkStatisticsSnapshot getSnapshot() const;
+    /** @brief Get the snapshot interval in milliseconds */
+    int getInterval() const {
+        return timer.interval();
+    }
+    /** @brief Set the snapshot interval in milliseconds */
+    void setInterval(int ms) {
+        timer.setInterval(ms);
+    }
+
+    /** @brief One CSV row per link, system, component and message id */
+    static QString toCsv(const MAVLinkStatisticsSnapshot& snapshot);
+    /** @brief Nested JSON document of the snapshot */
+    static QString toJson(const MAVLinkStatisticsSnapshot& snapshot);
+    /** @brief Write the latest snapshot to a file, as JSON if the name ends with .json, else as CSV */
+    bool exportSnapshot(const QString& fileName) const;
+
+public slots:
+    /** @brief Take a new snapshot of all counters */
+    void updateSnapshot();
+
+signals:
+    /** @brief A new snapshot is available */
+    void snapshotUpdated();
+
+protected:
+    mutable QMutex mutex;           ///< Protects links and snapshot
+    QHash<LinkInterface*, MAVLinkLinkStatistics*> links;
+    MAVLinkStatisticsSnapshot snapshot;
+    QTimer timer;
+    QElapsedTimer clock;
+    qint64 lastUpdate;              ///< Time of the last snapshot in nanoseconds
+};
+
+#endif // MAVLINKSTATISTICS_H
@@ -1,12 +1,392 @@
+#include <algorithm>
+#include <QStringList>
+
 #include "MAVLinkSwarmSimulationLink.h"
+#include "QGC.h"
+
+#if MAVLINK_CRC_EXTRA
+static const quint8 messageCrcs[256] = MAVLINK_MESSAGE_CRCS;
+#endif
+
+/** System ids given to the vehicles, the rest is left to ground stations */
+static const int swarmSystemIds = 250;
+/** Center of the swarm */
+static const double swarmLatitude = 47.397742;
+static const double swarmLongitude = 8.545594;
+/** Distance between two vehicles on the grid, in degrees */
+static const double swarmSpacing = 0.001;
+/** Vehicles per grid row */
+static const int swarmRowLength = 25;
+/** Radius of the circle every vehicle flies, in meters */
+static const double circleRadius = 50.0;
+/** Angular speed on the circle in radians per second */
+static const double circleRate = 0.1;
+/** Meters per degree latitude */
+static const double metersPerDegree = 111319.5;
 
 MAVLinkSwarmSimulationLink::MAVLinkSwarmSimulationLink(QString readFile, QString writeFile, int rate, QObject *parent) :
-    MAVLinkSimulationLink(readFile, writeFile, rate, parent)
+    MAVLinkSimulationLink(readFile, writeFile, rate, parent),
+    vehicleCount(10),
+    messageMix(defaultMessageMix()),
+    seed(1),
+    lossRate(0.0),
+    jitter(0),
+    fastMode(false),
+    randomState(1),
+    generatedMessages(0),
+    droppedMessages(0),
+    acknowledgedMessages(0),
+    stalls(0)
+{
+    name = "MAVLink swarm simulation link";
+}
+
+MAVLinkSwarmSimulationLink::~MAVLinkSwarmSimulationLink()
+{
+    disconnect();
+    wait();
+}
+
+QList<SwarmMessage> MAVLinkSwarmSimulationLink::defaultMessageMix()
+{
+    QList<SwarmMessage> mix;
+    mix << SwarmMessage(MAVLINK_MSG_ID_HEARTBEAT, 1.0f)
+        << SwarmMessage(MAVLINK_MSG_ID_SYS_STATUS, 2.0f)
+        << SwarmMessage(MAVLINK_MSG_ID_GPS_RAW_INT, 5.0f)
+        << SwarmMessage(MAVLINK_MSG_ID_ATTITUDE, 50.0f)
+        << SwarmMessage(MAVLINK_MSG_ID_GLOBAL_POSITION_INT, 10.0f)
+        << SwarmMessage(MAVLINK_MSG_ID_VFR_HUD, 4.0f);
+    return mix;
+}
+
+bool MAVLinkSwarmSimulationLink::isSupportedMessage(quint8 msgid)
+{
+    switch (msgid)
+    {
+    case MAVLINK_MSG_ID_HEARTBEAT:
+    case MAVLINK_MSG_ID_SYS_STATUS:
+    case MAVLINK_MSG_ID_GPS_RAW_INT:
+    case MAVLINK_MSG_ID_ATTITUDE:
+    case MAVLINK_MSG_ID_LOCAL_POSITION_NED:
+    case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
+    case MAVLINK_MSG_ID_VFR_HUD:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool MAVLinkSwarmSimulationLink::parseMessageMix(const QString& text, QList<SwarmMessage>* mix)
+{
+    QList<SwarmMessage> parsed;
+    foreach (const QString& entry, text.split(',', QString::SkipEmptyParts))
+    {
+        QStringList fields = entry.split(':');
+        if (fields.size() != 2) return false;
+        bool idOk, rateOk;
+        uint msgid = fields.at(0).trimmed().toUInt(&idOk);
+        float rate = fields.at(1).trimmed().toFloat(&rateOk);
+        if (!idOk || !rateOk || msgid > 255 || rate <= 0.0f) return false;
+        if (!isSupportedMessage(msgid)) return false;
+        parsed.append(SwarmMessage(msgid, rate));
+    }
+    if (parsed.isEmpty()) return false;
+    *mix = parsed;
+    return true;
+}
+
+void MAVLinkSwarmSimulationLink::vehicleId(int vehicle, quint8* sysid, quint8* compid)
+{
+    *sysid = 1 + vehicle % swarmSystemIds;
+    *compid = 1 + vehicle / swarmSystemIds;
+}
+
+bool MAVLinkSwarmSimulationLink::later(const Event& a, const Event& b)
+{
+    // Ties are broken by the stream, this keeps the order deterministic
+    if (a.due != b.due) return a.due > b.due;
+    if (a.vehicle != b.vehicle) return a.vehicle > b.vehicle;
+    return a.message > b.message;
+}
+
+quint32 MAVLinkSwarmSimulationLink::random()
+{
+    // xorshift32, the same sequence on every platform
+    quint32 x = randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    randomState = x;
+    return x;
+}
+
+double MAVLinkSwarmSimulationLink::randomUnit()
+{
+    return random() / 4294967296.0;
+}
+
+/**
+ * Every vehicle starts at a random time within the first second with its
+ * heartbeat, so the receiver knows the vehicle before its other messages
+ * arrive. The other streams start at a random phase within their first
+ * period, so the messages do not arrive in bursts.
+ */
+void MAVLinkSwarmSimulationLink::reset()
+{
+    randomState = (seed != 0) ? seed : 1;
+    events.clear();
+    for (int vehicle = 0; vehicle < vehicleCount; vehicle++)
+    {
+        const quint64 start = random() % 1000000;
+        for (int i = 0; i < messageMix.size(); i++)
+        {
+            const SwarmMessage& message = messageMix.at(i);
+            if (message.rate <= 0.0f || !isSupportedMessage(message.msgid)) continue;
+            Event event;
+            event.period = qMax(quint64(1), quint64(1000000.0 / message.rate));
+            event.nominal = start;
+            if (message.msgid != MAVLINK_MSG_ID_HEARTBEAT) event.nominal += 1 + random() % event.period;
+            event.due = event.nominal + ((jitter > 0) ? random() % (jitter + 1) : 0);
+            event.vehicle = vehicle;
+            event.message = i;
+            events.append(event);
+        }
+    }
+    std::make_heap(events.begin(), events.end(), later);
+    sequences.fill(0, vehicleCount);
+
+    QMutexLocker locker(&counterMutex);
+    generatedMessages = 0;
+    droppedMessages = 0;
+    acknowledgedMessages = 0;
+    stalls = 0;
+}
+
+int MAVLinkSwarmSimulationLink::generate(quint64 until, QByteArray* block)
+{
+    int generated = 0;
+    int dropped = 0;
+    while (!events.isEmpty() && events.first().due <= until)
+    {
+        std::pop_heap(events.begin(), events.end(), later);
+        Event& event = events.last();
+
+        if (lossRate > 0.0 && randomUnit() < lossRate)
+        {
+            // The lost message still uses up its sequence number
+            sequences[event.vehicle]++;
+            dropped++;
+        }
+        else
+        {
+            appendFrame(event, block);
+            generated++;
+        }
+
+        event.nominal += event.period;
+        event.due = event.nominal + ((jitter > 0) ? random() % (jitter + 1) : 0);
+        std::push_heap(events.begin(), events.end(), later);
+    }
+
+    QMutexLocker locker(&counterMutex);
+    generatedMessages += generated;
+    droppedMessages += dropped;
+    return generated;
+}
+
+/**
+ * The vehicles fly circles on a grid, the state is derived from the
+ * simulated time only. The time stamps are the nominal send times, the
+ * jitter only delays the arrival.
+ */
+void MAVLinkSwarmSimulationLink::appendFrame(const Event& event, QByteArray* block)
+{
+    const int vehicle = event.vehicle;
+    quint8 sysid, compid;
+    vehicleId(vehicle, &sysid, &compid);
+
+    const double seconds = event.nominal / 1000000.0;
+    const quint32 bootMs = quint32(event.nominal / 1000);
+    const double angle = circleRate * seconds + vehicle * 0.7;
+    const double north = circleRadius * cos(angle);
+    const double east = circleRadius * sin(angle);
+    const double vn = -circleRadius * circleRate * sin(angle);
+    const double ve = circleRadius * circleRate * cos(angle);
+    const double speed = circleRadius * circleRate;
+    const double altitude = 20.0 + vehicle % 10;
+    const double latitude = swarmLatitude + (vehicle / swarmRowLength) * swarmSpacing + north / metersPerDegree;
+    const double longitude = swarmLongitude + (vehicle % swarmRowLength) * swarmSpacing + east / (metersPerDegree * cos(swarmLatitude * M_PI / 180.0));
+    const double yaw = atan2(ve, vn);
+    const double heading = (yaw < 0.0) ? yaw + 2.0 * M_PI : yaw;
+
+    mavlink_message_t msg;
+    switch (messageMix.at(event.message).msgid)
+    {
+    case MAVLINK_MSG_ID_HEARTBEAT:
+        mavlink_msg_heartbeat_pack(sysid, compid, &msg, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_GENERIC, MAV_MODE_GUIDED_ARMED, 0, MAV_STATE_ACTIVE);
+        break;
+    case MAVLINK_MSG_ID_SYS_STATUS:
+        mavlink_msg_sys_status_pack(sysid, compid, &msg, 0, 0, 0, 500, 12000 - (bootMs / 1000) % 2000, -1, 80, 0, 0, 0, 0, 0, 0);
+        break;
+    case MAVLINK_MSG_ID_GPS_RAW_INT:
+        mavlink_msg_gps_raw_int_pack(sysid, compid, &msg, event.nominal, 3, latitude * 1E7, longitude * 1E7, altitude * 1000.0, 100, 100, speed * 100.0, heading * 18000.0 / M_PI, 10);
+        break;
+    case MAVLINK_MSG_ID_ATTITUDE:
+        mavlink_msg_attitude_pack(sysid, compid, &msg, bootMs, 0.2 * sin(3.0 * angle), 0.1 * cos(2.0 * angle), yaw, 0.6 * circleRate * cos(3.0 * angle), -0.2 * circleRate * sin(2.0 * angle), circleRate);
+        break;
+    case MAVLINK_MSG_ID_LOCAL_POSITION_NED:
+        mavlink_msg_local_position_ned_pack(sysid, compid, &msg, bootMs, north, east, -altitude, vn, ve, 0);
+        break;
+    case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
+        mavlink_msg_global_position_int_pack(sysid, compid, &msg, bootMs, latitude * 1E7, longitude * 1E7, altitude * 1000.0, altitude * 1000.0, vn * 100.0, ve * 100.0, 0, heading * 18000.0 / M_PI);
+        break;
+    case MAVLINK_MSG_ID_VFR_HUD:
+        mavlink_msg_vfr_hud_pack(sysid, compid, &msg, speed, speed, heading * 180.0 / M_PI, 50, altitude, 0);
+        break;
+    default:
+        return;
+    }
+
+    // The packing functions number the messages per channel, every vehicle
+    // needs its own sequence so the receiver can detect the losses
+    msg.seq = sequences[vehicle]++;
+    quint16 checksum = crc_calculate(&msg.len, msg.len + MAVLINK_CORE_HEADER_LEN);
+#if MAVLINK_CRC_EXTRA
+    crc_accumulate(messageCrcs[msg.msgid], &checksum);
+#endif
+    msg.checksum = checksum;
+    mavlink_ck_a(&msg) = checksum & 0xFF;
+    mavlink_ck_b(&msg) = checksum >> 8;
+
+    const int offset = block->size();
+    block->resize(offset + MAVLINK_MAX_PACKET_LEN);
+    const int length = mavlink_msg_to_send_buffer(reinterpret_cast<uint8_t*>(block->data() + offset), &msg);
+    block->resize(offset + length);
+}
+
+/**
+ * In paced mode the link emits everything that is due every loop interval.
+ * In fast mode every iteration advances the simulated time by
+ * SWARM_FAST_STEP ms, but only if the consumer acknowledged all but
+ * SWARM_FAST_WINDOW of the emitted messages.
+ */
+void MAVLinkSwarmSimulationLink::run()
 {
+    QElapsedTimer clock;
+    clock.start();
+    quint64 simulated = 0;
+
+    while (_isConnected)
+    {
+        if (fastMode)
+        {
+            QMutexLocker locker(&counterMutex);
+            while (_isConnected && generatedMessages - acknowledgedMessages > SWARM_FAST_WINDOW)
+            {
+                if (!acknowledged.wait(&counterMutex, SWARM_WAIT_TIMEOUT))
+                {
+                    // The consumer lost messages or does not acknowledge, do not wait forever
+                    stalls++;
+                    acknowledgedMessages = generatedMessages;
+                }
+            }
+            locker.unlock();
+            simulated += SWARM_FAST_STEP * 1000;
+        }
+        else
+        {
+            simulated = clock.nsecsElapsed() / 1000;
+        }
+
+        QByteArray chunk;
+        generate(simulated, &chunk);
+        if (!chunk.isEmpty())
+        {
+            // The block grew frame by frame, drop the spare capacity before it is queued
+            chunk.squeeze();
+            linkStatistics.countReceived(chunk.size());
+            emit bytesReceived(this, chunk);
+        }
+        // Answers to the ground station
+        readBytes();
+
+        if (!fastMode) QGC::SLEEP::msleep(int(loopInterval));
+    }
 }
 
+/**
+ * A previous run is finished first, then the swarm restarts from the
+ * current configuration.
+ */
+bool MAVLinkSwarmSimulationLink::connect()
+{
+    if (isConnected()) return true;
+    wait();
+    reset();
+
+    _isConnected = true;
+    emit connected();
+    emit connected(true);
+    start(LowPriority);
+    return true;
+}
 
 void MAVLinkSwarmSimulationLink::mainloop()
 {
+    // The vehicles are simulated in generate()
+}
+
+void MAVLinkSwarmSimulationLink::setVehicleCount(int count)
+{
+    vehicleCount = qBound(0, count, SWARM_MAX_VEHICLES);
+}
+
+void MAVLinkSwarmSimulationLink::setMessageMix(const QList<SwarmMessage>& mix)
+{
+    messageMix = mix;
+}
 
+void MAVLinkSwarmSimulationLink::setSeed(quint32 seed)
+{
+    this->seed = seed;
+}
+
+void MAVLinkSwarmSimulationLink::setLossRate(double rate)
+{
+    lossRate = qBound(0.0, rate, 1.0);
+}
+
+void MAVLinkSwarmSimulationLink::setJitter(int usec)
+{
+    jitter = qMax(usec, 0);
+}
+
+void MAVLinkSwarmSimulationLink::setFastMode(bool enabled)
+{
+    fastMode = enabled;
+}
+
+void MAVLinkSwarmSimulationLink::acknowledge(int messages)
+{
+    QMutexLocker locker(&counterMutex);
+    acknowledgedMessages = qMin(acknowledgedMessages + qMax(messages, 0), generatedMessages);
+    acknowledged.wakeAll();
+}
+
+quint64 MAVLinkSwarmSimulationLink::getGeneratedMessages()
+{
+    QMutexLocker locker(&counterMutex);
+    return generatedMessages;
+}
+
+quint64 MAVLinkSwarmSimulationLink::getDroppedMessages()
+{
+    QMutexLocker locker(&counterMutex);
+    return droppedMessages;
+}
+
+quint64 MAVLinkSwarmSimulationLink::getStalls()
+{
+    QMutexLocker locker(&counterMutex);
+    return stalls;
 }
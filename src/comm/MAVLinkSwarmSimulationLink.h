@@ -1,19 +1,163 @@
 #ifndef MAVLINKSWARMSIMULATIONLINK_H
 #define MAVLINKSWARMSIMULATIONLINK_H
 
+#include <QList>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+
 #include "MAVLinkSimulationLink.h"
 
+/** @brief One message type of the swarm message mix */
+struct SwarmMessage
+{
+    SwarmMessage(quint8 msgid = 0, float rate = 0.0f) : msgid(msgid), rate(rate) {}
+    quint8 msgid;
+    float rate;             ///< Messages per second and vehicle
+};
+
+/**
+ * @brief Deterministic load generator simulating a swarm of vehicles
+ *
+ * Every vehicle sends the configured message mix at its rates, the start
+ * of every message stream is randomly staggered. An optional loss model
+ * drops messages (the sequence numbers show the gaps) and an optional
+ * jitter model delays them. All randomness comes from a seeded generator
+ * and the payloads only depend on the simulated time, so the generated
+ * byte stream is identical for the same configuration and seed.
+ *
+ * In paced mode the simulated time follows the wall clock. In fast mode
+ * the link emits blocks of SWARM_FAST_STEP ms simulated time as fast as
+ * the consumer reports them processed with acknowledge().
+ *
+ * Vehicles beyond the 250 available system ids share a system id and are
+ * distinguished by their component id.
+ *
+ * The configuration is applied on the next connect().
+ */
 class MAVLinkSwarmSimulationLink : public MAVLinkSimulationLink
 {
     Q_OBJECT
 public:
     MAVLinkSwarmSimulationLink(QString readFile="", QString writeFile="", int rate=5, QObject *parent = 0);
+    ~MAVLinkSwarmSimulationLink();
+
+    void run();
+    bool connect();
+
+    /** @brief Default message mix of a vehicle */
+    static QList<SwarmMessage> defaultMessageMix();
+    /**
+     * @brief Parse a message mix like "0:1,30:50,33:10"
+     *
+     * @param text comma separated pairs of message id and rate in Hertz
+     * @param mix the parsed mix, only valid if true is returned
+     * @return false if the text is malformed or contains an unsupported message id
+     */
+    static bool parseMessageMix(const QString& text, QList<SwarmMessage>* mix);
+    /** @brief Check if the generator can fill the payload of a message id */
+    static bool isSupportedMessage(quint8 msgid);
 
-signals:
+    int getVehicleCount() const {
+        return vehicleCount;
+    }
+    QList<SwarmMessage> getMessageMix() const {
+        return messageMix;
+    }
+    quint32 getSeed() const {
+        return seed;
+    }
+    /** @brief Probability of a message to be dropped, 0 to 1 */
+    double getLossRate() const {
+        return lossRate;
+    }
+    /** @brief Largest delay of a message in microseconds */
+    int getJitter() const {
+        return jitter;
+    }
+    bool isFastMode() const {
+        return fastMode;
+    }
+    /** @brief System and component id of a vehicle */
+    static void vehicleId(int vehicle, quint8* sysid, quint8* compid);
+
+    /** @brief Number of messages emitted since the last connect() */
+    quint64 getGeneratedMessages();
+    /** @brief Number of messages dropped by the loss model since the last connect() */
+    quint64 getDroppedMessages();
+    /** @brief Number of times the consumer did not keep up in fast mode */
+    quint64 getStalls();
+
+    /**
+     * @brief Append all frames due up to a simulated time
+     *
+     * Called by the link thread, can be used directly after reset() to
+     * generate the stream without running the link.
+     * @param until simulated time in microseconds
+     * @param block the frames are appended to it
+     * @return number of frames appended
+     */
+    int generate(quint64 until, QByteArray* block);
+    /** @brief Restart the simulation with the current configuration */
+    void reset();
 
 public slots:
     void mainloop();
+    /** @brief Set the number of vehicles, at most SWARM_MAX_VEHICLES */
+    void setVehicleCount(int count);
+    void setMessageMix(const QList<SwarmMessage>& mix);
+    void setSeed(quint32 seed);
+    /** @brief Set the probability of a message to be dropped, 0 to 1 */
+    void setLossRate(double rate);
+    /** @brief Set the largest delay of a message in microseconds */
+    void setJitter(int usec);
+    void setFastMode(bool enabled);
+    /**
+     * @brief Report processed messages in fast mode
+     *
+     * The link only runs SWARM_FAST_WINDOW messages ahead of the
+     * acknowledged ones. Can be called from any thread.
+     */
+    void acknowledge(int messages);
+
+protected:
+    /** @brief Next message of one stream, the streams form a heap ordered by due time */
+    struct Event
+    {
+        quint64 due;        ///< Simulated send time including the jitter, microseconds
+        quint64 nominal;    ///< Simulated send time without the jitter, microseconds
+        quint64 period;
+        int vehicle;
+        int message;        ///< Index into the message mix
+    };
+    /** @brief Heap order, the earliest event is on top */
+    static bool later(const Event& a, const Event& b);
+
+    /** @brief Next value of the seeded random number generator */
+    quint32 random();
+    /** @brief Uniformly distributed random number in [0, 1) */
+    double randomUnit();
+    /** @brief Pack the message of an event into a frame and append it */
+    void appendFrame(const Event& event, QByteArray* block);
+
+    int vehicleCount;
+    QList<SwarmMessage> messageMix;
+    quint32 seed;
+    double lossRate;
+    int jitter;
+    bool fastMode;
+
+    // Link thread only
+    QVector<Event> events;  ///< Min-heap of the next message of every stream
+    QVector<quint8> sequences; ///< Next sequence number of every vehicle
+    quint32 randomState;
 
+    QMutex counterMutex;    ///< Protects the counters below
+    QWaitCondition acknowledged;
+    quint64 generatedMessages;
+    quint64 droppedMessages;
+    quint64 acknowledgedMessages;
+    quint64 stalls;
 };
 
 #endif // MAVLINKSWARMSIMULATIONLINK_H
@@ -53,6 +53,15 @@ public:
     //virtual ~ProtocolInterface() {};
     virtual QString getName() = 0;
 
+    /**
+     * @brief Start receiving the bytes of a link
+     *
+     * The default implementation directly connects the link to receiveBytes().
+     */
+    virtual void addLink(LinkInterface* link) {
+        connect(link, SIGNAL(bytesReceived(LinkInterface*, QByteArray)), this, SLOT(receiveBytes(LinkInterface*, QByteArray)));
+    }
+
 public slots:
     virtual void receiveBytes(LinkInterface *link, QByteArray b) = 0;
 
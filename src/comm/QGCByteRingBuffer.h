@@ -0,0 +1,170 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of the byte ring buffer QGCByteRingBuffer
+ */
+
+#ifndef QGCBYTERINGBUFFER_H
+#define QGCBYTERINGBUFFER_H
+
+#include <string.h>
+#include <QtGlobal>
+#include <QAtomicInt>
+
+/**
+ * @brief Bounded byte ring buffer between one producer and one consumer thread
+ *
+ * Besides copying in and out, the producer can read directly into the
+ * free space (writePointer() / commit()) and the consumer can parse the
+ * stored bytes in place (readPointer() / consume()), which avoids an
+ * intermediate copy for device reads. The capacity is rounded up to the
+ * next power of two. As in QGCSpscQueue both indices run freely and
+ * their difference is the fill level.
+ */
+class QGCByteRingBuffer
+{
+public:
+    explicit QGCByteRingBuffer(int capacity) :
+        size(roundCapacity(capacity)),
+        mask(size - 1),
+        buffer(new char[size]),
+        head(0),
+        tail(0)
+    {
+    }
+
+    ~QGCByteRingBuffer()
+    {
+        delete[] buffer;
+    }
+
+    /** @brief Contiguous free space at the write position. Producer only. */
+    char* writePointer(int* contiguous)
+    {
+        const unsigned int t = static_cast<unsigned int>(int(tail));
+        const unsigned int h = static_cast<unsigned int>(head.fetchAndAddAcquire(0));
+        const unsigned int offset = t & mask;
+        *contiguous = static_cast<int>(qMin(size - (t - h), size - offset));
+        return buffer + offset;
+    }
+
+    /** @brief Publish bytes written to writePointer(). Producer only. */
+    void commit(int bytes)
+    {
+        tail.fetchAndAddRelease(bytes);
+    }
+
+    /** @brief Contiguous stored bytes at the read position. Consumer only. */
+    const char* readPointer(int* contiguous)
+    {
+        const unsigned int h = static_cast<unsigned int>(int(head));
+        const unsigned int t = static_cast<unsigned int>(tail.fetchAndAddAcquire(0));
+        const unsigned int offset = h & mask;
+        *contiguous = static_cast<int>(qMin(t - h, size - offset));
+        return buffer + offset;
+    }
+
+    /** @brief Release bytes read through readPointer(). Consumer only. */
+    void consume(int bytes)
+    {
+        head.fetchAndAddRelease(bytes);
+    }
+
+    /** @brief Append as many bytes as fit, returns the number of bytes written. Producer only. */
+    int write(const char* data, int length)
+    {
+        int written = 0;
+        while (written < length)
+        {
+            int contiguous;
+            char* target = writePointer(&contiguous);
+            if (contiguous == 0) break;
+            const int chunk = qMin(contiguous, length - written);
+            memcpy(target, data + written, chunk);
+            commit(chunk);
+            written += chunk;
+        }
+        return written;
+    }
+
+    /** @brief Remove up to maxLength bytes, returns the number of bytes read. Consumer only. */
+    int read(char* data, int maxLength)
+    {
+        int done = 0;
+        while (done < maxLength)
+        {
+            int contiguous;
+            const char* source = readPointer(&contiguous);
+            if (contiguous == 0) break;
+            const int chunk = qMin(contiguous, maxLength - done);
+            memcpy(data + done, source, chunk);
+            consume(chunk);
+            done += chunk;
+        }
+        return done;
+    }
+
+    /** @brief Number of stored bytes, only a snapshot if called concurrently */
+    int count() const
+    {
+        return static_cast<int>(static_cast<unsigned int>(int(tail)) - static_cast<unsigned int>(int(head)));
+    }
+
+    /** @brief Free space, only a snapshot if called concurrently */
+    int freeSpace() const
+    {
+        return capacity() - count();
+    }
+
+    int capacity() const {
+        return static_cast<int>(size);
+    }
+
+    /** @brief Drop all stored bytes. Consumer only. */
+    void clear()
+    {
+        head.fetchAndStoreRelease(tail.fetchAndAddAcquire(0));
+    }
+
+private:
+    static unsigned int roundCapacity(int capacity)
+    {
+        unsigned int rounded = 1;
+        while (rounded < static_cast<unsigned int>(qMax(capacity, 1))) rounded <<= 1;
+        return rounded;
+    }
+
+    // Not copyable
+    QGCByteRingBuffer(const QGCByteRingBuffer&);
+    QGCByteRingBuffer& operator=(const QGCByteRingBuffer&);
+
+    const unsigned int size;
+    const unsigned int mask;
+    char* const buffer;
+    QAtomicInt head;    ///< Next byte to read, written by the consumer
+    QAtomicInt tail;    ///< Next free byte, written by the producer
+};
+
+#endif // QGCBYTERINGBUFFER_H
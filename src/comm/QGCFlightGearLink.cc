@@ -33,6 +33,7 @@ This file is part of the QGROUNDCONTROL project
 #include <QList>
 #include <QDebug>
 #include <QMutexLocker>
+#include <QSettings>
 #include <iostream>
 #include "QGCFlightGearLink.h"
 #include "QGC.h"
@@ -44,7 +45,10 @@ QGCFlightGearLink::QGCFlightGearLink(UASInterface* mav, QString startupArguments
     process(NULL),
     terraSync(NULL),
     flightGearVersion(0),
-    startupArguments(startupArguments)
+    startupArguments(startupArguments),
+    binaryProtocol(false),
+    updateRate(50),
+    invalidDatagramReported(false)
 {
     this->host = host;
     this->port = port+mav->getUASID();
@@ -53,10 +57,14 @@ QGCFlightGearLink::QGCFlightGearLink(UASInterface* mav, QString startupArguments
     this->mav = mav;
     this->name = tr("FlightGear Link (port:%1)").arg(port);
     setRemoteHost(remoteHost);
+    loadSettings();
+    QGCFlightGearNet::initControls(&controls, 1);
 }
 
 QGCFlightGearLink::~QGCFlightGearLink()
-{   //do not disconnect unless it is connected.
+{
+    storeSettings();
+    //do not disconnect unless it is connected.
     //disconnectSimulation will delete the memory that was allocated for proces, terraSync and socket
     if(connectState){
        disconnectSimulation();
@@ -72,6 +80,36 @@ void QGCFlightGearLink::run()
     exec();
 }
 
+void QGCFlightGearLink::loadSettings()
+{
+    QSettings settings;
+    settings.sync();
+    settings.beginGroup("QGC_FLIGHTGEAR_LINK");
+    setBinaryProtocol(settings.value("BINARY_PROTOCOL", binaryProtocol).toBool());
+    setUpdateRate(settings.value("UPDATE_RATE", updateRate).toInt());
+    settings.endGroup();
+}
+
+void QGCFlightGearLink::storeSettings()
+{
+    QSettings settings;
+    settings.beginGroup("QGC_FLIGHTGEAR_LINK");
+    settings.setValue("BINARY_PROTOCOL", binaryProtocol);
+    settings.setValue("UPDATE_RATE", updateRate);
+    settings.endGroup();
+    settings.sync();
+}
+
+void QGCFlightGearLink::setBinaryProtocol(bool enabled)
+{
+    binaryProtocol = enabled;
+}
+
+void QGCFlightGearLink::setUpdateRate(int rate)
+{
+    updateRate = qBound(1, rate, 1000);
+}
+
 void QGCFlightGearLink::setPort(int port)
 {
     this->port = port;
@@ -169,9 +207,27 @@ void QGCFlightGearLink::updateControls(uint64_t time, float rollAilerons, float
 
     if(!isnan(rollAilerons) && !isnan(pitchElevator) && !isnan(yawRudder) && !isnan(throttle))
     {
-        QString state("%1\t%2\t%3\t%4\t%5\n");
-        state = state.arg(rollAilerons).arg(pitchElevator).arg(yawRudder).arg(true).arg(throttle);
-        writeBytes(state.toAscii().constData(), state.length());
+        const qint64 received = latency.controlsReceived();
+        if (binaryProtocol)
+        {
+            controls.aileron = rollAilerons;
+            controls.elevator = pitchElevator;
+            controls.rudder = yawRudder;
+            for (uint32_t i = 0; i < controls.num_engines; i++)
+            {
+                controls.throttle[i] = throttle;
+            }
+            FGNetCtrls packet = controls;
+            QGCFlightGearNet::convertByteOrder(&packet);
+            writeBytes((const char*)&packet, sizeof(packet));
+        }
+        else
+        {
+            QString state("%1\t%2\t%3\t%4\t%5\n");
+            state = state.arg(rollAilerons).arg(pitchElevator).arg(yawRudder).arg(true).arg(throttle);
+            writeBytes(state.toAscii().constData(), state.length());
+        }
+        latency.controlsSent(received, latency.now());
     }
     else
     {
@@ -214,58 +270,47 @@ void QGCFlightGearLink::writeBytes(const char* data, qint64 size)
  **/
 void QGCFlightGearLink::readBytes()
 {
-    const qint64 maxLength = 65536;
-    char data[maxLength];
-    QHostAddress sender;
-    quint16 senderPort;
-
-    unsigned int s = socket->pendingDatagramSize();
-    if (s > maxLength) std::cerr << __FILE__ << __LINE__ << " UDP datagram overflow, allowed to read less bytes than datagram size" << std::endl;
-    socket->readDatagram(data, maxLength, &sender, &senderPort);
-
-    QByteArray b(data, s);
-
-    // Print string
-    QString state(b);
-    //qDebug() << "FG LINK GOT:" << state;
-
-    QStringList values = state.split("\t");
+    while (socket && socket->hasPendingDatagrams())
+    {
+        const qint64 received = latency.now();
+        const qint64 size = socket->pendingDatagramSize();
+        if (buffer.size() < size) buffer.resize(size);
+        const qint64 read = socket->readDatagram(buffer.data(), buffer.size());
+        if (read < 0) break;
+        processDatagram(buffer.constData(), read, received);
+    }
+}
 
-    // Check length
-    if (values.size() != 17)
+/**
+ * @brief Parse one state datagram.
+ *
+ * @param data Pointer to the datagram
+ * @param size The size of the datagram
+ * @param received Receive time of the datagram in microseconds of latency.now()
+ **/
+void QGCFlightGearLink::processDatagram(const char* data, qint64 size, qint64 received)
+{
+    QGCHilState state;
+    if (binaryProtocol)
+    {
+        if (!QGCFlightGearNet::parseFDM(data, size, &state))
+        {
+            reportInvalidDatagram(tr("native datagram of %1 bytes").arg(size));
+            return;
+        }
+    }
+    else if (!QGCFlightGearNet::parseText(data, size, &state))
     {
-        qDebug() << "RETURN LENGTH MISMATCHING EXPECTED" << 17 << "BUT GOT" << values.size();
-        qDebug() << state;
+        reportInvalidDatagram(tr("text datagram without the expected 17 fields"));
         return;
     }
 
-    // Parse string
-    float roll, pitch, yaw, rollspeed, pitchspeed, yawspeed;
-    double lat, lon, alt;
-    double vx, vy, vz, xacc, yacc, zacc;
-
-    lat = values.at(1).toDouble() * 1e7;
-    lon = values.at(2).toDouble() * 1e7;
-    alt = values.at(3).toDouble() * 1e3;
-    roll = values.at(4).toDouble();
-    pitch = values.at(5).toDouble();
-    yaw = values.at(6).toDouble();
-    rollspeed = values.at(7).toDouble();
-    pitchspeed = values.at(8).toDouble();
-    yawspeed = values.at(9).toDouble();
-
-    xacc = values.at(10).toDouble()*1e3/9.8; // convert to mg's
-    yacc = values.at(11).toDouble()*1e3/9.8;
-    zacc = values.at(12).toDouble()*1e3/9.8;
-
-    vx = values.at(13).toDouble() * 1e2;
-    vy = values.at(14).toDouble() * 1e2;
-    vz = values.at(15).toDouble() * 1e2;
-
     // Send updated state
-    emit hilStateChanged(QGC::groundTimeUsecs(), roll, pitch, yaw, rollspeed,
-                         pitchspeed, yawspeed, lat, lon, alt,
-                         vx, vy, vz, xacc, yacc, zacc);
+    latency.stateEmitted(received, latency.now());
+    emit hilStateChanged(QGC::groundTimeUsecs(), state.roll, state.pitch, state.yaw, state.rollspeed,
+                         state.pitchspeed, state.yawspeed, state.lat * 1e7, state.lon * 1e7, state.alt * 1e3,
+                         state.vx * 1e2, state.vy * 1e2, state.vz * 1e2,
+                         state.xacc * 1e3 / 9.8, state.yacc * 1e3 / 9.8, state.zacc * 1e3 / 9.8); // convert to mg's
 
     //    // Echo data for debugging purposes
     //    std::cerr << __FILE__ << __LINE__ << "Received datagram:" << std::endl;
@@ -278,6 +323,17 @@ void QGCFlightGearLink::readBytes()
     //    std::cerr << std::endl;
 }
 
+/**
+ * Datagrams arrive at the update rate, a wrong protocol setting is only
+ * reported once per connection.
+ */
+void QGCFlightGearLink::reportInvalidDatagram(const QString& reason)
+{
+    if (invalidDatagramReported) return;
+    invalidDatagramReported = true;
+    qDebug() << "FG LINK: ignoring" << reason << "- check the protocol setting";
+}
+
 
 /**
  * @brief Get the number of bytes to read.
@@ -342,6 +398,10 @@ bool QGCFlightGearLink::connectSimulation()
 
     QObject::connect(socket, SIGNAL(readyRead()), this, SLOT(readBytes()));
 
+    latency.reset();
+    invalidDatagramReported = false;
+    QGCFlightGearNet::initControls(&controls, (mav->getSystemType() == MAV_TYPE_QUADROTOR) ? 4 : 1);
+
     process = new QProcess(this);
     terraSync = new QProcess(this);
 
@@ -435,15 +495,20 @@ bool QGCFlightGearLink::connectSimulation()
     //flightGearArguments << QString("--fg-root=%1").arg(fgRoot);
     flightGearArguments << QString("--fg-scenery=%1:%2").arg(terraSyncScenery); //according to http://wiki.flightgear.org/TerraSync a separate directory is used
     flightGearArguments << QString("--fg-aircraft=%1").arg(fgAircraft);
-    if (mav->getSystemType() == MAV_TYPE_QUADROTOR)
+    if (binaryProtocol)
+    {
+        flightGearArguments << QString("--native-fdm=socket,out,%1,127.0.0.1,%2,udp").arg(updateRate).arg(port);
+        flightGearArguments << QString("--native-ctrls=socket,in,%1,127.0.0.1,%2,udp").arg(updateRate).arg(currentPort);
+    }
+    else if (mav->getSystemType() == MAV_TYPE_QUADROTOR)
     {
-        flightGearArguments << QString("--generic=socket,out,50,127.0.0.1,%1,udp,qgroundcontrol-quadrotor").arg(port);
-        flightGearArguments << QString("--generic=socket,in,50,127.0.0.1,%1,udp,qgroundcontrol-quadrotor").arg(currentPort);
+        flightGearArguments << QString("--generic=socket,out,%1,127.0.0.1,%2,udp,qgroundcontrol-quadrotor").arg(updateRate).arg(port);
+        flightGearArguments << QString("--generic=socket,in,%1,127.0.0.1,%2,udp,qgroundcontrol-quadrotor").arg(updateRate).arg(currentPort);
     }
     else
     {
-        flightGearArguments << QString("--generic=socket,out,50,127.0.0.1,%1,udp,qgroundcontrol-fixed-wing").arg(port);
-        flightGearArguments << QString("--generic=socket,in,50,127.0.0.1,%1,udp,qgroundcontrol-fixed-wing").arg(currentPort);
+        flightGearArguments << QString("--generic=socket,out,%1,127.0.0.1,%2,udp,qgroundcontrol-fixed-wing").arg(updateRate).arg(port);
+        flightGearArguments << QString("--generic=socket,in,%1,127.0.0.1,%2,udp,qgroundcontrol-fixed-wing").arg(updateRate).arg(currentPort);
     }
     flightGearArguments << "--atlas=socket,out,1,localhost,5505,udp";
 //    flightGearArguments << "--in-air";
@@ -42,6 +42,7 @@ This file is part of the QGROUNDCONTROL project
 #include <configuration.h>
 #include "UASInterface.h"
 #include "QGCHilLink.h"
+#include "QGCFlightGearNet.h"
 
 class QGCFlightGearLink : public QGCHilLink
 {
@@ -81,6 +82,23 @@ public:
 
     void run();
 
+    /** @brief Load the protocol and update rate of the FlightGear HIL settings */
+    void loadSettings();
+    /** @brief Store the protocol and update rate of the FlightGear HIL settings */
+    void storeSettings();
+
+    /** @brief Exchange FGNetFDM and FGNetCtrls instead of the text protocol */
+    bool isBinaryProtocol() const {
+        return binaryProtocol;
+    }
+    /** @brief Rate at which FlightGear sends states, in Hertz */
+    int getUpdateRate() const {
+        return updateRate;
+    }
+
+    /** @brief Parse a state datagram of the selected protocol */
+    void processDatagram(const char* data, qint64 size, qint64 received);
+
 public slots:
 //    void setAddress(QString address);
     void setPort(int port);
@@ -118,6 +136,10 @@ public slots:
     void printTerraSyncOutput();
     void printTerraSyncError();
     void setStartupArguments(QString startupArguments);
+    /** @brief Select the native binary protocol, applied on the next connect */
+    void setBinaryProtocol(bool enabled);
+    /** @brief Set the rate at which FlightGear sends states, applied on the next connect */
+    void setUpdateRate(int rate);
 
 protected:
     QString name;
@@ -144,8 +166,15 @@ protected:
     QProcess* terraSync;
     unsigned int flightGearVersion;
     QString startupArguments;
+    bool binaryProtocol;
+    int updateRate;
+    QByteArray buffer;      ///< Reused receive buffer
+    bool invalidDatagramReported; ///< An unparsable datagram was reported since the connect
+    FGNetCtrls controls;    ///< Controls sent in binary mode, host byte order
 
     void setName(QString name);
+    /** @brief Report a datagram that does not match the protocol, once per connection */
+    void reportInvalidDatagram(const QString& reason);
 
 signals:
 
@@ -0,0 +1,181 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class QGCFlightGearNet
+ */
+
+#include <string.h>
+#include <math.h>
+#include <QtEndian>
+#include <QString>
+#include <QStringList>
+
+#include "QGCFlightGearNet.h"
+
+static const double radToDeg = 180.0 / M_PI;
+static const float feetToMeters = 0.3048f;
+
+/** @brief Swap consecutive 32 bit fields on little endian hosts */
+static void swapWords(void* first, int count)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    char* field = static_cast<char*>(first);
+    for (int i = 0; i < count; i++, field += sizeof(quint32))
+    {
+        quint32 value;
+        memcpy(&value, field, sizeof(value));
+        value = qbswap(value);
+        memcpy(field, &value, sizeof(value));
+    }
+#else
+    Q_UNUSED(first);
+    Q_UNUSED(count);
+#endif
+}
+
+/** @brief Swap consecutive 64 bit fields on little endian hosts */
+static void swapDoubles(void* first, int count)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    char* field = static_cast<char*>(first);
+    for (int i = 0; i < count; i++, field += sizeof(quint64))
+    {
+        quint64 value;
+        memcpy(&value, field, sizeof(value));
+        value = qbswap(value);
+        memcpy(field, &value, sizeof(value));
+    }
+#else
+    Q_UNUSED(first);
+    Q_UNUSED(count);
+#endif
+}
+
+void QGCFlightGearNet::convertByteOrder(FGNetFDM* fdm)
+{
+    swapWords(&fdm->version, 2);
+    swapDoubles(&fdm->longitude, 3);
+    // All fields after the position are 32 bit wide
+    const char* end = reinterpret_cast<const char*>(fdm) + sizeof(FGNetFDM);
+    swapWords(&fdm->agl, (end - reinterpret_cast<const char*>(&fdm->agl)) / sizeof(quint32));
+}
+
+void QGCFlightGearNet::convertByteOrder(FGNetCtrls* ctrls)
+{
+    // Runs of fields of the same width, including the explicit padding
+    swapWords(&ctrls->version, 2);
+    swapDoubles(&ctrls->aileron, 9);
+    swapWords(&ctrls->flaps_power, 3 + 4 * FG_NET_MAX_ENGINES + 1);
+    swapDoubles(ctrls->throttle, 3 * FG_NET_MAX_ENGINES);
+    swapWords(ctrls->fuel_pump_power, FG_NET_MAX_ENGINES);
+    swapDoubles(ctrls->prop_advance, FG_NET_MAX_ENGINES);
+    swapWords(ctrls->feed_tank_to, 4 + 4 + 6 * FG_NET_MAX_ENGINES + 1 + FG_NET_CTRLS_MAX_TANKS + 5 + 1 + 1);
+    swapDoubles(&ctrls->brake_left, 5);
+    swapWords(&ctrls->gear_handle, 2);
+    swapDoubles(&ctrls->comm_1, 11);
+    swapWords(&ctrls->icing, 3 + FG_NET_CTRLS_RESERVED);
+}
+
+bool QGCFlightGearNet::parseFDM(const char* data, qint64 size, QGCHilState* state)
+{
+    FGNetFDM fdm;
+    if (size < qint64(sizeof(fdm))) return false;
+    memcpy(&fdm, data, sizeof(fdm));
+    convertByteOrder(&fdm);
+    if (fdm.version != FG_NET_FDM_VERSION) return false;
+
+    state->lat = fdm.latitude * radToDeg;
+    state->lon = fdm.longitude * radToDeg;
+    state->alt = fdm.altitude;
+    state->roll = fdm.phi;
+    state->pitch = fdm.theta;
+    state->yaw = fdm.psi;
+    state->rollspeed = fdm.phidot;
+    state->pitchspeed = fdm.thetadot;
+    state->yawspeed = fdm.psidot;
+    state->vx = fdm.v_north * feetToMeters;
+    state->vy = fdm.v_east * feetToMeters;
+    state->vz = fdm.v_down * feetToMeters;
+    state->xacc = fdm.A_X_pilot * feetToMeters;
+    state->yacc = fdm.A_Y_pilot * feetToMeters;
+    state->zacc = fdm.A_Z_pilot * feetToMeters;
+    return true;
+}
+
+bool QGCFlightGearNet::parseText(const char* data, qint64 size, QGCHilState* state)
+{
+    QString line = QString::fromAscii(data, size);
+    QStringList values = line.split("\t");
+
+    // Check length
+    if (values.size() != 17) return false;
+
+    state->lat = values.at(1).toDouble();
+    state->lon = values.at(2).toDouble();
+    state->alt = values.at(3).toDouble();
+    state->roll = values.at(4).toDouble();
+    state->pitch = values.at(5).toDouble();
+    state->yaw = values.at(6).toDouble();
+    state->rollspeed = values.at(7).toDouble();
+    state->pitchspeed = values.at(8).toDouble();
+    state->yawspeed = values.at(9).toDouble();
+    state->xacc = values.at(10).toDouble();
+    state->yacc = values.at(11).toDouble();
+    state->zacc = values.at(12).toDouble();
+    state->vx = values.at(13).toDouble();
+    state->vy = values.at(14).toDouble();
+    state->vz = values.at(15).toDouble();
+    return true;
+}
+
+void QGCFlightGearNet::initControls(FGNetCtrls* ctrls, int engines)
+{
+    memset(ctrls, 0, sizeof(FGNetCtrls));
+    ctrls->version = FG_NET_CTRLS_VERSION;
+    ctrls->flaps_power = 1;
+    ctrls->flap_motor_ok = 1;
+    ctrls->num_engines = qBound(0, engines, FG_NET_MAX_ENGINES);
+    for (uint32_t i = 0; i < ctrls->num_engines; i++)
+    {
+        ctrls->master_bat[i] = 1;
+        ctrls->master_alt[i] = 1;
+        ctrls->magnetos[i] = 3;
+        ctrls->mixture[i] = 1.0;
+        ctrls->condition[i] = 1.0;
+        ctrls->fuel_pump_power[i] = 1;
+        ctrls->prop_advance[i] = 1.0;
+        ctrls->engine_ok[i] = 1;
+        ctrls->mag_left_ok[i] = 1;
+        ctrls->mag_right_ok[i] = 1;
+        ctrls->spark_plugs_ok[i] = 1;
+        ctrls->fuel_pump_ok[i] = 1;
+    }
+    ctrls->num_tanks = 1;
+    ctrls->fuel_selector[0] = 1;
+    ctrls->master_avionics = 1;
+    ctrls->temp_c = 15.0;
+    ctrls->press_inhg = 29.92;
+    ctrls->speedup = 1;
+}
@@ -0,0 +1,287 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of the FlightGear native protocol and class QGCFlightGearNet
+ */
+
+#ifndef QGCFLIGHTGEARNET_H
+#define QGCFLIGHTGEARNET_H
+
+#include <QtGlobal>
+#include "inttypes.h"
+
+/** Version of FGNetFDM, from FlightGear net_fdm.hxx */
+#define FG_NET_FDM_VERSION 24
+/** Version of FGNetCtrls, from FlightGear net_ctrls.hxx */
+#define FG_NET_CTRLS_VERSION 27
+
+#define FG_NET_MAX_ENGINES 4
+#define FG_NET_MAX_WHEELS 3
+#define FG_NET_MAX_TANKS 4
+#define FG_NET_CTRLS_MAX_TANKS 8
+#define FG_NET_CTRLS_RESERVED 25
+
+/**
+ * @brief Flight dynamics state sent by FlightGear and JSBSim
+ *
+ * Layout of FlightGear's --native-fdm and of the FLIGHTGEAR output of
+ * JSBSim. All fields are in network byte order on the wire.
+ */
+struct FGNetFDM
+{
+    uint32_t version;
+    uint32_t padding;
+
+    // Positions
+    double longitude;       ///< Geodetic radians
+    double latitude;        ///< Geodetic radians
+    double altitude;        ///< Above sea level in meters
+    float agl;              ///< Above ground level in meters
+    float phi;              ///< Roll in radians
+    float theta;            ///< Pitch in radians
+    float psi;              ///< Yaw or true heading in radians
+    float alpha;            ///< Angle of attack in radians
+    float beta;             ///< Side slip angle in radians
+
+    // Velocities
+    float phidot;           ///< Roll rate in radians per second
+    float thetadot;         ///< Pitch rate in radians per second
+    float psidot;           ///< Yaw rate in radians per second
+    float vcas;             ///< Calibrated airspeed in knots
+    float climb_rate;       ///< Feet per second
+    float v_north;          ///< North velocity in feet per second
+    float v_east;           ///< East velocity in feet per second
+    float v_down;           ///< Down velocity in feet per second
+    float v_body_u;         ///< Body frame velocity in feet per second
+    float v_body_v;
+    float v_body_w;
+
+    // Accelerations
+    float A_X_pilot;        ///< X acceleration at the pilot in feet per second squared
+    float A_Y_pilot;
+    float A_Z_pilot;
+
+    // Stall
+    float stall_warning;    ///< 0.0 to 1.0
+    float slip_deg;         ///< Slip ball deflection
+
+    // Engine status
+    uint32_t num_engines;
+    uint32_t eng_state[FG_NET_MAX_ENGINES];
+    float rpm[FG_NET_MAX_ENGINES];
+    float fuel_flow[FG_NET_MAX_ENGINES];
+    float fuel_px[FG_NET_MAX_ENGINES];
+    float egt[FG_NET_MAX_ENGINES];
+    float cht[FG_NET_MAX_ENGINES];
+    float mp_osi[FG_NET_MAX_ENGINES];
+    float tit[FG_NET_MAX_ENGINES];
+    float oil_temp[FG_NET_MAX_ENGINES];
+    float oil_px[FG_NET_MAX_ENGINES];
+
+    // Consumables
+    uint32_t num_tanks;
+    float fuel_quantity[FG_NET_MAX_TANKS];
+
+    // Gear status
+    uint32_t num_wheels;
+    uint32_t wow[FG_NET_MAX_WHEELS];
+    float gear_pos[FG_NET_MAX_WHEELS];
+    float gear_steer[FG_NET_MAX_WHEELS];
+    float gear_compression[FG_NET_MAX_WHEELS];
+
+    // Environment
+    uint32_t cur_time;      ///< Unix time
+    int32_t warp;           ///< Offset to the real time in seconds
+    float visibility;       ///< Meters
+
+    // Control surface positions, normalized
+    float elevator;
+    float elevator_trim_tab;
+    float left_flap;
+    float right_flap;
+    float left_aileron;
+    float right_aileron;
+    float rudder;
+    float nose_wheel;
+    float speedbrake;
+    float spoilers;
+};
+
+/**
+ * @brief Controls sent to FlightGear
+ *
+ * Layout of FlightGear's --native-ctrls. All fields are in network byte
+ * order on the wire. FlightGear reads the struct as laid out by its own
+ * compiler, which aligns the doubles to 8 bytes. The padding fields make
+ * that layout explicit, so it does not depend on the alignment rules of
+ * this build, e.g. 4 byte aligned doubles on 32 bit x86.
+ */
+struct FGNetCtrls
+{
+    uint32_t version;
+    uint32_t padding;
+
+    // Aero controls
+    double aileron;         ///< -1 to 1
+    double elevator;        ///< -1 to 1
+    double rudder;          ///< -1 to 1
+    double aileron_trim;
+    double elevator_trim;
+    double rudder_trim;
+    double flaps;           ///< 0 to 1
+    double spoilers;
+    double speedbrake;
+
+    // Aero control faults
+    uint32_t flaps_power;
+    uint32_t flap_motor_ok;
+
+    // Engine controls
+    uint32_t num_engines;
+    uint32_t master_bat[FG_NET_MAX_ENGINES];
+    uint32_t master_alt[FG_NET_MAX_ENGINES];
+    uint32_t magnetos[FG_NET_MAX_ENGINES];
+    uint32_t starter_power[FG_NET_MAX_ENGINES];
+    uint32_t padding2;
+    double throttle[FG_NET_MAX_ENGINES];    ///< 0 to 1
+    double mixture[FG_NET_MAX_ENGINES];     ///< 0 to 1
+    double condition[FG_NET_MAX_ENGINES];   ///< 0 to 1
+    uint32_t fuel_pump_power[FG_NET_MAX_ENGINES];
+    double prop_advance[FG_NET_MAX_ENGINES];
+    uint32_t feed_tank_to[4];
+    uint32_t reverse[4];
+
+    // Engine faults
+    uint32_t engine_ok[FG_NET_MAX_ENGINES];
+    uint32_t mag_left_ok[FG_NET_MAX_ENGINES];
+    uint32_t mag_right_ok[FG_NET_MAX_ENGINES];
+    uint32_t spark_plugs_ok[FG_NET_MAX_ENGINES];
+    uint32_t oil_press_status[FG_NET_MAX_ENGINES];
+    uint32_t fuel_pump_ok[FG_NET_MAX_ENGINES];
+
+    // Fuel management
+    uint32_t num_tanks;
+    uint32_t fuel_selector[FG_NET_CTRLS_MAX_TANKS];
+    uint32_t xfer_pump[5];
+    uint32_t cross_feed;
+    uint32_t padding3;
+
+    // Brake controls
+    double brake_left;
+    double brake_right;
+    double copilot_brake_left;
+    double copilot_brake_right;
+    double brake_parking;
+
+    // Landing gear
+    uint32_t gear_handle;
+
+    // Switches
+    uint32_t master_avionics;
+
+    // Nav and comm
+    double comm_1;
+    double comm_2;
+    double nav_1;
+    double nav_2;
+
+    // Wind and turbulence
+    double wind_speed_kt;
+    double wind_dir_deg;
+    double turbulence_norm;
+
+    // Temperature and pressure
+    double temp_c;
+    double press_inhg;
+
+    // Other environment information
+    double hground;         ///< Ground elevation in meters
+    double magvar;          ///< Magnetic variation in degrees
+
+    // Hazards
+    uint32_t icing;
+
+    // Simulation control
+    uint32_t speedup;
+    uint32_t freeze;
+
+    uint32_t reserved[FG_NET_CTRLS_RESERVED];
+};
+
+// The wire sizes, a mismatch fails to compile
+typedef char FGNetFDMSizeCheck[(sizeof(FGNetFDM) == 408) ? 1 : -1];
+typedef char FGNetCtrlsSizeCheck[(sizeof(FGNetCtrls) == 744) ? 1 : -1];
+
+/** @brief Vehicle state received from a simulator, in SI units */
+struct QGCHilState
+{
+    float roll;             ///< Radians
+    float pitch;
+    float yaw;
+    float rollspeed;        ///< Radians per second
+    float pitchspeed;
+    float yawspeed;
+    double lat;             ///< Degrees
+    double lon;
+    double alt;             ///< Meters above sea level
+    float vx;               ///< North velocity in meters per second
+    float vy;
+    float vz;
+    float xacc;             ///< Meters per second squared
+    float yacc;
+    float zacc;
+};
+
+/**
+ * @brief Parsing and packing of the FlightGear protocols
+ *
+ * The text protocol is the tab separated generic protocol defined by the
+ * qgroundcontrol-*.xml files, the native protocol exchanges FGNetFDM and
+ * FGNetCtrls. Parsing a native datagram does not allocate.
+ */
+class QGCFlightGearNet
+{
+public:
+    /** @brief Convert between host and network byte order, in place */
+    static void convertByteOrder(FGNetFDM* fdm);
+    /** @brief Convert between host and network byte order, in place */
+    static void convertByteOrder(FGNetCtrls* ctrls);
+
+    /**
+     * @brief Parse a FGNetFDM datagram
+     * @return false if the datagram is too short or has a different version
+     */
+    static bool parseFDM(const char* data, qint64 size, QGCHilState* state);
+    /**
+     * @brief Parse a line of the generic text protocol
+     * @return false if the line does not contain all fields
+     */
+    static bool parseText(const char* data, qint64 size, QGCHilState* state);
+
+    /** @brief Initialize controls with running engines and a standard atmosphere, in host byte order */
+    static void initControls(FGNetCtrls* ctrls, int engines);
+};
+
+#endif // QGCFLIGHTGEARNET_H
@@ -0,0 +1,161 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class QGCHilLatency
+ */
+
+#include <QMutexLocker>
+
+#include "QGCHilLatency.h"
+
+qint64 QGCHilLatencySample::percentile(double fraction) const
+{
+    if (count == 0) return 0;
+    const double target = fraction * count;
+    quint64 cumulative = 0;
+    for (int bin = 0; bin < histogram.size(); bin++)
+    {
+        cumulative += histogram.at(bin);
+        if (cumulative >= target && cumulative > 0)
+        {
+            return (bin == 0) ? 0 : (Q_INT64_C(1) << bin);
+        }
+    }
+    return max;
+}
+
+QGCHilLatency::QGCHilLatency()
+{
+    clock.start();
+    reset();
+}
+
+int QGCHilLatency::latencyBin(qint64 latency)
+{
+    int bin = 0;
+    while (latency > 0 && bin < HIL_LATENCY_BINS - 1)
+    {
+        latency >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+void QGCHilLatency::reset()
+{
+    QMutexLocker locker(&mutex);
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+    {
+        Record& record = records[stage];
+        record.count = 0;
+        record.sum = 0;
+        record.max = 0;
+        for (int bin = 0; bin < HIL_LATENCY_BINS; bin++)
+        {
+            record.histogram[bin] = 0;
+        }
+    }
+    lastReceived = -1;
+    lastEmitted = -1;
+    loopStart = -1;
+}
+
+void QGCHilLatency::add(Stage stage, qint64 latency)
+{
+    QMutexLocker locker(&mutex);
+    Record& record = records[stage];
+    record.count++;
+    record.sum += latency;
+    record.max = qMax(record.max, latency);
+    record.histogram[latencyBin(latency)]++;
+}
+
+void QGCHilLatency::stateEmitted(qint64 received, qint64 emitted)
+{
+    add(STAGE_PARSE, emitted - received);
+    QMutexLocker locker(&mutex);
+    lastReceived = received;
+    lastEmitted = emitted;
+}
+
+qint64 QGCHilLatency::controlsReceived()
+{
+    const qint64 received = now();
+    qint64 emitted;
+    {
+        QMutexLocker locker(&mutex);
+        emitted = lastEmitted;
+        if (emitted >= 0) loopStart = lastReceived;
+        lastReceived = -1;
+        lastEmitted = -1;
+    }
+    if (emitted >= 0) add(STAGE_AUTOPILOT, received - emitted);
+    return received;
+}
+
+void QGCHilLatency::controlsSent(qint64 received, qint64 sent)
+{
+    qint64 start;
+    {
+        QMutexLocker locker(&mutex);
+        start = loopStart;
+        loopStart = -1;
+    }
+    add(STAGE_SEND, sent - received);
+    if (start >= 0) add(STAGE_LOOP, sent - start);
+}
+
+QGCHilLatencySample QGCHilLatency::getSample(Stage stage) const
+{
+    QGCHilLatencySample sample;
+    QMutexLocker locker(&mutex);
+    const Record& record = records[stage];
+    sample.count = record.count;
+    sample.mean = (record.count > 0) ? record.sum / qint64(record.count) : 0;
+    sample.max = record.max;
+    sample.histogram.resize(HIL_LATENCY_BINS);
+    for (int bin = 0; bin < HIL_LATENCY_BINS; bin++)
+    {
+        sample.histogram[bin] = record.histogram[bin];
+    }
+    return sample;
+}
+
+QString QGCHilLatency::getStageName(Stage stage)
+{
+    switch (stage)
+    {
+    case STAGE_PARSE:
+        return QString("Parse");
+    case STAGE_AUTOPILOT:
+        return QString("Autopilot");
+    case STAGE_SEND:
+        return QString("Send");
+    case STAGE_LOOP:
+        return QString("Loop");
+    default:
+        return QString();
+    }
+}
@@ -0,0 +1,140 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class QGCHilLatency
+ */
+
+#ifndef QGCHILLATENCY_H
+#define QGCHILLATENCY_H
+
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QElapsedTimer>
+
+/** Number of log2 bins of a latency histogram */
+#define HIL_LATENCY_BINS 24
+
+/** @brief Latency statistics of one stage of the HIL loop */
+struct QGCHilLatencySample
+{
+    QGCHilLatencySample() : count(0), mean(0), max(0) {}
+    quint64 count;          ///< Number of measurements
+    qint64 mean;            ///< Mean latency in microseconds
+    qint64 max;             ///< Largest latency in microseconds
+    QVector<quint32> histogram; ///< Bin n > 0 counts latencies of [2^(n-1), 2^n) microseconds
+
+    /**
+     * @brief Latency below which a fraction of the measurements lies
+     *
+     * @param fraction 0 to 1, e.g. 0.99 for the 99th percentile
+     * @return upper bound of the histogram bin in microseconds, 0 if there are no measurements
+     */
+    qint64 percentile(double fraction) const;
+};
+
+/**
+ * @brief Timestamps the stages of a hardware in the loop exchange
+ *
+ * The loop starts with a simulator datagram carrying a new vehicle state
+ * and ends with the datagram carrying the control outputs computed from
+ * it. The stages are:
+ * - parse: state datagram received until the state is handed to the autopilot
+ * - autopilot: state handed to the autopilot until its controls arrive back
+ * - send: controls arrived until their datagram is sent to the simulator
+ * - loop: state datagram received until the controls datagram is sent
+ *
+ * Controls are attributed to the latest state which was not answered yet,
+ * controls arriving without a new state only count in the send stage.
+ *
+ * All timestamps come from now(). The methods can be called from any
+ * thread, the network thread of the link and the thread of the autopilot.
+ */
+class QGCHilLatency
+{
+public:
+    enum Stage
+    {
+        STAGE_PARSE = 0,
+        STAGE_AUTOPILOT,
+        STAGE_SEND,
+        STAGE_LOOP,
+        STAGE_COUNT
+    };
+
+    QGCHilLatency();
+
+    /** @brief Monotonic time in microseconds */
+    qint64 now() const {
+        return clock.nsecsElapsed() / 1000;
+    }
+
+    /**
+     * @brief A state was handed to the autopilot
+     * @param received time its datagram was received
+     * @param emitted time it was handed on
+     */
+    void stateEmitted(qint64 received, qint64 emitted);
+    /**
+     * @brief Controls arrived from the autopilot
+     * @return the current time, to be passed to controlsSent()
+     */
+    qint64 controlsReceived();
+    /**
+     * @brief The datagram with the controls was sent
+     * @param received time returned by controlsReceived()
+     * @param sent time the datagram was written to the socket
+     */
+    void controlsSent(qint64 received, qint64 sent);
+
+    /** @brief Add one measurement to a stage */
+    void add(Stage stage, qint64 latency);
+    /** @brief Drop all measurements and pending states */
+    void reset();
+
+    QGCHilLatencySample getSample(Stage stage) const;
+    /** @brief Human readable name of a stage */
+    static QString getStageName(Stage stage);
+    /** @brief Histogram bin of a latency in microseconds */
+    static int latencyBin(qint64 latency);
+
+protected:
+    struct Record
+    {
+        quint64 count;
+        qint64 sum;
+        qint64 max;
+        quint32 histogram[HIL_LATENCY_BINS];
+    };
+
+    mutable QMutex mutex;   ///< Protects all members below
+    Record records[STAGE_COUNT];
+    qint64 lastReceived;    ///< Receive time of the latest unanswered state, -1 if none
+    qint64 lastEmitted;     ///< Emit time of the latest unanswered state, -1 if none
+    qint64 loopStart;       ///< Receive time of the state answered by the pending controls, -1 if none
+    QElapsedTimer clock;
+};
+
+#endif // QGCHILLATENCY_H
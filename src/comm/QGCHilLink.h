@@ -4,6 +4,7 @@
 #include <QThread>
 #include <QProcess>
 #include "inttypes.h"
+#include "QGCHilLatency.h"
 
 class QGCHilLink : public QThread
 {
@@ -37,6 +38,25 @@ public:
      */
     virtual int getAirFrameIndex() = 0;
 
+    /** @brief Get the latency statistics of the simulation loop */
+    QGCHilLatency* getLatency() {
+        return &latency;
+    }
+
+    /**
+     * @brief Handle a datagram received from the simulation
+     *
+     * Called by the network thread of links which receive in a QGCHilUdpWorker.
+     * @param data Pointer to the datagram
+     * @param size The size of the datagram
+     * @param received Receive time in microseconds of getLatency()->now()
+     */
+    virtual void processDatagram(const char* data, qint64 size, qint64 received) {
+        Q_UNUSED(data);
+        Q_UNUSED(size);
+        Q_UNUSED(received);
+    }
+
 public slots:
     virtual void setPort(int port) = 0;
     /** @brief Add a new host to broadcast messages to */
@@ -64,6 +84,8 @@ public slots:
 protected:
     virtual void setName(QString name) = 0;
 
+    QGCHilLatency latency;
+
 signals:
     /**
      * @brief This signal is emitted instantly when the link is connected
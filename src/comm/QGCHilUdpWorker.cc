@@ -0,0 +1,90 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class QGCHilUdpWorker
+ */
+
+#include "QGCHilUdpWorker.h"
+#include "QGCHilLink.h"
+
+QGCHilUdpWorker::QGCHilUdpWorker(QGCHilLink* link) :
+    link(link),
+    socket(NULL),
+    localPort(0),
+    remotePort(0)
+{
+}
+
+QGCHilUdpWorker::~QGCHilUdpWorker()
+{
+    delete socket;
+}
+
+bool QGCHilUdpWorker::open()
+{
+    close();
+    socket = new QUdpSocket(this);
+    if (!socket->bind(localHost, localPort))
+    {
+        close();
+        return false;
+    }
+    connect(socket, SIGNAL(readyRead()), this, SLOT(readPendingDatagrams()));
+    return true;
+}
+
+void QGCHilUdpWorker::close()
+{
+    if (socket)
+    {
+        socket->close();
+        delete socket;
+        socket = NULL;
+    }
+}
+
+void QGCHilUdpWorker::readPendingDatagrams()
+{
+    if (!socket) return;
+    while (socket->hasPendingDatagrams())
+    {
+        const qint64 received = link->getLatency()->now();
+        const qint64 size = socket->pendingDatagramSize();
+        if (buffer.size() < size) buffer.resize(size);
+        const qint64 read = socket->readDatagram(buffer.data(), buffer.size());
+        if (read < 0) break;
+        link->processDatagram(buffer.constData(), read, received);
+    }
+}
+
+void QGCHilUdpWorker::send(const QByteArray& datagram, qint64 controlTime)
+{
+    if (!socket) return;
+    socket->writeDatagram(datagram, remoteHost, remotePort);
+    if (controlTime >= 0)
+    {
+        link->getLatency()->controlsSent(controlTime, link->getLatency()->now());
+    }
+}
@@ -0,0 +1,93 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class QGCHilUdpWorker
+ */
+
+#ifndef QGCHILUDPWORKER_H
+#define QGCHILUDPWORKER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHostAddress>
+#include <QUdpSocket>
+
+class QGCHilLink;
+
+/**
+ * @brief Owns the UDP socket of a HIL link in the network thread
+ *
+ * The worker is moved to the thread of its link, the link thread only runs
+ * the event loop of the worker and is started with a high priority. Every
+ * received datagram is timestamped when the socket is drained and handed to
+ * QGCHilLink::processDatagram() in this thread, so parsing a simulator
+ * state never waits for the GUI thread. Datagrams to the simulator arrive
+ * through a queued connection to send().
+ *
+ * The addresses have to be set before the worker is opened.
+ */
+class QGCHilUdpWorker : public QObject
+{
+    Q_OBJECT
+public:
+    QGCHilUdpWorker(QGCHilLink* link);
+    ~QGCHilUdpWorker();
+
+    void setLocalAddress(const QHostAddress& host, quint16 port) {
+        localHost = host;
+        localPort = port;
+    }
+    void setRemoteAddress(const QHostAddress& host, quint16 port) {
+        remoteHost = host;
+        remotePort = port;
+    }
+
+public slots:
+    /** @brief Create and bind the socket, call in the worker thread */
+    bool open();
+    /** @brief Close the socket, call in the worker thread */
+    void close();
+    /** @brief Read and process all pending datagrams */
+    void readPendingDatagrams();
+    /**
+     * @brief Send a datagram to the simulation
+     *
+     * @param datagram the datagram
+     * @param controlTime time returned by QGCHilLatency::controlsReceived() if
+     *        the datagram completes a set of controls, -1 otherwise
+     */
+    void send(const QByteArray& datagram, qint64 controlTime);
+
+protected:
+    QGCHilLink* link;
+    QUdpSocket* socket;
+    QHostAddress localHost;
+    quint16 localPort;
+    QHostAddress remoteHost;
+    quint16 remotePort;
+    QByteArray buffer;      ///< Reused receive buffer
+};
+
+#endif // QGCHILUDPWORKER_H
@@ -33,6 +33,7 @@ This file is part of the QGROUNDCONTROL project
 #include <QList>
 #include <QDebug>
 #include <QMutexLocker>
+#include <QSettings>
 #include <iostream>
 #include "QGCJSBSimLink.h"
 #include "QGC.h"
@@ -42,7 +43,11 @@ This file is part of the QGROUNDCONTROL project
 QGCJSBSimLink::QGCJSBSimLink(UASInterface* mav, QString startupArguments, QString remoteHost, QHostAddress host, quint16 port) :
     socket(NULL),
     process(NULL),
-    startupArguments(startupArguments)
+    startupArguments(startupArguments),
+    binaryProtocol(false),
+    updateRate(50),
+    lastState(-1),
+    textDatagramReported(false)
 {
     this->host = host;
     this->port = port+mav->getUASID();
@@ -51,10 +56,13 @@ QGCJSBSimLink::QGCJSBSimLink(UASInterface* mav, QString startupArguments, QStrin
     this->mav = mav;
     this->name = tr("JSBSim Link (port:%1)").arg(port);
     setRemoteHost(remoteHost);
+    loadSettings();
 }
 
 QGCJSBSimLink::~QGCJSBSimLink()
-{   //do not disconnect unless it is connected.
+{
+    storeSettings();
+    //do not disconnect unless it is connected.
     //disconnectSimulation will delete the memory that was allocated for proces, terraSync and socket
     if(connectState){
        disconnectSimulation();
@@ -70,6 +78,36 @@ void QGCJSBSimLink::run()
     exec();
 }
 
+void QGCJSBSimLink::loadSettings()
+{
+    QSettings settings;
+    settings.sync();
+    settings.beginGroup("QGC_JSBSIM_LINK");
+    setBinaryProtocol(settings.value("BINARY_PROTOCOL", binaryProtocol).toBool());
+    setUpdateRate(settings.value("UPDATE_RATE", updateRate).toInt());
+    settings.endGroup();
+}
+
+void QGCJSBSimLink::storeSettings()
+{
+    QSettings settings;
+    settings.beginGroup("QGC_JSBSIM_LINK");
+    settings.setValue("BINARY_PROTOCOL", binaryProtocol);
+    settings.setValue("UPDATE_RATE", updateRate);
+    settings.endGroup();
+    settings.sync();
+}
+
+void QGCJSBSimLink::setBinaryProtocol(bool enabled)
+{
+    binaryProtocol = enabled;
+}
+
+void QGCJSBSimLink::setUpdateRate(int rate)
+{
+    updateRate = qBound(1, rate, 1000);
+}
+
 void QGCJSBSimLink::setPort(int port)
 {
     this->port = port;
@@ -167,9 +205,11 @@ void QGCJSBSimLink::updateControls(uint64_t time, float rollAilerons, float pitc
 
     if(!isnan(rollAilerons) && !isnan(pitchElevator) && !isnan(yawRudder) && !isnan(throttle))
     {
+        const qint64 received = latency.controlsReceived();
         QString state("%1\t%2\t%3\t%4\t%5\n");
         state = state.arg(rollAilerons).arg(pitchElevator).arg(yawRudder).arg(true).arg(throttle);
         writeBytes(state.toAscii().constData(), state.length());
+        latency.controlsSent(received, latency.now());
     }
     else
     {
@@ -212,42 +252,51 @@ void QGCJSBSimLink::writeBytes(const char* data, qint64 size)
  **/
 void QGCJSBSimLink::readBytes()
 {
-    const qint64 maxLength = 65536;
-    char data[maxLength];
-    QHostAddress sender;
-    quint16 senderPort;
-
-    unsigned int s = socket->pendingDatagramSize();
-    if (s > maxLength) std::cerr << __FILE__ << __LINE__ << " UDP datagram overflow, allowed to read less bytes than datagram size" << std::endl;
-    socket->readDatagram(data, maxLength, &sender, &senderPort);
-
-    QByteArray b(data, s);
-
-    // Print string
-//    QString state(b);
-
-//    // Parse string
-//    float roll, pitch, yaw, rollspeed, pitchspeed, yawspeed;
-//    double lat, lon, alt;
-//    double vx, vy, vz, xacc, yacc, zacc;
-
-//    // Send updated state
-//    emit hilStateChanged(QGC::groundTimeUsecs(), roll, pitch, yaw, rollspeed,
-//                         pitchspeed, yawspeed, lat, lon, alt,
-//                         vx, vy, vz, xacc, yacc, zacc);
-
-
+    while (socket && socket->hasPendingDatagrams())
+    {
+        const qint64 received = latency.now();
+        const qint64 size = socket->pendingDatagramSize();
+        if (buffer.size() < size) buffer.resize(size);
+        const qint64 read = socket->readDatagram(buffer.data(), buffer.size());
+        if (read < 0) break;
+        processDatagram(buffer.constData(), read, received);
+    }
+}
 
+/**
+ * @brief Parse one state datagram.
+ *
+ * JSBSim sends FGNetFDM with an output directive of type FLIGHTGEAR.
+ * @param data Pointer to the datagram
+ * @param s The size of the datagram
+ * @param received Receive time of the datagram in microseconds of latency.now()
+ **/
+void QGCJSBSimLink::processDatagram(const char* data, qint64 s, qint64 received)
+{
+    if (binaryProtocol)
+    {
+        QGCHilState state;
+        if (!QGCFlightGearNet::parseFDM(data, s, &state)) return;
+        // JSBSim sets the output rate, only forward at the update rate
+        if (lastState >= 0 && received - lastState < 1000000 / updateRate) return;
+        lastState = received;
+
+        // Send updated state
+        latency.stateEmitted(received, latency.now());
+        emit hilStateChanged(QGC::groundTimeUsecs(), state.roll, state.pitch, state.yaw, state.rollspeed,
+                             state.pitchspeed, state.yawspeed, state.lat * 1e7, state.lon * 1e7, state.alt * 1e3,
+                             state.vx * 1e2, state.vy * 1e2, state.vz * 1e2,
+                             state.xacc * 1e3 / 9.8, state.yacc * 1e3 / 9.8, state.zacc * 1e3 / 9.8); // convert to mg's
+        return;
+    }
 
-        // Echo data for debugging purposes
-        std::cerr << __FILE__ << __LINE__ << "Received datagram:" << std::endl;
-        int i;
-        for (i=0; i<s; i++)
-        {
-            unsigned int v=data[i];
-            fprintf(stderr,"%02x ", v);
-        }
-        std::cerr << std::endl;
+    // The text output of JSBSim is not parsed, datagrams arrive at the output rate
+    Q_UNUSED(data);
+    if (!textDatagramReported)
+    {
+        textDatagramReported = true;
+        qDebug() << "JSBSim LINK: ignoring text datagrams of" << s << "bytes, select the binary protocol";
+    }
 }
 
 
@@ -308,6 +357,10 @@ bool QGCJSBSimLink::connectSimulation()
 
     QObject::connect(socket, SIGNAL(readyRead()), this, SLOT(readBytes()));
 
+    latency.reset();
+    lastState = -1;
+    textDatagramReported = false;
+
     process = new QProcess(this);
 
     connect(mav, SIGNAL(hilControlsChanged(uint64_t, float, float, float, float, uint8_t, uint8_t)), this, SLOT(updateControls(uint64_t,float,float,float,float,uint8_t,uint8_t)));
@@ -42,6 +42,7 @@ This file is part of the QGROUNDCONTROL project
 #include <configuration.h>
 #include "UASInterface.h"
 #include "QGCHilLink.h"
+#include "QGCFlightGearNet.h"
 
 class QGCJSBSimLink : public QGCHilLink
 {
@@ -81,6 +82,23 @@ public:
 
     void run();
 
+    /** @brief Load the protocol and update rate of the JSBSim HIL settings */
+    void loadSettings();
+    /** @brief Store the protocol and update rate of the JSBSim HIL settings */
+    void storeSettings();
+
+    /** @brief Parse FGNetFDM states instead of dumping the datagrams */
+    bool isBinaryProtocol() const {
+        return binaryProtocol;
+    }
+    /** @brief Highest rate at which states are forwarded, in Hertz */
+    int getUpdateRate() const {
+        return updateRate;
+    }
+
+    /** @brief Parse a state datagram of the selected protocol */
+    void processDatagram(const char* data, qint64 size, qint64 received);
+
 public slots:
 //    void setAddress(QString address);
     void setPort(int port);
@@ -116,6 +134,10 @@ public slots:
     bool disconnectSimulation();
 
     void setStartupArguments(QString startupArguments);
+    /** @brief Select the FGNetFDM output of JSBSim */
+    void setBinaryProtocol(bool enabled);
+    /** @brief Set the highest rate at which states are forwarded */
+    void setUpdateRate(int rate);
 
 protected:
     QString name;
@@ -142,6 +164,11 @@ protected:
     unsigned int flightGearVersion;
     QString startupArguments;
     QString script;
+    bool binaryProtocol;
+    int updateRate;
+    qint64 lastState;       ///< Receive time of the last forwarded state, -1 if none
+    QByteArray buffer;      ///< Reused receive buffer
+    bool textDatagramReported; ///< A text datagram was reported since the connect
 
     void setName(QString name);
 
@@ -0,0 +1,112 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of the bounded single-producer/single-consumer queue QGCSpscQueue
+ */
+
+#ifndef QGCSPSCQUEUE_H
+#define QGCSPSCQUEUE_H
+
+#include <QAtomicInt>
+
+/**
+ * @brief Bounded lock-free queue between exactly one producer and one consumer thread
+ *
+ * push() may only be called from the producer and pop() only from the
+ * consumer thread. The capacity is rounded up to the next power of two.
+ * Both indices run freely and wrap around, their difference is the fill level.
+ * Ordering is guaranteed by the release store of the own index and the
+ * acquire load of the index of the other side.
+ */
+template <class T>
+class QGCSpscQueue
+{
+public:
+    explicit QGCSpscQueue(int capacity) :
+        size(roundCapacity(capacity)),
+        mask(size - 1),
+        buffer(new T[size]),
+        head(0),
+        tail(0)
+    {
+    }
+
+    ~QGCSpscQueue()
+    {
+        delete[] buffer;
+    }
+
+    /** @brief Append an item, returns false if the queue is full. Producer only. */
+    bool push(const T& item)
+    {
+        const unsigned int t = static_cast<unsigned int>(int(tail));
+        const unsigned int h = static_cast<unsigned int>(head.fetchAndAddAcquire(0));
+        if (t - h >= size) return false;
+        buffer[t & mask] = item;
+        tail.fetchAndStoreRelease(static_cast<int>(t + 1));
+        return true;
+    }
+
+    /** @brief Remove the oldest item, returns false if the queue is empty. Consumer only. */
+    bool pop(T* item)
+    {
+        const unsigned int h = static_cast<unsigned int>(int(head));
+        const unsigned int t = static_cast<unsigned int>(tail.fetchAndAddAcquire(0));
+        if (h == t) return false;
+        *item = buffer[h & mask];
+        head.fetchAndStoreRelease(static_cast<int>(h + 1));
+        return true;
+    }
+
+    /** @brief Current fill level, only a snapshot if called concurrently */
+    int count() const
+    {
+        return static_cast<int>(static_cast<unsigned int>(int(tail)) - static_cast<unsigned int>(int(head)));
+    }
+
+    int capacity() const {
+        return static_cast<int>(size);
+    }
+
+private:
+    static unsigned int roundCapacity(int capacity)
+    {
+        unsigned int rounded = 1;
+        while (rounded < static_cast<unsigned int>(qMax(capacity, 1))) rounded <<= 1;
+        return rounded;
+    }
+
+    // Not copyable
+    QGCSpscQueue(const QGCSpscQueue&);
+    QGCSpscQueue& operator=(const QGCSpscQueue&);
+
+    const unsigned int size;
+    const unsigned int mask;
+    T* const buffer;
+    QAtomicInt head;    ///< Next item to read, written by the consumer
+    QAtomicInt tail;    ///< Next free slot, written by the producer
+};
+
+#endif // QGCSPSCQUEUE_H
@@ -45,7 +45,7 @@ QGCXPlaneLink::QGCXPlaneLink(UASInterface* mav, QString remoteHost, QHostAddress
     mav(mav),
     remoteHost(QHostAddress("127.0.0.1")),
     remotePort(49000),
-    socket(NULL),
+    worker(NULL),
     process(NULL),
     terraSync(NULL),
     airframeID(QGCXPlaneLink::AIRFRAME_UNKNOWN),
@@ -61,11 +61,17 @@ QGCXPlaneLink::QGCXPlaneLink(UASInterface* mav, QString remoteHost, QHostAddress
     this->name = tr("X-Plane Link (localPort:%1)").arg(localPort);
     setRemoteHost(remoteHost);
     loadSettings();
+
+    // The states are emitted in the link thread
+    qRegisterMetaType<uint64_t>("uint64_t");
+    qRegisterMetaType<int32_t>("int32_t");
+    qRegisterMetaType<int16_t>("int16_t");
 }
 
 QGCXPlaneLink::~QGCXPlaneLink()
 {
     storeSettings();
+    stopWorker();
 //    if(connectState) {
 //       disconnectSimulation();
 //    }
@@ -132,12 +138,25 @@ void QGCXPlaneLink::setVersion(unsigned int version)
 /**
  * @brief Runs the thread
  *
+ * Only runs the event loop of the network worker.
  **/
 void QGCXPlaneLink::run()
 {
     exec();
 }
 
+void QGCXPlaneLink::stopWorker()
+{
+    if (worker)
+    {
+        QMetaObject::invokeMethod(worker, "close", Qt::BlockingQueuedConnection);
+    }
+    quit();
+    wait();
+    delete worker;
+    worker = NULL;
+}
+
 void QGCXPlaneLink::setPort(int localPort)
 {
     this->localPort = localPort;
@@ -230,6 +249,7 @@ void QGCXPlaneLink::updateActuators(uint64_t time, float act1, float act2, float
     if (mav->getSystemType() == MAV_TYPE_QUADROTOR)
     // Only update this for multirotors
     {
+        const qint64 received = latency.controlsReceived();
 
         Q_UNUSED(time);
         Q_UNUSED(act5);
@@ -283,7 +303,7 @@ void QGCXPlaneLink::updateActuators(uint64_t time, float act1, float act2, float
 //            p.f[3] = (act4 - 1000.0f) / 1000.0f;
 //        }
         // Throttle
-        writeBytes((const char*)&p, sizeof(p));
+        queueDatagram((const char*)&p, sizeof(p), received);
     }
 }
 
@@ -298,6 +318,8 @@ void QGCXPlaneLink::updateControls(uint64_t time, float rollAilerons, float pitc
         return;
     }
 
+    const qint64 received = latency.controlsReceived();
+
     #pragma pack(push, 1)
     struct payload {
         char b[5];
@@ -349,61 +371,46 @@ void QGCXPlaneLink::updateControls(uint64_t time, float rollAilerons, float pitc
     p.f[1] = throttle;
     p.f[2] = throttle;
     p.f[3] = throttle;
-    // Throttle
-    writeBytes((const char*)&p, sizeof(p));
+    // Throttle, completes the set of controls
+    queueDatagram((const char*)&p, sizeof(p), received);
 }
 
 void QGCXPlaneLink::writeBytes(const char* data, qint64 size)
+{
+    queueDatagram(data, size, -1);
+}
+
+void QGCXPlaneLink::queueDatagram(const char* data, qint64 size, qint64 controlTime)
 {
     if (!data) return;
-    //#define QGCXPlaneLink_DEBUG
-#if 1
-    QString bytes;
-    QString ascii;
-    for (int i=0; i<size; i++)
-    {
-        unsigned char v = data[i];
-        bytes.append(QString().sprintf("%02x ", v));
-        if (data[i] > 31 && data[i] < 127)
-        {
-            ascii.append(data[i]);
-        }
-        else
-        {
-            ascii.append(219);
-        }
-    }
-    //qDebug() << "Sent" << size << "bytes to" << remoteHost.toString() << ":" << remotePort << "data:";
-    //qDebug() << bytes;
-    //qDebug() << "ASCII:" << ascii;
-#endif
-    if (connectState && socket) socket->writeDatagram(data, size, remoteHost, remotePort);
+    if (connectState && worker) emit datagramQueued(QByteArray(data, size), controlTime);
 }
 
 /**
- * @brief Read a number of bytes from the interface.
+ * @brief Process the pending datagrams.
  *
- * @param data Pointer to the data byte array to write the bytes to
- * @param maxLength The maximum number of bytes to write
+ * The datagrams are read and parsed in the link thread as they arrive,
+ * this only triggers reading in case the notification was missed.
  **/
 void QGCXPlaneLink::readBytes()
+{
+    if (worker) QMetaObject::invokeMethod(worker, "readPendingDatagrams");
+}
+
+/**
+ * @brief Parse one datagram received from X-Plane.
+ *
+ * @param data Pointer to the datagram
+ * @param s The size of the datagram
+ * @param received Receive time of the datagram in microseconds of latency.now()
+ **/
+void QGCXPlaneLink::processDatagram(const char* data, qint64 s, qint64 received)
 {
     // Only emit updates on attitude message
     bool emitUpdate = false;
 
-    const qint64 maxLength = 1000;
-    char data[maxLength];
-    QHostAddress sender;
-    quint16 senderPort;
-
-    unsigned int s = socket->pendingDatagramSize();
-    if (s > maxLength) std::cerr << __FILE__ << __LINE__ << " UDP datagram overflow, allowed to read less bytes than datagram size" << std::endl;
-    socket->readDatagram(data, maxLength, &sender, &senderPort);
-
-    QByteArray b(data, s);
-
-    /*// Print string
-    QString state(b)*/;
+    // XPlane always has 5 bytes header
+    if (s < 5) return;
 
     // Calculate the number of data segments a 36 bytes
     // XPlane always has 5 bytes header: 'DATA@'
@@ -529,7 +536,7 @@ void QGCXPlaneLink::readBytes()
     }
     else
     {
-        qDebug() << "UNKNOWN PACKET:" << data;
+        qDebug() << "UNKNOWN PACKET:" << QByteArray(data, s);
     }
 
     // Send updated state
@@ -545,6 +552,7 @@ void QGCXPlaneLink::readBytes()
         }
         simUpdateLast = QGC::groundTimeMilliseconds();
 
+        latency.stateEmitted(received, latency.now());
         emit hilStateChanged(QGC::groundTimeUsecs(), roll, pitch, yaw, rollspeed,
                          pitchspeed, yawspeed, lat*1E7, lon*1E7, alt*1E3,
                          vx, vy, vz, xacc*1000, yacc*1000, zacc*1000);
@@ -574,7 +582,8 @@ void QGCXPlaneLink::readBytes()
  **/
 qint64 QGCXPlaneLink::bytesAvailable()
 {
-    return socket->pendingDatagramSize();
+    // Datagrams are read as soon as they arrive
+    return 0;
 }
 
 /**
@@ -614,12 +623,7 @@ bool QGCXPlaneLink::disconnectSimulation()
         delete terraSync;
         terraSync = NULL;
     }
-    if (socket)
-    {
-        socket->close();
-        delete socket;
-        socket = NULL;
-    }
+    stopWorker();
 
     emit simulationDisconnected();
     emit simulationConnected(false);
@@ -761,16 +765,25 @@ bool QGCXPlaneLink::connectSimulation()
     // XXX Hack
     storeSettings();
 
-    start(LowPriority);
-
     if (!mav) return false;
     if (connectState) return false;
 
-    socket = new QUdpSocket(this);
-    connectState = socket->bind(localHost, localPort);
-    if (!connectState) return false;
+    // Parse and send in a separate high priority thread,
+    // independent of the load of the GUI thread
+    latency.reset();
+    worker = new QGCHilUdpWorker(this);
+    worker->setLocalAddress(localHost, localPort);
+    worker->setRemoteAddress(remoteHost, remotePort);
+    worker->moveToThread(this);
+    start(HighestPriority);
+    QMetaObject::invokeMethod(worker, "open", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, connectState));
+    if (!connectState)
+    {
+        stopWorker();
+        return false;
+    }
 
-    QObject::connect(socket, SIGNAL(readyRead()), this, SLOT(readBytes()));
+    QObject::connect(this, SIGNAL(datagramQueued(QByteArray,qint64)), worker, SLOT(send(QByteArray,qint64)));
 
     connect(mav, SIGNAL(hilControlsChanged(uint64_t, float, float, float, float, uint8_t, uint8_t)), this, SLOT(updateControls(uint64_t,float,float,float,float,uint8_t,uint8_t)));
     connect(mav, SIGNAL(hilActuatorsChanged(uint64_t, float, float, float, float, float, float, float, float)), this, SLOT(updateActuators(uint64_t,float,float,float,float,float,float,float,float)));
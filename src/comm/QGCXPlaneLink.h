@@ -42,7 +42,16 @@ This file is part of the QGROUNDCONTROL project
 #include <configuration.h>
 #include "UASInterface.h"
 #include "QGCHilLink.h"
+#include "QGCHilUdpWorker.h"
 
+/**
+ * @brief Hardware in the loop link to X-Plane
+ *
+ * The UDP exchange runs in the thread of the link with a high priority, see
+ * QGCHilUdpWorker. States are parsed there and handed to the autopilot,
+ * control datagrams are queued to the thread from the thread of the
+ * autopilot. The stages of the exchange are timestamped in getLatency().
+ */
 class QGCXPlaneLink : public QGCHilLink
 {
     Q_OBJECT
@@ -75,6 +84,9 @@ public:
 
     void run();
 
+    /** @brief Parse a datagram from X-Plane, called in the link thread */
+    void processDatagram(const char* data, qint64 size, qint64 received);
+
     /**
      * @brief Get remote host and port
      * @return string in format <host>:<port>
@@ -152,6 +164,10 @@ public slots:
      */
     void setRandomAttitude();
 
+signals:
+    /** @brief Hand a datagram to the network thread */
+    void datagramQueued(const QByteArray& datagram, qint64 controlTime);
+
 protected:
     UASInterface* mav;
     QString name;
@@ -160,17 +176,9 @@ protected:
     QHostAddress remoteHost;
     quint16 remotePort;
     int id;
-    QUdpSocket* socket;
+    QGCHilUdpWorker* worker;    ///< Owns the socket, lives in the link thread
     bool connectState;
 
-    quint64 bitsSentTotal;
-    quint64 bitsSentCurrent;
-    quint64 bitsSentMax;
-    quint64 bitsReceivedTotal;
-    quint64 bitsReceivedCurrent;
-    quint64 bitsReceivedMax;
-    quint64 connectionStartTime;
-    QMutex statisticsMutex;
     QMutex dataMutex;
     QTimer refreshTimer;
     QProcess* process;
@@ -195,6 +203,13 @@ protected:
     float simUpdateHz;
 
     void setName(QString name);
+    /**
+     * @brief Queue a datagram to the network thread
+     * @param controlTime see QGCHilUdpWorker::send()
+     */
+    void queueDatagram(const char* data, qint64 size, qint64 controlTime);
+    /** @brief Close the socket and stop the link thread */
+    void stopWorker();
 
 };
 
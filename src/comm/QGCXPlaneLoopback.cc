@@ -0,0 +1,200 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class QGCXPlaneLoopback
+ */
+
+#include <string.h>
+
+#include "QGCXPlaneLoopback.h"
+#include "QGCHilLink.h"
+
+#pragma pack(push, 1)
+/** @brief One DATA segment of X-Plane */
+struct XPlaneDataSegment
+{
+    int index;
+    float f[8];
+};
+#pragma pack(pop)
+
+/** Size of the "DATA" header of a datagram */
+static const int xplaneHeaderSize = 5;
+
+QGCXPlaneLoopback::QGCXPlaneLoopback(QObject* parent) :
+    QObject(parent),
+    linkPort(0),
+    autopilot(NULL),
+    pendingState(-1),
+    statesSent(0),
+    controlsReceived(0),
+    roll(0.0f),
+    pitch(0.0f),
+    yaw(0.0f),
+    aileron(0.0f),
+    elevator(0.0f),
+    rudder(0.0f)
+{
+    connect(&timer, SIGNAL(timeout()), this, SLOT(sendState()));
+    connect(&socket, SIGNAL(readyRead()), this, SLOT(readPendingDatagrams()));
+}
+
+bool QGCXPlaneLoopback::bind(const QHostAddress& host, quint16 port)
+{
+    return socket.bind(host, port);
+}
+
+void QGCXPlaneLoopback::setAutopilot(QGCHilLink* link)
+{
+    if (autopilot)
+    {
+        disconnect(autopilot, SIGNAL(hilStateChanged(uint64_t,float,float,float,float,float,float,int32_t,int32_t,int32_t,int16_t,int16_t,int16_t,int16_t,int16_t,int16_t)), this, 0);
+    }
+    autopilot = link;
+    if (autopilot)
+    {
+        connect(autopilot, SIGNAL(hilStateChanged(uint64_t,float,float,float,float,float,float,int32_t,int32_t,int32_t,int16_t,int16_t,int16_t,int16_t,int16_t,int16_t)),
+                this, SLOT(answerState(uint64_t,float,float,float,float,float,float,int32_t,int32_t,int32_t,int16_t,int16_t,int16_t,int16_t,int16_t,int16_t)));
+    }
+}
+
+void QGCXPlaneLoopback::getControls(float* aileron, float* elevator, float* rudder) const
+{
+    *aileron = this->aileron;
+    *elevator = this->elevator;
+    *rudder = this->rudder;
+}
+
+void QGCXPlaneLoopback::start(int rate)
+{
+    latency.reset();
+    pendingState = -1;
+    statesSent = 0;
+    controlsReceived = 0;
+    timer.start(1000 / qMax(rate, 1));
+}
+
+void QGCXPlaneLoopback::stop()
+{
+    timer.stop();
+}
+
+void QGCXPlaneLoopback::setAttitude(float roll, float pitch, float yaw)
+{
+    this->roll = roll;
+    this->pitch = pitch;
+    this->yaw = yaw;
+}
+
+void QGCXPlaneLoopback::sendState()
+{
+    // The link announces itself with its ISET datagram
+    if (linkPort == 0) return;
+
+    XPlaneDataSegment segments[4];
+    memset(segments, 0, sizeof(segments));
+    // Speeds in knots
+    segments[0].index = 3;
+    segments[0].f[6] = 40.0f;
+    segments[0].f[7] = 40.0f;
+    // Angular rates
+    segments[1].index = 16;
+    // Pitch, roll, true heading in degrees
+    segments[2].index = 17;
+    segments[2].f[0] = pitch;
+    segments[2].f[1] = roll;
+    segments[2].f[2] = yaw;
+    // Latitude, longitude and altitude in feet
+    segments[3].index = 20;
+    segments[3].f[0] = 47.3977f;
+    segments[3].f[1] = 8.5456f;
+    segments[3].f[2] = 1640.0f;
+
+    char datagram[xplaneHeaderSize + sizeof(segments)];
+    memcpy(datagram, "DATA@", xplaneHeaderSize);
+    memcpy(datagram + xplaneHeaderSize, segments, sizeof(segments));
+
+    if (pendingState < 0) pendingState = latency.now();
+    if (socket.writeDatagram(datagram, sizeof(datagram), linkHost, linkPort) > 0)
+    {
+        statesSent++;
+    }
+}
+
+void QGCXPlaneLoopback::readPendingDatagrams()
+{
+    while (socket.hasPendingDatagrams())
+    {
+        char datagram[1024];
+        QHostAddress sender;
+        quint16 senderPort;
+        const qint64 size = socket.readDatagram(datagram, sizeof(datagram), &sender, &senderPort);
+        if (size < xplaneHeaderSize) continue;
+        linkHost = sender;
+        linkPort = senderPort;
+
+        if (memcmp(datagram, "DATA", 4) != 0) continue;
+        for (qint64 offset = xplaneHeaderSize; offset + qint64(sizeof(XPlaneDataSegment)) <= size; offset += sizeof(XPlaneDataSegment))
+        {
+            XPlaneDataSegment segment;
+            memcpy(&segment, datagram + offset, sizeof(segment));
+            if (segment.index == 12)
+            {
+                elevator = -segment.f[0];
+                aileron = segment.f[1];
+                rudder = segment.f[2];
+            }
+            else if (segment.index == 25)
+            {
+                // The throttle completes a set of controls
+                controlsReceived++;
+                if (pendingState >= 0)
+                {
+                    latency.add(QGCHilLatency::STAGE_LOOP, latency.now() - pendingState);
+                    pendingState = -1;
+                }
+            }
+        }
+    }
+}
+
+void QGCXPlaneLoopback::answerState(uint64_t time_us, float roll, float pitch, float yaw, float rollspeed,
+                                    float pitchspeed, float yawspeed, int32_t lat, int32_t lon, int32_t alt,
+                                    int16_t vx, int16_t vy, int16_t vz, int16_t xacc, int16_t yacc, int16_t zacc)
+{
+    Q_UNUSED(rollspeed);
+    Q_UNUSED(pitchspeed);
+    Q_UNUSED(yawspeed);
+    Q_UNUSED(lat);
+    Q_UNUSED(lon);
+    Q_UNUSED(alt);
+    Q_UNUSED(vx);
+    Q_UNUSED(vy);
+    Q_UNUSED(vz);
+    Q_UNUSED(xacc);
+    Q_UNUSED(yacc);
+    Q_UNUSED(zacc);
+    if (autopilot) autopilot->updateControls(time_us, roll, pitch, yaw, 0.5f, 0, 0);
+}
@@ -0,0 +1,117 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class QGCXPlaneLoopback
+ */
+
+#ifndef QGCXPLANELOOPBACK_H
+#define QGCXPLANELOOPBACK_H
+
+#include <QObject>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QHostAddress>
+
+#include "inttypes.h"
+#include "QGCHilLatency.h"
+
+class QGCHilLink;
+
+/**
+ * @brief Stub simulator speaking the X-Plane 10 UDP protocol
+ *
+ * Tests the HIL exchange of QGCXPlaneLink without X-Plane. The stub sends
+ * DATA datagrams with attitude, angular rates, position and speeds at a
+ * fixed rate to the address the link sent its ISET datagram from, and
+ * receives the control datagrams of the link. The round trip from a state
+ * datagram to the next complete set of controls is kept in the loop stage
+ * of getLatency().
+ *
+ * Without an autopilot in the loop setAutopilot() lets the stub answer
+ * every state of the link with controls itself: the attitude in radians is
+ * passed back as aileron, elevator and rudder.
+ */
+class QGCXPlaneLoopback : public QObject
+{
+    Q_OBJECT
+public:
+    QGCXPlaneLoopback(QObject* parent = 0);
+
+    /**
+     * @brief Bind the simulator socket
+     * @param port 0 picks a free port, X-Plane listens on 49000
+     */
+    bool bind(const QHostAddress& host = QHostAddress::LocalHost, quint16 port = 49000);
+    /** @brief The port the simulator listens on */
+    quint16 getPort() const {
+        return socket.localPort();
+    }
+    /** @brief Answer the states of a link in place of an autopilot */
+    void setAutopilot(QGCHilLink* link);
+
+    /** @brief Number of state datagrams sent */
+    quint64 getStatesSent() const {
+        return statesSent;
+    }
+    /** @brief Number of complete control sets received */
+    quint64 getControlsReceived() const {
+        return controlsReceived;
+    }
+    /** @brief Last received aileron, elevator and rudder */
+    void getControls(float* aileron, float* elevator, float* rudder) const;
+    /** @brief Round trip statistics, see QGCHilLatency::STAGE_LOOP */
+    QGCHilLatency* getLatency() {
+        return &latency;
+    }
+
+public slots:
+    /** @brief Start sending states at a rate in Hertz */
+    void start(int rate);
+    void stop();
+    /** @brief Set the attitude sent to the link, in degrees */
+    void setAttitude(float roll, float pitch, float yaw);
+
+protected slots:
+    void sendState();
+    void readPendingDatagrams();
+    void answerState(uint64_t time_us, float roll, float pitch, float yaw, float rollspeed,
+                     float pitchspeed, float yawspeed, int32_t lat, int32_t lon, int32_t alt,
+                     int16_t vx, int16_t vy, int16_t vz, int16_t xacc, int16_t yacc, int16_t zacc);
+
+protected:
+    QUdpSocket socket;
+    QTimer timer;
+    QHostAddress linkHost;
+    quint16 linkPort;       ///< Port of the link, 0 until its first datagram arrived
+    QGCHilLink* autopilot;
+    QGCHilLatency latency;
+    qint64 pendingState;    ///< Send time of the oldest unanswered state, -1 if none
+    quint64 statesSent;
+    quint64 controlsReceived;
+    float roll, pitch, yaw;
+    float aileron, elevator, rudder;
+};
+
+#endif // QGCXPLANELOOPBACK_H
@@ -9,6 +9,7 @@
  */
 
 #include <QTimer>
+#include <QTime>
 #include <QDebug>
 #include <QSettings>
 #include <QMutexLocker>
@@ -212,8 +213,13 @@ using namespace TNX;
 SerialLink::SerialLink(QString portname, int baudRate, bool hardwareFlowControl, bool parity,
                        int dataBits, int stopBits) :
     port(NULL),
+    readCount(0),
+    readBytesTotal(0),
+    chunkCount(0),
+    chunkAllocations(0),
     ports(new QVector<QString>()),
-    m_stopp(false)
+    m_stopp(false),
+    m_readMode(READ_EVENT)
 {
     // Setup settings
     this->porthandle = portname.trimmed();
@@ -369,6 +375,7 @@ void SerialLink::loadSettings()
         setStopBits(settings.value("SERIALLINK_COMM_STOPBITS").toInt());
         setDataBits(settings.value("SERIALLINK_COMM_DATABITS").toInt());
         setFlowType(settings.value("SERIALLINK_COMM_FLOW_CONTROL").toInt());
+        setReadMode(settings.value("SERIALLINK_COMM_READ_MODE", m_readMode).toInt());
     }
 }
 
@@ -382,6 +389,7 @@ void SerialLink::writeSettings()
     settings.setValue("SERIALLINK_COMM_STOPBITS", getStopBits());
     settings.setValue("SERIALLINK_COMM_DATABITS", getDataBits());
     settings.setValue("SERIALLINK_COMM_FLOW_CONTROL", getFlowType());
+    settings.setValue("SERIALLINK_COMM_READ_MODE", getReadMode());
     settings.sync();
 }
 
@@ -389,6 +397,11 @@ void SerialLink::writeSettings()
 /**
  * @brief Runs the thread
  *
+ * In event mode the thread blocks in select() (POSIX) or on the comm
+ * events (Windows) of the port until bytes arrive, so they are read
+ * without the delay of the polling interval and an idle port does not
+ * wake the thread. The wait times out after wait_timeout ms to check
+ * for a disconnect request. Polling mode is kept as a fallback.
  **/
 void SerialLink::run()
 {
@@ -398,6 +411,7 @@ void SerialLink::run()
     // Qt way to make clear what a while(1) loop does
     forever
     {
+        int readMode;
         {
             QMutexLocker locker(&this->m_stoppMutex);
             if(this->m_stopp)
@@ -405,13 +419,29 @@ void SerialLink::run()
                 this->m_stopp = false;
                 break;
             }
+            readMode = m_readMode;
+        }
+
+        if (readMode == READ_EVENT && port && port->isOpen())
+        {
+            QTime waitTime;
+            waitTime.start();
+            if (!port->waitForReadyRead(SerialLink::wait_timeout) && waitTime.elapsed() < SerialLink::wait_timeout / 2)
+            {
+                // The wait failed instead of timing out, do not spin on a broken port
+                MG::SLEEP::msleep(SerialLink::poll_interval);
+            }
+            checkForBytes();
+        }
+        else
+        {
+            // Check if new bytes have arrived, if yes, emit the notification signal
+            checkForBytes();
+            /* Serial data isn't arriving that fast normally, this saves the thread
+                     * from consuming too much processing time
+                     */
+            MG::SLEEP::msleep(SerialLink::poll_interval);
         }
-        // Check if new bytes have arrived, if yes, emit the notification signal
-        checkForBytes();
-        /* Serial data isn't arriving that fast normally, this saves the thread
-                 * from consuming too much processing time
-                 */
-        MG::SLEEP::msleep(SerialLink::poll_interval);
     }
     if (port) {
         port->flushInBuffer();
@@ -462,7 +492,7 @@ void SerialLink::writeBytes(const char* data, qint64 size)
             //            qDebug() << "Serial link " << this->getName() << "transmitted" << b << "bytes:";
 
             // Increase write counter
-            bitsSentTotal += size * 8;
+            linkStatistics.countSent(b);
 
             //            int i;
             //            for (i=0; i<size; i++)
@@ -480,42 +510,118 @@ void SerialLink::writeBytes(const char* data, qint64 size)
 }
 
 /**
- * @brief Read a number of bytes from the interface.
+ * @brief Read all available bytes from the interface.
  *
- * @param data Pointer to the data byte array to write the bytes to
- * @param maxLength The maximum number of bytes to write
+ * The OS buffer is drained completely, every read is sized to the bytes
+ * available and goes directly into the chunk handed to the receivers. All
+ * bytes of one call are handed out in one chunk of at most
+ * SERIAL_READ_BUFFER_SIZE bytes. The chunks are reused once the receivers
+ * released them, see takeReadChunk().
  **/
 void SerialLink::readBytes()
 {
     dataMutex.lock();
     if(port && port->isOpen()) {
-        const qint64 maxLength = 2048;
-        char data[maxLength];
         qint64 numBytes = port->bytesAvailable();
-        //qDebug() << "numBytes: " << numBytes;
-
-        if(numBytes > 0) {
-            /* Read as much data in buffer as possible without overflow */
-            if(maxLength < numBytes) numBytes = maxLength;
+        QByteArray chunk;
+        int filled = 0;
 
-            port->read(data, numBytes);
-            QByteArray b(data, numBytes);
-            emit bytesReceived(this, b);
-
-            //qDebug() << "SerialLink::readBytes()" << std::hex << data;
-            //            int i;
-            //            for (i=0; i<numBytes; i++){
-            //                unsigned int v=data[i];
-            //
-            //                fprintf(stderr,"%02x ", v);
-            //            }
-            //            fprintf(stderr,"\n");
-            bitsReceivedTotal += numBytes * 8;
+        while (numBytes > 0) {
+            if (chunk.isEmpty()) {
+                chunk = takeReadChunk();
+            }
+            /* Read as much data as is available directly into the chunk */
+            const int length = int(qMin(numBytes, qint64(SERIAL_READ_BUFFER_SIZE - filled)));
+            chunk.resize(filled + length);
+            qint64 bytesRead = port->read(chunk.data() + filled, length);
+            if (bytesRead <= 0) {
+                break;
+            }
+            filled += int(bytesRead);
+            readCount++;
+            readBytesTotal += bytesRead;
+            if (filled >= SERIAL_READ_BUFFER_SIZE) {
+                emitReadChunk(chunk, filled);
+                filled = 0;
+            }
+            numBytes = port->bytesAvailable();
         }
+        emitReadChunk(chunk, filled);
     }
     dataMutex.unlock();
 }
 
+/**
+ * Every emitted chunk stays in readChunks. As soon as the receivers
+ * dropped their copies the chunk is no longer shared and its memory is
+ * written again without an allocation. dataMutex is locked.
+ */
+QByteArray SerialLink::takeReadChunk()
+{
+    for (int i = 0; i < readChunks.size(); i++) {
+        if (readChunks.at(i).isDetached()) {
+            return readChunks.takeAt(i);
+        }
+    }
+    chunkAllocations++;
+    return QByteArray();
+}
+
+/**
+ * Emits the first length bytes of the chunk and keeps it for reuse,
+ * dataMutex is locked.
+ */
+void SerialLink::emitReadChunk(QByteArray& chunk, int length)
+{
+    if (length > 0) {
+        chunk.resize(length);
+        emit bytesReceived(this, chunk);
+        chunkCount++;
+        linkStatistics.countReceived(length);
+    }
+    if (!chunk.isEmpty() && readChunks.size() < SERIAL_READ_CHUNKS) {
+        readChunks.append(chunk);
+    }
+    chunk = QByteArray();
+}
+
+quint64 SerialLink::getReadCount()
+{
+    QMutexLocker locker(&dataMutex);
+    return readCount;
+}
+
+quint64 SerialLink::getReadBytes()
+{
+    QMutexLocker locker(&dataMutex);
+    return readBytesTotal;
+}
+
+quint64 SerialLink::getChunkCount()
+{
+    QMutexLocker locker(&dataMutex);
+    return chunkCount;
+}
+
+quint64 SerialLink::getChunkAllocations()
+{
+    QMutexLocker locker(&dataMutex);
+    return chunkAllocations;
+}
+
+double SerialLink::getBytesPerRead()
+{
+    QMutexLocker locker(&dataMutex);
+    return (readCount > 0) ? double(readBytesTotal) / readCount : 0.0;
+}
+
+double SerialLink::getReadsPerSecond()
+{
+    QMutexLocker locker(&dataMutex);
+    const quint64 elapsed = MG::TIME::getGroundTimeNow() - connectionStartTime;
+    return (elapsed > 0) ? readCount * 1000.0 / elapsed : 0.0;
+}
+
 
 /**
  * @brief Get the number of bytes to read.
@@ -764,50 +870,6 @@ qint64 SerialLink::getNominalDataRate()
     return dataRate;
 }
 
-qint64 SerialLink::getTotalUpstream()
-{
-    statisticsMutex.lock();
-    return bitsSentTotal / ((MG::TIME::getGroundTimeNow() - connectionStartTime) / 1000);
-    statisticsMutex.unlock();
-}
-
-qint64 SerialLink::getCurrentUpstream()
-{
-    return 0; // TODO
-}
-
-qint64 SerialLink::getMaxUpstream()
-{
-    return 0; // TODO
-}
-
-qint64 SerialLink::getBitsSent()
-{
-    return bitsSentTotal;
-}
-
-qint64 SerialLink::getBitsReceived()
-{
-    return bitsReceivedTotal;
-}
-
-qint64 SerialLink::getTotalDownstream()
-{
-    statisticsMutex.lock();
-    return bitsReceivedTotal / ((MG::TIME::getGroundTimeNow() - connectionStartTime) / 1000);
-    statisticsMutex.unlock();
-}
-
-qint64 SerialLink::getCurrentDownstream()
-{
-    return 0; // TODO
-}
-
-qint64 SerialLink::getMaxDownstream()
-{
-    return 0; // TODO
-}
-
 bool SerialLink::isFullDuplex()
 {
     /* Serial connections are always half duplex */
@@ -845,6 +907,12 @@ int SerialLink::getParityType()
     return portSettings.parity();
 }
 
+int SerialLink::getReadMode()
+{
+    QMutexLocker locker(&this->m_stoppMutex);
+    return m_readMode;
+}
+
 int SerialLink::getDataBitsType()
 {
     return portSettings.dataBits();
@@ -1216,3 +1284,11 @@ bool SerialLink::setStopBitsType(int stopBits)
     if(reconnect) connect();
     return accepted;
 }
+
+bool SerialLink::setReadMode(int mode)
+{
+    if (mode != READ_POLLING && mode != READ_EVENT) return false;
+    QMutexLocker locker(&this->m_stoppMutex);
+    m_readMode = mode;
+    return true;
+}
@@ -67,6 +67,14 @@ public:
     ~SerialLink();
 
     static const int poll_interval = SERIAL_POLL_INTERVAL; ///< Polling interval, defined in configuration.h
+    static const int wait_timeout = SERIAL_WAIT_TIMEOUT; ///< Maximum wait for data in event mode, defined in configuration.h
+
+    /** @brief How the receive thread waits for new bytes */
+    enum ReadMode
+    {
+        READ_POLLING = 0,   ///< Check the port every poll_interval ms
+        READ_EVENT          ///< Block until the port is readable
+    };
 
     /** @brief Get a list of the currently available ports */
     QVector<QString>* getCurrentPorts();
@@ -92,17 +100,25 @@ public:
     int getParityType();
     int getDataBitsType();
     int getStopBitsType();
+    /** @brief Get the read mode, see ReadMode */
+    int getReadMode();
 
     /* Extensive statistics for scientific purposes */
     qint64 getNominalDataRate();
-    qint64 getTotalUpstream();
-    qint64 getCurrentUpstream();
-    qint64 getMaxUpstream();
-    qint64 getTotalDownstream();
-    qint64 getCurrentDownstream();
-    qint64 getMaxDownstream();
-    qint64 getBitsSent();
-    qint64 getBitsReceived();
+
+    /* Receive buffer statistics */
+    /** @brief Number of reads from the port since the link was created */
+    quint64 getReadCount();
+    /** @brief Number of bytes read from the port since the link was created */
+    quint64 getReadBytes();
+    /** @brief Number of bytesReceived() signals since the link was created */
+    quint64 getChunkCount();
+    /** @brief Number of chunks allocated because no chunk was released by the receivers */
+    quint64 getChunkAllocations();
+    /** @brief Average number of bytes per read from the port */
+    double getBytesPerRead();
+    /** @brief Average number of reads per second since the connection was opened */
+    double getReadsPerSecond();
 
     void loadSettings();
     void writeSettings();
@@ -128,6 +144,8 @@ public slots:
     bool setParityType(int parity);
     bool setDataBitsType(int dataBits);
     bool setStopBitsType(int stopBits);
+    /** @brief Set the read mode, see ReadMode. Takes effect immediately, also while connected. */
+    bool setReadMode(int mode);
 
     void readBytes();
     /**
@@ -155,21 +173,23 @@ protected:
     int timeout;
     int id;
 
-    quint64 bitsSentTotal;
-    quint64 bitsSentShortTerm;
-    quint64 bitsSentCurrent;
-    quint64 bitsSentMax;
-    quint64 bitsReceivedTotal;
-    quint64 bitsReceivedShortTerm;
-    quint64 bitsReceivedCurrent;
-    quint64 bitsReceivedMax;
     quint64 connectionStartTime;
-    QMutex statisticsMutex;
     QMutex dataMutex;
+    quint64 readCount;              ///< Protected by dataMutex
+    quint64 readBytesTotal;         ///< Protected by dataMutex
+    quint64 chunkCount;             ///< Protected by dataMutex
+    quint64 chunkAllocations;       ///< Protected by dataMutex
+    QList<QByteArray> readChunks;   ///< Chunks handed out before, protected by dataMutex
     QVector<QString>* ports;
 
+    /** @brief Take a chunk the receivers released, an empty one if there is none */
+    QByteArray takeReadChunk();
+    /** @brief Hand out the first bytes of a chunk through bytesReceived() */
+    void emitReadChunk(QByteArray& chunk, int length);
+
 private:
 	volatile bool m_stopp;
+	int m_readMode;         ///< ReadMode of the receive thread, protected by m_stoppMutex
 	QMutex m_stoppMutex;
 
     void setName(QString name);
@@ -0,0 +1,214 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Implementation of class SerialPortDiscovery
+ */
+
+#include <QElapsedTimer>
+
+#include "SerialPortDiscovery.h"
+#include "MAVLinkFrameScanner.h"
+#include "qserialport.h"
+
+using namespace TNX;
+
+SerialPortProbe::SerialPortProbe(const QString& portName, const QList<int>& baudRates, int timeout, QObject* parent) :
+    QThread(parent),
+    portName(portName),
+    baudRates(baudRates),
+    timeout(timeout),
+    stopRequested(0)
+{
+}
+
+void SerialPortProbe::stop()
+{
+    stopRequested.fetchAndStoreRelaxed(1);
+}
+
+/**
+ * The port object is created here, so it belongs to the probe thread.
+ */
+void SerialPortProbe::run()
+{
+    QString device = portName;
+#ifdef _WIN32
+    // Same special case as in SerialLink::setPortName()
+    if (!device.startsWith("\\")) device = "\\\\.\\" + device;
+#endif
+
+    QPortSettings settings;
+    settings.setDataBits(QPortSettings::DB_8);
+    settings.setParity(QPortSettings::PAR_NONE);
+    settings.setStopBits(QPortSettings::STOP_1);
+    settings.setFlowControl(QPortSettings::FLOW_OFF);
+
+    QSerialPort* port = NULL;
+    MAVLinkFrameScanner scanner;
+    mavlink_message_t message;
+    char buffer[MAVLINK_MAX_PACKET_LEN * 4];
+
+    for (int i = 0; i < baudRates.size() && !int(stopRequested); i++)
+    {
+        bool ok;
+        settings.setBaudRate(QPortSettings::baudRateFromInt(baudRates.at(i), ok));
+        if (!ok) continue;
+
+        if (!port)
+        {
+            port = new QSerialPort(device, settings);
+            port->setCommTimeouts(QSerialPort::CtScheme_NonBlockingRead);
+            // In use or not a serial port
+            if (!port->open()) break;
+        }
+        else if (!port->setPortSettings(settings))
+        {
+            continue;
+        }
+        // Bytes received at the last baud rate are garbage
+        port->flushInBuffer();
+        scanner.reset();
+
+        QElapsedTimer elapsed;
+        elapsed.start();
+        while (elapsed.elapsed() < timeout && !int(stopRequested))
+        {
+            port->waitForReadyRead(qMin(timeout - int(elapsed.elapsed()), SERIAL_WAIT_TIMEOUT));
+            const qint64 available = qMin(port->bytesAvailable(), qint64(sizeof(buffer)));
+            if (available <= 0) continue;
+            const qint64 length = port->read(buffer, available);
+            if (length <= 0) continue;
+
+            scanner.setInput(buffer, int(length));
+            if (scanner.nextMessage(&message))
+            {
+                result.portName = portName;
+                result.baudRate = baudRates.at(i);
+                result.systemId = message.sysid;
+                break;
+            }
+        }
+        if (isFound()) break;
+    }
+
+    if (port)
+    {
+        port->close();
+        delete port;
+    }
+}
+
+SerialPortDiscovery::SerialPortDiscovery(QObject* parent) : QObject(parent),
+    baudRates(defaultBaudRates()),
+    timeout(SERIAL_DISCOVERY_TIMEOUT)
+{
+}
+
+SerialPortDiscovery::~SerialPortDiscovery()
+{
+    stop();
+}
+
+QList<int> SerialPortDiscovery::defaultBaudRates()
+{
+    QList<int> rates;
+    rates << 57600 << 115200 << 921600 << 230400 << 460800 << 38400 << 19200 << 9600;
+    return rates;
+}
+
+QString SerialPortDiscovery::normalizePortName(const QString& port)
+{
+    QString name = port;
+#ifdef Q_OS_WIN
+    name = name.split("-").first();
+#endif
+    return name.remove(" ");
+}
+
+void SerialPortDiscovery::setBaudRates(const QList<int>& rates)
+{
+    baudRates = rates;
+}
+
+void SerialPortDiscovery::setTimeout(int ms)
+{
+    timeout = qMax(ms, 1);
+}
+
+void SerialPortDiscovery::start(const QStringList& ports)
+{
+    stop();
+    results.clear();
+
+    foreach (const QString& port, ports)
+    {
+        const QString name = normalizePortName(port);
+        if (name.isEmpty()) continue;
+        SerialPortProbe* probe = new SerialPortProbe(name, baudRates, timeout, this);
+        connect(probe, SIGNAL(finished()), this, SLOT(probeFinished()));
+        probes.append(probe);
+    }
+    if (probes.isEmpty())
+    {
+        emit finished();
+        return;
+    }
+    foreach (SerialPortProbe* probe, probes)
+    {
+        probe->start();
+    }
+}
+
+void SerialPortDiscovery::stop()
+{
+    foreach (SerialPortProbe* probe, probes)
+    {
+        probe->stop();
+    }
+    foreach (SerialPortProbe* probe, probes)
+    {
+        disconnect(probe, SIGNAL(finished()), this, SLOT(probeFinished()));
+        probe->wait();
+        probe->deleteLater();
+    }
+    probes.clear();
+}
+
+void SerialPortDiscovery::probeFinished()
+{
+    SerialPortProbe* probe = static_cast<SerialPortProbe*>(sender());
+    // Probes of a stopped discovery are no longer in the list
+    if (probes.removeAll(probe) == 0) return;
+
+    if (probe->isFound())
+    {
+        const SerialPortDiscoveryResult result = probe->getResult();
+        results.append(result);
+        emit portFound(result.portName, result.baudRate, result.systemId);
+    }
+    probe->deleteLater();
+
+    if (probes.isEmpty()) emit finished();
+}
@@ -0,0 +1,157 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+/**
+ * @file
+ *   @brief Definition of class SerialPortDiscovery
+ */
+
+#ifndef SERIALPORTDISCOVERY_H
+#define SERIALPORTDISCOVERY_H
+
+#include <QObject>
+#include <QThread>
+#include <QList>
+#include <QStringList>
+#include <QAtomicInt>
+#include <configuration.h>
+
+/** @brief Port, baud rate and sender of the first valid MAVLink frame found on a port */
+struct SerialPortDiscoveryResult
+{
+    SerialPortDiscoveryResult() : baudRate(0), systemId(-1) {}
+    QString portName;       ///< Port name as accepted by SerialLink::setPortName()
+    int baudRate;
+    int systemId;           ///< System id of the frame, the vehicle behind the port
+};
+
+/**
+ * @brief Probes one serial port at a list of baud rates
+ *
+ * The port is opened once with 8N1 and no flow control, the baud rate is
+ * switched while it stays open. At every baud rate the received bytes are
+ * scanned for SERIAL_DISCOVERY_TIMEOUT ms, the first frame with a valid
+ * length and CRC confirms the baud rate. At a wrong baud rate the bytes are
+ * garbage and do not pass the CRC check.
+ */
+class SerialPortProbe : public QThread
+{
+    Q_OBJECT
+public:
+    SerialPortProbe(const QString& portName, const QList<int>& baudRates, int timeout, QObject* parent = 0);
+
+    void run();
+    /** @brief Stop probing as soon as possible, can be called from any thread */
+    void stop();
+
+    QString getPortName() const {
+        return portName;
+    }
+    /** @brief Check if a valid frame was found, only valid after the thread finished */
+    bool isFound() const {
+        return result.baudRate > 0;
+    }
+    /** @brief Get the confirmed port settings, only valid after the thread finished */
+    SerialPortDiscoveryResult getResult() const {
+        return result;
+    }
+
+protected:
+    QString portName;
+    QList<int> baudRates;
+    int timeout;
+    QAtomicInt stopRequested;
+    SerialPortDiscoveryResult result;
+};
+
+/**
+ * @brief Finds the serial ports MAVLink vehicles are connected to
+ *
+ * Every candidate port is probed in its own SerialPortProbe thread, so
+ * discovering many ports takes as long as probing the slowest one instead
+ * of the sum of all. Ports which are already open, e.g. by a connected
+ * SerialLink, fail to open and are skipped.
+ *
+ * Typical use:
+ * @code
+ * discovery.start(QStringList::fromVector(*link->getCurrentPorts()));
+ * // portFound() offers the settings for SerialLink::setPortName() and SerialLink::setBaudRate()
+ * @endcode
+ */
+class SerialPortDiscovery : public QObject
+{
+    Q_OBJECT
+public:
+    SerialPortDiscovery(QObject* parent = 0);
+    ~SerialPortDiscovery();
+
+    /** @brief Common MAVLink baud rates, the most likely ones first */
+    static QList<int> defaultBaudRates();
+    /**
+     * @brief Get the name of a port in the form SerialLink expects
+     *
+     * Strips the description the port enumeration appends on Windows.
+     */
+    static QString normalizePortName(const QString& port);
+
+    QList<int> getBaudRates() const {
+        return baudRates;
+    }
+    /** @brief Time in ms the probes listen at one baud rate */
+    int getTimeout() const {
+        return timeout;
+    }
+    bool isRunning() const {
+        return !probes.isEmpty();
+    }
+    /** @brief Ports found during the last discovery, in the order they were found */
+    QList<SerialPortDiscoveryResult> getResults() const {
+        return results;
+    }
+
+public slots:
+    /** @brief Set the baud rates to try, in this order. Takes effect on the next start(). */
+    void setBaudRates(const QList<int>& rates);
+    void setTimeout(int ms);
+    /** @brief Probe all ports in parallel, a running discovery is stopped first */
+    void start(const QStringList& ports);
+    /** @brief Stop all probes and wait for them */
+    void stop();
+
+signals:
+    /** @brief A valid MAVLink frame was received on a port */
+    void portFound(const QString& portName, int baudRate, int systemId);
+    /** @brief All probes finished */
+    void finished();
+
+protected slots:
+    void probeFinished();
+
+protected:
+    QList<int> baudRates;
+    int timeout;
+    QList<SerialPortProbe*> probes;     ///< Running probes
+    QList<SerialPortDiscoveryResult> results;
+};
+
+#endif // SERIALPORTDISCOVERY_H
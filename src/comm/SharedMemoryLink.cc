@@ -0,0 +1,260 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+
+/**
+ * @file
+ *   @brief Implementation of class SharedMemoryLink
+ */
+
+#include <QMutexLocker>
+#include <QDebug>
+
+#include "SharedMemoryLink.h"
+#if defined(Q_OS_UNIX)
+#include "qgc_shm_ring.h"
+#endif
+
+SharedMemoryLink::SharedMemoryLink(const QString& segmentName) :
+    segmentName(segmentName),
+    id(getNextLinkId()),
+    segment(NULL),
+    createdSegment(false),
+    stopRequested(false),
+    droppedWrites(0)
+{
+    name = tr("Shared Memory Link (%1)").arg(segmentName);
+}
+
+SharedMemoryLink::~SharedMemoryLink()
+{
+    disconnect();
+}
+
+bool SharedMemoryLink::isAvailable()
+{
+#if defined(Q_OS_UNIX)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * The thread sleeps until the other side writes into its ring or
+ * SHARED_MEMORY_WAIT_TIMEOUT expires, which bounds the disconnect delay.
+ */
+void SharedMemoryLink::run()
+{
+#if defined(Q_OS_UNIX)
+    forever
+    {
+        {
+            QMutexLocker locker(&runMutex);
+            if (stopRequested) break;
+        }
+        if (qgc_shm_wait(&segment->to_gcs, SHARED_MEMORY_WAIT_TIMEOUT) > 0)
+        {
+            readBytes();
+        }
+    }
+#endif
+}
+
+/**
+ * Copies everything the other side has written into one block. The copy
+ * cannot be avoided, the protocols parse the block in another thread after
+ * the ring space has been handed back. The block is only as large as the
+ * data, it may wait in the queue of the parser for a while.
+ */
+void SharedMemoryLink::readBytes()
+{
+#if defined(Q_OS_UNIX)
+    qgc_shm_ring_t* ring = &segment->to_gcs;
+    const int available = qgc_shm_count(ring);
+    if (available == 0) return;
+
+    QByteArray chunk;
+    chunk.resize(available);
+    char* target = chunk.data();
+    int copied = 0;
+    while (copied < available)
+    {
+        uint32_t contiguous;
+        const uint8_t* source = qgc_shm_read_pointer(ring, &contiguous);
+        contiguous = qMin(contiguous, uint32_t(available - copied));
+        memcpy(target + copied, source, contiguous);
+        qgc_shm_consume(ring, contiguous);
+        copied += contiguous;
+    }
+
+    linkStatistics.countReceived(available);
+    emit bytesReceived(this, chunk);
+#endif
+}
+
+void SharedMemoryLink::writeBytes(const char* data, qint64 length)
+{
+#if defined(Q_OS_UNIX)
+    QMutexLocker locker(&writeMutex);
+    if (!segment) return;
+    const bool written = (length > 0 && length <= QGC_SHM_RING_SIZE &&
+                          qgc_shm_write(&segment->from_gcs, data, length) > 0);
+    locker.unlock();
+
+    if (written)
+    {
+        linkStatistics.countSent(length);
+    }
+    else
+    {
+        // The other side does not read, drop the frame like a datagram
+        droppedWrites.fetchAndAddRelaxed(1);
+    }
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(length);
+#endif
+}
+
+bool SharedMemoryLink::connect()
+{
+    if (isConnected()) disconnect();
+
+#if defined(Q_OS_UNIX)
+    // Attach to the segment of a running simulator, create it otherwise
+    const QByteArray segmentKey = segmentName.toLocal8Bit();
+    qgc_shm_segment_t* mapped = qgc_shm_open(segmentKey.constData(), 0);
+    const bool created = (mapped == NULL);
+    if (created) mapped = qgc_shm_open(segmentKey.constData(), 1);
+    if (!mapped)
+    {
+        emit communicationError(getName(), tr("Could not open shared memory segment %1").arg(segmentName));
+        return false;
+    }
+    // Data left from an earlier session is outdated
+    qgc_shm_discard(&mapped->to_gcs);
+    {
+        QMutexLocker locker(&writeMutex);
+        segment = mapped;
+        createdSegment = created;
+    }
+    {
+        QMutexLocker locker(&runMutex);
+        stopRequested = false;
+    }
+    start(HighPriority);
+
+    emit connected(true);
+    emit connected();
+    return true;
+#else
+    emit communicationError(getName(), tr("Shared memory links are not supported on this platform"));
+    return false;
+#endif
+}
+
+bool SharedMemoryLink::disconnect()
+{
+    {
+        QMutexLocker locker(&runMutex);
+        stopRequested = true;
+    }
+    wait();
+
+#if defined(Q_OS_UNIX)
+    QMutexLocker locker(&writeMutex);
+    if (!segment) return true;
+    qgc_shm_close(segment);
+    segment = NULL;
+    // The segment of a simulator stays, the simulator removes it
+    if (createdSegment) shm_unlink(segmentName.toLocal8Bit().constData());
+    createdSegment = false;
+    locker.unlock();
+#endif
+
+    emit disconnected();
+    emit connected(false);
+    return true;
+}
+
+void SharedMemoryLink::setSegmentName(const QString& name)
+{
+    const bool reconnect = isConnected();
+    if (reconnect) disconnect();
+    segmentName = name;
+    this->name = tr("Shared Memory Link (%1)").arg(segmentName);
+    emit nameChanged(this->name);
+    if (reconnect) connect();
+}
+
+bool SharedMemoryLink::isConnected()
+{
+    QMutexLocker locker(&writeMutex);
+    return (segment != NULL);
+}
+
+qint64 SharedMemoryLink::bytesAvailable()
+{
+#if defined(Q_OS_UNIX)
+    QMutexLocker locker(&writeMutex);
+    if (segment) return qgc_shm_count(&segment->to_gcs);
+#endif
+    return 0;
+}
+
+int SharedMemoryLink::getId()
+{
+    return id;
+}
+
+QString SharedMemoryLink::getName()
+{
+    return name;
+}
+
+QString SharedMemoryLink::getSegmentName()
+{
+    return segmentName;
+}
+
+quint64 SharedMemoryLink::getDroppedWrites()
+{
+    return quint32(int(droppedWrites));
+}
+
+qint64 SharedMemoryLink::getNominalDataRate()
+{
+    return 1000000000; // Memory bandwidth, practically unlimited
+}
+
+bool SharedMemoryLink::isFullDuplex()
+{
+    return true;
+}
+
+int SharedMemoryLink::getLinkQuality()
+{
+    /* This feature is not supported with this interface */
+    return -1;
+}
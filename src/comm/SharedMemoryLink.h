@@ -0,0 +1,98 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+
+/**
+ * @file
+ *   @brief Shared memory link to simulators and companion processes on the same host
+ */
+
+#ifndef SHAREDMEMORYLINK_H
+#define SHAREDMEMORYLINK_H
+
+#include <QString>
+#include <QMutex>
+#include <QByteArray>
+#include <LinkInterface.h>
+#include <configuration.h>
+
+struct qgc_shm_segment;
+
+/**
+ * @brief Link over a POSIX shared memory segment
+ *
+ * The segment holds one lock-free ring per direction, its layout is defined
+ * in the C header qgc_shm_ring.h which external processes include to attach.
+ * Frames are written directly into the ring of the other side, there is no
+ * system call per frame. The receive thread sleeps on a futex until the
+ * other side writes.
+ */
+class SharedMemoryLink : public LinkInterface
+{
+    Q_OBJECT
+
+public:
+    SharedMemoryLink(const QString& segmentName = SHARED_MEMORY_LINK_NAME);
+    ~SharedMemoryLink();
+
+    /** @brief Check if shared memory links are supported on this platform */
+    static bool isAvailable();
+
+    bool isConnected();
+    qint64 bytesAvailable();
+    int getId();
+    QString getName();
+    /** @brief Name of the POSIX shared memory segment */
+    QString getSegmentName();
+    /** @brief Number of writes dropped because the ring of the other side was full */
+    quint64 getDroppedWrites();
+
+    qint64 getNominalDataRate();
+    bool isFullDuplex();
+    int getLinkQuality();
+
+    void run();
+
+public slots:
+    /** @brief Set the name of the segment, reconnects if the link is connected */
+    void setSegmentName(const QString& name);
+    void writeBytes(const char* data, qint64 length);
+    bool connect();
+    bool disconnect();
+
+protected slots:
+    void readBytes();
+
+protected:
+    QString name;
+    QString segmentName;
+    int id;
+    qgc_shm_segment* segment;   ///< Mapped segment, NULL while disconnected
+    bool createdSegment;        ///< The segment was created by this link and is removed on disconnect
+    bool stopRequested;         ///< Ends the receive thread, protected by runMutex
+    QMutex runMutex;
+    QMutex writeMutex;          ///< Keeps a single producer on the outgoing ring
+    QAtomicInt droppedWrites;
+};
+
+#endif // SHAREDMEMORYLINK_H
@@ -0,0 +1,207 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+
+/**
+ * @file
+ *   @brief Implementation of class UDPEndpointTable
+ */
+
+#include <string.h>
+#include <QAbstractSocket>
+
+#include "UDPEndpointTable.h"
+#include "MAVLinkFrameScanner.h"
+
+/**
+ * @brief Offset of the target_system field in the payload of each message
+ *
+ * Built once from the field descriptions of the message definitions.
+ */
+class MAVLinkTargetTable
+{
+public:
+    MAVLinkTargetTable()
+    {
+        static const mavlink_message_info_t info[256] = MAVLINK_MESSAGE_INFO;
+        for (int msgid = 0; msgid < 256; msgid++)
+        {
+            offsets[msgid] = -1;
+            for (unsigned int f = 0; f < info[msgid].num_fields; f++)
+            {
+                const mavlink_field_info_t& field = info[msgid].fields[f];
+                if (field.name && strcmp(field.name, "target_system") == 0 &&
+                        field.type == MAVLINK_TYPE_UINT8_T && field.array_length == 0)
+                {
+                    offsets[msgid] = field.wire_offset;
+                    break;
+                }
+            }
+        }
+    }
+
+    int offsets[256];
+};
+
+static const MAVLinkTargetTable targetTable;
+
+UDPEndpointTable::UDPEndpointTable(qint64 timeout) :
+    timeout(timeout),
+    lastExpiry(0),
+    targetedFrames(0),
+    broadcastFrames(0)
+{
+    for (int i = 0; i < 256; i++)
+    {
+        systems[i] = -1;
+    }
+}
+
+int UDPEndpointTable::targetSystemOffset(quint8 msgid)
+{
+    return targetTable.offsets[msgid];
+}
+
+quint64 UDPEndpointTable::key(const QHostAddress& address, quint16 port)
+{
+    if (address.protocol() == QAbstractSocket::IPv4Protocol)
+    {
+        return (quint64(address.toIPv4Address()) << 16) | port;
+    }
+    // IPv6 peers are rare, their keys are kept apart from the IPv4 keys
+    return (quint64(1) << 63) | (quint64(qHash(address.toString())) << 16) | port;
+}
+
+int UDPEndpointTable::insert(const QHostAddress& address, quint16 port)
+{
+    const quint64 endpointKey = key(address, port);
+    QHash<quint64, int>::const_iterator it = index.constFind(endpointKey);
+    if (it != index.constEnd()) return it.value();
+
+    UDPEndpoint endpoint;
+    endpoint.address = address;
+    endpoint.port = port;
+    endpoint.configured = false;
+    endpoint.lastSeen = 0;
+    endpoints.append(endpoint);
+    index.insert(endpointKey, endpoints.size() - 1);
+    return endpoints.size() - 1;
+}
+
+int UDPEndpointTable::addEndpoint(const QHostAddress& address, quint16 port)
+{
+    const int endpoint = insert(address, port);
+    endpoints[endpoint].configured = true;
+    return endpoint;
+}
+
+void UDPEndpointTable::removeAt(int endpoint)
+{
+    const int last = endpoints.size() - 1;
+    index.remove(key(endpoints.at(endpoint).address, endpoints.at(endpoint).port));
+    for (int sysid = 0; sysid < 256; sysid++)
+    {
+        if (systems[sysid] == endpoint) systems[sysid] = -1;
+        else if (systems[sysid] == last) systems[sysid] = endpoint;
+    }
+    if (endpoint != last)
+    {
+        endpoints[endpoint] = endpoints.at(last);
+        index.insert(key(endpoints.at(endpoint).address, endpoints.at(endpoint).port), endpoint);
+    }
+    endpoints.resize(last);
+}
+
+void UDPEndpointTable::removeAddress(const QHostAddress& address)
+{
+    // Backwards, removeAt() moves the last endpoint
+    for (int i = endpoints.size() - 1; i >= 0; i--)
+    {
+        if (endpoints.at(i).address == address) removeAt(i);
+    }
+}
+
+void UDPEndpointTable::expire(qint64 now)
+{
+    if (now - lastExpiry < 1000) return;
+    lastExpiry = now;
+    for (int i = endpoints.size() - 1; i >= 0; i--)
+    {
+        if (!endpoints.at(i).configured && now - endpoints.at(i).lastSeen > timeout) removeAt(i);
+    }
+}
+
+void UDPEndpointTable::learn(const QHostAddress& sender, quint16 senderPort, const char* data, int length, qint64 now)
+{
+    expire(now);
+    const int endpoint = insert(sender, senderPort);
+    endpoints[endpoint].lastSeen = now;
+
+    // The system ids are only trusted if the datagram consists of whole frames,
+    // the CRC is checked later by the protocol
+    const quint8* bytes = reinterpret_cast<const quint8*>(data);
+    int offset = 0;
+    while (offset + 1 < length && bytes[offset] == MAVLINK_STX)
+    {
+        offset += MAVLinkFrameScanner::frameLength(bytes[offset + 1]);
+    }
+    if (offset != length) return;
+
+    for (offset = 0; offset < length; offset += MAVLinkFrameScanner::frameLength(bytes[offset + 1]))
+    {
+        systems[bytes[offset + 3]] = endpoint;
+    }
+}
+
+int UDPEndpointTable::route(const char* data, int length, qint64 now)
+{
+    expire(now);
+    const quint8* bytes = reinterpret_cast<const quint8*>(data);
+    if (length >= MAVLINK_NUM_NON_PAYLOAD_BYTES && bytes[0] == MAVLINK_STX &&
+            length == MAVLinkFrameScanner::frameLength(bytes[1]))
+    {
+        const int offset = targetSystemOffset(bytes[5]);
+        if (offset >= 0 && offset < bytes[1])
+        {
+            // Target system 0 addresses all systems
+            const quint8 target = bytes[MAVLINK_NUM_HEADER_BYTES + offset];
+            if (target != 0 && systems[target] >= 0)
+            {
+                targetedFrames++;
+                return systems[target];
+            }
+        }
+    }
+    broadcastFrames++;
+    return ALL_ENDPOINTS;
+}
+
+QList<QHostAddress> UDPEndpointTable::addresses() const
+{
+    QList<QHostAddress> result;
+    for (int i = 0; i < endpoints.size(); i++)
+    {
+        result.append(endpoints.at(i).address);
+    }
+    return result;
+}
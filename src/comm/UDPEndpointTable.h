@@ -0,0 +1,129 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+
+/**
+ * @file
+ *   @brief Definition of class UDPEndpointTable
+ */
+
+#ifndef UDPENDPOINTTABLE_H
+#define UDPENDPOINTTABLE_H
+
+#include <QHostAddress>
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+/** @brief One peer of a UDP link */
+struct UDPEndpoint
+{
+    QHostAddress address;
+    quint16 port;
+    bool configured;        ///< Added by the user, never expires
+    qint64 lastSeen;        ///< Time of the last datagram from this peer in milliseconds, 0 if none
+};
+
+/**
+ * @brief Peers of a UDP link and the systems behind them
+ *
+ * Peers are hashed by address and port, so a fleet of vehicles on one
+ * host has one endpoint per vehicle. The system ids of the frames a peer
+ * sends are learned, which lets messages with a target system go to the
+ * owning peer only instead of to all of them. Learned peers which stay
+ * silent for longer than the timeout are removed.
+ *
+ * The table is not thread-safe, the link guards it with its data mutex.
+ */
+class UDPEndpointTable
+{
+public:
+    /** Returned by route() if a frame has to go to all endpoints */
+    static const int ALL_ENDPOINTS = -1;
+
+    UDPEndpointTable(qint64 timeout);
+
+    /** @brief Add a peer the user configured, returns its index */
+    int addEndpoint(const QHostAddress& address, quint16 port);
+    /** @brief Remove all peers with this address */
+    void removeAddress(const QHostAddress& address);
+    /**
+     * @brief Account a received datagram
+     *
+     * Adds or refreshes the sender and assigns the system ids of the frames
+     * in the datagram to it. Stale endpoints are removed on the way.
+     * @param now current time in milliseconds
+     */
+    void learn(const QHostAddress& sender, quint16 senderPort, const char* data, int length, qint64 now);
+    /**
+     * @brief Find the destination of an outgoing frame
+     *
+     * @return index of the endpoint which owns the target system of the frame,
+     *         ALL_ENDPOINTS for broadcasts, unknown targets and other data
+     */
+    int route(const char* data, int length, qint64 now);
+
+    int size() const {
+        return endpoints.size();
+    }
+    const UDPEndpoint& at(int index) const {
+        return endpoints.at(index);
+    }
+    /** @brief Index of the endpoint owning the system, -1 if unknown */
+    int systemEndpoint(quint8 sysid) const {
+        return systems[sysid];
+    }
+    /** @brief Addresses of all endpoints */
+    QList<QHostAddress> addresses() const;
+    /** @brief Number of routed frames which went to one endpoint only */
+    quint64 getTargetedFrames() const {
+        return targetedFrames;
+    }
+    /** @brief Number of routed frames which went to all endpoints */
+    quint64 getBroadcastFrames() const {
+        return broadcastFrames;
+    }
+
+    /** @brief Offset of the target system field in the payload of the message, -1 if it has none */
+    static int targetSystemOffset(quint8 msgid);
+
+protected:
+    /** @brief Add or find the endpoint, returns its index */
+    int insert(const QHostAddress& address, quint16 port);
+    /** @brief Remove the endpoint, the last endpoint takes its index */
+    void removeAt(int index);
+    /** @brief Remove learned endpoints not seen within the timeout, at most once per second */
+    void expire(qint64 now);
+    /** @brief Hash key of address and port */
+    static quint64 key(const QHostAddress& address, quint16 port);
+
+    QVector<UDPEndpoint> endpoints;
+    QHash<quint64, int> index;  ///< Endpoint index by key()
+    int systems[256];           ///< Endpoint index by system id, -1 if unknown
+    qint64 timeout;
+    qint64 lastExpiry;
+    quint64 targetedFrames;
+    quint64 broadcastFrames;
+};
+
+#endif // UDPENDPOINTTABLE_H
@@ -38,9 +38,26 @@ This file is part of the QGROUNDCONTROL project
 #include "QGC.h"
 #include <QHostInfo>
 //#include <netinet/in.h>
+#if defined(Q_OS_LINUX)
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
 
 UDPLink::UDPLink(QHostAddress host, quint16 port)
-	: socket(NULL)
+	: socket(NULL),
+    endpoints(UDP_ENDPOINT_TIMEOUT),
+    ioMode(isBatchedIOAvailable() ? IO_BATCHED : IO_SINGLE),
+    activeIOMode(IO_SINGLE),
+    batchSocket(-1),
+    ipv6Socket(NULL),
+    stopRequested(false),
+    receiveCalls(0),
+    truncatedDatagrams(0)
 {
     this->host = host;
     this->port = port;
@@ -61,9 +78,40 @@ UDPLink::~UDPLink()
 /**
  * @brief Runs the thread
  *
+ * In batched mode the thread blocks in poll() on the socket and reads
+ * the datagrams itself, the wait times out after UDP_WAIT_TIMEOUT ms to
+ * check for a disconnect request. In single mode QUdpSocket notifies the
+ * link through its readyRead() signal.
  **/
 void UDPLink::run()
 {
+#if defined(Q_OS_LINUX)
+    if (activeIOMode == IO_BATCHED)
+    {
+        forever
+        {
+            {
+                QMutexLocker locker(&runMutex);
+                if (stopRequested) break;
+            }
+            pollfd descriptor;
+            descriptor.fd = batchSocket;
+            descriptor.events = POLLIN;
+            descriptor.revents = 0;
+            const int ready = poll(&descriptor, 1, UDP_WAIT_TIMEOUT);
+            if (ready > 0)
+            {
+                readBatch();
+            }
+            else if (ready < 0 && errno != EINTR)
+            {
+                // Do not spin on a broken socket
+                msleep(UDP_WAIT_TIMEOUT);
+            }
+        }
+        return;
+    }
+#endif
 	exec();
 }
 
@@ -122,10 +170,10 @@ void UDPLink::addHost(const QString& host)
                     address = hostAddresses.at(i);
                 }
             }
-            hosts.append(address);
             //qDebug() << "Address:" << address.toString();
             // Set port according to user input
-            ports.append(host.split(":").last().toInt());
+            QMutexLocker locker(&dataMutex);
+            endpoints.addEndpoint(address, host.split(":").last().toInt());
         }
     }
     else
@@ -134,9 +182,9 @@ void UDPLink::addHost(const QString& host)
         if (info.error() == QHostInfo::NoError)
         {
             // Add host
-            hosts.append(info.addresses().first());
             // Set port according to default (this port)
-            ports.append(port);
+            QMutexLocker locker(&dataMutex);
+            endpoints.addEndpoint(info.addresses().first(), port);
         }
     }
 }
@@ -157,23 +205,28 @@ void UDPLink::removeHost(const QString& hostname)
             address = hostAddresses.at(i);
         }
     }
-    for (int i = 0; i < hosts.count(); ++i)
-    {
-        if (hosts.at(i) == address)
-        {
-            hosts.removeAt(i);
-            ports.removeAt(i);
-        }
-    }
+    QMutexLocker locker(&dataMutex);
+    endpoints.removeAddress(address);
 }
 
 void UDPLink::writeBytes(const char* data, qint64 size)
 {
-    // Broadcast to all connected systems
-    for (int h = 0; h < hosts.size(); h++)
+#if defined(Q_OS_LINUX)
+    if (activeIOMode == IO_BATCHED)
+    {
+        writeBatch(data, size);
+        return;
+    }
+#endif
+    QMutexLocker locker(&dataMutex);
+    // Send targeted messages to the peer of the target system, broadcast everything else
+    const int target = endpoints.route(data, size, QGC::groundTimeMilliseconds());
+    const int first = (target == UDPEndpointTable::ALL_ENDPOINTS) ? 0 : target;
+    const int last = (target == UDPEndpointTable::ALL_ENDPOINTS) ? endpoints.size() : target + 1;
+    for (int h = first; h < last; h++)
     {
-        QHostAddress currentHost = hosts.at(h);
-        quint16 currentPort = ports.at(h);
+        QHostAddress currentHost = endpoints.at(h).address;
+        quint16 currentPort = endpoints.at(h).port;
 //#define UDPLINK_DEBUG
 #ifdef UDPLINK_DEBUG
         QString bytes;
@@ -195,7 +248,10 @@ void UDPLink::writeBytes(const char* data, qint64 size)
         qDebug() << bytes;
         qDebug() << "ASCII:" << ascii;
 #endif
-        socket->writeDatagram(data, size, currentHost, currentPort);
+        if (socket->writeDatagram(data, size, currentHost, currentPort) > 0)
+        {
+            linkStatistics.countSent(size);
+        }
     }
 }
 
@@ -215,6 +271,7 @@ void UDPLink::readBytes()
         QHostAddress sender;
         quint16 senderPort;
         socket->readDatagram(datagram.data(), datagram.size(), &sender, &senderPort);
+        linkStatistics.countReceived(datagram.size());
 
         // FIXME TODO Check if this method is better than retrieving the data by individual processes
         emit bytesReceived(this, datagram);
@@ -230,21 +287,207 @@ void UDPLink::readBytes()
 //        std::cerr << std::endl;
 
 
-        // Add host to broadcast list if not yet present
-        if (!hosts.contains(sender))
+        learnHost(sender, senderPort, datagram);
+    }
+    receiveCalls.fetchAndAddRelaxed(1);
+}
+
+void UDPLink::learnHost(const QHostAddress& sender, quint16 senderPort, const QByteArray& datagram)
+{
+    QMutexLocker locker(&dataMutex);
+    endpoints.learn(sender, senderPort, datagram.constData(), datagram.size(), QGC::groundTimeMilliseconds());
+}
+
+QList<QHostAddress> UDPLink::getHosts()
+{
+    QMutexLocker locker(&dataMutex);
+    return endpoints.addresses();
+}
+
+int UDPLink::getEndpointForSystem(int sysid)
+{
+    if (sysid < 0 || sysid > 255) return -1;
+    QMutexLocker locker(&dataMutex);
+    return endpoints.systemEndpoint(sysid);
+}
+
+quint64 UDPLink::getTargetedFrames()
+{
+    QMutexLocker locker(&dataMutex);
+    return endpoints.getTargetedFrames();
+}
+
+#if defined(Q_OS_LINUX)
+/**
+ * Reads up to UDP_BATCH_DATAGRAMS datagrams with one recvmmsg() call into
+ * the slots of batchBuffer, moves them together and emits a copy of them
+ * as one block. The copy is only as large as the datagrams, a block
+ * queued by a receiver does not pin the receive slots. A datagram only holds complete MAVLink frames, so the protocol
+ * parses the block like a stream. Reading continues while full batches
+ * arrive.
+ */
+void UDPLink::readBatch()
+{
+    mmsghdr messages[UDP_BATCH_DATAGRAMS];
+    iovec slots[UDP_BATCH_DATAGRAMS];
+    sockaddr_in senders[UDP_BATCH_DATAGRAMS];
+
+    int received;
+    do
+    {
+        char* data = batchBuffer.data();
+        for (int i = 0; i < UDP_BATCH_DATAGRAMS; i++)
         {
-            hosts.append(sender);
-            ports.append(senderPort);
-            //        ports->insert(sender, senderPort);
+            slots[i].iov_base = data + i * UDP_BATCH_DATAGRAM_SIZE;
+            slots[i].iov_len = UDP_BATCH_DATAGRAM_SIZE;
+            memset(&messages[i].msg_hdr, 0, sizeof(msghdr));
+            messages[i].msg_hdr.msg_name = &senders[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            messages[i].msg_hdr.msg_iov = &slots[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
         }
-        else
+
+        received = recvmmsg(batchSocket, messages, UDP_BATCH_DATAGRAMS, MSG_DONTWAIT, NULL);
+        if (received <= 0) break;
+
+        int length = 0;
+        int truncated = 0;
+        const qint64 now = QGC::groundTimeMilliseconds();
+        QHostAddress sender;
+        const sockaddr_in* lastSender = NULL;
+        QMutexLocker dataLocker(&dataMutex);
+        for (int i = 0; i < received; i++)
         {
-            int index = hosts.indexOf(sender);
-            ports.replace(index, senderPort);
+            if (messages[i].msg_hdr.msg_flags & MSG_TRUNC)
+            {
+                truncated++;
+                continue;
+            }
+            const int size = messages[i].msg_len;
+            if (length != i * UDP_BATCH_DATAGRAM_SIZE)
+            {
+                memmove(data + length, data + i * UDP_BATCH_DATAGRAM_SIZE, size);
+            }
+
+            // A batch usually comes from one sender
+            if (!lastSender || senders[i].sin_addr.s_addr != lastSender->sin_addr.s_addr)
+            {
+                sender.setAddress(ntohl(senders[i].sin_addr.s_addr));
+            }
+            lastSender = &senders[i];
+            endpoints.learn(sender, ntohs(lastSender->sin_port), data + length, size, now);
+            length += size;
         }
+        dataLocker.unlock();
+
+        linkStatistics.countReceived(length, received - truncated);
+        receiveCalls.fetchAndAddRelaxed(1);
+        if (truncated > 0) truncatedDatagrams.fetchAndAddRelaxed(truncated);
+
+        if (length > 0) emit bytesReceived(this, QByteArray(data, length));
     }
+    while (received == UDP_BATCH_DATAGRAMS);
 }
 
+/**
+ * Broadcasts go to all peers, one sendmmsg() call sends the datagram to up
+ * to UDP_BATCH_DATAGRAMS peers instead of one writeDatagram() call per peer.
+ * The socket of the batched mode is IPv4 only, IPv6 peers get the datagram
+ * through a QUdpSocket.
+ */
+void UDPLink::writeBatch(const char* data, qint64 size)
+{
+    mmsghdr messages[UDP_BATCH_DATAGRAMS];
+    sockaddr_in destinations[UDP_BATCH_DATAGRAMS];
+    iovec slot;
+    slot.iov_base = const_cast<char*>(data);
+    slot.iov_len = size;
+
+    QMutexLocker locker(&dataMutex);
+    const int target = endpoints.route(data, size, QGC::groundTimeMilliseconds());
+    int h = (target == UDPEndpointTable::ALL_ENDPOINTS) ? 0 : target;
+    const int last = (target == UDPEndpointTable::ALL_ENDPOINTS) ? endpoints.size() : target + 1;
+    while (h < last)
+    {
+        int count = 0;
+        for (; h < last && count < UDP_BATCH_DATAGRAMS; h++)
+        {
+            const UDPEndpoint& endpoint = endpoints.at(h);
+            if (endpoint.address.protocol() != QAbstractSocket::IPv4Protocol)
+            {
+                if (!ipv6Socket) ipv6Socket = new QUdpSocket();
+                if (ipv6Socket->writeDatagram(data, size, endpoint.address, endpoint.port) > 0)
+                {
+                    linkStatistics.countSent(size);
+                }
+                continue;
+            }
+            sockaddr_in& destination = destinations[count];
+            memset(&destination, 0, sizeof(destination));
+            destination.sin_family = AF_INET;
+            destination.sin_addr.s_addr = htonl(endpoint.address.toIPv4Address());
+            destination.sin_port = htons(endpoint.port);
+            memset(&messages[count].msg_hdr, 0, sizeof(msghdr));
+            messages[count].msg_hdr.msg_name = &destination;
+            messages[count].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            messages[count].msg_hdr.msg_iov = &slot;
+            messages[count].msg_hdr.msg_iovlen = 1;
+            count++;
+        }
+
+        int sent = 0;
+        while (sent < count)
+        {
+            const int result = sendmmsg(batchSocket, messages + sent, count - sent, 0);
+            if (result <= 0) break;
+            sent += result;
+        }
+        if (sent > 0) linkStatistics.countSent(int(size) * sent, sent);
+    }
+}
+
+bool UDPLink::batchedConnect()
+{
+    const int descriptor = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (descriptor < 0) return false;
+
+    // Same behaviour as the default bind mode of QUdpSocket
+    int reuse = 1;
+    setsockopt(descriptor, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(host.toIPv4Address());
+    address.sin_port = htons(port);
+    if (::bind(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        ::close(descriptor);
+        return false;
+    }
+
+    batchSocket = descriptor;
+    // Never handed out, so it is allocated once per connection
+    batchBuffer.resize(UDP_BATCH_DATAGRAMS * UDP_BATCH_DATAGRAM_SIZE);
+    return true;
+}
+#else
+void UDPLink::readBatch()
+{
+}
+
+void UDPLink::writeBatch(const char* data, qint64 size)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(size);
+}
+
+bool UDPLink::batchedConnect()
+{
+    return false;
+}
+#endif
+
 
 /**
  * @brief Get the number of bytes to read.
@@ -253,6 +496,15 @@ void UDPLink::readBytes()
  **/
 qint64 UDPLink::bytesAvailable()
 {
+#if defined(Q_OS_LINUX)
+    if (activeIOMode == IO_BATCHED)
+    {
+        // Size of the next datagram, like QUdpSocket::pendingDatagramSize()
+        int pending = 0;
+        if (ioctl(batchSocket, FIONREAD, &pending) != 0) return -1;
+        return pending;
+    }
+#endif
     return socket->pendingDatagramSize();
 }
 
@@ -263,6 +515,10 @@ qint64 UDPLink::bytesAvailable()
  **/
 bool UDPLink::disconnect()
 {
+    {
+        QMutexLocker locker(&runMutex);
+        stopRequested = true;
+    }
 	this->quit();
 	this->wait();
 
@@ -271,6 +527,19 @@ bool UDPLink::disconnect()
 		delete socket;
 		socket = NULL;
 	}
+#if defined(Q_OS_LINUX)
+    if (batchSocket >= 0)
+    {
+        ::close(batchSocket);
+        batchSocket = -1;
+    }
+    {
+        QMutexLocker locker(&dataMutex);
+        delete ipv6Socket;
+        ipv6Socket = NULL;
+    }
+#endif
+    activeIOMode = IO_SINGLE;
 
     connectState = false;
 
@@ -288,9 +557,17 @@ bool UDPLink::connect()
 {
 	if(this->isRunning())
 	{
+        {
+            QMutexLocker locker(&runMutex);
+            stopRequested = true;
+        }
 		this->quit();
 		this->wait();
 	}
+    {
+        QMutexLocker locker(&runMutex);
+        stopRequested = false;
+    }
     bool connected = this->hardwareConnect();
     start(HighPriority);
     return connected;
@@ -298,6 +575,18 @@ bool UDPLink::connect()
 
 bool UDPLink::hardwareConnect(void)
 {
+    // The batched mode uses its own IPv4 socket and falls back to QUdpSocket otherwise
+    if (ioMode == IO_BATCHED && host.protocol() == QAbstractSocket::IPv4Protocol && batchedConnect())
+    {
+        activeIOMode = IO_BATCHED;
+        connectState = true;
+        emit connected(connectState);
+        emit connected();
+        connectionStartTime = QGC::groundTimeUsecs()/1000;
+        return connectState;
+    }
+
+    activeIOMode = IO_SINGLE;
 	socket = new QUdpSocket();
 
     //Check if we are using a multicast-address
@@ -364,67 +653,75 @@ int UDPLink::getId()
     return id;
 }
 
-QString UDPLink::getName()
+int UDPLink::getIOMode()
 {
-    return name;
+    return ioMode;
 }
 
-void UDPLink::setName(QString name)
+/**
+ * recvmmsg() and sendmmsg() are Linux specific. Extended messages have to
+ * arrive as one block per datagram and can be larger than the batch slots,
+ * so protobuf builds keep the single mode.
+ */
+bool UDPLink::isBatchedIOAvailable()
 {
-    this->name = name;
-    emit nameChanged(this->name);
+#if defined(Q_OS_LINUX) && !defined(QGC_PROTOBUF_ENABLED)
+    return true;
+#else
+    return false;
+#endif
 }
 
-
-qint64 UDPLink::getNominalDataRate()
+bool UDPLink::setIOMode(int mode)
 {
-    return 54000000; // 54 Mbit
-}
+    if (mode != IO_SINGLE && mode != IO_BATCHED) return false;
+    if (mode == IO_BATCHED && !isBatchedIOAvailable()) return false;
+    if (mode == ioMode) return true;
 
-qint64 UDPLink::getTotalUpstream()
-{
-    statisticsMutex.lock();
-    qint64 totalUpstream = bitsSentTotal / ((QGC::groundTimeUsecs()/1000 - connectionStartTime) / 1000);
-    statisticsMutex.unlock();
-    return totalUpstream;
+    bool reconnect(false);
+    if(this->isConnected())
+    {
+        disconnect();
+        reconnect = true;
+    }
+    ioMode = mode;
+    if(reconnect)
+    {
+        connect();
+    }
+    return true;
 }
 
-qint64 UDPLink::getCurrentUpstream()
+quint64 UDPLink::getReceivedDatagrams()
 {
-    return 0; // TODO
+    return linkStatistics.getReceivedPackets();
 }
 
-qint64 UDPLink::getMaxUpstream()
+quint64 UDPLink::getReceiveCalls()
 {
-    return 0; // TODO
+    return quint32(int(receiveCalls));
 }
 
-qint64 UDPLink::getBitsSent()
+quint64 UDPLink::getTruncatedDatagrams()
 {
-    return bitsSentTotal;
+    return quint32(int(truncatedDatagrams));
 }
 
-qint64 UDPLink::getBitsReceived()
+QString UDPLink::getName()
 {
-    return bitsReceivedTotal;
+    return name;
 }
 
-qint64 UDPLink::getTotalDownstream()
+void UDPLink::setName(QString name)
 {
-    statisticsMutex.lock();
-    qint64 totalDownstream = bitsReceivedTotal / ((QGC::groundTimeUsecs()/1000 - connectionStartTime) / 1000);
-    statisticsMutex.unlock();
-    return totalDownstream;
+    this->name = name;
+    emit nameChanged(this->name);
 }
 
-qint64 UDPLink::getCurrentDownstream()
-{
-    return 0; // TODO
-}
 
-qint64 UDPLink::getMaxDownstream()
+qint64 UDPLink::getNominalDataRate()
 {
-    return 0; // TODO
+    return 54000000; // 54 Mbit
 }
 
 bool UDPLink::isFullDuplex()
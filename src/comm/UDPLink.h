@@ -38,6 +38,7 @@ This file is part of the QGROUNDCONTROL project
 #include <QUdpSocket>
 #include <LinkInterface.h>
 #include <configuration.h>
+#include "UDPEndpointTable.h"
 
 class UDPLink : public LinkInterface
 {
@@ -49,6 +50,13 @@ public:
     //UDPLink(QHostAddress host = "239.255.76.67", quint16 port = 7667);
     ~UDPLink();
 
+    /** @brief How datagrams are exchanged with the socket */
+    enum IOMode
+    {
+        IO_SINGLE = 0,  ///< One datagram per call through QUdpSocket, delivered one by one
+        IO_BATCHED      ///< Many datagrams per recvmmsg()/sendmmsg() call, delivered as one block
+    };
+
     bool isConnected();
     qint64 bytesAvailable();
     int getPort() const {
@@ -65,20 +73,25 @@ public:
     int getParityType();
     int getDataBitsType();
     int getStopBitsType();
-    QList<QHostAddress> getHosts() {
-        return hosts;
-    }
+    /** @brief Addresses of all peers, configured and learned */
+    QList<QHostAddress> getHosts();
+    /** @brief Index of the peer the system sends from, -1 if unknown */
+    int getEndpointForSystem(int sysid);
+    /** @brief Number of sent frames which went to the peer of their target system only */
+    quint64 getTargetedFrames();
+    /** @brief Get the I/O mode, see IOMode */
+    int getIOMode();
+    /** @brief Check if the batched I/O mode is supported by this build */
+    static bool isBatchedIOAvailable();
+    /** @brief Number of received datagrams */
+    quint64 getReceivedDatagrams();
+    /** @brief Number of receive calls, each one delivering one or more datagrams */
+    quint64 getReceiveCalls();
+    /** @brief Number of datagrams dropped in batched mode because they exceeded UDP_BATCH_DATAGRAM_SIZE */
+    quint64 getTruncatedDatagrams();
 
     /* Extensive statistics for scientific purposes */
     qint64 getNominalDataRate();
-    qint64 getTotalUpstream();
-    qint64 getCurrentUpstream();
-    qint64 getMaxUpstream();
-    qint64 getTotalDownstream();
-    qint64 getCurrentDownstream();
-    qint64 getMaxDownstream();
-    qint64 getBitsSent();
-    qint64 getBitsReceived();
 
     void run();
 
@@ -93,6 +106,8 @@ public slots:
     void addHost(const QString& host);
     /** @brief Remove a host from broadcasting messages to */
     void removeHost(const QString& host);
+    /** @brief Set the I/O mode, see IOMode. Reconnects the link if it is connected. */
+    bool setIOMode(int mode);
     //    void readPendingDatagrams();
 
     void readBytes();
@@ -113,23 +128,33 @@ protected:
     int id;
     QUdpSocket* socket;
     bool connectState;
-    QList<QHostAddress> hosts;
-    QList<quint16> ports;
-
-    quint64 bitsSentTotal;
-    quint64 bitsSentCurrent;
-    quint64 bitsSentMax;
-    quint64 bitsReceivedTotal;
-    quint64 bitsReceivedCurrent;
-    quint64 bitsReceivedMax;
+    UDPEndpointTable endpoints;
+
     quint64 connectionStartTime;
-    QMutex statisticsMutex;
-    QMutex dataMutex;
+    QMutex dataMutex;       ///< Protects endpoints, which are learned by the receive thread in batched mode
+
+    int ioMode;             ///< IOMode of the next connection
+    int activeIOMode;       ///< IOMode of the current connection
+    int batchSocket;        ///< Socket descriptor in batched mode, -1 otherwise
+    QUdpSocket* ipv6Socket; ///< Sends to IPv6 peers in batched mode, created on first use, protected by dataMutex
+    bool stopRequested;     ///< Ends the receive loop of the batched mode, protected by runMutex
+    QMutex runMutex;
+    QByteArray batchBuffer; ///< Receive slots of the batched mode, compacted in place
+    QAtomicInt receiveCalls;
+    QAtomicInt truncatedDatagrams;
 
     void setName(QString name);
+    /** @brief Add or refresh the sender and learn the systems behind it */
+    void learnHost(const QHostAddress& sender, quint16 senderPort, const QByteArray& datagram);
 
 private:
 	bool hardwareConnect(void);
+    /** @brief Open and bind the socket of the batched mode */
+    bool batchedConnect();
+    /** @brief Read all pending datagrams in batches and emit one block per batch */
+    void readBatch();
+    /** @brief Send the data to its peers with as few system calls as possible */
+    void writeBatch(const char* data, qint64 size);
 
 signals:
     //Signals are defined by LinkInterface
@@ -0,0 +1,280 @@
+/*=====================================================================
+
+QGroundControl Open Source Ground Control Station
+
+(c) 2009 - 2012 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+This file is part of the QGROUNDCONTROL project
+
+    QGROUNDCONTROL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    QGROUNDCONTROL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+======================================================================*/
+
+
+/**
+ * @file
+ *   @brief Shared memory rings of the QGroundControl shared memory link
+ *
+ * Plain C, so simulators and companion processes on the same host can
+ * include this header without Qt and attach to the segment of a
+ * SharedMemoryLink. A segment holds one single-producer / single-consumer
+ * byte ring per direction. Both sides read and write the shared memory in
+ * place, the positions are the only synchronization. On Linux the consumer
+ * sleeps on a futex until the producer wakes it, other systems poll.
+ *
+ * Simulator side:
+ * @code
+ * qgc_shm_segment_t* segment = qgc_shm_open("/qgc_link", 1);
+ * qgc_shm_write(&segment->to_gcs, frame, length);
+ *
+ * if (qgc_shm_wait(&segment->from_gcs, 100) > 0)
+ * {
+ *     uint32_t contiguous;
+ *     const uint8_t* data = qgc_shm_read_pointer(&segment->from_gcs, &contiguous);
+ *     handle(data, contiguous);
+ *     qgc_shm_consume(&segment->from_gcs, contiguous);
+ * }
+ * qgc_shm_close(segment);
+ * @endcode
+ *
+ * Requires GCC or clang for the __atomic builtins, link with -lrt on older
+ * glibc versions.
+ */
+
+#ifndef QGC_SHM_RING_H
+#define QGC_SHM_RING_H
+
+#if !defined(_WIN32)
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define QGC_SHM_MAGIC 0x4D485351u   /* "QSHM" */
+#define QGC_SHM_VERSION 1u
+/** Size of one ring in bytes, a power of two */
+#define QGC_SHM_RING_SIZE 65536u
+#define QGC_SHM_CACHE_LINE 64
+
+/** One direction of the link */
+typedef struct qgc_shm_ring
+{
+    uint32_t head;      /**< Bytes written since creation, only advanced by the producer */
+    uint8_t pad0[QGC_SHM_CACHE_LINE - 4];
+    uint32_t tail;      /**< Bytes read since creation, only advanced by the consumer */
+    uint8_t pad1[QGC_SHM_CACHE_LINE - 4];
+    uint32_t wake;      /**< Incremented by the producer after each write, futex word */
+    uint32_t waiting;   /**< Non-zero while the consumer sleeps on wake */
+    uint8_t pad2[QGC_SHM_CACHE_LINE - 8];
+    uint8_t data[QGC_SHM_RING_SIZE];
+} qgc_shm_ring_t;
+
+/** Layout of the shared memory segment */
+typedef struct qgc_shm_segment
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ring_size;
+    uint8_t pad[QGC_SHM_CACHE_LINE - 12];
+    qgc_shm_ring_t to_gcs;      /**< Simulator / companion to ground station */
+    qgc_shm_ring_t from_gcs;    /**< Ground station to simulator / companion */
+} qgc_shm_segment_t;
+
+/** Number of bytes ready to read */
+static inline uint32_t qgc_shm_count(qgc_shm_ring_t* ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+/** Number of bytes which can be written */
+static inline uint32_t qgc_shm_free(qgc_shm_ring_t* ring)
+{
+    return QGC_SHM_RING_SIZE - qgc_shm_count(ring);
+}
+
+/** Wake the consumer if it sleeps, called by qgc_shm_commit() */
+static inline void qgc_shm_wake(qgc_shm_ring_t* ring)
+{
+    __atomic_fetch_add(&ring->wake, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->waiting, __ATOMIC_SEQ_CST))
+    {
+#if defined(__linux__)
+        syscall(SYS_futex, &ring->wake, FUTEX_WAKE, 1, NULL, NULL, 0);
+#endif
+    }
+}
+
+/**
+ * Producer: contiguous free space to build data in place
+ * @param contiguous set to the number of bytes which can be written at the returned pointer
+ */
+static inline uint8_t* qgc_shm_write_pointer(qgc_shm_ring_t* ring, uint32_t* contiguous)
+{
+    const uint32_t head = ring->head;
+    const uint32_t offset = head & (QGC_SHM_RING_SIZE - 1);
+    const uint32_t space = QGC_SHM_RING_SIZE - (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE));
+    *contiguous = (space < QGC_SHM_RING_SIZE - offset) ? space : QGC_SHM_RING_SIZE - offset;
+    return ring->data + offset;
+}
+
+/** Producer: publish bytes written at qgc_shm_write_pointer() */
+static inline void qgc_shm_commit(qgc_shm_ring_t* ring, uint32_t length)
+{
+    __atomic_store_n(&ring->head, ring->head + length, __ATOMIC_RELEASE);
+    qgc_shm_wake(ring);
+}
+
+/**
+ * Producer: copy a block into the ring
+ *
+ * The block is written completely or not at all, so frames are never cut.
+ * @return length, or 0 if the ring has not enough free space
+ */
+static inline uint32_t qgc_shm_write(qgc_shm_ring_t* ring, const void* data, uint32_t length)
+{
+    const uint32_t head = ring->head;
+    const uint32_t offset = head & (QGC_SHM_RING_SIZE - 1);
+    const uint32_t first = (length < QGC_SHM_RING_SIZE - offset) ? length : QGC_SHM_RING_SIZE - offset;
+    if (length == 0 || qgc_shm_free(ring) < length) return 0;
+    memcpy(ring->data + offset, data, first);
+    memcpy(ring->data, (const uint8_t*)data + first, length - first);
+    qgc_shm_commit(ring, length);
+    return length;
+}
+
+/**
+ * Consumer: contiguous readable bytes, to be processed in place
+ * @param contiguous set to the number of bytes readable at the returned pointer
+ */
+static inline const uint8_t* qgc_shm_read_pointer(qgc_shm_ring_t* ring, uint32_t* contiguous)
+{
+    const uint32_t tail = ring->tail;
+    const uint32_t offset = tail & (QGC_SHM_RING_SIZE - 1);
+    const uint32_t count = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail;
+    *contiguous = (count < QGC_SHM_RING_SIZE - offset) ? count : QGC_SHM_RING_SIZE - offset;
+    return ring->data + offset;
+}
+
+/** Consumer: release bytes returned by qgc_shm_read_pointer() */
+static inline void qgc_shm_consume(qgc_shm_ring_t* ring, uint32_t length)
+{
+    __atomic_store_n(&ring->tail, ring->tail + length, __ATOMIC_RELEASE);
+}
+
+/** Consumer: drop everything written so far, e.g. stale data of an earlier session */
+static inline void qgc_shm_discard(qgc_shm_ring_t* ring)
+{
+    __atomic_store_n(&ring->tail, __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+}
+
+/**
+ * Consumer: wait until the ring holds data
+ * @return number of readable bytes, 0 if the timeout expired
+ */
+static inline uint32_t qgc_shm_wait(qgc_shm_ring_t* ring, int timeout_ms)
+{
+    uint32_t count = qgc_shm_count(ring);
+    if (count > 0 || timeout_ms <= 0) return count;
+#if defined(__linux__)
+    {
+        /* A write after loading wake changes the futex word, the wait returns immediately then */
+        const uint32_t wake = __atomic_load_n(&ring->wake, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&ring->waiting, 1, __ATOMIC_SEQ_CST);
+        if (qgc_shm_count(ring) == 0)
+        {
+            struct timespec timeout;
+            timeout.tv_sec = timeout_ms / 1000;
+            timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+            syscall(SYS_futex, &ring->wake, FUTEX_WAIT, wake, &timeout, NULL, 0);
+        }
+        __atomic_store_n(&ring->waiting, 0, __ATOMIC_SEQ_CST);
+    }
+#else
+    while (timeout_ms-- > 0 && qgc_shm_count(ring) == 0)
+    {
+        usleep(1000);
+    }
+#endif
+    return qgc_shm_count(ring);
+}
+
+/**
+ * Map the named segment, create it if requested
+ *
+ * Both sides may create the segment, whoever comes first initializes it.
+ * @param name POSIX shared memory name, e.g. "/qgc_link"
+ * @param create non-zero to create a missing segment
+ * @return the mapped segment, NULL on errors or a layout mismatch
+ */
+static inline qgc_shm_segment_t* qgc_shm_open(const char* name, int create)
+{
+    struct stat status;
+    void* memory;
+    qgc_shm_segment_t* segment;
+    const int fd = shm_open(name, O_RDWR | (create ? O_CREAT : 0), 0600);
+    if (fd < 0) return NULL;
+
+    /* ftruncate() zero fills, all positions start at 0 */
+    if (fstat(fd, &status) != 0 ||
+            (status.st_size == 0 && ftruncate(fd, sizeof(qgc_shm_segment_t)) != 0) ||
+            (status.st_size != 0 && status.st_size != (off_t)sizeof(qgc_shm_segment_t)))
+    {
+        close(fd);
+        return NULL;
+    }
+    memory = mmap(NULL, sizeof(qgc_shm_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) return NULL;
+
+    segment = (qgc_shm_segment_t*)memory;
+    if (__atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE) == 0)
+    {
+        segment->version = QGC_SHM_VERSION;
+        segment->ring_size = QGC_SHM_RING_SIZE;
+        __atomic_store_n(&segment->magic, QGC_SHM_MAGIC, __ATOMIC_RELEASE);
+    }
+    if (segment->magic != QGC_SHM_MAGIC || segment->version != QGC_SHM_VERSION ||
+            segment->ring_size != QGC_SHM_RING_SIZE)
+    {
+        munmap(memory, sizeof(qgc_shm_segment_t));
+        return NULL;
+    }
+    return segment;
+}
+
+/** Unmap the segment, the segment itself stays until shm_unlink() */
+static inline void qgc_shm_close(qgc_shm_segment_t* segment)
+{
+    if (segment) munmap(segment, sizeof(qgc_shm_segment_t));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !_WIN32 */
+
+#endif /* QGC_SHM_RING_H */
@@ -6,6 +6,54 @@
 /** @brief Polling interval in ms */
 #define SERIAL_POLL_INTERVAL 9
 
+/** @brief Maximum time in ms a serial link waits for data in event mode, bounds the disconnect delay */
+#define SERIAL_WAIT_TIMEOUT 100
+
+/** @brief Largest chunk in bytes a serial link hands to the protocols */
+#define SERIAL_READ_BUFFER_SIZE 65536
+
+/** @brief Chunks a serial link keeps to reuse them once the receivers released them */
+#define SERIAL_READ_CHUNKS 8
+
+/** @brief Time in ms the serial port discovery listens for a valid MAVLink frame at one baud rate */
+#define SERIAL_DISCOVERY_TIMEOUT 1500
+
+/** @brief Number of datagrams a UDP link reads or sends with one system call in batched mode */
+#define UDP_BATCH_DATAGRAMS 64
+
+/** @brief Largest datagram in bytes a UDP link receives in batched mode, larger ones are dropped */
+#define UDP_BATCH_DATAGRAM_SIZE 2048
+
+/** @brief Maximum time in ms a UDP link waits for datagrams in batched mode, bounds the disconnect delay */
+#define UDP_WAIT_TIMEOUT 100
+
+/** @brief Time in ms after which a UDP link forgets a silent peer it learned */
+#define UDP_ENDPOINT_TIMEOUT 30000
+
+/** @brief Default POSIX shared memory segment of the shared memory link */
+#define SHARED_MEMORY_LINK_NAME "/qgc_link"
+
+/** @brief Maximum time in ms the shared memory link waits for data, bounds the disconnect delay */
+#define SHARED_MEMORY_WAIT_TIMEOUT 100
+
+/** @brief Sleep in ms between two iterations of the simulation link loop, bounds its emit cadence */
+#define SIMULATION_LOOP_INTERVAL 3
+
+/** @brief Size of the simulation link send buffer in bytes */
+#define SIMULATION_BUFFER_SIZE 65536
+
+/** @brief Largest number of vehicles the swarm simulation link generates */
+#define SWARM_MAX_VEHICLES 500
+
+/** @brief Simulated time in ms one block covers in the fast mode of the swarm simulation link */
+#define SWARM_FAST_STEP 10
+
+/** @brief Messages the swarm simulation link keeps in flight in fast mode before it waits for the consumer */
+#define SWARM_FAST_WINDOW 4096
+
+/** @brief Maximum time in ms the swarm simulation link waits for the consumer in fast mode */
+#define SWARM_WAIT_TIMEOUT 100
+
 /** @brief Heartbeat emission rate, in Hertz (times per second) */
 #define MAVLINK_HEARTBEAT_DEFAULT_RATE 1
 
@@ -28,8 +28,13 @@ This file is part of the QGROUNDCONTROL project
  *
  */
 
+#include <stdio.h>
+#include <string.h>
 #include <QtGui/QApplication>
 #include "QGCCore.h"
+#include "QGCSwarmBenchmark.h"
+#include "QGCReplayBenchmark.h"
+#include "MAVLinkLogBlockFile.h"
 #include "MainWindow.h"
 #include "configuration.h"
 
@@ -70,6 +75,45 @@ int main(int argc, char *argv[])
     qInstallMsgHandler( msgHandler );
 #endif
 
+    // The swarm benchmark runs the communication pipeline without any window
+    if (QGCSwarmBenchmark::isRequested(argc, argv))
+    {
+        QApplication app(argc, argv, false);
+        QGCSwarmBenchmark benchmark;
+        if (!benchmark.parseArguments(app.arguments())) return 1;
+        QTimer::singleShot(0, &benchmark, SLOT(start()));
+        return app.exec();
+    }
+
+    // The replay benchmark only needs a window for the linechart
+    if (QGCReplayBenchmark::isRequested(argc, argv))
+    {
+        QApplication app(argc, argv, QGCReplayBenchmark::needsDisplay(argc, argv));
+        QGCReplayBenchmark benchmark;
+        if (!benchmark.parseArguments(app.arguments())) return 1;
+        QTimer::singleShot(0, &benchmark, SLOT(start()));
+        return app.exec();
+    }
+
+    // Convert a log between the raw and the compressed block format
+    if (argc > 1 && strcmp(argv[1], "--convert-log") == 0)
+    {
+        if (argc != 4)
+        {
+            fprintf(stderr, "Usage: qgroundcontrol --convert-log FROM TO\n"
+                    "  converts a raw MAVLink log into a compressed block log (*.mavlinkz) or back\n");
+            return 1;
+        }
+        QCoreApplication app(argc, argv);
+        QString error;
+        if (!MAVLinkLogBlockFile::convert(app.arguments().at(2), app.arguments().at(3), &error))
+        {
+            fprintf(stderr, "%s\n", error.toLocal8Bit().constData());
+            return 1;
+        }
+        return 0;
+    }
+
     QGCCore core(argc, argv);
     return core.exec();
 }
@@ -0,0 +1,2332 @@
+#include "CommBenchmarkTest.h"
+#include <string.h>
+#include <stddef.h>
+#include <QtEndian>
+#if defined(Q_OS_UNIX)
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "MAVLinkFrameScanner.h"
+#include "MAVLinkParserWorker.h"
+#include "QGCSpscQueue.h"
+#include "QGCByteRingBuffer.h"
+#include "MAVLinkMessagePool.h"
+#include "MAVLinkMessageDispatcher.h"
+#include "MAVLinkProtocol.h"
+#include "UASManager.h"
+#include "UAS.h"
+#include "MAVLinkLogWriter.h"
+#include "MAVLinkStatistics.h"
+#include "UDPLink.h"
+#include "UDPEndpointTable.h"
+#include "MAVLinkSendScheduler.h"
+#include "SerialLink.h"
+#include "SharedMemoryLink.h"
+#include "MAVLinkSimulationLink.h"
+#include "MAVLinkSwarmSimulationLink.h"
+#include "LinkStatistics.h"
+#include "SerialPortDiscovery.h"
+#include "QGCXPlaneLink.h"
+#include "QGCXPlaneLoopback.h"
+#include "QGCFlightGearNet.h"
+#include "MAVLinkLogIndex.h"
+#include "MAVLinkLogReader.h"
+#include "MAVLinkLogReplay.h"
+#include "MAVLinkLogPacer.h"
+#include "MAVLinkLogBlockFile.h"
+#if defined(Q_OS_UNIX)
+#include "qgc_shm_ring.h"
+#endif
+
+/** Number of messages in the test stream */
+#define STREAM_MESSAGES 10000
+
+/**
+ * @brief Subscriber counting the received messages
+ */
+class CountingSubscriber : public MAVLinkMessageSubscriber
+{
+public:
+    CountingSubscriber(MAVLinkMessageDispatcher* dispatcher = NULL) :
+        dispatcher(dispatcher),
+        count(0),
+        lastSysid(0)
+    {
+    }
+
+    void receiveMessage(LinkInterface* link, const mavlink_message_t& message)
+    {
+        Q_UNUSED(link);
+        count++;
+        lastSysid = message.sysid;
+        // Unsubscribe while the message is dispatched
+        if (dispatcher) dispatcher->unsubscribe(this);
+    }
+
+    QString getSubscriberName() {
+        return "counter";
+    }
+
+    MAVLinkMessageDispatcher* dispatcher;   ///< Unsubscribe from this dispatcher after the first message
+    int count;
+    int lastSysid;
+};
+
+/**
+ * @brief Link recording the message ids of all written frames
+ */
+class RecordingLink : public LinkInterface
+{
+public:
+    RecordingLink() : id(getNextLinkId()) {}
+
+    int getId() { return id; }
+    QString getName() { return "recording link"; }
+    bool isConnected() { return true; }
+    qint64 getNominalDataRate() { return 57600; }
+    bool isFullDuplex() { return true; }
+    int getLinkQuality() { return 100; }
+    qint64 getTotalUpstream() { return 0; }
+    qint64 getCurrentUpstream() { return 0; }
+    qint64 getMaxUpstream() { return 0; }
+    qint64 getBitsSent() { return 0; }
+    qint64 getBitsReceived() { return 0; }
+    bool connect() { return true; }
+    bool disconnect() { return true; }
+    qint64 bytesAvailable() { return 0; }
+
+    void writeBytes(const char* bytes, qint64 length)
+    {
+        if (length > 5) msgids.append(quint8(bytes[5]));
+        frames.append(QByteArray(bytes, length));
+    }
+
+    QList<int> msgids;
+    QList<QByteArray> frames;
+
+protected:
+    void readBytes() {}
+    int id;
+};
+
+CommBenchmarkTest::CommBenchmarkTest()
+{
+}
+
+void CommBenchmarkTest::initTestCase()
+{
+    stream = createStream(STREAM_MESSAGES, &sent);
+}
+
+void CommBenchmarkTest::appendFrame(QByteArray& stream, const mavlink_message_t& message)
+{
+    uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+    int len = mavlink_msg_to_send_buffer(buffer, &message);
+    stream.append(reinterpret_cast<const char*>(buffer), len);
+}
+
+QByteArray CommBenchmarkTest::createStream(int messages, QList<mavlink_message_t>* sent)
+{
+    QByteArray data;
+    mavlink_message_t message;
+    for (int i = 0; i < messages; i++)
+    {
+        // Typical telemetry mix: small heartbeats, medium attitude and
+        // position messages and long parameter values
+        switch (i % 4)
+        {
+        case 0:
+            mavlink_msg_heartbeat_pack(1 + i % 3, MAV_COMP_ID_IMU, &message, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_GENERIC, MAV_MODE_FLAG_SAFETY_ARMED, i, MAV_STATE_ACTIVE);
+            break;
+        case 1:
+            mavlink_msg_attitude_pack(1 + i % 3, MAV_COMP_ID_IMU, &message, i, 0.1f * i, -0.2f, 0.3f, 0.01f, 0.02f, 0.03f);
+            break;
+        case 2:
+            mavlink_msg_global_position_int_pack(1 + i % 3, MAV_COMP_ID_IMU, &message, i, 473977418 + i, 85455939, 500000, 20000, 100, -100, 5, 9000);
+            break;
+        default:
+            mavlink_msg_param_value_pack(1 + i % 3, MAV_COMP_ID_IMU, &message, "SYS_AUTOSTART", 0.5f * i, MAV_PARAM_TYPE_REAL32, 200, i % 200);
+            break;
+        }
+        appendFrame(data, message);
+        if (sent) sent->append(message);
+    }
+    return data;
+}
+
+QByteArray CommBenchmarkTest::createLog(const QList<mavlink_message_t>& messages, bool corrupt, QList<qint64>* offsets)
+{
+    QByteArray data;
+    for (int i = 0; i < messages.size(); i++)
+    {
+        if (corrupt && i == messages.size() / 2)
+        {
+            // Garbage containing start signs, readers have to resynchronize
+            data.append(QByteArray(37, char(MAVLINK_STX)));
+        }
+        if (offsets) offsets->append(data.size());
+        quint64 time = 1000000 + i * 1000;
+        data.append(reinterpret_cast<const char*>(&time), sizeof(time));
+        appendFrame(data, messages.at(i));
+    }
+    return data;
+}
+
+void CommBenchmarkTest::scannerBlockSize_test_data()
+{
+    QTest::addColumn<int>("blockSize");
+
+    QTest::newRow("single bytes") << 1;
+    QTest::newRow("odd blocks") << 7;
+    QTest::newRow("serial read") << 64;
+    QTest::newRow("large blocks") << 2048;
+    QTest::newRow("whole stream") << stream.size();
+}
+
+void CommBenchmarkTest::scannerBlockSize_test()
+{
+    QFETCH(int, blockSize);
+
+    MAVLinkFrameScanner scanner;
+    mavlink_message_t message;
+    int count = 0;
+    for (int offset = 0; offset < stream.size(); offset += blockSize)
+    {
+        scanner.setInput(stream.constData() + offset, qMin(blockSize, stream.size() - offset));
+        while (scanner.nextMessage(&message))
+        {
+            const mavlink_message_t& expected = sent.at(count);
+            QCOMPARE(message.msgid, expected.msgid);
+            QCOMPARE(message.sysid, expected.sysid);
+            QCOMPARE(message.seq, expected.seq);
+            QCOMPARE(message.checksum, expected.checksum);
+            QVERIFY(memcmp(message.payload64, expected.payload64, message.len) == 0);
+            count++;
+        }
+    }
+    QCOMPARE(count, sent.size());
+    QCOMPARE(scanner.getParseErrors(), quint64(0));
+    QCOMPARE(scanner.getSkippedBytes(), quint64(0));
+    QCOMPARE(scanner.pendingBytes(), 0);
+}
+
+void CommBenchmarkTest::scannerCorruption_test()
+{
+    QByteArray data = createStream(100);
+    // Line noise in front and a flipped payload bit in the 10th frame
+    data.prepend(QByteArray("\x55\x01\xFE\x02", 4));
+    int position = 4;
+    for (int i = 0; i < 9; i++)
+    {
+        position += MAVLinkFrameScanner::frameLength(data.at(position + 1));
+    }
+    data[position + MAVLINK_NUM_HEADER_BYTES] = data.at(position + MAVLINK_NUM_HEADER_BYTES) ^ 0x01;
+
+    // The result has to be independent of the block size
+    for (int blockSize = 1; blockSize <= data.size(); blockSize += 97)
+    {
+        MAVLinkFrameScanner scanner;
+        mavlink_message_t message;
+        int count = 0;
+        for (int offset = 0; offset < data.size(); offset += blockSize)
+        {
+            scanner.setInput(data.constData() + offset, qMin(blockSize, data.size() - offset));
+            while (scanner.nextMessage(&message))
+            {
+                count++;
+            }
+        }
+        QCOMPARE(count, 99);
+        QVERIFY(scanner.getParseErrors() >= 1);
+        QVERIFY(scanner.getVersion09Markers() >= 1);
+    }
+}
+
+void CommBenchmarkTest::scannerSkip_test()
+{
+    QByteArray data;
+    mavlink_message_t message;
+    mavlink_msg_heartbeat_pack(1, MAV_COMP_ID_IMU, &message, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_GENERIC, 0, 0, MAV_STATE_ACTIVE);
+    appendFrame(data, message);
+    // Out-of-band payload which contains a start sign
+    data.append(QByteArray(16, char(MAVLINK_STX)));
+    appendFrame(data, message);
+
+    MAVLinkFrameScanner scanner;
+    scanner.setInput(data.constData(), data.size());
+    QVERIFY(scanner.nextMessage(&message));
+    scanner.skip(16);
+    QVERIFY(scanner.nextMessage(&message));
+    QVERIFY(!scanner.nextMessage(&message));
+    QCOMPARE(scanner.getReceivedFrames(), quint64(2));
+    QCOMPARE(scanner.getParseErrors(), quint64(0));
+    QCOMPARE(scanner.position(), data.size());
+}
+
+void CommBenchmarkTest::scannerThroughput_benchmark_data()
+{
+    QTest::addColumn<bool>("blockScanner");
+    QTest::addColumn<int>("blockSize");
+
+    QTest::newRow("parse_char, 64 byte blocks") << false << 64;
+    QTest::newRow("scanner, 64 byte blocks") << true << 64;
+    QTest::newRow("parse_char, 2048 byte blocks") << false << 2048;
+    QTest::newRow("scanner, 2048 byte blocks") << true << 2048;
+}
+
+/**
+ * Compares the frame rate of the block scanner against the per-byte
+ * mavlink_parse_char() state machine previously used in MAVLinkProtocol.
+ */
+void CommBenchmarkTest::scannerThroughput_benchmark()
+{
+    QFETCH(bool, blockScanner);
+    QFETCH(int, blockSize);
+
+    mavlink_message_t message;
+    int count = 0;
+    QBENCHMARK
+    {
+        count = 0;
+        if (blockScanner)
+        {
+            MAVLinkFrameScanner scanner;
+            for (int offset = 0; offset < stream.size(); offset += blockSize)
+            {
+                scanner.setInput(stream.constData() + offset, qMin(blockSize, stream.size() - offset));
+                while (scanner.nextMessage(&message))
+                {
+                    count++;
+                }
+            }
+        }
+        else
+        {
+            mavlink_status_t status;
+            for (int offset = 0; offset < stream.size(); offset += blockSize)
+            {
+                int end = qMin(offset + blockSize, stream.size());
+                for (int position = offset; position < end; position++)
+                {
+                    if (mavlink_parse_char(MAVLINK_COMM_0, (uint8_t)(stream.at(position)), &message, &status))
+                    {
+                        count++;
+                    }
+                }
+            }
+        }
+    }
+    QCOMPARE(count, STREAM_MESSAGES);
+}
+
+void CommBenchmarkTest::spscQueue_test()
+{
+    QGCSpscQueue<int> queue(100);
+    QCOMPARE(queue.capacity(), 128);
+
+    // Fill and drain several times to wrap the indices around
+    int value;
+    for (int round = 0; round < 3; round++)
+    {
+        for (int i = 0; i < queue.capacity(); i++)
+        {
+            QVERIFY(queue.push(i));
+        }
+        QVERIFY(!queue.push(-1));
+        QCOMPARE(queue.count(), queue.capacity());
+        for (int i = 0; i < queue.capacity(); i++)
+        {
+            QVERIFY(queue.pop(&value));
+            QCOMPARE(value, i);
+        }
+        QVERIFY(!queue.pop(&value));
+        QCOMPARE(queue.count(), 0);
+    }
+}
+
+void CommBenchmarkTest::parserWorker_test()
+{
+    MAVLinkParserWorker worker(NULL, 64);
+    QSignalSpy spy(&worker, SIGNAL(messagesReady()));
+
+    // Only one notification until the dispatcher acknowledged it
+    worker.receiveBytes(NULL, stream.left(1000));
+    worker.receiveBytes(NULL, stream.mid(1000, 1000));
+    QCOMPARE(spy.count(), 1);
+
+    mavlink_message_t message;
+    int count = 0;
+    worker.acknowledge();
+    while (worker.takeMessage(&message))
+    {
+        QCOMPARE(message.seq, sent.at(count).seq);
+        count++;
+    }
+    QVERIFY(count > 0);
+
+    // Overflow is counted, not blocking
+    worker.receiveBytes(NULL, stream);
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(worker.pendingMessages(), 64);
+    QVERIFY(worker.getDroppedMessages() > 0);
+}
+
+void CommBenchmarkTest::parserThread_test()
+{
+    QThread thread;
+    MAVLinkParserWorker* worker = new MAVLinkParserWorker(NULL, STREAM_MESSAGES);
+    worker->moveToThread(&thread);
+    thread.start();
+
+    QSignalSpy spy(worker, SIGNAL(messagesReady()));
+    for (int offset = 0; offset < stream.size(); offset += 2048)
+    {
+        QMetaObject::invokeMethod(worker, "receiveBytes", Qt::QueuedConnection,
+                                  Q_ARG(LinkInterface*, NULL), Q_ARG(QByteArray, stream.mid(offset, 2048)));
+    }
+
+    mavlink_message_t message;
+    int count = 0;
+    QTime timeout;
+    timeout.start();
+    while (count < STREAM_MESSAGES && timeout.elapsed() < 5000)
+    {
+        QTest::qWait(10);
+        worker->acknowledge();
+        while (worker->takeMessage(&message))
+        {
+            QCOMPARE(message.seq, sent.at(count).seq);
+            count++;
+        }
+    }
+    QCOMPARE(count, STREAM_MESSAGES);
+    QVERIFY(spy.count() > 0);
+    QCOMPARE(worker->getDroppedMessages(), 0);
+
+    thread.quit();
+    thread.wait();
+    delete worker;
+}
+
+void CommBenchmarkTest::messagePool_test()
+{
+    MAVLinkMessagePool* pool = MAVLinkMessagePool::instance();
+    const quint64 allocations = pool->getAllocations();
+    const int live = pool->getLiveMessages();
+
+    MAVLinkMessageHandle handle = pool->allocate(sent.at(3));
+    QCOMPARE(handle->msgid, sent.at(3).msgid);
+    QCOMPARE(handle->checksum, sent.at(3).checksum);
+    QVERIFY(memcmp(handle->payload64, sent.at(3).payload64, handle->len) == 0);
+    QCOMPARE(pool->getLiveMessages(), live + 1);
+
+    // Copies share the message
+    {
+        MAVLinkMessageHandle copy = handle;
+        MAVLinkMessageHandle assigned;
+        assigned = copy;
+        QCOMPARE(assigned.data(), handle.data());
+        QCOMPARE(pool->getLiveMessages(), live + 1);
+    }
+    QCOMPARE(pool->getLiveMessages(), live + 1);
+
+    // The block is reused after the last handle is gone
+    const mavlink_message_t* block = handle.data();
+    handle = MAVLinkMessageHandle();
+    QVERIFY(handle.isNull());
+    QCOMPARE(pool->getLiveMessages(), live);
+    const quint64 heapAllocations = pool->getHeapAllocations();
+    const quint64 reusedBlocks = pool->getReusedBlocks();
+    handle = pool->allocate(sent.at(0));
+    QCOMPARE(handle.data(), block);
+    QCOMPARE(pool->getHeapAllocations(), heapAllocations);
+    QCOMPARE(pool->getReusedBlocks(), reusedBlocks + 1);
+    QCOMPARE(pool->getAllocations(), allocations + 2);
+}
+
+void CommBenchmarkTest::messageFanOut_benchmark_data()
+{
+    QTest::addColumn<bool>("pooled");
+
+    QTest::newRow("by value") << false;
+    QTest::newRow("pooled handle") << true;
+}
+
+/**
+ * Hands every message of the stream to four receivers, once as
+ * copies of the message and once as pooled handles.
+ */
+void CommBenchmarkTest::messageFanOut_benchmark()
+{
+    QFETCH(bool, pooled);
+    const int receivers = 4;
+
+    MAVLinkMessagePool* pool = MAVLinkMessagePool::instance();
+    quint64 allocations = pool->getAllocations();
+    quint64 heapAllocations = pool->getHeapAllocations();
+    quint32 sum = 0;
+    QBENCHMARK
+    {
+        for (int i = 0; i < sent.size(); i++)
+        {
+            if (pooled)
+            {
+                MAVLinkMessageHandle handle = pool->allocate(sent.at(i));
+                for (int j = 0; j < receivers; j++)
+                {
+                    MAVLinkMessageHandle copy(handle);
+                    sum += copy->seq;
+                }
+            }
+            else
+            {
+                for (int j = 0; j < receivers; j++)
+                {
+                    mavlink_message_t copy = sent.at(i);
+                    sum += copy.seq;
+                }
+            }
+        }
+    }
+    QVERIFY(sum > 0);
+    if (pooled)
+    {
+        // After warm-up every message reuses a pooled block
+        QVERIFY(pool->getAllocations() > allocations);
+        QVERIFY(pool->getHeapAllocations() - heapAllocations <= 1);
+    }
+}
+
+void CommBenchmarkTest::dispatcher_test()
+{
+    MAVLinkMessageDispatcher dispatcher;
+    CountingSubscriber all;
+    CountingSubscriber heartbeats;
+    CountingSubscriber system2;
+    CountingSubscriber once(&dispatcher);
+
+    dispatcher.subscribeAll(&all);
+    dispatcher.subscribe(&heartbeats, MAVLINK_MSG_ID_HEARTBEAT);
+    // Duplicates are ignored
+    dispatcher.subscribe(&heartbeats, MAVLINK_MSG_ID_HEARTBEAT);
+    dispatcher.subscribeAll(&system2, 2);
+    dispatcher.subscribe(&once, MAVLINK_MSG_ID_ATTITUDE);
+    QCOMPARE(dispatcher.getSubscriptionCount(MAVLINK_MSG_ID_HEARTBEAT), 3);
+
+    for (int i = 0; i < 100; i++)
+    {
+        dispatcher.dispatch(NULL, sent.at(i));
+    }
+    QCOMPARE(all.count, 100);
+    QCOMPARE(heartbeats.count, 25);
+    QCOMPARE(system2.count, 33);
+    QCOMPARE(system2.lastSysid, 2);
+    QCOMPARE(once.count, 1);
+    QCOMPARE(dispatcher.getSubscriptionCount(MAVLINK_MSG_ID_ATTITUDE), 2);
+
+    quint64 deliveries = 0;
+    foreach (const MAVLinkSubscriberStatistics& statistics, dispatcher.getStatistics())
+    {
+        deliveries += statistics.deliveries;
+    }
+    QCOMPARE(deliveries, quint64(100 + 25 + 33));
+
+    // A destroyed subscriber is removed from the dispatcher
+    {
+        CountingSubscriber temporary;
+        dispatcher.subscribeAll(&temporary);
+        QCOMPARE(dispatcher.getSubscriptionCount(0), 4);
+    }
+    QCOMPARE(dispatcher.getSubscriptionCount(0), 3);
+    dispatcher.dispatch(NULL, sent.at(0));
+    QCOMPARE(all.count, 101);
+}
+
+/**
+ * Delivers the stream to 50 vehicles of which each only
+ * subscribed to its own system id.
+ */
+void CommBenchmarkTest::dispatcher_benchmark()
+{
+    const int vehicles = 50;
+    MAVLinkMessageDispatcher dispatcher;
+    CountingSubscriber subscribers[vehicles];
+    for (int i = 0; i < vehicles; i++)
+    {
+        dispatcher.subscribeAll(&subscribers[i], i + 1);
+    }
+
+    QList<mavlink_message_t> messages = sent;
+    for (int i = 0; i < messages.size(); i++)
+    {
+        messages[i].sysid = 1 + i % vehicles;
+    }
+
+    QBENCHMARK
+    {
+        for (int i = 0; i < messages.size(); i++)
+        {
+            dispatcher.dispatch(NULL, messages.at(i));
+        }
+    }
+    QVERIFY(subscribers[0].count > 0);
+}
+
+void CommBenchmarkTest::uasLookup_benchmark_data()
+{
+    QTest::addColumn<int>("vehicles");
+    QTest::addColumn<bool>("table");
+
+    QTest::newRow("1 vehicle, list") << 1 << false;
+    QTest::newRow("1 vehicle, table") << 1 << true;
+    QTest::newRow("50 vehicles, list") << 50 << false;
+    QTest::newRow("50 vehicles, table") << 50 << true;
+    QTest::newRow("250 vehicles, list") << 250 << false;
+    QTest::newRow("250 vehicles, table") << 250 << true;
+}
+
+/**
+ * Looks up the vehicle of every message of a stream, once with the
+ * id table of UASManager and once with the former list search.
+ */
+void CommBenchmarkTest::uasLookup_benchmark()
+{
+    QFETCH(int, vehicles);
+    QFETCH(bool, table);
+
+    MAVLinkProtocol protocol;
+    UASManager* manager = UASManager::instance();
+    QList<UAS*> systems;
+    for (int i = 1; i <= vehicles; i++)
+    {
+        UAS* uas = new UAS(&protocol, i);
+        manager->addUAS(uas);
+        systems.append(uas);
+    }
+    QVERIFY(manager->getUASForId(vehicles) == systems.last());
+
+    int found = 0;
+    QBENCHMARK
+    {
+        found = 0;
+        for (int i = 0; i < STREAM_MESSAGES; i++)
+        {
+            int id = 1 + i % vehicles;
+            UASInterface* system = NULL;
+            if (table)
+            {
+                system = manager->getUASForId(id);
+            }
+            else
+            {
+                foreach (UASInterface* sys, manager->getUASList())
+                {
+                    if (sys->getUASID() == id) system = sys;
+                }
+            }
+            if (system) found++;
+        }
+    }
+    QCOMPARE(found, STREAM_MESSAGES);
+
+    foreach (UAS* uas, systems)
+    {
+        manager->removeUAS(uas);
+        delete uas;
+    }
+    QVERIFY(manager->getUASForId(1) == NULL);
+}
+
+void CommBenchmarkTest::logWriter_test_data()
+{
+    QTest::addColumn<int>("policy");
+
+    QTest::newRow("no sync") << int(MAVLinkLogWriter::SYNC_NEVER);
+    QTest::newRow("sync per batch") << int(MAVLinkLogWriter::SYNC_BATCH);
+}
+
+void CommBenchmarkTest::logWriter_test()
+{
+    QFETCH(int, policy);
+
+    QString fileName = QDir::tempPath() + "/qgc_logwriter_test.mavlink";
+    QFile::remove(fileName);
+
+    MAVLinkLogWriter writer;
+    writer.setSyncPolicy(static_cast<MAVLinkLogWriter::SyncPolicy>(policy));
+    QVERIFY(writer.startLogging(fileName));
+    for (int i = 0; i < sent.size(); i++)
+    {
+        writer.append(i, sent.at(i));
+    }
+    writer.stopLogging();
+    QVERIFY(!writer.isLogging());
+
+    // Packets are either written or dropped, never blocking
+    QCOMPARE(writer.getWrittenPackets() + writer.getDroppedPackets(), sent.size());
+    QCOMPARE(writer.getWriteErrors(), 0);
+
+    // Walk the records: timestamp followed by the complete frame
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray data = file.readAll();
+    int position = 0;
+    int records = 0;
+    quint64 lastTime = 0;
+    while (position < data.size())
+    {
+        quint64 time;
+        memcpy(&time, data.constData() + position, sizeof(quint64));
+        QVERIFY(records == 0 || time > lastTime);
+        lastTime = time;
+        position += sizeof(quint64);
+        QCOMPARE((quint8)data.at(position), (quint8)MAVLINK_STX);
+        position += MAVLinkFrameScanner::frameLength(data.at(position + 1));
+        records++;
+    }
+    QCOMPARE(position, data.size());
+    QCOMPARE(records, writer.getWrittenPackets());
+
+    // The frames are intact
+    MAVLinkFrameScanner scanner;
+    mavlink_message_t message;
+    scanner.setInput(data.constData(), data.size());
+    int frames = 0;
+    while (scanner.nextMessage(&message)) frames++;
+    QCOMPARE(frames, records);
+
+    file.close();
+    QFile::remove(fileName);
+}
+
+void CommBenchmarkTest::forwardFrame_test()
+{
+    // The decoded message has to contain the received frame unchanged,
+    // multiplexing forwards these bytes without re-encoding
+    MAVLinkFrameScanner scanner;
+    scanner.setInput(stream.constData(), stream.size());
+
+    mavlink_message_t message;
+    int offset = 0;
+    int frames = 0;
+    while (scanner.nextMessage(&message))
+    {
+        const int length = message.len + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+        QCOMPARE(QByteArray(reinterpret_cast<const char*>(&message.magic), length),
+                 stream.mid(offset, length));
+        offset += length;
+        frames++;
+    }
+    QCOMPARE(frames, STREAM_MESSAGES);
+    QCOMPARE(offset, stream.size());
+}
+
+void CommBenchmarkTest::forwardFrame_benchmark_data()
+{
+    QTest::addColumn<bool>("reencode");
+
+    QTest::newRow("re-encode") << true;
+    QTest::newRow("raw frame") << false;
+}
+
+void CommBenchmarkTest::forwardFrame_benchmark()
+{
+    QFETCH(bool, reencode);
+
+    QByteArray out;
+    out.reserve(stream.size());
+    uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+    static uint8_t messageKeys[256] = MAVLINK_MESSAGE_CRCS;
+
+    QBENCHMARK
+    {
+        out.resize(0);
+        foreach (mavlink_message_t message, sent)
+        {
+            if (reencode)
+            {
+                // What multiplexing did before: finalize and serialize again
+                mavlink_finalize_message_chan(&message, message.sysid, message.compid, MAVLINK_COMM_0, message.len, messageKeys[message.msgid]);
+                int len = mavlink_msg_to_send_buffer(buffer, &message);
+                out.append(reinterpret_cast<const char*>(buffer), len);
+            }
+            else
+            {
+                out.append(reinterpret_cast<const char*>(&message.magic), message.len + MAVLINK_NUM_NON_PAYLOAD_BYTES);
+            }
+        }
+    }
+    QCOMPARE(out.size(), stream.size());
+}
+
+void CommBenchmarkTest::statistics_test()
+{
+    UDPLink link(QHostAddress::LocalHost, 14599);
+    MAVLinkStatistics statistics;
+    MAVLinkLinkStatistics* counters = statistics.addLink(&link);
+    QVERIFY(statistics.addLink(&link) == counters);
+
+    // 100 messages of system 1, every tenth sequence number is missing
+    mavlink_message_t message = sent.at(1);
+    message.sysid = 1;
+    message.compid = MAV_COMP_ID_IMU;
+    int seq = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        message.seq = seq & 0xFF;
+        seq += (i % 10 == 9) ? 2 : 1;
+        counters->countMessage(message);
+    }
+    // The sequence number wraps at 255 without counting a gap
+    message.sysid = 2;
+    for (int i = 0; i < 300; i++)
+    {
+        message.seq = i & 0xFF;
+        counters->countMessage(message);
+    }
+    counters->setParseErrors(7);
+
+    statistics.updateSnapshot();
+    MAVLinkStatisticsSnapshot snapshot = statistics.getSnapshot();
+    QCOMPARE(snapshot.links.size(), 1);
+    const MAVLinkLinkSample& linkSample = snapshot.links.at(0);
+    QCOMPARE(linkSample.linkId, link.getId());
+    QCOMPARE(linkSample.crcErrors, quint64(7));
+    QCOMPARE(linkSample.components.size(), 2);
+
+    const MAVLinkComponentSample& first = linkSample.components.at(0);
+    QCOMPARE(int(first.sysid), 1);
+    QCOMPARE(first.messages, quint64(100));
+    QCOMPARE(first.lost, quint64(9));
+    QCOMPARE(first.messageTypes.size(), 1);
+    QCOMPARE(int(first.messageTypes.at(0).msgid), int(message.msgid));
+    QCOMPARE(first.messageTypes.at(0).bytes, quint64(100 * (message.len + MAVLINK_NUM_NON_PAYLOAD_BYTES)));
+    quint32 jitters = 0;
+    foreach (quint32 count, first.messageTypes.at(0).jitterHistogram)
+    {
+        jitters += count;
+    }
+    QCOMPARE(jitters, quint32(98));
+
+    const MAVLinkComponentSample& second = linkSample.components.at(1);
+    QCOMPARE(second.messages, quint64(300));
+    QCOMPARE(second.lost, quint64(0));
+
+    // Totals keep growing, the exporters write one row per message id
+    counters->countMessage(message);
+    statistics.updateSnapshot();
+    snapshot = statistics.getSnapshot();
+    QCOMPARE(snapshot.links.at(0).components.at(1).messages, quint64(301));
+
+    QStringList rows = MAVLinkStatistics::toCsv(snapshot).split("\n", QString::SkipEmptyParts);
+    QCOMPARE(rows.size(), 3);
+    QVERIFY(rows.at(0).startsWith("time,link_id"));
+    QString json = MAVLinkStatistics::toJson(snapshot);
+    QVERIFY(json.contains("\"crc_errors\":7"));
+    QCOMPARE(json.count("\"msgid\":"), 2);
+
+    QCOMPARE(MAVLinkLinkStatistics::jitterBin(0), 0);
+    QCOMPARE(MAVLinkLinkStatistics::jitterBin(1), 1);
+    QCOMPARE(MAVLinkLinkStatistics::jitterBin(1000), 10);
+    QCOMPARE(MAVLinkLinkStatistics::jitterBin(Q_INT64_C(1) << 40), MAVLINK_STATISTICS_JITTER_BINS - 1);
+
+    statistics.removeLink(&link);
+    statistics.updateSnapshot();
+    QCOMPARE(statistics.getSnapshot().links.size(), 0);
+}
+
+/**
+ * Cost of counting one message on the parser thread.
+ */
+void CommBenchmarkTest::statistics_benchmark()
+{
+    MAVLinkLinkStatistics counters(0, "benchmark");
+    QBENCHMARK
+    {
+        foreach (const mavlink_message_t& message, sent)
+        {
+            counters.countMessage(message);
+        }
+    }
+}
+
+void CommBenchmarkTest::sendScheduler_test()
+{
+    RecordingLink link;
+    MAVLinkSendScheduler scheduler;
+
+    // 57600 baud with start and stop bits
+    QCOMPARE(scheduler.getRateLimit(&link), qint64(5760));
+
+    // A parameter burst on a slow link, only the first frames fit into the budget
+    scheduler.setRateLimit(&link, 10);
+    mavlink_message_t message;
+    for (int i = 0; i < 20; i++)
+    {
+        mavlink_msg_param_value_pack(1, MAV_COMP_ID_IMU, &message, "PARAM", i, MAV_PARAM_TYPE_REAL32, 20, i);
+        scheduler.sendMessage(&link, message, 255, 0);
+    }
+    const int immediate = link.msgids.size();
+    QVERIFY(immediate > 0 && immediate < 20);
+
+    // Repeated manual control is coalesced, it and the heartbeat overtake the parameters
+    for (int i = 0; i < 3; i++)
+    {
+        mavlink_msg_manual_control_pack(255, 0, &message, 1, 100 * i, 0, 0, 0, 0);
+        scheduler.sendMessage(&link, message, 255, 0);
+    }
+    mavlink_msg_heartbeat_pack(255, 0, &message, MAV_TYPE_GCS, MAV_AUTOPILOT_INVALID, MAV_MODE_MANUAL_ARMED, 0, MAV_STATE_ACTIVE);
+    scheduler.sendMessage(&link, message, 255, 0);
+    QVERIFY(scheduler.getQueuedFrames(&link) > 20 - immediate);
+
+    // The waiting frames are sent from the timer
+    scheduler.setRateLimit(&link, 5000);
+    QCOMPARE(scheduler.getRateLimit(&link), qint64(5000));
+    QTime timeout;
+    timeout.start();
+    while (scheduler.getQueuedFrames(&link) > 0 && timeout.elapsed() < 5000)
+    {
+        QTest::qWait(10);
+    }
+    QCOMPARE(scheduler.getQueuedFrames(&link), 0);
+
+    QList<MAVLinkSendStatistics> statistics = scheduler.getStatistics(&link);
+    QCOMPARE(statistics.size(), int(MAVLinkSendScheduler::PRIORITY_COUNT));
+    const MAVLinkSendStatistics& control = statistics.at(MAVLinkSendScheduler::PRIORITY_CONTROL);
+    QCOMPARE(control.sent + control.coalesced, quint64(3));
+    QVERIFY(control.coalesced > 0);
+    QCOMPARE(statistics.at(MAVLinkSendScheduler::PRIORITY_BULK).sent, quint64(20));
+    QVERIFY(statistics.at(MAVLinkSendScheduler::PRIORITY_BULK).maxLatency > 0);
+
+    QCOMPARE(link.msgids.size(), 20 + int(control.sent) + 1);
+    const int firstWaitingParam = link.msgids.indexOf(MAVLINK_MSG_ID_PARAM_VALUE, immediate);
+    QVERIFY(link.msgids.lastIndexOf(MAVLINK_MSG_ID_MANUAL_CONTROL) < firstWaitingParam);
+    QVERIFY(link.msgids.lastIndexOf(MAVLINK_MSG_ID_HEARTBEAT) < firstWaitingParam);
+
+    // Without a limit everything is written immediately
+    scheduler.setRateLimit(&link, -1);
+    QCOMPARE(scheduler.getRateLimit(&link), qint64(-1));
+    link.msgids.clear();
+    for (int i = 0; i < 20; i++)
+    {
+        scheduler.sendMessage(&link, message, 255, 0);
+    }
+    QCOMPARE(link.msgids.size(), 20);
+}
+
+/**
+ * Control messages queued for different vehicles on one link must not
+ * replace each other, only the waiting frame of the same target.
+ */
+void CommBenchmarkTest::sendSchedulerTargets_test()
+{
+    RecordingLink link;
+    MAVLinkSendScheduler scheduler;
+
+    // Exhaust the budget so the control messages wait
+    scheduler.setRateLimit(&link, 10);
+    mavlink_message_t message;
+    for (int i = 0; i < 20; i++)
+    {
+        mavlink_msg_param_value_pack(1, MAV_COMP_ID_IMU, &message, "PARAM", i, MAV_PARAM_TYPE_REAL32, 20, i);
+        scheduler.sendMessage(&link, message, 255, 0);
+    }
+    QVERIFY(scheduler.getQueuedFrames(&link) > 0);
+
+    // Three rounds of manual control for two vehicles, finalized with the same sender
+    for (int i = 0; i < 3; i++)
+    {
+        for (quint8 target = 1; target <= 2; target++)
+        {
+            mavlink_msg_manual_control_pack(255, 0, &message, target, 100 * i, 0, 0, 0, 0);
+            scheduler.sendMessage(&link, message, 255, 0);
+        }
+    }
+    // Forwarded setpoints for two components of the same vehicle
+    for (int i = 0; i < 2; i++)
+    {
+        for (quint8 component = 1; component <= 2; component++)
+        {
+            mavlink_msg_set_roll_pitch_yaw_thrust_pack(255, 0, &message, 3, component, 0.1f * i, 0, 0, 0.5f);
+            quint8 frame[MAVLINK_MAX_PACKET_LEN];
+            const int length = mavlink_msg_to_send_buffer(frame, &message);
+            scheduler.sendFrame(&link, reinterpret_cast<const char*>(frame), length);
+        }
+    }
+
+    scheduler.setRateLimit(&link, -1);
+    scheduler.flush();
+    QCOMPARE(scheduler.getQueuedFrames(&link), 0);
+    const MAVLinkSendStatistics control = scheduler.getStatistics(&link).at(MAVLinkSendScheduler::PRIORITY_CONTROL);
+    QCOMPARE(control.sent, quint64(4));
+    QCOMPARE(control.coalesced, quint64(6));
+
+    // Every target received its latest frame
+    QList<int> manualTargets;
+    QList<int> setpointComponents;
+    foreach (const QByteArray& frame, link.frames)
+    {
+        const quint8 msgid = quint8(frame.at(5));
+        const char* payload = frame.constData() + MAVLINK_NUM_HEADER_BYTES;
+        if (msgid == MAVLINK_MSG_ID_MANUAL_CONTROL)
+        {
+            mavlink_manual_control_t control;
+            memcpy(&control, payload, sizeof(control));
+            QCOMPARE(control.x, qint16(200));
+            manualTargets.append(control.target);
+        }
+        else if (msgid == MAVLINK_MSG_ID_SET_ROLL_PITCH_YAW_THRUST)
+        {
+            mavlink_set_roll_pitch_yaw_thrust_t setpoint;
+            memcpy(&setpoint, payload, sizeof(setpoint));
+            QCOMPARE(setpoint.target_system, quint8(3));
+            QCOMPARE(setpoint.roll, 0.1f);
+            setpointComponents.append(setpoint.target_component);
+        }
+    }
+    qSort(manualTargets);
+    qSort(setpointComponents);
+    QCOMPARE(manualTargets, QList<int>() << 1 << 2);
+    QCOMPARE(setpointComponents, QList<int>() << 1 << 2);
+}
+
+void CommBenchmarkTest::serialLatency_benchmark_data()
+{
+    QTest::addColumn<int>("readMode");
+
+    QTest::newRow("polling") << int(SerialLink::READ_POLLING);
+    QTest::newRow("event") << int(SerialLink::READ_EVENT);
+}
+
+/**
+ * Time from writing one byte into a pseudo terminal until the serial
+ * link emits it.
+ */
+void CommBenchmarkTest::serialLatency_benchmark()
+{
+#if defined(Q_OS_UNIX)
+    QFETCH(int, readMode);
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    QVERIFY(master >= 0);
+    QVERIFY(grantpt(master) == 0 && unlockpt(master) == 0);
+    const QString slaveName(ptsname(master));
+
+    SerialLink link(slaveName, 115200);
+    link.setPortName(slaveName);
+    link.setReadMode(readMode);
+    QSignalSpy spy(&link, SIGNAL(bytesReceived(LinkInterface*, QByteArray)));
+    link.connect();
+    QTime timeout;
+    timeout.start();
+    while (!link.isConnected() && timeout.elapsed() < 2000)
+    {
+        QTest::qWait(10);
+    }
+    QVERIFY(link.isConnected());
+
+    const char byte = 0x42;
+    QBENCHMARK
+    {
+        const int received = spy.count();
+        QVERIFY(write(master, &byte, 1) == 1);
+        timeout.restart();
+        while (spy.count() == received && timeout.elapsed() < 1000)
+        {
+            usleep(50);
+        }
+        QVERIFY(spy.count() > received);
+    }
+
+    link.disconnect();
+    close(master);
+#else
+    QSKIP("Needs a POSIX pseudo terminal", SkipAll);
+#endif
+}
+
+void CommBenchmarkTest::ringBuffer_test()
+{
+    QGCByteRingBuffer buffer(1000);
+    QCOMPARE(buffer.capacity(), 1024);
+
+    // Wrap around the end several times with odd chunk sizes
+    QByteArray out;
+    int written = 0;
+    char data[300];
+    while (written < stream.size())
+    {
+        const int length = qMin(int(sizeof(data)), stream.size() - written);
+        memcpy(data, stream.constData() + written, length);
+        written += buffer.write(data, length);
+        QVERIFY(buffer.count() <= buffer.capacity());
+        QCOMPARE(buffer.count() + buffer.freeSpace(), buffer.capacity());
+
+        // Parse in place, then consume
+        int contiguous;
+        const char* source = buffer.readPointer(&contiguous);
+        const int take = qMin(contiguous, 257);
+        out.append(source, take);
+        buffer.consume(take);
+    }
+    char rest[1024];
+    out.append(rest, buffer.read(rest, sizeof(rest)));
+    QCOMPARE(buffer.count(), 0);
+    QVERIFY(out == stream);
+
+    // Direct writes into the free space
+    int contiguous;
+    char* target = buffer.writePointer(&contiguous);
+    QVERIFY(contiguous > 0);
+    memset(target, 0x55, contiguous);
+    buffer.commit(contiguous);
+    QCOMPARE(buffer.count(), contiguous);
+    QCOMPARE(buffer.write(data, 1), (contiguous == buffer.capacity()) ? 0 : 1);
+    buffer.clear();
+    QCOMPARE(buffer.count(), 0);
+}
+
+/**
+ * Sends a large stream through a pseudo terminal and checks that the
+ * serial link delivers it completely, in order and in chunks of more than
+ * one read. Chunks released by the receivers are reused.
+ */
+void CommBenchmarkTest::serialReadBuffer_test()
+{
+#if defined(Q_OS_UNIX)
+    qRegisterMetaType<LinkInterface*>("LinkInterface*");
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    QVERIFY(master >= 0);
+    QVERIFY(grantpt(master) == 0 && unlockpt(master) == 0);
+    const QString slaveName(ptsname(master));
+
+    SerialLink link(slaveName, 115200);
+    link.setPortName(slaveName);
+    QSignalSpy spy(&link, SIGNAL(bytesReceived(LinkInterface*, QByteArray)));
+    link.connect();
+    QTime timeout;
+    timeout.start();
+    while (!link.isConnected() && timeout.elapsed() < 2000)
+    {
+        QTest::qWait(10);
+    }
+    QVERIFY(link.isConnected());
+
+    for (int offset = 0; offset < stream.size(); offset += 4096)
+    {
+        const int length = qMin(4096, stream.size() - offset);
+        QVERIFY(write(master, stream.constData() + offset, length) == length);
+    }
+
+    timeout.restart();
+    while (link.getReadBytes() < quint64(stream.size()) && timeout.elapsed() < 5000)
+    {
+        QTest::qWait(10);
+    }
+
+    QByteArray received;
+    for (int i = 0; i < spy.count(); i++)
+    {
+        received.append(spy.at(i).at(1).toByteArray());
+    }
+    QCOMPARE(received.size(), stream.size());
+    QVERIFY(received == stream);
+    QCOMPARE(link.getChunkCount(), quint64(spy.count()));
+    QVERIFY(link.getBytesPerRead() > 1.0);
+    // The spy keeps every chunk, none of them could be reused
+    QVERIFY(link.getChunkAllocations() >= link.getChunkCount());
+
+    // Released chunks are written again
+    const quint64 allocations = link.getChunkAllocations();
+    spy.clear();
+    received.clear();
+    QVERIFY(write(master, stream.constData(), 4096) == 4096);
+    timeout.restart();
+    while (link.getReadBytes() < quint64(stream.size() + 4096) && timeout.elapsed() < 5000)
+    {
+        QTest::qWait(10);
+    }
+    link.disconnect();
+    close(master);
+    QVERIFY(spy.count() > 0);
+    QCOMPARE(link.getChunkAllocations(), allocations);
+    qDebug() << "Reads:" << link.getReadCount() << "bytes per read:" << link.getBytesPerRead() << "chunks:" << link.getChunkCount();
+#else
+    QSKIP("Needs a POSIX pseudo terminal", SkipAll);
+#endif
+}
+
+/**
+ * Sends frames in single datagrams to a link in batched mode and checks
+ * that the emitted blocks hold all of them in order, that the sender is
+ * learned and that oversized datagrams are dropped.
+ */
+void CommBenchmarkTest::udpBatch_test()
+{
+    if (!UDPLink::isBatchedIOAvailable())
+    {
+        QSKIP("Batched UDP I/O is not available", SkipAll);
+    }
+
+    UDPLink link(QHostAddress::LocalHost, 14601);
+    QCOMPARE(link.getIOMode(), int(UDPLink::IO_BATCHED));
+    QSignalSpy spy(&link, SIGNAL(bytesReceived(LinkInterface*, QByteArray)));
+    QVERIFY(link.connect());
+
+    QUdpSocket peer;
+    QVERIFY(peer.bind(QHostAddress::LocalHost, 14602));
+
+    QByteArray expected;
+    const int datagrams = 1000;
+    for (int i = 0; i < datagrams; i++)
+    {
+        QByteArray frame;
+        appendFrame(frame, sent.at(i));
+        expected.append(frame);
+        QCOMPARE(peer.writeDatagram(frame, QHostAddress::LocalHost, 14601), qint64(frame.size()));
+
+        // Stay below the socket receive buffer
+        if (i % 100 == 99)
+        {
+            QTime timeout;
+            timeout.start();
+            while (link.getReceivedDatagrams() < quint64(i + 1) && timeout.elapsed() < 1000)
+            {
+                QTest::qWait(1);
+            }
+        }
+    }
+
+    const QByteArray oversized(UDP_BATCH_DATAGRAM_SIZE + 1, 0x42);
+    peer.writeDatagram(oversized, QHostAddress::LocalHost, 14601);
+    QTime timeout;
+    timeout.start();
+    while (link.getTruncatedDatagrams() == 0 && timeout.elapsed() < 1000)
+    {
+        QTest::qWait(10);
+    }
+
+    // The sender was learned, the link answers it
+    QVERIFY(link.getHosts().contains(QHostAddress::LocalHost));
+    link.writeBytes("reply", 5);
+    QVERIFY(peer.waitForReadyRead(1000));
+    QByteArray reply(peer.pendingDatagramSize(), 0);
+    peer.readDatagram(reply.data(), reply.size());
+    QCOMPARE(reply, QByteArray("reply"));
+
+    link.disconnect();
+
+    QByteArray received;
+    for (int i = 0; i < spy.count(); i++)
+    {
+        const QByteArray block = spy.at(i).at(1).toByteArray();
+        // Queued blocks do not pin the receive slots
+        QCOMPARE(block.capacity(), block.size());
+        received.append(block);
+    }
+    QCOMPARE(link.getReceivedDatagrams(), quint64(datagrams));
+    QCOMPARE(link.getTruncatedDatagrams(), quint64(1));
+    QVERIFY(received == expected);
+    QVERIFY(link.getReceiveCalls() <= quint64(spy.count()) + 1);
+}
+
+void CommBenchmarkTest::udpThroughput_benchmark_data()
+{
+    QTest::addColumn<int>("ioMode");
+
+    QTest::newRow("single") << int(UDPLink::IO_SINGLE);
+    QTest::newRow("batched") << int(UDPLink::IO_BATCHED);
+}
+
+/**
+ * Datagrams per second from one UDP link to another over the loopback
+ * interface, sent in bursts below the socket receive buffer.
+ */
+void CommBenchmarkTest::udpThroughput_benchmark()
+{
+    QFETCH(int, ioMode);
+    if (ioMode == UDPLink::IO_BATCHED && !UDPLink::isBatchedIOAvailable())
+    {
+        QSKIP("Batched UDP I/O is not available", SkipAll);
+    }
+
+    UDPLink receiver(QHostAddress::LocalHost, 14603);
+    QVERIFY(receiver.setIOMode(ioMode));
+    UDPLink sender(QHostAddress::LocalHost, 14604);
+    QVERIFY(sender.setIOMode(ioMode));
+    QVERIFY(receiver.connect());
+    QVERIFY(sender.connect());
+    sender.addHost("127.0.0.1:14603");
+
+    const QByteArray frame = stream.left(MAVLinkFrameScanner::frameLength(stream.at(1)));
+    const int burst = 128;
+    const quint64 start = receiver.getReceivedDatagrams();
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QBENCHMARK
+    {
+        const quint64 expected = receiver.getReceivedDatagrams() + burst;
+        for (int i = 0; i < burst; i++)
+        {
+            sender.writeBytes(frame.constData(), frame.size());
+        }
+        QTime timeout;
+        timeout.start();
+        while (receiver.getReceivedDatagrams() < expected && timeout.elapsed() < 1000)
+        {
+            QCoreApplication::processEvents();
+        }
+    }
+    const double seconds = elapsed.nsecsElapsed() / 1e9;
+    const quint64 datagrams = receiver.getReceivedDatagrams() - start;
+    const quint64 calls = receiver.getReceiveCalls();
+
+    sender.disconnect();
+    receiver.disconnect();
+
+    QVERIFY(datagrams > 0);
+    qDebug() << "Datagrams per second:" << datagrams / seconds << "datagrams per receive call:" << double(datagrams) / qMax(calls, quint64(1));
+}
+
+/**
+ * Two vehicles behind one host, the table has to keep them apart, route
+ * commands to the owner of the target system and forget silent peers.
+ */
+void CommBenchmarkTest::endpointTable_test()
+{
+    UDPEndpointTable table(5000);
+    const QHostAddress localHost(QHostAddress::LocalHost);
+    const int configured = table.addEndpoint(QHostAddress("10.0.0.1"), 14550);
+
+    QByteArray heartbeats[2];
+    for (int i = 0; i < 2; i++)
+    {
+        mavlink_message_t message;
+        mavlink_msg_heartbeat_pack(i + 1, MAV_COMP_ID_IMU, &message, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_GENERIC, 0, 0, MAV_STATE_ACTIVE);
+        appendFrame(heartbeats[i], message);
+    }
+    qint64 now = 100000;
+    table.learn(localHost, 14560, heartbeats[0].constData(), heartbeats[0].size(), now);
+    table.learn(localHost, 14570, heartbeats[1].constData(), heartbeats[1].size(), now);
+    // Not a sequence of whole frames, no system is learned
+    table.learn(localHost, 14580, "\xFE\x09garbage", 9, now);
+    QCOMPARE(table.size(), 4);
+    QCOMPARE(table.systemEndpoint(3), -1);
+    const int second = table.systemEndpoint(2);
+    QVERIFY(second >= 0);
+    QCOMPARE(table.at(second).port, quint16(14570));
+    QVERIFY(table.systemEndpoint(1) != second);
+
+    QVERIFY(UDPEndpointTable::targetSystemOffset(MAVLINK_MSG_ID_COMMAND_LONG) >= 0);
+    QCOMPARE(UDPEndpointTable::targetSystemOffset(MAVLINK_MSG_ID_HEARTBEAT), -1);
+
+    QByteArray command;
+    mavlink_message_t message;
+    mavlink_msg_command_long_pack(255, 0, &message, 2, 0, MAV_CMD_NAV_RETURN_TO_LAUNCH, 0, 0, 0, 0, 0, 0, 0, 0);
+    appendFrame(command, message);
+    QCOMPARE(table.route(command.constData(), command.size(), now), second);
+    QCOMPARE(table.route(heartbeats[0].constData(), heartbeats[0].size(), now), int(UDPEndpointTable::ALL_ENDPOINTS));
+
+    QByteArray unknown;
+    mavlink_msg_command_long_pack(255, 0, &message, 7, 0, MAV_CMD_NAV_RETURN_TO_LAUNCH, 0, 0, 0, 0, 0, 0, 0, 0);
+    appendFrame(unknown, message);
+    QCOMPARE(table.route(unknown.constData(), unknown.size(), now), int(UDPEndpointTable::ALL_ENDPOINTS));
+    QByteArray everyone;
+    mavlink_msg_command_long_pack(255, 0, &message, 0, 0, MAV_CMD_NAV_RETURN_TO_LAUNCH, 0, 0, 0, 0, 0, 0, 0, 0);
+    appendFrame(everyone, message);
+    QCOMPARE(table.route(everyone.constData(), everyone.size(), now), int(UDPEndpointTable::ALL_ENDPOINTS));
+    QCOMPARE(table.getTargetedFrames(), quint64(1));
+    QCOMPARE(table.getBroadcastFrames(), quint64(3));
+
+    // Only system 2 keeps talking, the other learned peers expire
+    now += 4000;
+    table.learn(localHost, 14570, heartbeats[1].constData(), heartbeats[1].size(), now);
+    now += 2000;
+    table.route(command.constData(), command.size(), now);
+    QCOMPARE(table.size(), 2);
+    QCOMPARE(table.systemEndpoint(1), -1);
+    QCOMPARE(table.at(table.systemEndpoint(2)).port, quint16(14570));
+    QCOMPARE(table.route(command.constData(), command.size(), now), table.systemEndpoint(2));
+    QCOMPARE(table.at(configured).port, quint16(14550));
+
+    table.removeAddress(localHost);
+    QCOMPARE(table.size(), 1);
+    QCOMPARE(table.systemEndpoint(2), -1);
+    QVERIFY(table.addresses().contains(QHostAddress("10.0.0.1")));
+}
+
+/**
+ * Attaches to the segment of a shared memory link like a simulator would
+ * and exchanges data in both directions.
+ */
+void CommBenchmarkTest::sharedMemoryLink_test()
+{
+#if defined(Q_OS_UNIX)
+    const QString name = QString("/qgc_test_%1").arg(getpid());
+    SharedMemoryLink link(name);
+    QSignalSpy spy(&link, SIGNAL(bytesReceived(LinkInterface*, QByteArray)));
+    QVERIFY(link.connect());
+    QVERIFY(link.isConnected());
+
+    qgc_shm_segment_t* segment = qgc_shm_open(name.toLocal8Bit().constData(), 0);
+    QVERIFY(segment != NULL);
+
+    // Simulator to ground station, larger than the ring
+    int written = 0;
+    QTime timeout;
+    timeout.start();
+    while (written < stream.size() && timeout.elapsed() < 5000)
+    {
+        const int length = qMin(4096, stream.size() - written);
+        if (qgc_shm_write(&segment->to_gcs, stream.constData() + written, length) > 0)
+        {
+            written += length;
+        }
+        else
+        {
+            usleep(100);
+        }
+    }
+    QCOMPARE(written, stream.size());
+    while (link.getBitsReceived() < qint64(stream.size()) * 8 && timeout.elapsed() < 5000)
+    {
+        QTest::qWait(10);
+    }
+
+    // Ground station to simulator
+    link.writeBytes(stream.constData(), 300);
+    QCOMPARE(qgc_shm_wait(&segment->from_gcs, 100), uint32_t(300));
+    uint32_t contiguous;
+    const uint8_t* data = qgc_shm_read_pointer(&segment->from_gcs, &contiguous);
+    QCOMPARE(contiguous, uint32_t(300));
+    QVERIFY(memcmp(data, stream.constData(), 300) == 0);
+    qgc_shm_consume(&segment->from_gcs, contiguous);
+
+    // Nobody reads, the ring fills up and writes are dropped
+    for (uint32_t i = 0; i <= QGC_SHM_RING_SIZE / 300; i++)
+    {
+        link.writeBytes(stream.constData(), 300);
+    }
+    QCOMPARE(link.getDroppedWrites(), quint64(1));
+
+    // The link created the segment and removes it
+    link.disconnect();
+    qgc_shm_close(segment);
+    QVERIFY(qgc_shm_open(name.toLocal8Bit().constData(), 0) == NULL);
+
+    QByteArray received;
+    for (int i = 0; i < spy.count(); i++)
+    {
+        const QByteArray block = spy.at(i).at(1).toByteArray();
+        QCOMPARE(block.capacity(), block.size());
+        received.append(block);
+    }
+    QVERIFY(received == stream);
+
+    // A segment created by the simulator stays
+    segment = qgc_shm_open(name.toLocal8Bit().constData(), 1);
+    QVERIFY(segment != NULL);
+    QVERIFY(link.connect());
+    link.disconnect();
+    qgc_shm_close(segment);
+    segment = qgc_shm_open(name.toLocal8Bit().constData(), 0);
+    QVERIFY(segment != NULL);
+    qgc_shm_close(segment);
+    shm_unlink(name.toLocal8Bit().constData());
+#else
+    QSKIP("Needs POSIX shared memory", SkipAll);
+#endif
+}
+
+/**
+ * The simulation link has to reach a target data rate far above what the
+ * former 2048 bytes per loop allowed, in few large blocks.
+ */
+void CommBenchmarkTest::simulationLoad_test()
+{
+    const int target = 2000000;
+    MAVLinkSimulationLink link("");
+    link.setLoopInterval(1);
+    link.setTargetDataRate(target);
+    QCOMPARE(link.getTargetDataRate(), target);
+    QSignalSpy spy(&link, SIGNAL(bytesReceived(LinkInterface*, QByteArray)));
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    link.connect();
+    QTest::qWait(1000);
+    link.disconnect();
+    const double seconds = elapsed.nsecsElapsed() / 1e9;
+    const double rate = link.getEmittedBytes() / seconds;
+
+    qDebug() << "Bytes per second:" << rate << "blocks:" << spy.count();
+    QVERIFY(rate > target * 0.5);
+    QVERIFY(rate < target * 1.5);
+    QVERIFY(spy.count() > 0);
+    QVERIFY(link.getEmittedBytes() / spy.count() > 1000);
+    for (int i = 0; i < spy.count(); i++)
+    {
+        const QByteArray block = spy.at(i).at(1).toByteArray();
+        QCOMPARE(block.capacity(), block.size());
+    }
+}
+
+/**
+ * The same seed has to give the same stream, the losses have to show up
+ * as gaps in the sequence numbers of the vehicles.
+ */
+void CommBenchmarkTest::swarmGenerator_test()
+{
+    const int vehicles = 300;
+    MAVLinkSwarmSimulationLink first;
+    MAVLinkSwarmSimulationLink second;
+    QList<MAVLinkSwarmSimulationLink*> links;
+    links << &first << &second;
+    foreach (MAVLinkSwarmSimulationLink* link, links)
+    {
+        link->setVehicleCount(vehicles);
+        link->setSeed(7);
+        link->setLossRate(0.05);
+        link->setJitter(2000);
+        link->reset();
+    }
+
+    QByteArray firstStream, secondStream;
+    // Generating in different steps must not change the stream
+    for (int ms = 100; ms <= 2000; ms += 100)
+    {
+        first.generate(ms * 1000, &firstStream);
+    }
+    second.generate(2000000, &secondStream);
+    QCOMPARE(firstStream, secondStream);
+
+    const quint64 generated = first.getGeneratedMessages();
+    const quint64 dropped = first.getDroppedMessages();
+    QVERIFY(generated > 0);
+    const double loss = double(dropped) / (generated + dropped);
+    QVERIFY(loss > 0.03 && loss < 0.07);
+
+    MAVLinkFrameScanner scanner;
+    scanner.setInput(firstStream.constData(), firstStream.size());
+    QHash<int, int> lastSeq;
+    quint64 gaps = 0;
+    mavlink_message_t message;
+    while (scanner.nextMessage(&message))
+    {
+        const int key = (message.sysid << 8) | message.compid;
+        const int expected = lastSeq.value(key, -1) + 1;
+        gaps += quint8(message.seq - expected);
+        lastSeq.insert(key, message.seq);
+    }
+    QCOMPARE(scanner.getParseErrors(), quint64(0));
+    QCOMPARE(scanner.getReceivedFrames(), generated);
+    QCOMPARE(lastSeq.size(), vehicles);
+    QCOMPARE(gaps, dropped);
+
+    // Another seed gives another stream
+    second.setSeed(8);
+    second.reset();
+    secondStream.clear();
+    second.generate(2000000, &secondStream);
+    QVERIFY(firstStream != secondStream);
+}
+
+/**
+ * The counters have to end up in the totals and in the per-second history,
+ * which keeps the last LINK_STATISTICS_HISTORY samples in order.
+ */
+void CommBenchmarkTest::linkStatistics_test()
+{
+    LinkStatistics statistics;
+    statistics.countReceived(100);
+    statistics.countReceived(200, 2);
+    statistics.countSent(50);
+    statistics.countForwarded(70);
+    // Counted bytes are visible before they are sampled
+    QCOMPARE(statistics.getReceivedBytes(), quint64(300));
+    QCOMPARE(statistics.getReceivedPackets(), quint64(3));
+    QCOMPARE(statistics.getForwardedBytes(), quint64(70));
+    QCOMPARE(statistics.getHistorySize(), 0);
+
+    QSignalSpy spy(&statistics, SIGNAL(sampled()));
+    statistics.sample();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(statistics.getReceivedBytes(), quint64(300));
+    QCOMPARE(statistics.getSentBytes(), quint64(50));
+    QCOMPARE(statistics.getSentPackets(), quint64(1));
+    QCOMPARE(statistics.getForwardedBytes(), quint64(70));
+    QCOMPARE(statistics.getHistorySize(), 1);
+    const LinkTrafficSample first = statistics.getHistory(1).first();
+    QCOMPARE(first.receivedBytes, quint32(300));
+    QCOMPARE(first.sentPackets, quint32(1));
+    QVERIFY(first.interval > 0);
+    const LinkTrafficRate rate = statistics.getRate();
+    QCOMPARE(rate.receivedBytes, 300 * 1000.0 / first.interval);
+    QCOMPARE(rate.receivedBytes / rate.sentBytes, 6.0);
+
+    // Wrap the ring, the oldest samples are overwritten
+    for (int i = 1; i <= LINK_STATISTICS_HISTORY + 10; i++)
+    {
+        statistics.countReceived(i);
+        statistics.sample();
+    }
+    QCOMPARE(statistics.getHistorySize(), LINK_STATISTICS_HISTORY);
+    QVector<LinkTrafficSample> history = statistics.getHistory();
+    QCOMPARE(history.size(), LINK_STATISTICS_HISTORY);
+    QCOMPARE(history.first().receivedBytes, quint32(11));
+    QCOMPARE(history.last().receivedBytes, quint32(LINK_STATISTICS_HISTORY + 10));
+    history = statistics.getHistory(3);
+    QCOMPARE(history.size(), 3);
+    QCOMPARE(history.at(0).receivedBytes, quint32(LINK_STATISTICS_HISTORY + 8));
+    QCOMPARE(history.at(2).receivedBytes, quint32(LINK_STATISTICS_HISTORY + 10));
+    QVERIFY(statistics.getMaxRate().receivedBytes >= statistics.getRate().receivedBytes);
+
+    statistics.reset();
+    QCOMPARE(statistics.getReceivedBytes(), quint64(0));
+    QCOMPARE(statistics.getForwardedBytes(), quint64(0));
+    QCOMPARE(statistics.getHistorySize(), 0);
+    QCOMPARE(statistics.getRate().receivedBytes, 0.0);
+}
+
+/**
+ * Probes three pseudo terminals in parallel: one fed with heartbeats, one
+ * fed with bytes which contain start signs but no valid frame and a silent
+ * one. Only the first one may be found. Pseudo terminals ignore the baud
+ * rate, so the first rate tried is confirmed.
+ */
+void CommBenchmarkTest::serialDiscovery_test()
+{
+#if defined(Q_OS_UNIX)
+    int masters[3];
+    QStringList ports;
+    for (int i = 0; i < 3; i++)
+    {
+        masters[i] = posix_openpt(O_RDWR | O_NOCTTY);
+        QVERIFY(masters[i] >= 0);
+        QVERIFY(grantpt(masters[i]) == 0 && unlockpt(masters[i]) == 0);
+        ports << QString(ptsname(masters[i]));
+    }
+
+    QByteArray heartbeat;
+    mavlink_message_t message;
+    mavlink_msg_heartbeat_pack(42, MAV_COMP_ID_IMU, &message, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_GENERIC, 0, 0, MAV_STATE_ACTIVE);
+    appendFrame(heartbeat, message);
+    QByteArray garbage = heartbeat;
+    // Broken CRC
+    garbage[garbage.size() - 1] = garbage.at(garbage.size() - 1) ^ 0x55;
+
+    SerialPortDiscovery discovery;
+    const int timeout = 300;
+    discovery.setTimeout(timeout);
+    QCOMPARE(discovery.getTimeout(), timeout);
+    QSignalSpy found(&discovery, SIGNAL(portFound(QString,int,int)));
+    QSignalSpy finished(&discovery, SIGNAL(finished()));
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    discovery.start(ports);
+    QVERIFY(discovery.isRunning());
+    while (finished.count() == 0 && elapsed.elapsed() < 10000)
+    {
+        // Writes fail once a probe closed its port
+        ssize_t written = write(masters[0], heartbeat.constData(), heartbeat.size());
+        written = write(masters[1], garbage.constData(), garbage.size());
+        Q_UNUSED(written);
+        QTest::qWait(20);
+    }
+    const qint64 duration = elapsed.elapsed();
+    for (int i = 0; i < 3; i++)
+    {
+        close(masters[i]);
+    }
+
+    QCOMPARE(finished.count(), 1);
+    QVERIFY(!discovery.isRunning());
+    QCOMPARE(found.count(), 1);
+    QCOMPARE(found.at(0).at(0).toString(), ports.at(0));
+    const QList<SerialPortDiscoveryResult> results = discovery.getResults();
+    QCOMPARE(results.size(), 1);
+    QCOMPARE(results.first().portName, ports.at(0));
+    QCOMPARE(results.first().baudRate, SerialPortDiscovery::defaultBaudRates().first());
+    QCOMPARE(results.first().systemId, 42);
+
+    // The ports were probed in parallel, not one after the other
+    const int rates = discovery.getBaudRates().size();
+    qDebug() << "Discovery took" << duration << "ms";
+    QVERIFY(duration < 2 * rates * timeout);
+#else
+    QSKIP("Needs a POSIX pseudo terminal", SkipAll);
+#endif
+}
+
+/**
+ * A state answered by controls fills all stages, controls without a new
+ * state only count as sent.
+ */
+void CommBenchmarkTest::hilLatency_test()
+{
+    QCOMPARE(QGCHilLatency::latencyBin(0), 0);
+    QCOMPARE(QGCHilLatency::latencyBin(1), 1);
+    QCOMPARE(QGCHilLatency::latencyBin(1000), 10);
+    QCOMPARE(QGCHilLatency::latencyBin(Q_INT64_C(1) << 40), HIL_LATENCY_BINS - 1);
+
+    QGCHilLatency latency;
+    const qint64 received = latency.now();
+    latency.stateEmitted(received, received + 100);
+    const qint64 controls = latency.controlsReceived();
+    QVERIFY(controls >= received);
+    latency.controlsSent(controls, controls + 300);
+    // Not attributed to a state
+    latency.controlsSent(latency.controlsReceived(), controls + 500);
+
+    QGCHilLatencySample parse = latency.getSample(QGCHilLatency::STAGE_PARSE);
+    QCOMPARE(parse.count, quint64(1));
+    QCOMPARE(parse.mean, qint64(100));
+    QCOMPARE(parse.histogram.at(QGCHilLatency::latencyBin(100)), quint32(1));
+    QCOMPARE(parse.percentile(0.5), qint64(128));
+    QCOMPARE(latency.getSample(QGCHilLatency::STAGE_AUTOPILOT).count, quint64(1));
+    QCOMPARE(latency.getSample(QGCHilLatency::STAGE_SEND).count, quint64(2));
+    QGCHilLatencySample loop = latency.getSample(QGCHilLatency::STAGE_LOOP);
+    QCOMPARE(loop.count, quint64(1));
+    QCOMPARE(loop.max, controls + 300 - received);
+
+    latency.reset();
+    QCOMPARE(latency.getSample(QGCHilLatency::STAGE_LOOP).count, quint64(0));
+    QCOMPARE(latency.getSample(QGCHilLatency::STAGE_LOOP).percentile(0.99), qint64(0));
+}
+
+/**
+ * Runs the X-Plane link against the loopback simulator, which also stands
+ * in for the autopilot. The attitude has to make the full round trip and
+ * every stage of the loop has to be measured.
+ */
+void CommBenchmarkTest::xplaneLoopback_test()
+{
+    MAVLinkProtocol protocol;
+    UAS uas(&protocol, 1);
+    uas.enableHilXPlane(false);
+    QGCXPlaneLink* link = dynamic_cast<QGCXPlaneLink*>(uas.getHILSimulation());
+    QVERIFY(link);
+    link->setVersion(10);
+
+    QGCXPlaneLoopback simulator;
+    QVERIFY(simulator.bind(QHostAddress::LocalHost, 0));
+    link->setRemoteHost(QString("127.0.0.1:%1").arg(simulator.getPort()));
+    // Any free local port, the simulator answers the sender of the ISET datagram
+    link->setPort(0);
+    QVERIFY(link->isConnected());
+    // The stub answers the states instead of the vehicle
+    QObject::disconnect(link, SIGNAL(hilStateChanged(uint64_t,float,float,float,float,float,float,int32_t,int32_t,int32_t,int16_t,int16_t,int16_t,int16_t,int16_t,int16_t)), &uas, 0);
+    simulator.setAutopilot(link);
+
+    simulator.setAttitude(10.0f, -5.0f, 90.0f);
+    simulator.start(100);
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while (simulator.getControlsReceived() < 20 && elapsed.elapsed() < 5000)
+    {
+        QTest::qWait(10);
+    }
+    simulator.stop();
+    QVERIFY(simulator.getControlsReceived() >= 20);
+
+    float aileron, elevator, rudder;
+    simulator.getControls(&aileron, &elevator, &rudder);
+    QVERIFY(qAbs(aileron - 10.0f / 180.0f * M_PI) < 1e-4);
+    QVERIFY(qAbs(elevator + 5.0f / 180.0f * M_PI) < 1e-4);
+    QVERIFY(qAbs(rudder - M_PI / 2.0) < 1e-4);
+
+    for (int stage = 0; stage < QGCHilLatency::STAGE_COUNT; stage++)
+    {
+        QGCHilLatencySample sample = link->getLatency()->getSample(static_cast<QGCHilLatency::Stage>(stage));
+        qDebug() << QGCHilLatency::getStageName(static_cast<QGCHilLatency::Stage>(stage))
+                 << "mean" << sample.mean << "us, 99%" << sample.percentile(0.99) << "us, max" << sample.max << "us";
+        QVERIFY(sample.count > 0);
+    }
+    QGCHilLatencySample roundTrip = simulator.getLatency()->getSample(QGCHilLatency::STAGE_LOOP);
+    qDebug() << "Round trip mean" << roundTrip.mean << "us";
+    QVERIFY(roundTrip.count > 0);
+
+    link->disconnectSimulation();
+    QVERIFY(!link->isConnected());
+}
+
+/** @brief FGNetFDM datagram as FlightGear sends it */
+static QByteArray createFDMDatagram()
+{
+    FGNetFDM fdm;
+    memset(&fdm, 0, sizeof(fdm));
+    fdm.version = FG_NET_FDM_VERSION;
+    fdm.latitude = 47.3977 / 180.0 * M_PI;
+    fdm.longitude = 8.5456 / 180.0 * M_PI;
+    fdm.altitude = 500.0;
+    fdm.phi = 0.1f;
+    fdm.theta = -0.2f;
+    fdm.psi = 3.0f;
+    fdm.psidot = 0.05f;
+    fdm.v_north = 10.0f;
+    fdm.A_Z_pilot = -32.174f;
+    fdm.num_engines = 1;
+    fdm.rpm[0] = 5000.0f;
+    fdm.rudder = 0.25f;
+    QGCFlightGearNet::convertByteOrder(&fdm);
+    return QByteArray(reinterpret_cast<const char*>(&fdm), sizeof(fdm));
+}
+
+/**
+ * The structs have to match the layout of FlightGear, fields have to be
+ * converted to and from network byte order.
+ */
+void CommBenchmarkTest::flightGearNet_test()
+{
+    QCOMPARE(int(sizeof(FGNetFDM)), 408);
+    QCOMPARE(int(sizeof(FGNetCtrls)), 744);
+
+    QByteArray datagram = createFDMDatagram();
+    // Version in network byte order
+    QCOMPARE(quint8(datagram.at(3)), quint8(FG_NET_FDM_VERSION));
+    QGCHilState state;
+    QVERIFY(QGCFlightGearNet::parseFDM(datagram.constData(), datagram.size(), &state));
+    QVERIFY(qAbs(state.lat - 47.3977) < 1e-9);
+    QVERIFY(qAbs(state.lon - 8.5456) < 1e-9);
+    QCOMPARE(state.alt, 500.0);
+    QCOMPARE(state.roll, 0.1f);
+    QCOMPARE(state.pitch, -0.2f);
+    QCOMPARE(state.yaw, 3.0f);
+    QCOMPARE(state.yawspeed, 0.05f);
+    QVERIFY(qAbs(state.vx - 3.048f) < 1e-5);
+    QVERIFY(qAbs(state.zacc + 9.80665f) < 1e-3);
+
+    // The last field has to survive the conversion
+    FGNetFDM fdm;
+    memcpy(&fdm, datagram.constData(), sizeof(fdm));
+    QGCFlightGearNet::convertByteOrder(&fdm);
+    QCOMPARE(fdm.rudder, 0.25f);
+    QCOMPARE(fdm.rpm[0], 5000.0f);
+
+    QVERIFY(!QGCFlightGearNet::parseFDM(datagram.constData(), datagram.size() - 1, &state));
+    datagram[3] = char(FG_NET_FDM_VERSION + 1);
+    QVERIFY(!QGCFlightGearNet::parseFDM(datagram.constData(), datagram.size(), &state));
+
+    FGNetCtrls ctrls;
+    QGCFlightGearNet::initControls(&ctrls, 4);
+    ctrls.throttle[3] = 0.5;
+    ctrls.speedup = 1;
+    FGNetCtrls packet = ctrls;
+    QGCFlightGearNet::convertByteOrder(&packet);
+    const uchar* bytes = reinterpret_cast<const uchar*>(&packet);
+    QCOMPARE(qFromBigEndian<quint32>(bytes), quint32(FG_NET_CTRLS_VERSION));
+    QCOMPARE(qFromBigEndian<quint32>(bytes + offsetof(FGNetCtrls, speedup)), quint32(1));
+    QCOMPARE(qFromBigEndian<quint32>(bytes + offsetof(FGNetCtrls, num_engines)), quint32(4));
+    QGCFlightGearNet::convertByteOrder(&packet);
+    QVERIFY(memcmp(&packet, &ctrls, sizeof(ctrls)) == 0);
+}
+
+void CommBenchmarkTest::flightGearParse_benchmark_data()
+{
+    QTest::addColumn<bool>("binary");
+    QTest::newRow("text") << false;
+    QTest::newRow("native") << true;
+}
+
+/**
+ * Parse cost of one state in the generic text protocol and in FGNetFDM.
+ */
+void CommBenchmarkTest::flightGearParse_benchmark()
+{
+    QFETCH(bool, binary);
+
+    QByteArray datagram;
+    if (binary)
+    {
+        datagram = createFDMDatagram();
+    }
+    else
+    {
+        // As defined by qgroundcontrol-fixed-wing.xml
+        datagram = QString("12.3456\t%1\t%2\t%3\t%4\t%5\t%6\t%7\t%8\t%9\t0.01000\t0.02000\t-9.80665\t3.04800000\t0.00000000\t0.00000000\t15.43333333\n")
+                   .arg(47.3977, 0, 'f', 18).arg(8.5456, 0, 'f', 18).arg(500.0, 0, 'f', 5)
+                   .arg(0.1, 0, 'f', 5).arg(-0.2, 0, 'f', 5).arg(3.0, 0, 'f', 5)
+                   .arg(0.0, 0, 'f', 6).arg(0.0, 0, 'f', 6).arg(0.05, 0, 'f', 6).toAscii();
+    }
+
+    QGCHilState state;
+    int parsed = 0;
+    QBENCHMARK
+    {
+        parsed = 0;
+        for (int i = 0; i < 1000; i++)
+        {
+            bool ok = binary ? QGCFlightGearNet::parseFDM(datagram.constData(), datagram.size(), &state)
+                             : QGCFlightGearNet::parseText(datagram.constData(), datagram.size(), &state);
+            if (ok) parsed++;
+        }
+    }
+    QCOMPARE(parsed, 1000);
+    QVERIFY(qAbs(state.lat - 47.3977) < 1e-6);
+    QCOMPARE(state.roll, 0.1f);
+}
+
+/**
+ * Indexes a log with variable length records and a corrupted region,
+ * checks the lookups and the reuse of the sidecar file
+ */
+void CommBenchmarkTest::logIndex_test()
+{
+    QString fileName = QDir::tempPath() + "/qgc_logindex_test.mavlink";
+    QFile::remove(MAVLinkLogIndex::indexFileName(fileName));
+
+    QList<qint64> offsets;
+    QByteArray data = createLog(sent, true, &offsets);
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(data), qint64(data.size()));
+    file.close();
+
+    MAVLinkLogIndex index;
+    index.build(fileName);
+    QVERIFY(index.wait(30000));
+    QVERIFY(index.isReady());
+    QVERIFY(!index.isLoadedFromFile());
+    QCOMPARE(index.count(), sent.size());
+    QVERIFY(index.getResyncs() > 0);
+    for (int i = 0; i < index.count(); i++)
+    {
+        QCOMPARE(index.offset(i), offsets.at(i));
+        QCOMPARE(index.time(i), quint64(1000000 + i * 1000));
+    }
+    QCOMPARE(index.startTime(), quint64(1000000));
+    QCOMPARE(index.endTime(), quint64(1000000 + (sent.size() - 1) * 1000));
+
+    // Binary searches by time and by offset
+    QCOMPARE(index.findTime(0), 0);
+    QCOMPARE(index.findTime(1000000 + 2500 * 1000), 2500);
+    QCOMPARE(index.findTime(1000000 + 2500 * 1000 + 1), 2501);
+    QCOMPARE(index.findTime(quint64(-1)), index.count());
+    QCOMPARE(index.findOffset(offsets.at(5000) + 1), 5001);
+
+    // The sidecar is reused for the unchanged log
+    QVERIFY(QFile::exists(MAVLinkLogIndex::indexFileName(fileName)));
+    index.build(fileName);
+    QVERIFY(index.wait(30000));
+    QVERIFY(index.isReady());
+    QVERIFY(index.isLoadedFromFile());
+    QCOMPARE(index.count(), sent.size());
+    QCOMPARE(index.offset(sent.size() - 1), offsets.last());
+
+    // ..but not once the log changed
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Append));
+    quint64 time = 1000000 + sent.size() * 1000;
+    QByteArray record(reinterpret_cast<const char*>(&time), sizeof(time));
+    appendFrame(record, sent.first());
+    file.write(record);
+    file.close();
+    index.build(fileName);
+    QVERIFY(index.wait(30000));
+    QVERIFY(index.isReady());
+    QVERIFY(!index.isLoadedFromFile());
+    QCOMPARE(index.count(), sent.size() + 1);
+    QCOMPARE(index.endTime(), time);
+
+    QFile::remove(MAVLinkLogIndex::indexFileName(fileName));
+    QFile::remove(fileName);
+}
+
+/**
+ * Reads a log with a corrupted region, the frames have to be views into
+ * the mapping and the reader has to resynchronize behind the garbage
+ */
+void CommBenchmarkTest::logReader_test()
+{
+    QString fileName = QDir::tempPath() + "/qgc_logreader_test.mavlink";
+    QList<qint64> offsets;
+    QByteArray data = createLog(sent, true, &offsets);
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(data), qint64(data.size()));
+    file.close();
+
+    MAVLinkLogReader reader;
+    QVERIFY(!reader.next(NULL));
+    QVERIFY(reader.open(fileName));
+    QCOMPARE(reader.size(), qint64(data.size()));
+    QVERIFY(reader.isMappedCompletely());
+
+    MAVLinkLogFrame frame;
+    const char* previous = NULL;
+    int records = 0;
+    while (reader.next(&frame))
+    {
+        QVERIFY(records < sent.size());
+        QCOMPARE(frame.offset, offsets.at(records));
+        QCOMPARE(frame.time, quint64(1000000 + records * 1000));
+        QCOMPARE(frame.bytes(), data.mid(frame.offset + MAVLinkLogReader::timeLen, frame.length));
+        // Views of consecutive records point into the same mapping
+        QVERIFY(previous == NULL || frame.data > previous);
+        previous = frame.data;
+        records++;
+    }
+    QCOMPARE(records, sent.size());
+    QCOMPARE(reader.getResyncs(), 1);
+    QVERIFY(reader.atEnd());
+
+    // Seeking to a record offset continues there
+    QVERIFY(reader.seek(offsets.at(1234)));
+    QVERIFY(reader.next(&frame));
+    QCOMPARE(frame.offset, offsets.at(1234));
+    QVERIFY(!reader.seek(data.size() + 1));
+
+    reader.close();
+    QVERIFY(!reader.isOpen());
+    QFile::remove(fileName);
+}
+
+void CommBenchmarkTest::logReader_benchmark_data()
+{
+    QTest::addColumn<bool>("mapped");
+
+    QTest::newRow("QFile") << false;
+    QTest::newRow("mapped") << true;
+}
+
+/**
+ * Replays a log into a frame scanner as the log player feeds MAVLinkProtocol,
+ * once with buffered QFile reads and once from the mapping. Set
+ * QGC_BENCHMARK_LOG to use a recorded log instead of the generated 32 MB.
+ */
+void CommBenchmarkTest::logReader_benchmark()
+{
+    QFETCH(bool, mapped);
+
+    QString fileName = QString::fromLocal8Bit(qgetenv("QGC_BENCHMARK_LOG"));
+    const bool generated = fileName.isEmpty();
+    if (generated)
+    {
+        fileName = QDir::tempPath() + "/qgc_logreader_benchmark.mavlink";
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        QByteArray data = createLog(sent, false);
+        while (file.size() < 32 * 1024 * 1024)
+        {
+            QCOMPARE(file.write(data), qint64(data.size()));
+        }
+        file.close();
+    }
+
+    MAVLinkFrameScanner scanner;
+    mavlink_message_t message;
+    int frames = 0;
+    QBENCHMARK
+    {
+        frames = 0;
+        scanner.reset();
+        if (mapped)
+        {
+            MAVLinkLogReader reader;
+            QVERIFY(reader.open(fileName));
+            MAVLinkLogFrame frame;
+            while (reader.next(&frame))
+            {
+                QByteArray packet = frame.bytes();
+                scanner.setInput(packet.constData(), packet.size());
+                while (scanner.nextMessage(&message)) frames++;
+            }
+        }
+        else
+        {
+            QFile file(fileName);
+            QVERIFY(file.open(QIODevice::ReadOnly));
+            char header[MAVLinkLogReader::timeLen + 2];
+            while (file.peek(header, sizeof(header)) == sizeof(header))
+            {
+                QByteArray time = file.read(MAVLinkLogReader::timeLen);
+                Q_UNUSED(time);
+                QByteArray packet = file.read(MAVLinkFrameScanner::frameLength(header[MAVLinkLogReader::timeLen + 1]));
+                scanner.setInput(packet.constData(), packet.size());
+                while (scanner.nextMessage(&message)) frames++;
+            }
+        }
+    }
+    QVERIFY(frames > 0);
+    QCOMPARE(scanner.getParseErrors(), quint64(0));
+
+    if (generated)
+    {
+        QFile::remove(fileName);
+    }
+}
+
+/**
+ * Replays a log unpaced into vehicles created beforehand, so no heartbeat
+ * creates a vehicle through the factory
+ */
+void CommBenchmarkTest::logReplay_test()
+{
+    QString fileName = QDir::tempPath() + "/qgc_logreplay_test.mavlink";
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QByteArray data = createLog(sent, false);
+    QCOMPARE(file.write(data), qint64(data.size()));
+    file.close();
+
+    MAVLinkProtocol protocol;
+    protocol.enableLogging(false);
+    UASManager* manager = UASManager::instance();
+    QList<UAS*> systems;
+    for (int i = 1; i <= 3; i++)
+    {
+        UAS* uas = new UAS(&protocol, i);
+        manager->addUAS(uas);
+        systems.append(uas);
+    }
+    CountingSubscriber counter;
+    protocol.getDispatcher()->subscribeAll(&counter);
+
+    RecordingLink link;
+    MAVLinkLogReplay replay(&protocol);
+    QSignalSpy finished(&replay, SIGNAL(finished()));
+    QVERIFY(!replay.start(fileName + ".missing", &link));
+    QVERIFY(replay.start(fileName, &link));
+    QVERIFY(replay.isRunning());
+    for (int i = 0; i < 1000 && replay.isRunning(); i++)
+    {
+        QTest::qWait(10);
+    }
+    QVERIFY(!replay.isRunning());
+    QCOMPARE(finished.count(), 1);
+    QCOMPARE(replay.getFrames(), quint64(sent.size()));
+    QCOMPARE(counter.count, sent.size());
+
+    // The stages add up to the wall clock time
+    QList<MAVLinkLogReplay::Stage> stages = replay.getStages();
+    QVERIFY(stages.size() >= 4);
+    QCOMPARE(stages.first().name, QString("read"));
+    QCOMPARE(stages.at(1).name, QString("protocol"));
+    QCOMPARE(stages.last().name, QString("other"));
+    qint64 total = 0;
+    bool counted = false;
+    foreach (const MAVLinkLogReplay::Stage& stage, stages)
+    {
+        total += stage.time;
+        if (stage.name == "counter") counted = true;
+    }
+    QVERIFY(counted);
+    QCOMPARE(total, replay.getElapsed());
+    QVERIFY(replay.getFrameRate() > 0.0);
+    QVERIFY(replay.getReport().contains("protocol"));
+
+    protocol.getDispatcher()->unsubscribe(&counter);
+    foreach (UAS* uas, systems)
+    {
+        manager->removeUAS(uas);
+        delete uas;
+    }
+    QFile::remove(fileName);
+}
+
+/**
+ * Paces the 10 s of the generated log at 20 times the real time. Pausing
+ * holds the stream, a seek and a speed change apply to the running replay.
+ */
+void CommBenchmarkTest::logPacer_test()
+{
+    QString fileName = QDir::tempPath() + "/qgc_logpacer_test.mavlink";
+    QList<qint64> offsets;
+    QByteArray data = createLog(sent, false, &offsets);
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(data), qint64(data.size()));
+    file.close();
+
+    RecordingLink link;
+    MAVLinkLogPacer pacer;
+    QSignalSpy bytes(&pacer, SIGNAL(bytesReady(LinkInterface*, QByteArray)));
+    QSignalSpy end(&pacer, SIGNAL(endReached()));
+    pacer.setSpeed(20.0);
+    QVERIFY(!pacer.start(fileName + ".missing", &link));
+
+    QElapsedTimer clock;
+    clock.start();
+    QVERIFY(pacer.start(fileName, &link));
+    for (int i = 0; i < 500 && end.isEmpty(); i++)
+    {
+        QTest::qWait(10);
+    }
+    QCOMPARE(end.count(), 1);
+    QVERIFY(clock.elapsed() >= 450);
+    QCOMPARE(pacer.getFrames(), quint64(sent.size()));
+    // Frames due at the same time are released together
+    QVERIFY(pacer.getBatches() < pacer.getFrames());
+    QVERIFY(pacer.getMeanDrift() <= pacer.getMaxDrift());
+    int total = 0;
+    foreach (const QList<QVariant>& arguments, bytes)
+    {
+        total += arguments.at(1).toByteArray().size();
+    }
+    QCOMPARE(total, data.size() - sent.size() * MAVLinkLogReader::timeLen);
+
+    QVERIFY(pacer.start(fileName, &link));
+    QTest::qWait(100);
+    pacer.pause();
+    QVERIFY(pacer.isPaused());
+    // Batches released before the pause are still delivered
+    QTest::qWait(50);
+    const quint64 frames = pacer.getFrames();
+    QVERIFY(frames > 0 && frames < quint64(sent.size()));
+    QTest::qWait(100);
+    QCOMPARE(pacer.getFrames(), frames);
+
+    pacer.seek(offsets.at(sent.size() - 100));
+    QCOMPARE(pacer.getOffset(), offsets.at(sent.size() - 100));
+    pacer.setSpeed(1.0);
+    pacer.resume();
+    end.clear();
+    clock.restart();
+    for (int i = 0; i < 500 && end.isEmpty(); i++)
+    {
+        QTest::qWait(10);
+    }
+    QCOMPARE(end.count(), 1);
+    QVERIFY(clock.elapsed() >= 90);
+    QCOMPARE(pacer.getFrames(), frames + 100);
+    QCOMPARE(pacer.getOffset(), qint64(data.size()));
+
+    pacer.stop();
+    QFile::remove(fileName);
+}
+
+/**
+ * Converts the generated log into a block log and back. The reader has to
+ * return the same records from the blocks, seeking by time decompresses a
+ * single block and a log without footer is recovered from the blocks.
+ */
+void CommBenchmarkTest::logBlockFile_test()
+{
+    QString rawName = QDir::tempPath() + "/qgc_logblock_test.mavlink";
+    QString blockName = QDir::tempPath() + "/qgc_logblock_test.mavlinkz";
+    QString copyName = QDir::tempPath() + "/qgc_logblock_copy.mavlink";
+    QList<qint64> offsets;
+    QByteArray data = createLog(sent, false, &offsets);
+    QFile file(rawName);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(data), qint64(data.size()));
+    file.close();
+
+    QString error;
+    QVERIFY(!MAVLinkLogBlockFile::convert(rawName + ".missing", blockName, &error));
+    QVERIFY(!error.isEmpty());
+    QVERIFY(MAVLinkLogBlockFile::convert(rawName, blockName, &error));
+    QVERIFY(MAVLinkLogBlockFile::isBlockLog(blockName));
+    QVERIFY(!MAVLinkLogBlockFile::isBlockLog(rawName));
+    QVERIFY(QFileInfo(blockName).size() < data.size());
+
+    MAVLinkLogBlockFile blocks;
+    QVERIFY(blocks.open(blockName));
+    QVERIFY(!blocks.isRecovered());
+    QVERIFY(blocks.count() > 1);
+    QCOMPARE(blocks.rawSize(), qint64(data.size()));
+    QCOMPARE(blocks.startTime(), quint64(1000000));
+    QCOMPARE(blocks.endTime(), quint64(1000000 + (sent.size() - 1) * 1000));
+    quint32 records = 0;
+    for (int i = 0; i < blocks.count(); i++)
+    {
+        // Blocks start at record boundaries of the raw log
+        QVERIFY(offsets.contains(blocks.block(i).rawOffset));
+        QVERIFY(blocks.block(i).rawSize <= quint32(MAVLinkLogBlockFile::blockSize));
+        records += blocks.block(i).records;
+    }
+    QCOMPARE(records, quint32(sent.size()));
+    QByteArray block;
+    QVERIFY(blocks.readBlock(1, &block));
+    QCOMPARE(block, data.mid(blocks.block(1).rawOffset, blocks.block(1).rawSize));
+    blocks.close();
+
+    // The reader sees the uncompressed records
+    MAVLinkLogReader reader;
+    QVERIFY(reader.open(blockName));
+    QVERIFY(reader.isBlockLog());
+    QCOMPARE(reader.size(), qint64(data.size()));
+    MAVLinkLogFrame frame;
+    int count = 0;
+    while (reader.next(&frame))
+    {
+        QCOMPARE(frame.offset, offsets.at(count));
+        QCOMPARE(frame.bytes(), data.mid(frame.offset + MAVLinkLogReader::timeLen, frame.length));
+        count++;
+    }
+    QCOMPARE(count, sent.size());
+    QCOMPARE(reader.getResyncs(), 0);
+
+    QVERIFY(reader.seekTime(1000000 + 7000 * 1000));
+    QVERIFY(reader.next(&frame));
+    QCOMPARE(frame.offset, offsets.at(7000));
+    QVERIFY(reader.seek(offsets.at(1234)));
+    QVERIFY(reader.next(&frame));
+    QCOMPARE(frame.time, quint64(1000000 + 1234 * 1000));
+    QVERIFY(reader.seekTime(quint64(-1)));
+    QVERIFY(reader.atEnd());
+    reader.close();
+
+    // Converting back restores the raw log
+    QVERIFY(MAVLinkLogBlockFile::convert(blockName, copyName, &error));
+    QFile copy(copyName);
+    QVERIFY(copy.open(QIODevice::ReadOnly));
+    QVERIFY(copy.readAll() == data);
+    copy.close();
+
+    // A failed conversion leaves the destination and the source untouched
+    QString binName = QDir::tempPath() + "/qgc_logblock_test.bin";
+    QFile bin(binName);
+    QVERIFY(bin.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    for (int i = 0; i < 4096; i++)
+    {
+        bin.putChar(char(i * 7 + 3));
+    }
+    bin.close();
+    QVERIFY(!MAVLinkLogBlockFile::convert(binName, copyName, &error));
+    QVERIFY(!error.isEmpty());
+    QVERIFY(!MAVLinkLogBlockFile::convert(rawName + ".missing", copyName, &error));
+    QVERIFY(!MAVLinkLogBlockFile::convert(copyName, copyName, &error));
+    QVERIFY(!QFile::exists(copyName + ".part"));
+    QVERIFY(copy.open(QIODevice::ReadOnly));
+    QVERIFY(copy.readAll() == data);
+    copy.close();
+    QFile::remove(binName);
+
+    // Without the footer the blocks are found by walking the file
+    QFile truncated(blockName);
+    QVERIFY(truncated.open(QIODevice::ReadWrite));
+    QVERIFY(truncated.resize(truncated.size() - 1));
+    truncated.close();
+    QVERIFY(blocks.open(blockName));
+    QVERIFY(blocks.isRecovered());
+    QCOMPARE(blocks.rawSize(), qint64(data.size()));
+    QCOMPARE(blocks.endTime(), quint64(1000000 + (sent.size() - 1) * 1000));
+    blocks.close();
+
+    // The writer compresses logs with the block log suffix
+    QFile::remove(blockName);
+    MAVLinkLogWriter writer;
+    QVERIFY(writer.startLogging(blockName));
+    QVERIFY(writer.isCompressed());
+    for (int i = 0; i < sent.size(); i++)
+    {
+        writer.append(i, sent.at(i));
+    }
+    writer.stopLogging();
+    QCOMPARE(writer.getWriteErrors(), 0);
+    QVERIFY(blocks.open(blockName));
+    QVERIFY(!blocks.isRecovered());
+    records = 0;
+    for (int i = 0; i < blocks.count(); i++)
+    {
+        records += blocks.block(i).records;
+    }
+    QCOMPARE(records, quint32(writer.getWrittenPackets()));
+    blocks.close();
+
+    QFile::remove(rawName);
+    QFile::remove(blockName);
+    QFile::remove(copyName);
+}
@@ -0,0 +1,90 @@
+#ifndef COMMBENCHMARKTEST_H
+#define COMMBENCHMARKTEST_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QtTest/QtTest>
+
+#include "QGCMAVLink.h"
+#include "AutoTest.h"
+
+/**
+ * @brief Correctness tests and throughput benchmarks of the communication path
+ *
+ * The benchmarks run with the usual QtTest options, e.g. -tickcounter or
+ * -iterations, and report the time per processed stream.
+ */
+class CommBenchmarkTest : public QObject
+{
+    Q_OBJECT
+public:
+  CommBenchmarkTest();
+
+private slots:
+  void initTestCase();
+
+  void scannerBlockSize_test_data();
+  void scannerBlockSize_test();
+  void scannerCorruption_test();
+  void scannerSkip_test();
+  void scannerThroughput_benchmark_data();
+  void scannerThroughput_benchmark();
+  void spscQueue_test();
+  void parserWorker_test();
+  void parserThread_test();
+  void messagePool_test();
+  void messageFanOut_benchmark_data();
+  void messageFanOut_benchmark();
+  void dispatcher_test();
+  void dispatcher_benchmark();
+  void uasLookup_benchmark_data();
+  void uasLookup_benchmark();
+  void logWriter_test_data();
+  void logWriter_test();
+  void forwardFrame_test();
+  void forwardFrame_benchmark_data();
+  void forwardFrame_benchmark();
+  void statistics_test();
+  void statistics_benchmark();
+  void sendScheduler_test();
+  void sendSchedulerTargets_test();
+  void serialLatency_benchmark_data();
+  void serialLatency_benchmark();
+  void ringBuffer_test();
+  void serialReadBuffer_test();
+  void udpBatch_test();
+  void udpThroughput_benchmark_data();
+  void udpThroughput_benchmark();
+  void endpointTable_test();
+  void sharedMemoryLink_test();
+  void simulationLoad_test();
+  void swarmGenerator_test();
+  void linkStatistics_test();
+  void serialDiscovery_test();
+  void hilLatency_test();
+  void xplaneLoopback_test();
+  void flightGearNet_test();
+  void flightGearParse_benchmark_data();
+  void flightGearParse_benchmark();
+  void logIndex_test();
+  void logReader_test();
+  void logReader_benchmark_data();
+  void logReader_benchmark();
+  void logReplay_test();
+  void logPacer_test();
+  void logBlockFile_test();
+
+private:
+  /** @brief Append a complete frame of the message to the stream */
+  static void appendFrame(QByteArray& stream, const mavlink_message_t& message);
+  /** @brief Build a stream of mixed telemetry messages */
+  static QByteArray createStream(int messages, QList<mavlink_message_t>* sent = NULL);
+  /** @brief Build a MAVLink log of the messages, optionally with garbage in the middle */
+  static QByteArray createLog(const QList<mavlink_message_t>& messages, bool corrupt, QList<qint64>* offsets = NULL);
+
+  QByteArray stream;
+  QList<mavlink_message_t> sent;
+};
+
+DECLARE_TEST(CommBenchmarkTest)
+#endif // COMMBENCHMARKTEST_H
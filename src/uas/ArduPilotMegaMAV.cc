@@ -44,7 +44,7 @@ ArduPilotMegaMAV::ArduPilotMegaMAV(MAVLinkProtocol* mavlink, int id) :
  *             messages can be sent back to the system via this link
  * @param message MAVLink message, as received from the MAVLink protocol stack
  */
-void ArduPilotMegaMAV::receiveMessage(LinkInterface* link, mavlink_message_t message)
+void ArduPilotMegaMAV::receiveMessage(LinkInterface* link, const mavlink_message_t& message)
 {
     // Let UAS handle the default message set
     UAS::receiveMessage(link, message);
@@ -33,7 +33,7 @@ public:
     ArduPilotMegaMAV(MAVLinkProtocol* mavlink, int id = 0);
 public slots:
     /** @brief Receive a MAVLink message from this MAV */
-    void receiveMessage(LinkInterface* link, mavlink_message_t message);
+    void receiveMessage(LinkInterface* link, const mavlink_message_t& message);
 };
 
 #endif // ARDUPILOTMAV_H
@@ -36,11 +36,11 @@ PxQuadMAV::PxQuadMAV(MAVLinkProtocol* mavlink, int id) :
  *             messages can be sent back to the system via this link
  * @param message MAVLink message, as received from the MAVLink protocol stack
  */
-void PxQuadMAV::receiveMessage(LinkInterface* link, mavlink_message_t message)
+void PxQuadMAV::receiveMessage(LinkInterface* link, const mavlink_message_t& message)
 {
     // Only compile this portion if matching MAVLink packets have been compiled
 #ifdef MAVLINK_ENABLED_PIXHAWK
-    mavlink_message_t* msg = &message;
+    const mavlink_message_t* msg = &message;
 
     if (message.sysid == uasId)
     {
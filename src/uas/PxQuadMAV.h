@@ -34,7 +34,7 @@ public:
     PxQuadMAV(MAVLinkProtocol* mavlink, int id);
 public slots:
     /** @brief Receive a MAVLink message from this MAV */
-    void receiveMessage(LinkInterface* link, mavlink_message_t message);
+    void receiveMessage(LinkInterface* link, const mavlink_message_t& message);
 #if defined(QGC_PROTOBUF_ENABLED)
     /** @brief Receive a Protobuf message from this MAV */
     void receiveExtendedMessage(LinkInterface* link, std::tr1::shared_ptr<google::protobuf::Message> message);
@@ -28,8 +28,9 @@ UASInterface* QGCMAVLinkUASFactory::createUAS(MAVLinkProtocol* mavlink, LinkInte
         UAS* mav = new UAS(mavlink, sysid);
         // Set the system type
         mav->setSystemType((int)heartbeat->type);
-        // Connect this robot to the UAS object
-        connect(mavlink, SIGNAL(messageReceived(LinkInterface*, mavlink_message_t)), mav, SLOT(receiveMessage(LinkInterface*, mavlink_message_t)));
+        // Connect this robot to the UAS object, it only receives
+        // the messages of its own system id
+        mavlink->getDispatcher()->subscribeAll(mav, sysid);
 #ifdef QGC_PROTOBUF_ENABLED
         connect(mavlink, SIGNAL(extendedMessageReceived(LinkInterface*, std::tr1::shared_ptr<google::protobuf::Message>)), mav, SLOT(receiveExtendedMessage(LinkInterface*, std::tr1::shared_ptr<google::protobuf::Message>)));
 #endif
@@ -41,11 +42,9 @@ UASInterface* QGCMAVLinkUASFactory::createUAS(MAVLinkProtocol* mavlink, LinkInte
         PxQuadMAV* mav = new PxQuadMAV(mavlink, sysid);
         // Set the system type
         mav->setSystemType((int)heartbeat->type);
-        // Connect this robot to the UAS object
-        // it is IMPORTANT here to use the right object type,
-        // else the slot of the parent object is called (and thus the special
-        // packets never reach their goal)
-        connect(mavlink, SIGNAL(messageReceived(LinkInterface*, mavlink_message_t)), mav, SLOT(receiveMessage(LinkInterface*, mavlink_message_t)));
+        // Connect this robot to the UAS object, it only receives
+        // the messages of its own system id
+        mavlink->getDispatcher()->subscribeAll(mav, sysid);
 #ifdef QGC_PROTOBUF_ENABLED
         connect(mavlink, SIGNAL(extendedMessageReceived(LinkInterface*, std::tr1::shared_ptr<google::protobuf::Message>)), mav, SLOT(receiveExtendedMessage(LinkInterface*, std::tr1::shared_ptr<google::protobuf::Message>)));
 #endif
@@ -57,11 +56,9 @@ UASInterface* QGCMAVLinkUASFactory::createUAS(MAVLinkProtocol* mavlink, LinkInte
         SlugsMAV* mav = new SlugsMAV(mavlink, sysid);
         // Set the system type
         mav->setSystemType((int)heartbeat->type);
-        // Connect this robot to the UAS object
-        // it is IMPORTANT here to use the right object type,
-        // else the slot of the parent object is called (and thus the special
-        // packets never reach their goal)
-        connect(mavlink, SIGNAL(messageReceived(LinkInterface*, mavlink_message_t)), mav, SLOT(receiveMessage(LinkInterface*, mavlink_message_t)));
+        // Connect this robot to the UAS object, it only receives
+        // the messages of its own system id
+        mavlink->getDispatcher()->subscribeAll(mav, sysid);
         uas = mav;
     }
     break;
@@ -70,11 +67,9 @@ UASInterface* QGCMAVLinkUASFactory::createUAS(MAVLinkProtocol* mavlink, LinkInte
         ArduPilotMegaMAV* mav = new ArduPilotMegaMAV(mavlink, sysid);
         // Set the system type
         mav->setSystemType((int)heartbeat->type);
-        // Connect this robot to the UAS object
-        // it is IMPORTANT here to use the right object type,
-        // else the slot of the parent object is called (and thus the special
-        // packets never reach their goal)
-        connect(mavlink, SIGNAL(messageReceived(LinkInterface*, mavlink_message_t)), mav, SLOT(receiveMessage(LinkInterface*, mavlink_message_t)));
+        // Connect this robot to the UAS object, it only receives
+        // the messages of its own system id
+        mavlink->getDispatcher()->subscribeAll(mav, sysid);
         uas = mav;
     }
     break;
@@ -83,7 +78,7 @@ UASInterface* QGCMAVLinkUASFactory::createUAS(MAVLinkProtocol* mavlink, LinkInte
 		{
 			senseSoarMAV* mav = new senseSoarMAV(mavlink,sysid);
 			mav->setSystemType((int)heartbeat->type);
-			connect(mavlink, SIGNAL(messageReceived(LinkInterface*, mavlink_message_t)), mav, SLOT(receiveMessage(LinkInterface*, mavlink_message_t)));
+			mavlink->getDispatcher()->subscribeAll(mav, sysid);
 			uas = mav;
 			break;
 		}
@@ -92,11 +87,9 @@ UASInterface* QGCMAVLinkUASFactory::createUAS(MAVLinkProtocol* mavlink, LinkInte
     {
         UAS* mav = new UAS(mavlink, sysid);
         mav->setSystemType((int)heartbeat->type);
-        // Connect this robot to the UAS object
-        // it is IMPORTANT here to use the right object type,
-        // else the slot of the parent object is called (and thus the special
-        // packets never reach their goal)
-        connect(mavlink, SIGNAL(messageReceived(LinkInterface*, mavlink_message_t)), mav, SLOT(receiveMessage(LinkInterface*, mavlink_message_t)));
+        // Connect this robot to the UAS object, it only receives
+        // the messages of its own system id
+        mavlink->getDispatcher()->subscribeAll(mav, sysid);
         uas = mav;
     }
     break;
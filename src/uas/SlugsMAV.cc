@@ -46,7 +46,7 @@ SlugsMAV::SlugsMAV(MAVLinkProtocol* mavlink, int id) :
  *             messages can be sent back to the system via this link
  * @param message MAVLink message, as received from the MAVLink protocol stack
  */
-void SlugsMAV::receiveMessage(LinkInterface* link, mavlink_message_t message)
+void SlugsMAV::receiveMessage(LinkInterface* link, const mavlink_message_t& message)
 {
     UAS::receiveMessage(link, message);// Let UAS handle the default message set
 
@@ -57,7 +57,7 @@ public:
 
 public slots:
     /** @brief Receive a MAVLink message from this MAV */
-    void receiveMessage(LinkInterface* link, mavlink_message_t message);
+    void receiveMessage(LinkInterface* link, const mavlink_message_t& message);
 
     void emitSignals (void);
 
@@ -290,7 +290,7 @@ bool UAS::getSelected() const
     return (UASManager::instance()->getActiveUAS() == this);
 }
 
-void UAS::receiveMessage(LinkInterface* link, mavlink_message_t message)
+void UAS::receiveMessage(LinkInterface* link, const mavlink_message_t& message)
 {
     if (!link) return;
     if (!links->contains(link))
@@ -49,7 +49,7 @@ This file is part of the QGROUNDCONTROL project
  * automatically updated by the comm architecture, so when writing code to e.g. control the vehicle
  * no knowledge of the communication infrastructure is needed.
  */
-class UAS : public UASInterface
+class UAS : public UASInterface, public MAVLinkMessageSubscriber
 {
     Q_OBJECT
 public:
@@ -73,6 +73,10 @@ public:
 
     /** @brief The name of the robot */
     QString getUASName(void) const;
+    /** @brief The name of the robot in the message dispatch statistics */
+    QString getSubscriberName() {
+        return getUASName();
+    }
     /** @brief Get short state */
     const QString& getShortState() const;
     /** @brief Get short mode */
@@ -584,7 +588,7 @@ public slots:
     void removeLink(QObject* object);
 
     /** @brief Receive a message from one of the communication links. */
-    virtual void receiveMessage(LinkInterface* link, mavlink_message_t message);
+    virtual void receiveMessage(LinkInterface* link, const mavlink_message_t& message);
 
 #ifdef QGC_PROTOBUF_ENABLED
     /** @brief Receive a message from one of the communication links. */
@@ -268,6 +268,12 @@ void UASManager::addUAS(UASInterface* uas)
     if (!systems.contains(uas))
     {
         systems.append(uas);
+        // The latest system with an id wins, as in the list search
+        int id = uas->getUASID();
+        if (id >= 0 && id < 256)
+        {
+            systemTable[id].fetchAndStoreOrdered(uas);
+        }
         connect(uas, SIGNAL(destroyed(QObject*)), this, SLOT(removeUAS(QObject*)));
         // Set home position on UAV if set in UI
         // - this is done on a per-UAV basis
@@ -285,6 +291,22 @@ void UASManager::addUAS(UASInterface* uas)
 
 void UASManager::removeUAS(QObject* uas)
 {
+    // Search by pointer, the object might already be destroyed
+    for (int id = 0; id < 256; id++)
+    {
+        UASInterface* entry = systemTable[id];
+        if (entry && static_cast<QObject*>(entry) == uas)
+        {
+            // Fall back to an older system with the same id
+            UASInterface* replacement = NULL;
+            foreach (UASInterface* sys, systems)
+            {
+                if (sys != entry && sys->getUASID() == id) replacement = sys;
+            }
+            systemTable[id].fetchAndStoreOrdered(replacement);
+        }
+    }
+
     UASInterface* mav = qobject_cast<UASInterface*>(uas);
 
     if (mav) {
@@ -394,6 +416,11 @@ void UASManager::configureActiveUAS()
 
 UASInterface* UASManager::getUASForId(int id)
 {
+    if (id >= 0 && id < 256)
+    {
+        return systemTable[id];
+    }
+
     UASInterface* system = NULL;
 
     foreach(UASInterface* sys, systems) {
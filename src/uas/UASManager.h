@@ -34,6 +34,7 @@ This file is part of the QGROUNDCONTROL project
 #include <QThread>
 #include <QList>
 #include <QMutex>
+#include <QAtomicPointer>
 #include <UASInterface.h>
 #include "../../libs/eigen/Eigen/Eigen"
 #include "QGCGeo.h"
@@ -63,7 +64,9 @@ public:
      * @brief Get the UAS with this id
      *
      * Although not enforced by this implementation, the IDs are constrained to be
-     * in the range of 1 - 127 by the MAVLINK protocol.
+     * in the range of 1 - 127 by the MAVLINK protocol. IDs in the range 0 - 255
+     * are looked up in a table without locking, so this is safe to call from
+     * any thread.
      *
      * @param id unique system / aircraft id
      * @return UAS with the given ID, NULL pointer else
@@ -243,6 +246,7 @@ public slots:
 protected:
     UASManager();
     QList<UASInterface*> systems;
+    QAtomicPointer<UASInterface> systemTable[256]; ///< Systems indexed by their id
     UASInterface* activeUAS;
     QMutex activeUASMutex;
     double homeLat;
@@ -40,6 +40,7 @@ This file is part of the QGROUNDCONTROL project
 #include "SerialConfigurationWindow.h"
 #include "SerialLink.h"
 #include "UDPLink.h"
+#include "SharedMemoryLink.h"
 #include "MAVLinkSimulationLink.h"
 #ifdef XBEELINK
 #include "XbeeLink.h"
@@ -52,6 +53,7 @@ This file is part of the QGROUNDCONTROL project
 #include "MAVLinkProtocol.h"
 #include "MAVLinkSettingsWidget.h"
 #include "QGCUDPLinkConfiguration.h"
+#include "QGCSharedMemoryLinkConfiguration.h"
 #include "LinkManager.h"
 #include "MainWindow.h"
 
@@ -70,6 +72,7 @@ CommConfigurationWindow::CommConfigurationWindow(LinkInterface* link, ProtocolIn
 #ifdef XBEELINK
 	ui.linkType->addItem(tr("Xbee API"),QGC_LINK_XBEE);
 #endif // XBEELINK
+    if (SharedMemoryLink::isAvailable()) ui.linkType->addItem(tr("Shared Memory"), QGC_LINK_SHARED_MEMORY);
     ui.linkType->setEditable(false);
 
     ui.connectionType->addItem("MAVLink", QGC_PROTOCOL_MAVLINK);
@@ -125,6 +128,13 @@ CommConfigurationWindow::CommConfigurationWindow(LinkInterface* link, ProtocolIn
         ui.linkGroupBox->setTitle(tr("UDP Link"));
         ui.linkType->setCurrentIndex(1);
     }
+    SharedMemoryLink* shm = dynamic_cast<SharedMemoryLink*>(link);
+    if (shm != 0) {
+        QWidget* conf = new QGCSharedMemoryLinkConfiguration(shm, this);
+        ui.linkScrollArea->setWidget(conf);
+        ui.linkGroupBox->setTitle(tr("Shared Memory Link"));
+        ui.linkType->setCurrentIndex(ui.linkType->findData(QGC_LINK_SHARED_MEMORY));
+    }
     MAVLinkSimulationLink* sim = dynamic_cast<MAVLinkSimulationLink*>(link);
     if (sim != 0) {
         ui.linkType->setCurrentIndex(2);
@@ -153,7 +163,7 @@ CommConfigurationWindow::CommConfigurationWindow(LinkInterface* link, ProtocolIn
 		connect(xbee,SIGNAL(tryConnectEnd(bool)),ui.actionConnect,SLOT(setEnabled(bool)));
 	}
 #endif // XBEELINK
-    if (serial == 0 && udp == 0 && sim == 0
+    if (serial == 0 && udp == 0 && shm == 0 && sim == 0
 #ifdef OPAL_RT
             && opal == 0
 #endif
@@ -164,9 +174,8 @@ CommConfigurationWindow::CommConfigurationWindow(LinkInterface* link, ProtocolIn
         qDebug() << "Link is NOT a known link, can't open configuration window";
     }
 
-#ifdef XBEELINK
+	linkTypeIndex = ui.linkType->currentIndex();
 	connect(ui.linkType,SIGNAL(currentIndexChanged(int)),this,SLOT(setLinkType(int)));
-#endif // XBEELINK
 
     // Open details pane for MAVLink if necessary
     MAVLinkProtocol* mavlink = dynamic_cast<MAVLinkProtocol*>(protocol);
@@ -198,57 +207,77 @@ QAction* CommConfigurationWindow::getAction()
 
 void CommConfigurationWindow::setLinkType(int linktype)
 {
-	if(link->isConnected())
-	{
-		// close old configuration window
-		this->window()->close();
-	}
-	else
-	{
-		// delete old configuration window
-		this->remove();
-	}
-
 	LinkInterface *tmpLink(NULL);
-	switch(linktype)
+	// The combo box entries depend on the build, select by link type instead of index
+	switch(ui.linkType->itemData(linktype).toInt())
 	{
 #ifdef XBEELINK
-		case 4:
+		case QGC_LINK_XBEE:
 			{
 				XbeeLink *xbee = new XbeeLink();
 				tmpLink = xbee;
-				MainWindow::instance()->addLink(tmpLink);
 				break;
 			}
 #endif // XBEELINK
-		case 1:
+		case QGC_LINK_UDP:
 			{
 				UDPLink *udp = new UDPLink();
 				tmpLink = udp;
-				MainWindow::instance()->addLink(tmpLink);
 				break;
 			}
 			
 #ifdef OPAL_RT
-		case 3:
+		case QGC_LINK_OPAL:
 			{
 				OpalLink* opal = new OpalLink();
 				tmpLink = opal;
-				MainWindow::instance()->addLink(tmpLink);
 				break;
 			}
+#else
+		case QGC_LINK_OPAL:
+			// Not available in this build
+			break;
 #endif // OPAL_RT
-		default:
+		case QGC_LINK_SHARED_MEMORY:
 			{
+				SharedMemoryLink *shm = new SharedMemoryLink();
+				tmpLink = shm;
+				break;
 			}
-		case 0:
+		case QGC_LINK_SERIAL:
 			{
 				SerialLink *serial = new SerialLink();
 				tmpLink = serial;
-				MainWindow::instance()->addLink(tmpLink);
 				break;
 			}
+		case QGC_LINK_SIMULATION:
+			// Simulation links are started from the simulation menu
+			break;
+		default:
+			break;
+	}
+
+	if (!tmpLink)
+	{
+		// Keep the current link and show its type again
+		ui.linkType->blockSignals(true);
+		ui.linkType->setCurrentIndex(linkTypeIndex);
+		ui.linkType->blockSignals(false);
+		return;
+	}
+
+	if(link->isConnected())
+	{
+		// close old configuration window
+		this->window()->close();
+	}
+	else
+	{
+		// delete old configuration window
+		this->remove();
 	}
+	MainWindow::instance()->addLink(tmpLink);
+
 	// trigger new window
 
 	const int32_t& linkIndex(LinkManager::instance()->getLinks().indexOf(tmpLink));
@@ -47,7 +47,8 @@ enum qgc_link_t {
 #ifdef XBEELINK
 	QGC_LINK_XBEE,
 #endif
-    QGC_LINK_OPAL
+    QGC_LINK_OPAL,
+    QGC_LINK_SHARED_MEMORY
 };
 
 enum qgc_protocol_t {
@@ -87,6 +88,7 @@ private:
     Ui::commSettings ui;
     LinkInterface* link;
     QAction* action;
+    int linkTypeIndex; ///< Combo box entry of the type of the current link
 };
 
 
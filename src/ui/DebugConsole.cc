@@ -58,7 +58,6 @@ DebugConsole::DebugConsole(QWidget *parent) :
     lineBufferTimer(),
     snapShotTimer(),
     snapShotInterval(500),
-    snapShotBytes(0),
     dataRate(0.0f),
     lowpassDataRate(0.0f),
     dataRateThreshold(400),
@@ -297,9 +296,9 @@ void DebugConsole::receiveTextMessage(int id, int component, int severity, QStri
 
 void DebugConsole::updateTrafficMeasurements()
 {
-    lowpassDataRate = lowpassDataRate * 0.9f + (0.1f * ((float)snapShotBytes / (float)snapShotInterval) * 1000.0f);
-    dataRate = ((float)snapShotBytes / (float)snapShotInterval) * 1000.0f;
-    snapShotBytes = 0;
+    // The link counts its traffic, the rate is the one of its last one second sample
+    dataRate = (currLink) ? float(currLink->getLinkStatistics()->getRate().receivedBytes) : 0.0f;
+    lowpassDataRate = lowpassDataRate * 0.9f + 0.1f * dataRate;
 
     // Check if limit has been exceeded
     if ((lowpassDataRate > dataRateThreshold) && autoHold) {
@@ -353,7 +352,6 @@ void DebugConsole::paintEvent(QPaintEvent *event)
 
 void DebugConsole::receiveBytes(LinkInterface* link, QByteArray bytes)
 {
-    snapShotBytes += bytes.size();
     int len = bytes.size();
     int lastSpace = 0;
     if ((this->bytesToIgnore > 260) || (this->bytesToIgnore < -2)) this->bytesToIgnore = 0;
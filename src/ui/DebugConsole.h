@@ -130,9 +130,8 @@ protected:
     QString lineBuffer;       ///< Buffere where bytes are stored before writing them out
     quint64 lastLineBuffer;   ///< Last line buffer emission time
     QTimer lineBufferTimer;   ///< Line buffer timer
-    QTimer snapShotTimer;     ///< Timer for measuring traffic snapshots
-    int snapShotInterval;     ///< Snapshot interval for traffic measurements
-    int snapShotBytes;        ///< Number of bytes received in current snapshot
+    QTimer snapShotTimer;     ///< Timer for updating the traffic measurements
+    int snapShotInterval;     ///< Update interval of the traffic measurements
     float dataRate;           ///< Current data rate
     float lowpassDataRate;    ///< Lowpass filtered data rate
     float dataRateThreshold;  ///< Threshold where to enable auto-hold
@@ -4,12 +4,16 @@
 #include <QObject>
 #include "MAVLinkProtocol.h"
 
-class MAVLinkDecoder : public QObject
+class MAVLinkDecoder : public QObject, public MAVLinkMessageSubscriber
 {
     Q_OBJECT
 public:
     MAVLinkDecoder(MAVLinkProtocol* protocol, QObject *parent = 0);
 
+    QString getSubscriberName() {
+        return tr("MAVLink decoder");
+    }
+
 signals:
     void textMessageReceived(int uasid, int componentid, int severity, const QString& text);
     void valueChanged(const int uasId, const QString& name, const QString& unit, const quint8 value, const quint64 msec);
@@ -25,7 +29,7 @@ signals:
 
 public slots:
     /** @brief Receive one message from the protocol and decode it */
-    void receiveMessage(LinkInterface* link,mavlink_message_t message);
+    void receiveMessage(LinkInterface* link, const mavlink_message_t& message);
 protected:
     /** @brief Emit the value of one message field */
     void emitFieldValue(mavlink_message_t* msg, int fieldid, quint64 time);
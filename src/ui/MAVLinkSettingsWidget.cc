@@ -35,6 +35,7 @@ This file is part of the QGROUNDCONTROL project
 #include "MAVLinkSettingsWidget.h"
 #include "LinkManager.h"
 #include "UDPLink.h"
+#include "MAVLinkLogBlockFile.h"
 #include "ui_MAVLinkSettingsWidget.h"
 #include <QSettings>
 
@@ -145,6 +146,10 @@ MAVLinkSettingsWidget::MAVLinkSettingsWidget(MAVLinkProtocol* protocol, QWidget
     m_ui->multiplexingFilterCheckBox->setVisible(false);
     m_ui->multiplexingFilterLineEdit->setVisible(false);
 
+    // Link statistics
+    connect(protocol->getStatistics(), SIGNAL(snapshotUpdated()), this, SLOT(updateStatistics()));
+    updateStatistics();
+
 //    // Update settings
 //    m_ui->loggingCheckBox->setChecked(protocol->loggingEnabled());
 //    m_ui->heartbeatCheckBox->setChecked(protocol->heartbeatsEnabled());
@@ -159,9 +164,9 @@ void MAVLinkSettingsWidget::updateLogfileName(const QString& fileName)
 
 void MAVLinkSettingsWidget::chooseLogfileName()
 {
-    QString fileName = QFileDialog::getSaveFileName(this, tr("Specify MAVLink log file name"), QDesktopServices::storageLocation(QDesktopServices::DesktopLocation), tr("MAVLink Logfile (*.mavlink);;"));
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Specify MAVLink log file name"), QDesktopServices::storageLocation(QDesktopServices::DesktopLocation), tr("MAVLink Logfile (*.mavlink);;Compressed MAVLink Logfile (*.mavlinkz);;"));
 
-    if (!fileName.endsWith(".mavlink"))
+    if (!fileName.endsWith(".mavlink") && !MAVLinkLogBlockFile::isBlockLogName(fileName))
     {
         fileName.append(".mavlink");
     }
@@ -239,6 +244,25 @@ void MAVLinkSettingsWidget::setDroneOSHost(QString host)
     enableDroneOS(m_ui->droneOSCheckBox->isChecked());
 }
 
+void MAVLinkSettingsWidget::updateStatistics()
+{
+    const MAVLinkStatisticsSnapshot snapshot = protocol->getStatistics()->getSnapshot();
+    if (snapshot.links.isEmpty()) return;
+
+    QStringList lines;
+    foreach (const MAVLinkLinkSample& link, snapshot.links)
+    {
+        lines.append(tr("%1: %2 msg/s, %3 B/s, %4 CRC errors").arg(link.linkName)
+                     .arg(link.messageRate, 0, 'f', 1).arg(link.byteRate, 0, 'f', 0).arg(link.crcErrors));
+        foreach (const MAVLinkComponentSample& component, link.components)
+        {
+            lines.append(tr("    System %1 / component %2: %3 msg/s, %4% loss").arg(component.sysid).arg(component.compid)
+                         .arg(component.messageRate, 0, 'f', 1).arg(component.loss, 0, 'f', 1));
+        }
+    }
+    m_ui->statisticsLabel->setText(lines.join("\n"));
+}
+
 MAVLinkSettingsWidget::~MAVLinkSettingsWidget()
 {
     delete m_ui;
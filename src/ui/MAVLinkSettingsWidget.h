@@ -28,6 +28,8 @@ public slots:
     void setDroneOSKey(QString key);
 
     void setDroneOSHost(QString host);
+    /** @brief Show the receive rates of the latest statistics snapshot */
+    void updateStatistics();
 
 protected:
     MAVLinkProtocol* protocol;
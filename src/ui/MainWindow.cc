@@ -1108,6 +1108,8 @@ void MainWindow::connectCommonActions()
     connect(ui.actionJoystickSettings, SIGNAL(triggered()), this, SLOT(configure()));
     // Application Settings
     connect(ui.actionSettings, SIGNAL(triggered()), this, SLOT(showSettings()));
+    // Link statistics
+    connect(ui.actionExportLinkStatistics, SIGNAL(triggered()), this, SLOT(exportLinkStatistics()));
 }
 
 void MainWindow::showHelp()
@@ -1171,6 +1173,23 @@ void MainWindow::showSettings()
     settings->show();
 }
 
+void MainWindow::exportLinkStatistics()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export Link Statistics"),
+                                                    QDesktopServices::storageLocation(QDesktopServices::DesktopLocation),
+                                                    tr("CSV Files (*.csv);;JSON Files (*.json)"));
+    if (fileName.isEmpty()) return;
+    if (!fileName.endsWith(".csv", Qt::CaseInsensitive) && !fileName.endsWith(".json", Qt::CaseInsensitive))
+    {
+        fileName.append(".csv");
+    }
+
+    if (!mavlink->getStatistics()->exportSnapshot(fileName))
+    {
+        showCriticalMessage(tr("Could not export link statistics"), tr("Please make sure that the file %1 is writable or select a different file").arg(fileName));
+    }
+}
+
 void MainWindow::addLink()
 {
     SerialLink* link = new SerialLink();
@@ -138,6 +138,8 @@ public slots:
 
     /** @brief Show the application settings */
     void showSettings();
+    /** @brief Write the MAVLink link statistics to a CSV or JSON file */
+    void exportLinkStatistics();
     /** @brief Add a communication link */
     void addLink();
     void addLink(LinkInterface* link);
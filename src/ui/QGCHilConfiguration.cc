@@ -11,6 +11,8 @@ QGCHilConfiguration::QGCHilConfiguration(UAS *mav, QWidget *parent) :
     ui(new Ui::QGCHilConfiguration)
 {
     ui->setupUi(this);
+    connect(&latencyTimer, SIGNAL(timeout()), this, SLOT(updateLatency()));
+    latencyTimer.start(1000);
 }
 
 void QGCHilConfiguration::receiveStatusMessage(const QString& message)
@@ -18,6 +20,29 @@ void QGCHilConfiguration::receiveStatusMessage(const QString& message)
     ui->statusLabel->setText(message);
 }
 
+void QGCHilConfiguration::updateLatency()
+{
+    QGCHilLink* sim = mav->getHILSimulation();
+    if (!sim || !sim->isConnected())
+    {
+        ui->latencyLabel->clear();
+        return;
+    }
+
+    QStringList lines;
+    for (int stage = 0; stage < QGCHilLatency::STAGE_COUNT; stage++)
+    {
+        QGCHilLatencySample sample = sim->getLatency()->getSample(static_cast<QGCHilLatency::Stage>(stage));
+        if (sample.count == 0) continue;
+        lines.append(tr("%1: %2 ms mean, %3 ms 99%, %4 ms max")
+                     .arg(QGCHilLatency::getStageName(static_cast<QGCHilLatency::Stage>(stage)))
+                     .arg(sample.mean / 1000.0, 0, 'f', 2)
+                     .arg(sample.percentile(0.99) / 1000.0, 0, 'f', 2)
+                     .arg(sample.max / 1000.0, 0, 'f', 2));
+    }
+    ui->latencyLabel->setText(lines.join("\n"));
+}
+
 QGCHilConfiguration::~QGCHilConfiguration()
 {
     delete ui;
@@ -2,6 +2,7 @@
 #define QGCHILCONFIGURATION_H
 
 #include <QWidget>
+#include <QTimer>
 
 #include "QGCHilLink.h"
 #include "UAS.h"
@@ -21,9 +22,12 @@ public:
 public slots:
     /** @brief Receive status message */
     void receiveStatusMessage(const QString& message);
+    /** @brief Show the latency of the simulation loop */
+    void updateLatency();
 
 protected:
     UAS* mav;
+    QTimer latencyTimer;
     
 private slots:
     void on_simComboBox_currentIndexChanged(int index);
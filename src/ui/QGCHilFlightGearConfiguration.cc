@@ -28,6 +28,14 @@ QGCHilFlightGearConfiguration::QGCHilFlightGearConfiguration(UAS* mav,QWidget *p
         items << "<aircraft>";
     }
     ui->aircraftComboBox->addItems(items);
+
+    // Show the stored settings of the simulation link
+    QGCFlightGearLink* link = dynamic_cast<QGCFlightGearLink*>(mav->getHILSimulation());
+    if (link)
+    {
+        ui->binaryCheckBox->setChecked(link->isBinaryProtocol());
+        ui->rateSpinBox->setValue(link->getUpdateRate());
+    }
 }
 
 QGCHilFlightGearConfiguration::~QGCHilFlightGearConfiguration()
@@ -40,6 +48,18 @@ void QGCHilFlightGearConfiguration::on_startButton_clicked()
     //XXX check validity of inputs
     QString options = ui->optionsPlainTextEdit->toPlainText();
     options.append(" --aircraft=" + ui->aircraftComboBox->currentText());
+    // Create the link without starting it, it has to be configured before it connects
+    if (!dynamic_cast<QGCFlightGearLink*>(mav->getHILSimulation()))
+    {
+        mav->enableHilFlightGear(false, options);
+    }
+    QGCFlightGearLink* link = dynamic_cast<QGCFlightGearLink*>(mav->getHILSimulation());
+    if (link)
+    {
+        link->setBinaryProtocol(ui->binaryCheckBox->isChecked());
+        link->setUpdateRate(ui->rateSpinBox->value());
+        link->storeSettings();
+    }
     mav->enableHilFlightGear(true,  options);
 }
 
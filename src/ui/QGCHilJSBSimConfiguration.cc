@@ -28,6 +28,14 @@ QGCHilJSBSimConfiguration::QGCHilJSBSimConfiguration(UAS* mav,QWidget *parent) :
         items << "<aircraft>";
     }
     ui->aircraftComboBox->addItems(items);
+
+    // Show the stored settings of the simulation link
+    QGCJSBSimLink* link = dynamic_cast<QGCJSBSimLink*>(mav->getHILSimulation());
+    if (link)
+    {
+        ui->binaryCheckBox->setChecked(link->isBinaryProtocol());
+        ui->rateSpinBox->setValue(link->getUpdateRate());
+    }
 }
 
 QGCHilJSBSimConfiguration::~QGCHilJSBSimConfiguration()
@@ -40,6 +48,18 @@ void QGCHilJSBSimConfiguration::on_startButton_clicked()
     //XXX check validity of inputs
     QString options = ui->optionsPlainTextEdit->toPlainText();
     options.append(" --script=" + ui->aircraftComboBox->currentText());
+    // Create the link without starting it, it has to be configured before it connects
+    if (!dynamic_cast<QGCJSBSimLink*>(mav->getHILSimulation()))
+    {
+        mav->enableHilJSBSim(false, options);
+    }
+    QGCJSBSimLink* link = dynamic_cast<QGCJSBSimLink*>(mav->getHILSimulation());
+    if (link)
+    {
+        link->setBinaryProtocol(ui->binaryCheckBox->isChecked());
+        link->setUpdateRate(ui->rateSpinBox->value());
+        link->storeSettings();
+    }
     mav->enableHilJSBSim(true,  options);
 }
 
@@ -12,6 +12,7 @@ const unsigned int QGCMAVLinkInspector::updateInterval = 1000U;
 
 QGCMAVLinkInspector::QGCMAVLinkInspector(MAVLinkProtocol* protocol, QWidget *parent) :
     QWidget(parent),
+    dispatcher(protocol->getDispatcher()),
     selectedSystemID(0),
     selectedComponentID(0),
     ui(new Ui::QGCMAVLinkInspector)
@@ -43,7 +44,7 @@ QGCMAVLinkInspector::QGCMAVLinkInspector(MAVLinkProtocol* protocol, QWidget *par
 
     // Connect external connections
     connect(UASManager::instance(), SIGNAL(UASCreated(UASInterface*)), this, SLOT(addSystem(UASInterface*)));
-    connect(protocol, SIGNAL(messageReceived(LinkInterface*,mavlink_message_t)), this, SLOT(receiveMessage(LinkInterface*,mavlink_message_t)));
+    updateSubscription();
 
     // Attach the UI's refresh rate to a timer.
     connect(&updateTimer, SIGNAL(timeout()), this, SLOT(refreshView()));
@@ -59,11 +60,22 @@ void QGCMAVLinkInspector::selectDropDownMenuSystem(int dropdownid)
 {
     selectedSystemID = ui->systemComboBox->itemData(dropdownid).toInt();
     rebuildComponentList();
+    updateSubscription();
 }
 
 void QGCMAVLinkInspector::selectDropDownMenuComponent(int dropdownid)
 {
     selectedComponentID = ui->componentComboBox->itemData(dropdownid).toInt();
+    updateSubscription();
+}
+
+/**
+ * Only the messages of the selected system and component are delivered
+ */
+void QGCMAVLinkInspector::updateSubscription()
+{
+    dispatcher->unsubscribe(this);
+    dispatcher->subscribeAll(this, selectedSystemID, selectedComponentID);
 }
 
 void QGCMAVLinkInspector::rebuildComponentList()
@@ -147,11 +159,9 @@ void QGCMAVLinkInspector::refreshView()
     }
 }
 
-void QGCMAVLinkInspector::receiveMessage(LinkInterface* link,mavlink_message_t message)
+void QGCMAVLinkInspector::receiveMessage(LinkInterface* link, const mavlink_message_t& message)
 {
     Q_UNUSED(link);
-    if (selectedSystemID != 0 && selectedSystemID != message.sysid) return;
-    if (selectedComponentID != 0 && selectedComponentID != message.compid) return;
     // Only overwrite if system filter is set
     memcpy(receivedMessages+message.msgid, &message, sizeof(mavlink_message_t));
 
@@ -14,7 +14,7 @@ namespace Ui {
 class QTreeWidgetItem;
 class UASInterface;
 
-class QGCMAVLinkInspector : public QWidget
+class QGCMAVLinkInspector : public QWidget, public MAVLinkMessageSubscriber
 {
     Q_OBJECT
 
@@ -22,8 +22,12 @@ public:
     explicit QGCMAVLinkInspector(MAVLinkProtocol* protocol, QWidget *parent = 0);
     ~QGCMAVLinkInspector();
 
+    QString getSubscriberName() {
+        return tr("MAVLink inspector");
+    }
+
 public slots:
-    void receiveMessage(LinkInterface* link,mavlink_message_t message);
+    void receiveMessage(LinkInterface* link, const mavlink_message_t& message);
     /** @brief Clear all messages */
     void clearView();
     /** Update view */
@@ -36,6 +40,7 @@ public slots:
     void selectDropDownMenuComponent(int dropdownid);
 
 protected:
+    MAVLinkMessageDispatcher* dispatcher; ///< Delivers the messages of the selected system
     int selectedSystemID;          ///< Currently selected system
     int selectedComponentID;       ///< Currently selected component
     QMap<int, quint64> lastMessageUpdate; ///< Used to switch between highlight and non-highlighting color
@@ -50,6 +55,8 @@ protected:
     void updateField(int msgid, int fieldid, QTreeWidgetItem* item);
     /** @brief Rebuild the list of components */
     void rebuildComponentList();
+    /** @brief Subscribe to the messages of the selected system and component */
+    void updateSubscription();
 
     static const unsigned int updateInterval;
     static const float updateHzLowpass;
@@ -11,9 +11,7 @@ QGCMAVLinkLogPlayer::QGCMAVLinkLogPlayer(MAVLinkProtocol* mavlink, QWidget *pare
     QWidget(parent),
     lineCounter(0),
     totalLines(0),
-    startTime(0),
     endTime(0),
-    currentStartTime(0),
     accelerationFactor(1.0f),
     mavlink(mavlink),
     logLink(NULL),
@@ -22,23 +20,37 @@ QGCMAVLinkLogPlayer::QGCMAVLinkLogPlayer(MAVLinkProtocol* mavlink, QWidget *pare
     binaryBaudRate(57600),
     isPlaying(false),
     currPacketCount(0),
+    currPacketIndex(0),
+    unpacedReplay(new MAVLinkLogReplay(mavlink, this)),
     ui(new Ui::QGCMAVLinkLogPlayer)
 {
     ui->setupUi(this);
     ui->gridLayout->setAlignment(Qt::AlignTop);
 
-    // Connect protocol
-    connect(this, SIGNAL(bytesReady(LinkInterface*,QByteArray)), mavlink, SLOT(receiveBytes(LinkInterface*,QByteArray)));
+    // Connect protocol, the packets are parsed immediately in the GUI thread
+    connect(this, SIGNAL(bytesReady(LinkInterface*,QByteArray)), mavlink, SLOT(receiveBytes(LinkInterface*,QByteArray)), Qt::DirectConnection);
 
-    // Setup timer
+    // Setup timer, binary logs are replayed at a fixed rate
     connect(&loopTimer, SIGNAL(timeout()), this, SLOT(logLoop()));
 
+    // Setup pacing of MAVLink logs
+    connect(&pacer, SIGNAL(bytesReady(LinkInterface*,QByteArray)), this, SIGNAL(bytesReady(LinkInterface*,QByteArray)));
+    connect(&pacer, SIGNAL(timeChanged(quint64)), this, SLOT(pacerTimeChanged(quint64)));
+    connect(&pacer, SIGNAL(endReached()), this, SLOT(pacerEndReached()));
+
+    // Setup frame index
+    connect(&logIndex, SIGNAL(progressChanged(int)), this, SLOT(logIndexProgress(int)));
+    connect(&logIndex, SIGNAL(finished()), this, SLOT(logIndexFinished()));
+
+    // Setup unpaced replay
+    connect(unpacedReplay, SIGNAL(progressChanged(int)), this, SLOT(unpacedReplayProgress(int)));
+    connect(unpacedReplay, SIGNAL(finished()), this, SLOT(unpacedReplayFinished()));
+
     // Setup buttons
     connect(ui->selectFileButton, SIGNAL(clicked()), this, SLOT(selectLogFile()));
     connect(ui->playButton, SIGNAL(clicked()), this, SLOT(playPauseToggle()));
     connect(ui->speedSlider, SIGNAL(valueChanged(int)), this, SLOT(setAccelerationFactorInt(int)));
     connect(ui->positionSlider, SIGNAL(valueChanged(int)), this, SLOT(jumpToSliderVal(int)));
-    connect(ui->positionSlider, SIGNAL(sliderPressed()), this, SLOT(pause()));
 
     setAccelerationFactorInt(49);
     ui->speedSlider->setValue(49);
@@ -79,18 +91,37 @@ void QGCMAVLinkLogPlayer::play()
     if (logFile.isOpen())
     {
         ui->selectFileButton->setEnabled(false);
-        if (logLink)
+        // A paused replay continues on the same link
+        if (!logLink)
         {
-            logLink->disconnect();
-            LinkManager::instance()->removeLink(logLink);
-            delete logLink;
+            logLink = new MAVLinkSimulationLink("");
         }
-        logLink = new MAVLinkSimulationLink("");
 
         // Start timer
-        if (mavlinkLogFormat)
+        if (mavlinkLogFormat && ui->unpacedCheckBox->isChecked())
         {
-            loopTimer.start(1);
+            // Continue at the packet a paced replay would send next
+            qint64 offset = pacer.isRunning() ? pacer.getOffset() : logReader.position();
+            pacer.stop();
+            if (!unpacedReplay->start(logFile.fileName(), logLink, offset))
+            {
+                ui->logStatsLabel->setText(tr("Error reading the log file."));
+                pause();
+                return;
+            }
+        }
+        else if (mavlinkLogFormat)
+        {
+            if (pacer.isRunning())
+            {
+                pacer.resume();
+            }
+            else if (!pacer.start(logFile.fileName(), logLink, logReader.position()))
+            {
+                ui->logStatsLabel->setText(tr("Error reading the log file."));
+                pause();
+                return;
+            }
         }
         else
         {
@@ -123,53 +154,79 @@ void QGCMAVLinkLogPlayer::pause()
 {
     isPlaying = false;
     loopTimer.stop();
+    unpacedReplay->stop();
+    // The pacer keeps its position, play() continues there
+    pacer.pause();
     ui->playButton->setIcon(QIcon(":files/images/actions/media-playback-start.svg"));
     ui->selectFileButton->setEnabled(true);
-    if (logLink)
-    {
-        logLink->disconnect();
-        LinkManager::instance()->removeLink(logLink);
-        delete logLink;
-        logLink = NULL;
-    }
 }
 
 bool QGCMAVLinkLogPlayer::reset(int packetIndex)
 {
-    // Reset only for valid values
+    // MAVLink log records have different lengths, only the
+    // index knows where they start. Binary logs have none.
     const unsigned int packetSize = timeLen + packetLen;
-    if (packetIndex >= 0 && packetIndex*packetSize <= logFile.size() - packetSize)
+    qint64 offset;
+    double fraction;
+    if (mavlinkLogFormat && packetIndex == 0)
     {
-        bool result = true;
-        pause();
-        loopCounter = 0;
-        logFile.reset();
-
-        if (!logFile.seek(packetIndex*packetSize))
-        {
-            // Fallback: Start from scratch
-            logFile.reset();
-            ui->logStatsLabel->setText(tr("Changing packet index failed, back to start."));
-            result = false;
-        }
-
-        ui->playButton->setIcon(QIcon(":files/images/actions/media-playback-start.svg"));
-        ui->positionSlider->blockSignals(true);
-        int sliderVal = (packetIndex / (double)(logFile.size()/packetSize)) * (ui->positionSlider->maximum() - ui->positionSlider->minimum());
-        ui->positionSlider->setValue(sliderVal);
-        ui->positionSlider->blockSignals(false);
-        startTime = 0;
-        return result;
+        offset = 0;
+        fraction = 0.0;
+    }
+    else if (mavlinkLogFormat && packetIndex > 0 && logIndex.isReady() && packetIndex < logIndex.count())
+    {
+        offset = logIndex.offset(packetIndex);
+        fraction = timeFraction(logIndex.time(packetIndex));
+    }
+    else if (!mavlinkLogFormat && packetIndex >= 0 && packetIndex*packetSize <= logFile.size() - packetSize)
+    {
+        offset = packetIndex*packetSize;
+        fraction = packetIndex / (double)(logFile.size()/packetSize);
     }
     else
     {
         return false;
     }
+    return seekToOffset(offset, fraction, packetIndex);
+}
+
+bool QGCMAVLinkLogPlayer::seekToOffset(qint64 offset, double fraction, int packetIndex)
+{
+    bool result = true;
+    pause();
+    pacer.stop();
+    if (logLink)
+    {
+        logLink->disconnect();
+        LinkManager::instance()->removeLink(logLink);
+        delete logLink;
+        logLink = NULL;
+    }
+    loopCounter = 0;
+    logFile.reset();
+    currPacketIndex = packetIndex;
+
+    if (!(mavlinkLogFormat ? logReader.seek(offset) : logFile.seek(offset)))
+    {
+        // Fallback: Start from scratch
+        logFile.reset();
+        logReader.seek(0);
+        currPacketIndex = 0;
+        ui->logStatsLabel->setText(tr("Changing packet index failed, back to start."));
+        result = false;
+    }
+
+    ui->playButton->setIcon(QIcon(":files/images/actions/media-playback-start.svg"));
+    ui->positionSlider->blockSignals(true);
+    int sliderVal = fraction * (ui->positionSlider->maximum() - ui->positionSlider->minimum());
+    ui->positionSlider->setValue(sliderVal);
+    ui->positionSlider->blockSignals(false);
+    return result;
 }
 
 bool QGCMAVLinkLogPlayer::selectLogFile()
 {
-    QString fileName = QFileDialog::getOpenFileName(this, tr("Specify MAVLink log file name to replay"), QDesktopServices::storageLocation(QDesktopServices::DesktopLocation), tr("MAVLink or Binary Logfile (*.mavlink *.bin *.log)"));
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Specify MAVLink log file name to replay"), QDesktopServices::storageLocation(QDesktopServices::DesktopLocation), tr("MAVLink or Binary Logfile (*.mavlink *.mavlinkz *.bin *.log)"));
 
     if (fileName == "")
     {
@@ -198,6 +255,8 @@ void QGCMAVLinkLogPlayer::setAccelerationFactorInt(int factor)
         accelerationFactor = 1+(f/2.0f);
     }
 
+    pacer.setSpeed(accelerationFactor);
+
     // Update timer interval
     if (!mavlinkLogFormat)
     {
@@ -231,6 +290,9 @@ bool QGCMAVLinkLogPlayer::loadLogFile(const QString& file)
         pause();
         logFile.close();
     }
+    logIndex.cancel();
+    pacer.stop();
+    logReader.close();
     logFile.setFileName(file);
 
     if (!logFile.open(QFile::ReadOnly))
@@ -243,39 +305,36 @@ bool QGCMAVLinkLogPlayer::loadLogFile(const QString& file)
     {
         QFileInfo logFileInfo(file);
         logFile.reset();
-        startTime = 0;
         ui->logFileNameLabel->setText(tr("%1").arg(logFileInfo.baseName()));
 
         // Select if binary or MAVLink log format is used
-        mavlinkLogFormat = file.endsWith(".mavlink");
+        mavlinkLogFormat = file.endsWith(".mavlink") || MAVLinkLogBlockFile::isBlockLog(file);
 
-        if (mavlinkLogFormat)
+        if (mavlinkLogFormat && !logReader.open(file))
         {
-            // Get the time interval from the logfile
-            QByteArray timestamp = logFile.read(timeLen);
-
-            // First timestamp
-            quint64 starttime = *((quint64*)(timestamp.constData()));
-
-            // Last timestamp
-            logFile.seek(logFile.size()-packetLen-timeLen);
-            QByteArray timestamp2 = logFile.read(timeLen);
-            quint64 endtime = *((quint64*)(timestamp2.constData()));
-            // Reset everything
-            logFile.reset();
-
-            qDebug() << "Starttime:" << starttime << "End:" << endtime;
-
-            // WARNING: Order matters in this computation
-            int seconds = (endtime - starttime)/1000000;
-            int minutes = seconds / 60;
-            int hours = minutes / 60;
-            seconds -= 60*minutes;
-            minutes -= 60*hours;
+            MainWindow::instance()->showCriticalMessage(tr("The selected logfile is unreadable"), tr("Please make sure that the file %1 is readable or select a different file").arg(file));
+            logFile.close();
+            logFile.setFileName("");
+            return false;
+        }
 
-            QString timelabel = tr("%1h:%2m:%3s").arg(hours, 2).arg(minutes, 2).arg(seconds, 2);
-            currPacketCount = logFileInfo.size()/(MAVLINK_MAX_PACKET_LEN+sizeof(quint64));
-            ui->logStatsLabel->setText(tr("%2 MB, %3 packets, %4").arg(logFileInfo.size()/1000000.0f, 0, 'f', 2).arg(currPacketCount).arg(timelabel));
+        if (mavlinkLogFormat && logReader.isBlockLog())
+        {
+            // Block logs seek by the time ranges of their blocks
+            // right away, the index only adds the packet count
+            currPacketCount = 0;
+            ui->positionSlider->setEnabled(true);
+            ui->logStatsLabel->setText(tr("%1 MB compressed, %2 blocks, indexing..").arg(logFileInfo.size()/1000000.0f, 0, 'f', 2).arg(logReader.getBlockFile().count()));
+            logIndex.build(file);
+        }
+        else if (mavlinkLogFormat)
+        {
+            // Packet count and duration are only known once the records
+            // are indexed, seeking is not possible until then
+            currPacketCount = 0;
+            ui->positionSlider->setEnabled(false);
+            ui->logStatsLabel->setText(tr("%1 MB, indexing..").arg(logFileInfo.size()/1000000.0f, 0, 'f', 2));
+            logIndex.build(file);
         }
         else
         {
@@ -304,6 +363,7 @@ bool QGCMAVLinkLogPlayer::loadLogFile(const QString& file)
 
             QString timelabel = tr("%1h:%2m:%3s").arg(hours, 2).arg(minutes, 2).arg(seconds, 2);
             ui->logStatsLabel->setText(tr("%2 MB, %4 at %5 KB/s").arg(logFileInfo.size()/1000000.0f, 0, 'f', 2).arg(timelabel).arg(binaryBaudRate/10.0f/1024.0f, 0, 'f', 2));
+            ui->positionSlider->setEnabled(true);
         }
 
         // Reset current state
@@ -313,163 +373,229 @@ bool QGCMAVLinkLogPlayer::loadLogFile(const QString& file)
     }
 }
 
-/**
- * Jumps to the current percentage of the position slider
- */
-void QGCMAVLinkLogPlayer::jumpToSliderVal(int slidervalue)
+void QGCMAVLinkLogPlayer::logIndexProgress(int percent)
 {
-    loopTimer.stop();
-    // Set the logfile to the correct percentage and
-    // align to the timestamp values
-    int packetCount = logFile.size() / (packetLen + timeLen);
-    int packetIndex = (packetCount - 1) * (slidervalue / (double)(ui->positionSlider->maximum() - ui->positionSlider->minimum()));
-
-    // Do only accept valid jumps
-    if (reset(packetIndex))
+    if (!isPlaying)
     {
-        if (mavlinkLogFormat)
-        {
-            ui->logStatsLabel->setText(tr("Jumped to packet %1").arg(packetIndex));
-        }
+        QFileInfo logFileInfo(logFile);
+        ui->logStatsLabel->setText(tr("%1 MB, indexing %2%").arg(logFileInfo.size()/1000000.0f, 0, 'f', 2).arg(percent));
     }
 }
 
-/**
- * This function is the "mainloop" of the log player, reading one line
- * and adjusting the mainloop timer to read the next line in time.
- * It might not perfectly match the timing of the log file,
- * but it will never induce a static drift into the log file replay.
- * For scientific logging, the use of onboard timestamps and the log
- * functionality of the line chart plot is recommended.
- */
-void QGCMAVLinkLogPlayer::logLoop()
+void QGCMAVLinkLogPlayer::logIndexFinished()
 {
-    if (mavlinkLogFormat)
+    // A cancelled build of a previously selected file is of no interest
+    if (!mavlinkLogFormat || logIndex.isRunning() || logIndex.getLogFileName() != logFile.fileName())
     {
-        bool ok;
-
-        // First check initialization
-        if (startTime == 0)
-        {
-            QByteArray startBytes = logFile.read(timeLen);
+        return;
+    }
+    if (!logIndex.isReady())
+    {
+        ui->logStatsLabel->setText(logReader.isBlockLog() ? tr("Indexing the log failed, seeking by blocks only.") : tr("Indexing the log failed, seeking is disabled."));
+        return;
+    }
 
-            // Check if the correct number of bytes could be read
-            if (startBytes.length() != timeLen)
-            {
-                ui->logStatsLabel->setText(tr("Error reading first %1 bytes").arg(timeLen));
-                MainWindow::instance()->showCriticalMessage(tr("Failed loading MAVLink Logfile"), tr("Error reading first %1 bytes from logfile. Got %2 instead of %1 bytes. Is the logfile readable?").arg(timeLen).arg(startBytes.length()));
-                reset();
-                return;
-            }
+    // WARNING: Order matters in this computation
+    int seconds = (logIndex.endTime() - logIndex.startTime())/1000000;
+    int minutes = seconds / 60;
+    int hours = minutes / 60;
+    seconds -= 60*minutes;
+    minutes -= 60*hours;
+
+    QString timelabel = tr("%1h:%2m:%3s").arg(hours, 2).arg(minutes, 2).arg(seconds, 2);
+    currPacketCount = logIndex.count();
+    ui->positionSlider->setEnabled(true);
+    if (!isPlaying)
+    {
+        QFileInfo logFileInfo(logFile);
+        ui->logStatsLabel->setText(tr("%2 MB, %3 packets, %4").arg(logFileInfo.size()/1000000.0f, 0, 'f', 2).arg(currPacketCount).arg(timelabel));
+    }
+}
 
-            // Convert data to timestamp
-            startTime = *((quint64*)(startBytes.constData()));
-            currentStartTime = QGC::groundTimeUsecs();
-            ok = true;
+void QGCMAVLinkLogPlayer::unpacedReplayProgress(int percent)
+{
+    ui->positionSlider->blockSignals(true);
+    ui->positionSlider->setValue(ui->positionSlider->minimum() + (ui->positionSlider->maximum() - ui->positionSlider->minimum()) * percent / 100);
+    ui->positionSlider->blockSignals(false);
+}
 
-            //qDebug() << "START TIME: " << startTime;
+void QGCMAVLinkLogPlayer::unpacedReplayFinished()
+{
+    // pause() and loading another file stop the replay as well, only
+    // a replay that reached the end is reported
+    const bool reachedEnd = isPlaying;
+    const QString report = unpacedReplay->getReport();
+    if (reachedEnd)
+    {
+        reset();
+    }
+    ui->logStatsLabel->setText(tr("Replayed %1 packets at %2 packets/s").arg(unpacedReplay->getFrames()).arg(unpacedReplay->getFrameRate(), 0, 'f', 0));
+    if (reachedEnd)
+    {
+        MainWindow::instance()->showInfoMessage(tr("Unpaced replay finished"), report);
+    }
+}
 
-            // Check if these bytes could be correctly decoded
-            if (!ok)
-            {
-                ui->logStatsLabel->setText(tr("Error decoding first timestamp, aborting."));
-                MainWindow::instance()->showCriticalMessage(tr("Failed loading MAVLink Logfile"), tr("Could not load initial timestamp from file %1. Is the file corrupted?").arg(logFile.fileName()));
-                reset();
-                return;
-            }
+void QGCMAVLinkLogPlayer::pacerTimeChanged(quint64 time)
+{
+    // Don't move the slider under the mouse
+    if (!ui->positionSlider->isSliderDown())
+    {
+        double fraction = logReader.size() > 0 ? pacer.getOffset()/static_cast<double>(logReader.size()) : 0.0;
+        if (logIndex.isReady() || logReader.isBlockLog())
+        {
+            // Matches the time based seeking
+            fraction = timeFraction(time);
         }
+        ui->positionSlider->blockSignals(true);
+        ui->positionSlider->setValue((ui->positionSlider->maximum()-ui->positionSlider->minimum())*fraction);
+        ui->positionSlider->blockSignals(false);
+    }
 
+    // Update the drift about once per second
+    if (isPlaying && loopCounter % 20 == 0)
+    {
+        ui->logStatsLabel->setText(tr("Playing, drift %1 ms mean, %2 ms max").arg(pacer.getMeanDrift()/1e6, 0, 'f', 1).arg(pacer.getMaxDrift()/1e6, 0, 'f', 1));
+    }
+    loopCounter++;
+}
 
-        // Initialization seems fine, load next chunk
-        QByteArray chunk = logFile.read(timeLen+packetLen);
-        QByteArray packet = chunk.mid(0, packetLen);
+void QGCMAVLinkLogPlayer::pacerEndReached()
+{
+    QString status = tr("Reached end of MAVLink log file, drift %1 ms mean, %2 ms max, %3 corrections.").arg(pacer.getMeanDrift()/1e6, 0, 'f', 1).arg(pacer.getMaxDrift()/1e6, 0, 'f', 1).arg(pacer.getDriftCorrections());
+    reset();
+    ui->logStatsLabel->setText(status);
+    MainWindow::instance()->showStatusMessage(status);
+}
 
-        // Emit this packet
-        emit bytesReady(logLink, packet);
+quint64 QGCMAVLinkLogPlayer::logStartTime() const
+{
+    return logIndex.isReady() ? logIndex.startTime() : logReader.getBlockFile().startTime();
+}
 
-        // Check if reached end of file before reading next timestamp
-        if (chunk.length() < timeLen+packetLen || logFile.atEnd())
-        {
-            // Reached end of file
-            reset();
+quint64 QGCMAVLinkLogPlayer::logEndTime() const
+{
+    return logIndex.isReady() ? logIndex.endTime() : logReader.getBlockFile().endTime();
+}
 
-            QString status = tr("Reached end of MAVLink log file.");
-            ui->logStatsLabel->setText(status);
-            MainWindow::instance()->showStatusMessage(status);
-            return;
-        }
+double QGCMAVLinkLogPlayer::timeFraction(quint64 time) const
+{
+    const quint64 start = logStartTime();
+    const quint64 end = logEndTime();
+    if (end <= start || time <= start)
+    {
+        return 0.0;
+    }
+    return qMin(1.0, (time - start) / (double)(end - start));
+}
 
-        // End of file not reached, read next timestamp
-        QByteArray rawTime = chunk.mid(packetLen);
+/**
+ * Jumps to the current percentage of the position slider
+ */
+void QGCMAVLinkLogPlayer::jumpToSliderVal(int slidervalue)
+{
+    loopTimer.stop();
+    double fraction = slidervalue / (double)(ui->positionSlider->maximum() - ui->positionSlider->minimum());
 
-        // This is the timestamp of the next packet
-        quint64 time = *((quint64*)(rawTime.constData()));
-        ok = true;
-        if (!ok)
+    if (mavlinkLogFormat)
+    {
+        // The slider covers the logged time span
+        if (logIndex.isReady() || logReader.isBlockLog())
         {
-            // Convert it to 64bit number
-            QString status = tr("Time conversion error during log replay. Continuing..");
-            ui->logStatsLabel->setText(status);
-            MainWindow::instance()->showStatusMessage(status);
+            jumpToTime(logStartTime() + (quint64)(fraction * (logEndTime() - logStartTime())));
         }
-        else
-        {
-            // Normal processing, passed all checks
-            // start timer to match time offset between
-            // this and next packet
-
-
-            // Offset in ms
-            qint64 timediff = (time - startTime)/accelerationFactor;
-
-            // Immediately load any data within
-            // a 3 ms interval
+        return;
+    }
 
-            int nextExecutionTime = (((qint64)currentStartTime + (qint64)timediff) - (qint64)QGC::groundTimeUsecs())/1000;
+    // Set the logfile to the correct percentage and
+    // align to the timestamp values
+    int packetCount = logFile.size() / (packetLen + timeLen);
+    int packetIndex = (packetCount - 1) * fraction;
+    reset(packetIndex);
+}
 
-            //qDebug() << "nextExecutionTime:" << nextExecutionTime << "QGC START TIME:" << currentStartTime << "LOG START TIME:" << startTime;
+bool QGCMAVLinkLogPlayer::jumpToTime(quint64 time)
+{
+    if (!mavlinkLogFormat)
+    {
+        return false;
+    }
 
-            if (nextExecutionTime < 2)
-            {
-                logLoop();
-            }
-            else
-            {
-                loopTimer.start(nextExecutionTime);
-            }
-        }
+    qint64 offset;
+    int packetIndex = -1;
+    QString status;
+    if (logIndex.isReady() && logIndex.count() > 0)
+    {
+        packetIndex = qMin(logIndex.findTime(time), logIndex.count() - 1);
+        offset = logIndex.offset(packetIndex);
+        time = logIndex.time(packetIndex);
+        status = tr("Jumped to packet %1").arg(packetIndex);
+    }
+    else if (logReader.isBlockLog() && logReader.seekTime(time) && !logReader.atEnd())
+    {
+        // Only the block containing the time was decompressed
+        offset = logReader.position();
+        status = tr("Jumped to %1 s").arg((time > logStartTime() ? time - logStartTime() : 0)/1000000.0, 0, 'f', 1);
     }
     else
     {
-        // Binary format - read at fixed rate
-        const int len = 100;
-        QByteArray chunk = logFile.read(len);
+        return false;
+    }
+
+    if (isPlaying && pacer.isRunning())
+    {
+        // Continue playing at the new position
+        pacer.seek(offset);
+        currPacketIndex = packetIndex;
+        ui->positionSlider->blockSignals(true);
+        ui->positionSlider->setValue((ui->positionSlider->maximum()-ui->positionSlider->minimum())*timeFraction(time));
+        ui->positionSlider->blockSignals(false);
+        ui->logStatsLabel->setText(status);
+        return true;
+    }
+
+    // Do only accept valid jumps
+    if (seekToOffset(offset, timeFraction(time), packetIndex))
+    {
+        ui->logStatsLabel->setText(status);
+        return true;
+    }
+    return false;
+}
 
-        // Emit this packet
-        emit bytesReady(logLink, chunk);
+/**
+ * This function is the "mainloop" of the log player for binary logs,
+ * which are replayed at the fixed rate of their baud rate. MAVLink logs
+ * are paced by their timestamps in the MAVLinkLogPacer thread.
+ */
+void QGCMAVLinkLogPlayer::logLoop()
+{
+    // Binary format - read at fixed rate
+    const int len = 100;
+    QByteArray chunk = logFile.read(len);
 
-        // Check if reached end of file before reading next timestamp
-        if (chunk.length() < len || logFile.atEnd())
-        {
-            // Reached end of file
-            reset();
+    // Emit this packet
+    emit bytesReady(logLink, chunk);
 
-            QString status = tr("Reached end of binary log file.");
-            ui->logStatsLabel->setText(status);
-            MainWindow::instance()->showStatusMessage(status);
-            return;
-        }
+    // Check if reached end of file before reading next timestamp
+    if (chunk.length() < len || logFile.atEnd())
+    {
+        // Reached end of file
+        reset();
+
+        QString status = tr("Reached end of binary log file.");
+        ui->logStatsLabel->setText(status);
+        MainWindow::instance()->showStatusMessage(status);
+        return;
     }
-    // Ui update: Only every 20 messages
-    // to prevent flickering and high CPU load
 
-    // Update status label
-    // Update progress bar
-    if (loopCounter % 40 == 0 || currPacketCount < 500)
+    // Ui update: Only every 40 reads
+    // to prevent flickering and high CPU load
+    if ((loopCounter % 40 == 0 || currPacketCount < 500) && !ui->positionSlider->isSliderDown())
     {
         QFileInfo logFileInfo(logFile);
-        int progress = (ui->positionSlider->maximum()-ui->positionSlider->minimum())*(logFile.pos()/static_cast<float>(logFileInfo.size()));
-        //qDebug() << "Progress:" << progress;
+        double fraction = logFile.pos()/static_cast<float>(logFileInfo.size());
+        int progress = (ui->positionSlider->maximum()-ui->positionSlider->minimum())*fraction;
         ui->positionSlider->blockSignals(true);
         ui->positionSlider->setValue(progress);
         ui->positionSlider->blockSignals(false);
@@ -7,6 +7,10 @@
 #include "MAVLinkProtocol.h"
 #include "LinkInterface.h"
 #include "MAVLinkSimulationLink.h"
+#include "MAVLinkLogIndex.h"
+#include "MAVLinkLogReader.h"
+#include "MAVLinkLogReplay.h"
+#include "MAVLinkLogPacer.h"
 
 namespace Ui
 {
@@ -54,11 +58,27 @@ public slots:
     bool loadLogFile(const QString& file);
     /** @brief Jump to a position in the logfile */
     void jumpToSliderVal(int slidervalue);
-    /** @brief The logging mainloop */
+    /** @brief Jump to the first packet at or after a log time in microseconds */
+    bool jumpToTime(quint64 time);
+    /** @brief The replay mainloop of binary logs */
     void logLoop();
     /** @brief Set acceleration factor in percent */
     void setAccelerationFactorInt(int factor);
 
+protected slots:
+    /** @brief Show the indexing progress */
+    void logIndexProgress(int percent);
+    /** @brief Enable seeking once the frame index is complete */
+    void logIndexFinished();
+    /** @brief Show the position of the unpaced replay */
+    void unpacedReplayProgress(int percent);
+    /** @brief Report the throughput of the unpaced replay */
+    void unpacedReplayFinished();
+    /** @brief Show the position and the drift of the paced replay */
+    void pacerTimeChanged(quint64 time);
+    /** @brief Rewind and report the drift once the paced replay is complete */
+    void pacerEndReached();
+
 signals:
     /** @brief Send ready bytes */
     void bytesReady(LinkInterface* link, const QByteArray& bytes);
@@ -66,9 +86,7 @@ signals:
 protected:
     int lineCounter;
     int totalLines;
-    quint64 startTime;
     quint64 endTime;
-    quint64 currentStartTime;
     float accelerationFactor;
     MAVLinkProtocol* mavlink;
     MAVLinkSimulationLink* logLink;
@@ -79,9 +97,22 @@ protected:
     int binaryBaudRate;
     bool isPlaying;
     unsigned int currPacketCount;
+    int currPacketIndex;        ///< Index of the packet the replay started at, -1 if unknown
+    MAVLinkLogIndex logIndex;   ///< Record offsets of MAVLink logs, required for seeking
+    MAVLinkLogReader logReader; ///< Position to start MAVLink logs at, binary logs are read from logFile
+    MAVLinkLogPacer pacer;      ///< Replays MAVLink logs in real time
+    MAVLinkLogReplay* unpacedReplay; ///< Replays MAVLink logs as fast as possible
     static const int packetLen = MAVLINK_MAX_PACKET_LEN;
     static const int timeLen = sizeof(quint64);
     void changeEvent(QEvent *e);
+    /** @brief Position of a log time on the slider, 0 to 1 */
+    double timeFraction(quint64 time) const;
+    /** @brief First log time on the slider, from the index or the blocks of a block log */
+    quint64 logStartTime() const;
+    /** @brief Last log time on the slider */
+    quint64 logEndTime() const;
+    /** @brief Stop the replay and continue at a record offset, see reset() */
+    bool seekToOffset(qint64 offset, double fraction, int packetIndex);
 
 private:
     Ui::QGCMAVLinkLogPlayer *ui;
@@ -0,0 +1,39 @@
+#include "QGCSharedMemoryLinkConfiguration.h"
+#include "ui_QGCSharedMemoryLinkConfiguration.h"
+
+QGCSharedMemoryLinkConfiguration::QGCSharedMemoryLinkConfiguration(SharedMemoryLink* link, QWidget *parent) :
+    QWidget(parent),
+    link(link),
+    ui(new Ui::QGCSharedMemoryLinkConfiguration)
+{
+    ui->setupUi(this);
+    ui->segmentNameEdit->setText(link->getSegmentName());
+    connect(ui->segmentNameEdit, SIGNAL(editingFinished()), this, SLOT(setSegmentName()));
+}
+
+QGCSharedMemoryLinkConfiguration::~QGCSharedMemoryLinkConfiguration()
+{
+    delete ui;
+}
+
+void QGCSharedMemoryLinkConfiguration::changeEvent(QEvent *e)
+{
+    QWidget::changeEvent(e);
+    switch (e->type()) {
+    case QEvent::LanguageChange:
+        ui->retranslateUi(this);
+        break;
+    default:
+        break;
+    }
+}
+
+void QGCSharedMemoryLinkConfiguration::setSegmentName()
+{
+    QString name = ui->segmentNameEdit->text().trimmed();
+    // POSIX shared memory names start with a slash
+    if (!name.startsWith("/")) name.prepend("/");
+    ui->segmentNameEdit->setText(name);
+    if (name.length() > 1 && name != link->getSegmentName())
+        link->setSegmentName(name);
+}
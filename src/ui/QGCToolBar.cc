@@ -26,6 +26,7 @@ This file is part of the QGROUNDCONTROL project
 #include "QGCToolBar.h"
 #include "UASManager.h"
 #include "MainWindow.h"
+#include "MAVLinkLogBlockFile.h"
 
 QGCToolBar::QGCToolBar(QWidget *parent) :
     QToolBar(parent),
@@ -104,6 +105,11 @@ QGCToolBar::QGCToolBar(QWidget *parent) :
     toolBarDistLabel->setToolTip(tr("Distance to current waypoint"));
     addWidget(toolBarDistLabel);
 
+    toolBarTrafficLabel = new QLabel("-- kB/s", this);
+    toolBarTrafficLabel->setStyleSheet("QLabel { margin: 0px 2px; font: 12px; color: #3C7B9E; }");
+    toolBarTrafficLabel->setToolTip(tr("Received and sent data rate of the links of the vehicle"));
+    addWidget(toolBarTrafficLabel);
+
     toolBarMessageLabel = new QLabel("No system messages.", this);
     toolBarMessageLabel->setStyleSheet("QLabel { margin: 0px 4px; font: 12px; font-style: italic; color: #3C7B9E; }");
 	toolBarMessageLabel->setToolTip(tr("Most recent system message"));
@@ -192,7 +198,7 @@ void QGCToolBar::logging(bool checked)
     if (checked)
     {
 		// Prompt the user for a filename/location to save to
-        QString fileName = QFileDialog::getSaveFileName(this, tr("Specify MAVLink log file to save to"), QDesktopServices::storageLocation(QDesktopServices::DesktopLocation), tr("MAVLink Logfile (*.mavlink *.log *.bin);;"));
+        QString fileName = QFileDialog::getSaveFileName(this, tr("Specify MAVLink log file to save to"), QDesktopServices::storageLocation(QDesktopServices::DesktopLocation), tr("MAVLink Logfile (*.mavlink *.log *.bin);;Compressed MAVLink Logfile (*.mavlinkz);;"));
 
 		// Check that they didn't cancel out
 		if (fileName.isNull())
@@ -202,7 +208,7 @@ void QGCToolBar::logging(bool checked)
 		}
 
 		// Make sure the file's named properly
-        if (!fileName.endsWith(".mavlink"))
+        if (!fileName.endsWith(".mavlink") && !MAVLinkLogBlockFile::isBlockLogName(fileName))
         {
             fileName.append(".mavlink");
         }
@@ -300,6 +306,19 @@ void QGCToolBar::updateArmingState(bool armed)
 
 void QGCToolBar::updateView()
 {
+    // The traffic changes without any notification, read it from the links
+    if (mav)
+    {
+        LinkTrafficRate traffic;
+        foreach (LinkInterface* link, *mav->getLinks())
+        {
+            const LinkTrafficRate rate = link->getLinkStatistics()->getRate(updateViewTimer.interval() / 1000);
+            traffic.receivedBytes += rate.receivedBytes;
+            traffic.sentBytes += rate.sentBytes;
+        }
+        toolBarTrafficLabel->setText(tr("RX %1 TX %2 kB/s").arg(traffic.receivedBytes / 1000.0, 0, 'f', 1).arg(traffic.sentBytes / 1000.0, 0, 'f', 1));
+    }
+
     if (!changed) return;
     toolBarDistLabel->setText(tr("%1 m").arg(wpDistance, 6, 'f', 2, '0'));
     toolBarWpLabel->setText(tr("WP%1").arg(wpId));
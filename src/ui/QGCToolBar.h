@@ -93,6 +93,7 @@ protected:
     QLabel* toolBarWpLabel;
     QLabel* toolBarDistLabel;
     QLabel* toolBarMessageLabel;
+    QLabel* toolBarTrafficLabel;
     QPushButton* connectButton;
     QProgressBar* toolBarBatteryBar;
     QLabel* toolBarBatteryVoltageLabel;
@@ -37,7 +37,8 @@ This file is part of the QGROUNDCONTROL project
 #include <QFileInfoList>
 
 SerialConfigurationWindow::SerialConfigurationWindow(LinkInterface* link, QWidget *parent, Qt::WindowFlags flags) : QWidget(parent, flags),
-    userConfigured(false)
+    userConfigured(false),
+    discovery(NULL)
 {
     SerialLinkInterface* serialLink = dynamic_cast<SerialLinkInterface*>(link);
 
@@ -172,6 +173,11 @@ SerialConfigurationWindow::SerialConfigurationWindow(LinkInterface* link, QWidge
         portCheckTimer->setInterval(1000);
         connect(portCheckTimer, SIGNAL(timeout()), this, SLOT(setupPortList()));
 
+        discovery = new SerialPortDiscovery(this);
+        connect(ui.detectButton, SIGNAL(clicked()), this, SLOT(detectPort()));
+        connect(discovery, SIGNAL(portFound(QString,int,int)), this, SLOT(portDetected(QString,int,int)));
+        connect(discovery, SIGNAL(finished()), this, SLOT(detectionFinished()));
+
         // Display the widget
         this->window()->setWindowTitle(tr("Serial Communication Settings"));
     }
@@ -232,6 +238,45 @@ void SerialConfigurationWindow::setupPortList()
     ui.portName->setEditText(this->link->getPortName());
 }
 
+void SerialConfigurationWindow::detectPort()
+{
+    if (!link || discovery->isRunning()) return;
+
+    // An open port can not be probed, release it
+    if (link->isConnected()) link->disconnect();
+    const QStringList ports = QStringList::fromVector(*link->getCurrentPorts());
+    ui.detectButton->setEnabled(false);
+    ui.detectLabel->setText(tr("Probing %n port(s)", "", ports.size()));
+    discovery->start(ports);
+}
+
+void SerialConfigurationWindow::portDetected(const QString& port, int baudRate, int systemId)
+{
+    // Only the first port found is used, the others are reported when the discovery finished
+    if (discovery->getResults().size() > 1) return;
+
+    link->setPortName(port);
+    link->setBaudRate(baudRate);
+    ui.portName->setEditText(port);
+    ui.baudRate->setCurrentIndex(ui.baudRate->findText(QString::number(baudRate)));
+    userConfigured = true;
+    ui.detectLabel->setText(tr("System %1 at %2 baud").arg(systemId).arg(baudRate));
+}
+
+void SerialConfigurationWindow::detectionFinished()
+{
+    ui.detectButton->setEnabled(true);
+    const QList<SerialPortDiscoveryResult> results = discovery->getResults();
+    if (results.isEmpty())
+    {
+        ui.detectLabel->setText(tr("No MAVLink system found"));
+    }
+    else if (results.size() > 1)
+    {
+        ui.detectLabel->setText(tr("System %1 at %2 baud, %3 more ports found").arg(results.first().systemId).arg(results.first().baudRate).arg(results.size() - 1));
+    }
+}
+
 void SerialConfigurationWindow::enableFlowControl(bool flow)
 {
     if(flow)
@@ -40,6 +40,7 @@ This file is part of the QGROUNDCONTROL project
 #include <QHideEvent>
 #include <LinkInterface.h>
 #include <SerialLinkInterface.h>
+#include "SerialPortDiscovery.h"
 #include "ui_SerialSettings.h"
 
 class SerialConfigurationWindow : public QWidget
@@ -61,6 +62,11 @@ public slots:
     void setPortName(QString port);
     void setLinkName(QString name);
     void setupPortList();
+    /** @brief Probe all ports for a MAVLink system */
+    void detectPort();
+    /** @brief Apply the first port and baud rate the discovery found */
+    void portDetected(const QString& port, int baudRate, int systemId);
+    void detectionFinished();
 
 protected:
     void showEvent(QShowEvent* event);
@@ -73,6 +79,7 @@ private:
     SerialLinkInterface* link;
     QAction* action;
     QTimer* portCheckTimer;
+    SerialPortDiscovery* discovery;
 
 };
 